@@ -0,0 +1,239 @@
+/* ==== VMX Includes ======================================================= */
+#include <vmx/SimulatedVolumeMixer.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* ==== Open Source Includes =============================================== */
+#include <benchmark/benchmark.h>
+
+/* ==== Classes ============================================================ */
+// Observers only count deliveries; anything heavier would be measuring the
+// observer instead of the notification machinery.
+class CountingSessionObserver : public vmx::AudioSession::Observer
+{
+public: /* Methods */
+    CountingSessionObserver(std::atomic<std::uint64_t> &delivered) : m_delivered(delivered) {};
+
+public: /* Virtual Methods */
+    virtual void onNameChange(std::string) override { ++m_delivered; };
+    virtual void onIconPathChange(std::string) override { ++m_delivered; };
+    virtual void onStateChange(vmx::AudioSession::State) override { ++m_delivered; };
+    virtual void onVolumeChange(float) override { ++m_delivered; };
+    virtual void onChannelVolumesChange(std::vector<float>) override { ++m_delivered; };
+    virtual void onMuteChange(bool) override { ++m_delivered; };
+    virtual void onPeakSample(float) override { ++m_delivered; };
+    virtual void onLoudnessSample(vmx::Loudness) override { ++m_delivered; };
+
+private: /* Members */
+    std::atomic<std::uint64_t> &m_delivered;
+};
+
+class CountingDeviceObserver : public vmx::AudioDevice::Observer
+{
+public: /* Methods */
+    CountingDeviceObserver(std::atomic<std::uint64_t> &delivered) : m_delivered(delivered) {};
+
+public: /* Virtual Methods */
+    virtual void onNameChange(std::string) override { ++m_delivered; };
+    virtual void onIconPathChange(std::string) override { ++m_delivered; };
+    virtual void onStateChange(vmx::AudioDevice::State) override { ++m_delivered; };
+    virtual void onDefaultChange(bool) override { ++m_delivered; };
+    virtual void onVolumeChange(float) override { ++m_delivered; };
+    virtual void onChannelVolumesChange(std::vector<float>) override { ++m_delivered; };
+    virtual void onMuteChange(bool) override { ++m_delivered; };
+    virtual void onPeakSample(float) override { ++m_delivered; };
+    virtual void onLoudnessSample(vmx::Loudness) override { ++m_delivered; };
+    virtual void onAudioSessionAdded(const std::string &, std::weak_ptr<vmx::AudioSession>) override { ++m_delivered; };
+    virtual void onAudioSessionRemoved(const std::string &) override { ++m_delivered; };
+
+private: /* Members */
+    std::atomic<std::uint64_t> &m_delivered;
+};
+
+/* ==== Static Helper Functions ============================================ */
+// Observer callbacks are dispatched asynchronously, so an iteration is only
+// complete once every callback it triggered has actually run.
+static void
+waitForDeliveries
+(
+    const std::atomic<std::uint64_t> &delivered,
+    std::uint64_t expected
+)
+{
+    while (delivered.load(std::memory_order_acquire) < expected)
+    {
+        std::this_thread::yield();
+    }
+}
+
+/* ==== Benchmarks ========================================================= */
+// Cost of one volume change on a session as a function of its observer count.
+static void
+BM_NotifyFanOut
+(
+    benchmark::State &state
+)
+{
+    const auto observerCount = static_cast<std::size_t>(state.range(0));
+    std::atomic<std::uint64_t> delivered{0};
+    vmx::SimulatedVolumeMixer mixer;
+    auto pSession = mixer.createDevice("device", "Device", true)->createSession("session", "Session");
+
+    std::vector<std::shared_ptr<CountingSessionObserver>> observers;
+    for (std::size_t i = 0; i < observerCount; i++)
+    {
+        observers.push_back(std::make_shared<CountingSessionObserver>(delivered));
+        pSession->addObserver(observers.back(), false);
+    }
+
+    std::uint64_t expected = 0;
+    bool bToggle = false;
+    for (auto _ : state)
+    {
+        bToggle = !bToggle;
+        pSession->simulateVolume(bToggle ? 0.25f : 0.75f);
+        expected += observerCount;
+        waitForDeliveries(delivered, expected);
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(expected));
+}
+BENCHMARK(BM_NotifyFanOut)->RangeMultiplier(4)->Range(1, 256)->UseRealTime();
+
+// Cost of registering an observer with bNotifyNow=true on a device holding N sessions.
+static void
+BM_AddObserverNotifyNow
+(
+    benchmark::State &state
+)
+{
+    const auto sessionCount = static_cast<std::size_t>(state.range(0));
+    std::atomic<std::uint64_t> delivered{0};
+    vmx::SimulatedVolumeMixer mixer;
+    auto pDevice = mixer.createDevice("device", "Device", true);
+    for (std::size_t i = 0; i < sessionCount; i++)
+    {
+        pDevice->createSession("session" + std::to_string(i), "Session");
+    }
+
+    auto pObserver = std::make_shared<CountingDeviceObserver>(delivered);
+    for (auto _ : state)
+    {
+        pDevice->addObserver(pObserver, true);
+        pDevice->removeObserver(pObserver);
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(delivered.load()));
+}
+BENCHMARK(BM_AddObserverNotifyNow)->Arg(0)->RangeMultiplier(8)->Range(1, 4096);
+
+// Cost of a session appearing and disappearing on a device with N device observers.
+static void
+BM_SessionChurn
+(
+    benchmark::State &state
+)
+{
+    const auto observerCount = static_cast<std::size_t>(state.range(0));
+    std::atomic<std::uint64_t> delivered{0};
+    vmx::SimulatedVolumeMixer mixer;
+    auto pDevice = mixer.createDevice("device", "Device", true);
+
+    std::vector<std::shared_ptr<CountingDeviceObserver>> observers;
+    for (std::size_t i = 0; i < observerCount; i++)
+    {
+        observers.push_back(std::make_shared<CountingDeviceObserver>(delivered));
+        pDevice->addObserver(observers.back(), false);
+    }
+
+    std::uint64_t expected = 0;
+    for (auto _ : state)
+    {
+        pDevice->createSession("session", "Session");
+        pDevice->destroySession("session");
+        expected += 2 * observerCount;
+        waitForDeliveries(delivered, expected);
+    }
+
+    state.SetItemsProcessed(2 * static_cast<std::int64_t>(state.iterations()));
+}
+BENCHMARK(BM_SessionChurn)->Arg(0)->Arg(1)->Arg(8)->UseRealTime();
+
+// Cost of one peak sampling tick over a device with N sessions, each with M observers.
+static void
+BM_PeakTick
+(
+    benchmark::State &state
+)
+{
+    const auto sessionCount = static_cast<std::size_t>(state.range(0));
+    const auto observerCount = static_cast<std::size_t>(state.range(1));
+    std::atomic<std::uint64_t> delivered{0};
+    vmx::SimulatedVolumeMixer mixer;
+    auto pDevice = mixer.createDevice("device", "Device", true);
+
+    std::vector<std::shared_ptr<CountingSessionObserver>> observers;
+    for (std::size_t i = 0; i < sessionCount; i++)
+    {
+        auto pSession = pDevice->createSession("session" + std::to_string(i), "Session");
+        for (std::size_t j = 0; j < observerCount; j++)
+        {
+            observers.push_back(std::make_shared<CountingSessionObserver>(delivered));
+            pSession->addObserver(observers.back(), false);
+        }
+    }
+
+    std::uint64_t expected = 0;
+    for (auto _ : state)
+    {
+        mixer.peakSample();
+        expected += sessionCount * observerCount;
+        waitForDeliveries(delivered, expected);
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * sessionCount));
+}
+BENCHMARK(BM_PeakTick)->ArgsProduct({{1, 16, 64, 256}, {0, 1}})->UseRealTime();
+
+// Contention between threads hammering changeVolume() on the same session.
+static std::unique_ptr<vmx::SimulatedVolumeMixer> g_pContendedMixer;
+static vmx::SimulatedAudioSession *g_pContendedSession = nullptr;
+
+static void
+BM_ConcurrentChangeVolume
+(
+    benchmark::State &state
+)
+{
+    if (state.thread_index() == 0)
+    {
+        g_pContendedMixer = std::make_unique<vmx::SimulatedVolumeMixer>();
+        g_pContendedSession = g_pContendedMixer->createDevice("device", "Device", true)->createSession("session", "Session").get();
+    }
+
+    // distinct values per thread so every call is a real change
+    const float base = 0.01f * static_cast<float>(state.thread_index());
+    bool bToggle = false;
+    for (auto _ : state)
+    {
+        bToggle = !bToggle;
+        g_pContendedSession->changeVolume(base + (bToggle ? 0.5f : 0.25f));
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+
+    if (state.thread_index() == 0)
+    {
+        g_pContendedSession = nullptr;
+        g_pContendedMixer.reset();
+    }
+}
+BENCHMARK(BM_ConcurrentChangeVolume)->ThreadRange(1, 8)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,277 @@
+/* ==== VMX Includes ======================================================= */
+#include <vmx/GainRamp.h>
+#include <vmx/LoudnessMeter.h>
+#include <vmx/PcmMeter.h>
+#include <vmx/SpectrumAnalyzer.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+/* ==== Open Source Includes =============================================== */
+#include <benchmark/benchmark.h>
+
+/* ==== Types ============================================================== */
+using PcmKernel = void (*)(vmx::SampleFormat, const void*, std::size_t, std::span<float>);
+
+/* ==== Static Helper Functions ============================================ */
+static std::size_t
+bytesPerSample
+(
+    vmx::SampleFormat format
+)
+{
+    switch (format)
+    {
+        case vmx::SampleFormat::Int16: return 2;
+        case vmx::SampleFormat::Int24: return 3;
+        default:                       return 4;
+    }
+}
+
+static const char *
+formatName
+(
+    vmx::SampleFormat format
+)
+{
+    switch (format)
+    {
+        case vmx::SampleFormat::Float32: return "f32";
+        case vmx::SampleFormat::Int16:   return "i16";
+        case vmx::SampleFormat::Int24:   return "i24";
+        default:                         return "i32";
+    }
+}
+
+// Arguments are {PcmMeter::Isa, SampleFormat, channel count}. The buffer is a
+// typical device period that stays in L2, so the result is kernel throughput
+// rather than memory bandwidth; compare the GB/s of each ISA against scalar.
+static void
+runPcmKernel
+(
+    benchmark::State &state,
+    PcmKernel kernel
+)
+{
+    const auto isa = static_cast<vmx::PcmMeter::Isa>(state.range(0));
+    const auto format = static_cast<vmx::SampleFormat>(state.range(1));
+    const auto channelCount = static_cast<std::size_t>(state.range(2));
+    constexpr std::size_t kFrameCount = 4096;
+
+    if (!vmx::PcmMeter::isSupported(isa))
+    {
+        state.SkipWithError("instruction set not supported on this CPU");
+        return;
+    }
+    vmx::PcmMeter::setIsa(isa);
+
+    std::vector<std::uint8_t> frames(kFrameCount * channelCount * bytesPerSample(format));
+    std::mt19937 random(1);
+    if (format == vmx::SampleFormat::Float32)
+    {
+        std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+        for (std::size_t i = 0; i < frames.size(); i += sizeof(float))
+        {
+            float sample = distribution(random);
+            std::memcpy(&frames[i], &sample, sizeof(float));
+        }
+    }
+    else
+    {
+        for (auto &byte : frames)
+        {
+            byte = static_cast<std::uint8_t>(random());
+        }
+    }
+
+    std::vector<float> levels(channelCount);
+    for (auto _ : state)
+    {
+        kernel(format, frames.data(), kFrameCount, levels);
+        benchmark::DoNotOptimize(levels.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * frames.size()));
+    state.SetLabel(std::string(vmx::toString(isa)) + "/" + formatName(format));
+}
+
+/* ==== Benchmarks ========================================================= */
+static void
+BM_PcmPeak
+(
+    benchmark::State &state
+)
+{
+    runPcmKernel(state, &vmx::PcmMeter::peak);
+}
+BENCHMARK(BM_PcmPeak)->ArgsProduct({{0, 1, 2, 3}, {0, 1, 2, 3}, {2, 6}});
+
+static void
+BM_PcmRms
+(
+    benchmark::State &state
+)
+{
+    runPcmKernel(state, &vmx::PcmMeter::rms);
+}
+BENCHMARK(BM_PcmRms)->ArgsProduct({{0, 1, 2, 3}, {0, 1, 2, 3}, {2, 6}});
+
+static void
+BM_PcmTruePeak
+(
+    benchmark::State &state
+)
+{
+    runPcmKernel(state, &vmx::PcmMeter::truePeak);
+}
+BENCHMARK(BM_PcmTruePeak)->ArgsProduct({{0, 1, 2, 3}, {0, 1, 2, 3}, {2, 6}});
+
+// Arguments are {PcmMeter::Isa, SampleFormat, channel count}; the meter picks
+// its filter kernel from PcmMeter::isa() when constructed. One 10 ms period
+// per call, like a backend feeding it from the audio thread. 50 streams at
+// 48 kHz are 2.4M frames/s, so staying under 1% of a core for them takes
+// 240M frames (items) per second.
+static void
+BM_LoudnessMeter
+(
+    benchmark::State &state
+)
+{
+    const auto isa = static_cast<vmx::PcmMeter::Isa>(state.range(0));
+    const auto format = static_cast<vmx::SampleFormat>(state.range(1));
+    const auto channelCount = static_cast<std::size_t>(state.range(2));
+    constexpr std::size_t kFrameCount = 480;
+
+    if (!vmx::PcmMeter::isSupported(isa))
+    {
+        state.SkipWithError("instruction set not supported on this CPU");
+        return;
+    }
+    vmx::PcmMeter::setIsa(isa);
+    vmx::LoudnessMeter meter(48000, channelCount);
+
+    std::vector<std::uint8_t> frames(kFrameCount * channelCount * bytesPerSample(format));
+    std::mt19937 random(1);
+    for (auto &byte : frames)
+    {
+        byte = static_cast<std::uint8_t>(random() & 0x3f); // keeps float samples small and finite
+    }
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(meter.process(format, frames.data(), kFrameCount));
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * kFrameCount));
+    state.SetLabel(std::string(vmx::toString(isa)) + "/" + formatName(format));
+}
+BENCHMARK(BM_LoudnessMeter)->ArgsProduct({{0, 2}, {0, 1}, {2, 6}});
+
+// The argument is the FFT size. Each iteration is one 10 ms period
+// of 48 kHz stereo through a tap and one analysis, the same as an analyzer
+// running at a 10 ms period; items are frames.
+static void
+BM_SpectrumAnalyzer
+(
+    benchmark::State &state
+)
+{
+    const auto fftSize = static_cast<std::size_t>(state.range(0));
+    constexpr std::size_t kFrameCount = 480;
+
+    vmx::SpectrumAnalyzer analyzer(fftSize, 32, std::chrono::milliseconds(0));
+    auto pAudioTap = std::make_shared<vmx::AudioTap>(48000, 2, std::chrono::milliseconds(100));
+    analyzer.addSource(pAudioTap);
+
+    std::vector<float> frames(kFrameCount * 2);
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> noise(-0.5f, 0.5f);
+    for (auto &sample : frames)
+    {
+        sample = noise(random);
+    }
+
+    for (auto _ : state)
+    {
+        pAudioTap->write(frames.data(), kFrameCount);
+        analyzer.analyze();
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * kFrameCount));
+}
+BENCHMARK(BM_SpectrumAnalyzer)->Arg(1024)->Arg(4096);
+
+// Arguments are {PcmMeter::Isa, stream count, channel count, ramping}. Each
+// iteration mixes one 10 ms period of every stream into a bus through the
+// stream's GainRamp, then runs the bus's own ramp over it, the same as a
+// device render. With ramping set every stream's target moves each period, so
+// half of every period is on a ramp. Items are samples summed, i.e. streams x
+// channels x frames, so items_per_second is the mix throughput.
+static void
+BM_MixBus
+(
+    benchmark::State &state
+)
+{
+    const auto isa = static_cast<vmx::PcmMeter::Isa>(state.range(0));
+    const auto streamCount = static_cast<std::size_t>(state.range(1));
+    const auto channelCount = static_cast<std::size_t>(state.range(2));
+    const bool bRamping = state.range(3) != 0;
+    constexpr std::size_t kFrameCount = 480;
+
+    if (!vmx::PcmMeter::isSupported(isa))
+    {
+        state.SkipWithError("instruction set not supported on this CPU");
+        return;
+    }
+    vmx::PcmMeter::setIsa(isa);
+
+    std::vector<std::unique_ptr<vmx::GainRamp>> gainRamps;
+    std::vector<std::vector<float>> streams(streamCount, std::vector<float>(kFrameCount * channelCount));
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> noise(-0.5f, 0.5f);
+    for (auto &stream : streams)
+    {
+        gainRamps.push_back(std::make_unique<vmx::GainRamp>(48000, 0.5f));
+        for (auto &sample : stream)
+        {
+            sample = noise(random);
+        }
+    }
+    vmx::GainRamp busGainRamp(48000, 0.8f);
+    std::vector<float> bus(kFrameCount * channelCount);
+
+    float target = 0.5f;
+    for (auto _ : state)
+    {
+        if (bRamping)
+        {
+            target = 1.0f - target;
+            for (auto &pGainRamp : gainRamps)
+            {
+                pGainRamp->setTarget(target);
+            }
+        }
+        std::fill(bus.begin(), bus.end(), 0.0f);
+        for (std::size_t stream = 0; stream < streamCount; ++stream)
+        {
+            gainRamps[stream]->process(streams[stream].data(), nullptr, bus.data(), channelCount, kFrameCount);
+        }
+        busGainRamp.process(bus.data(), bus.data(), nullptr, channelCount, kFrameCount);
+        benchmark::DoNotOptimize(bus.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * streamCount * channelCount * kFrameCount));
+    state.SetLabel(vmx::toString(isa));
+}
+BENCHMARK(BM_MixBus)->ArgsProduct({{0, 2}, {1, 16, 64}, {2, 6}, {0, 1}});
@@ -0,0 +1,140 @@
+/* ==== VMX Includes ======================================================= */
+#include <vmx/WorkThreads.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+
+/* ==== Open Source Includes =============================================== */
+#include <benchmark/benchmark.h>
+
+/* ==== Classes ============================================================ */
+// QueuedWorkThread as it was before MpscQueue, kept as the baseline: a
+// std::queue under a mutex, a copy per item, and a wakeup per item.
+template <class T>
+class LockedWorkThread
+{
+public:
+    LockedWorkThread(std::function<void(const T&)> queuedWorkFunction)
+      : m_queuedWorkFunction(queuedWorkFunction),
+        m_thread([this](std::stop_token stopToken){ workThreadFunc(stopToken); })
+    {
+    }
+
+    void queue(T &&workItem)
+    {
+        {
+            std::lock_guard guard(m_mutex);
+            m_queue.push(workItem);
+        }
+        m_condition.notify_one();
+    }
+
+private:
+    void workThreadFunc(std::stop_token stopToken)
+    {
+        while (true)
+        {
+            std::unique_lock lock(m_mutex);
+            if (!m_condition.wait(lock, stopToken, [this]{return !(this->m_queue.empty());}))
+            {
+                return;
+            }
+            T workItem = std::move(m_queue.front());
+            m_queue.pop();
+            lock.unlock();
+            m_queuedWorkFunction(workItem);
+        }
+    }
+
+private:
+    std::function<void(const T&)> m_queuedWorkFunction;
+    std::queue<T> m_queue;
+    std::mutex m_mutex;
+    std::condition_variable_any m_condition;
+    std::jthread m_thread;
+};
+
+/* ==== Benchmarks ========================================================= */
+// Producers queue bursts of session IDs, the way a device's session teardown
+// does, to one consumer. The consumer only counts; an iteration ends when its
+// burst has been consumed, so both sides of the queue are in the timing.
+static constexpr int kBurst = 64;
+
+template <class WorkThread>
+static void
+BM_QueueBurst
+(
+    benchmark::State &state
+)
+{
+    static std::unique_ptr<WorkThread> s_pWorkThread;
+    static std::atomic<std::uint64_t> s_consumed{0};
+    if (state.thread_index() == 0)
+    {
+        s_consumed = 0;
+        s_pWorkThread = std::make_unique<WorkThread>([](const std::string &){ s_consumed.fetch_add(1, std::memory_order_relaxed); });
+    }
+
+    std::uint64_t produced = 0;
+    const std::string sessionId = "{0.0.0.00000000}.{5a2e5c1e-8f0b-4e4b-9d1c-2b3f0c7a9e11}|" + std::to_string(state.thread_index());
+    for (auto _ : state)
+    {
+        for (int i = 0; i < kBurst; i++)
+        {
+            s_pWorkThread->queue(std::string(sessionId));
+        }
+        produced += kBurst;
+        // Every thread's bursts add up, so wait for at least this thread's share
+        while (s_consumed.load(std::memory_order_relaxed) < produced)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * kBurst));
+
+    if (state.thread_index() == 0)
+    {
+        s_pWorkThread.reset();
+    }
+}
+BENCHMARK_TEMPLATE(BM_QueueBurst, LockedWorkThread<std::string>)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_QueueBurst, vmx::QueuedWorkThread<std::string>)->ThreadRange(1, 16)->UseRealTime();
+
+// Move-only items, which the old queue could not take at all
+static void
+BM_QueueMoveOnly
+(
+    benchmark::State &state
+)
+{
+    std::atomic<std::uint64_t> consumed{0};
+    vmx::QueuedWorkThread<std::unique_ptr<std::string>> workThread([&](std::unique_ptr<std::string> pItem){
+        if (pItem) consumed.fetch_add(1, std::memory_order_relaxed);
+    });
+
+    std::uint64_t produced = 0;
+    for (auto _ : state)
+    {
+        for (int i = 0; i < kBurst; i++)
+        {
+            workThread.queue(std::make_unique<std::string>("session"));
+        }
+        produced += kBurst;
+        while (consumed.load(std::memory_order_relaxed) < produced)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * kBurst));
+}
+BENCHMARK(BM_QueueMoveOnly)->UseRealTime();
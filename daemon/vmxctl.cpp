@@ -0,0 +1,199 @@
+/* ==== VMX Includes ======================================================= */
+#include <vmx/ChannelVolumes.h>
+#include <vmx/ControlClient.h>
+#include <vmx/MeterSegment.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* ==== Static Helper Functions ============================================ */
+static void
+printUsage()
+{
+    std::printf(
+        "usage: vmxctl [--socket <path>] <command>\n"
+        "  list                   print every device and session with its handle\n"
+        "  watch                  print events as they arrive, until interrupted\n"
+        "  meters [name]          print peaks from vmxd's meter segment ten times a second\n"
+        "  volume <handle> <0-1>  change a volume\n"
+        "  mute <handle> <0|1>    change a mute\n"
+        "  balance <handle> <-1-1> change the left/right balance\n");
+}
+
+static void
+printObject
+(
+    const vmx::ControlClient::Object &object
+)
+{
+    std::printf("%s%4u %-8s %-24s %-24s vol %.2f bal %+.2f%s peak %.2f\n",
+        object.bSession ? "  " : "",
+        object.handle,
+        object.bSession ? "session" : (object.bDefault ? "device*" : "device"),
+        object.id.c_str(),
+        object.name.c_str(),
+        static_cast<double>(object.volume),
+        static_cast<double>(vmx::ChannelVolumes::balance(object.channelVolumes)),
+        object.bMuted ? " muted" : "",
+        static_cast<double>(object.peak));
+}
+
+static void
+list
+(
+    vmx::ControlClient &client
+)
+{
+    for (const auto &[handle, device] : client.objects())
+    {
+        if (device.bSession) continue;
+        printObject(device);
+        for (const auto &[sessionHandle, session] : client.objects())
+        {
+            if (session.bSession && session.parent == handle) printObject(session);
+        }
+    }
+}
+
+static void
+watch
+(
+    vmx::ControlClient &client
+)
+{
+    while (true)
+    {
+        for (const auto &event : client.poll(std::chrono::milliseconds(1000)))
+        {
+            auto object = client.objects().find(event.handle);
+            std::printf("%8llu %4u %-16s", static_cast<unsigned long long>(event.seq), event.handle, vmx::toString(event.kind));
+            if (object != client.objects().end())
+            {
+                std::printf(" %s vol %.2f%s peak %.2f", object->second.name.c_str(), static_cast<double>(object->second.volume),
+                    object->second.bMuted ? " muted" : "", static_cast<double>(object->second.peak));
+            }
+            std::printf("\n");
+        }
+        std::fflush(stdout);
+    }
+}
+
+static void
+meters
+(
+    const std::string &meterSegmentName
+)
+{
+    // Straight from shared memory, vmxd never hears about this
+    vmx::MeterSegmentReader reader(meterSegmentName);
+    while (true)
+    {
+        const auto &meters = reader.read();
+        std::printf("tick %llu\n", static_cast<unsigned long long>(reader.tick()));
+        for (const auto &meter : meters)
+        {
+            int width = static_cast<int>(meter.peak * 40.0f + 0.5f);
+            std::printf("%s%4u %-24s %.2f %.*s\n", meter.bSession ? "  " : "", meter.handle, meter.id.c_str(),
+                static_cast<double>(meter.peak), width, "########################################");
+        }
+        std::fflush(stdout);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+}
+
+/* ==== Main =============================================================== */
+int
+main
+(
+    int argc,
+    char **argv
+)
+{
+    std::vector<std::string> args(argv + 1, argv + argc);
+    std::string socketPath = vmx::defaultControlSocketPath();
+    if (args.size() >= 2 && args[0] == "--socket")
+    {
+        socketPath = args[1];
+        args.erase(args.begin(), args.begin() + 2);
+    }
+    if (args.empty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    try
+    {
+        if (args[0] == "meters" && args.size() <= 2)
+        {
+            meters(args.size() == 2 ? args[1] : vmx::defaultMeterSegmentName());
+            return 0;
+        }
+
+        vmx::ControlClient client(socketPath);
+        const std::string &command = args[0];
+        if (command == "list" && args.size() == 1)
+        {
+            list(client);
+            return 0;
+        }
+        if (command == "watch" && args.size() == 1)
+        {
+            watch(client);
+            return 0;
+        }
+        if (args.size() != 3)
+        {
+            printUsage();
+            return 1;
+        }
+
+        std::uint32_t handle = static_cast<std::uint32_t>(std::strtoul(args[1].c_str(), nullptr, 10));
+        float value = std::strtof(args[2].c_str(), nullptr);
+        auto object = client.objects().find(handle);
+        if (object == client.objects().end())
+        {
+            std::fprintf(stderr, "vmxctl: no device or session with handle %u\n", handle);
+            return 1;
+        }
+
+        if (command == "volume")
+        {
+            client.changeVolume(handle, value);
+        }
+        else if (command == "mute")
+        {
+            client.changeMute(handle, value != 0.0f);
+        }
+        else if (command == "balance")
+        {
+            auto channelVolumes = object->second.channelVolumes;
+            vmx::ChannelVolumes::setBalance(channelVolumes, value);
+            client.changeChannelVolumes(handle, channelVolumes);
+        }
+        else
+        {
+            printUsage();
+            return 1;
+        }
+
+        // Wait for the change to come back, or for the daemon to refuse it
+        std::uint64_t version = client.version();
+        for (int attempt = 0; attempt < 10 && client.version() == version; ++attempt)
+        {
+            client.poll(std::chrono::milliseconds(100));
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::fprintf(stderr, "vmxctl: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,125 @@
+/* ==== VMX Includes ======================================================= */
+#include <vmx/ControlServer.h>
+#include <vmx/SimulatedVolumeMixer.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <string>
+#include <thread>
+
+/* ==== Operating System Includes ========================================== */
+#include <csignal>
+
+/* ==== Types ============================================================== */
+struct Options
+{
+    std::string backend = "";
+    std::string socketPath = vmx::defaultControlSocketPath();
+    std::string meterSegmentName = vmx::defaultMeterSegmentName();
+    std::chrono::milliseconds peakPeriod{50};
+    std::chrono::milliseconds loudnessPeriod{0};
+    bool bDemo = false;
+};
+
+/* ==== Static Helper Functions ============================================ */
+static void
+printUsage()
+{
+    std::printf(
+        "usage: vmxd [options]\n"
+        "  --backend <name>       backend to serve (default: the first one that connects)\n"
+        "  --socket <path>        socket to listen on (default %s)\n"
+        "  --meter-segment <name> shared memory to publish peaks in, \"\" for none (default %s)\n"
+        "  --peak-period <ms>     peak sampling period, 0 disables (default 50)\n"
+        "  --loudness-period <ms> loudness sampling period, 0 disables (default 0)\n"
+        "  --demo                 serve a simulated mixer with a few devices and sessions\n",
+        vmx::defaultControlSocketPath().c_str(), vmx::defaultMeterSegmentName().c_str());
+}
+
+static bool
+parseOptions
+(
+    int argc,
+    char **argv,
+    Options &options
+)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--demo")
+        {
+            options.bDemo = true;
+            continue;
+        }
+        if (arg == "--help" || arg == "-h" || i + 1 >= argc) return false;
+        if      (arg == "--backend")         options.backend = argv[++i];
+        else if (arg == "--socket")          options.socketPath = argv[++i];
+        else if (arg == "--meter-segment")   options.meterSegmentName = argv[++i];
+        else if (arg == "--peak-period")     options.peakPeriod = std::chrono::milliseconds(std::strtoull(argv[++i], nullptr, 10));
+        else if (arg == "--loudness-period") options.loudnessPeriod = std::chrono::milliseconds(std::strtoull(argv[++i], nullptr, 10));
+        else return false;
+    }
+    return true;
+}
+
+static std::unique_ptr<vmx::VolumeMixer>
+createDemoMixer()
+{
+    auto pMixer = std::make_unique<vmx::SimulatedVolumeMixer>();
+    auto pSpeakers = pMixer->createDevice("speakers", "Speakers", true);
+    auto pHeadphones = pMixer->createDevice("headphones", "Headphones", false);
+    pSpeakers->createSession("music", "Music Player")->simulateLevel(0.5f);
+    pSpeakers->createSession("browser", "Web Browser")->simulateLevel(0.25f);
+    pHeadphones->createSession("call", "Voice Call")->simulateLevel(0.75f);
+    return pMixer;
+}
+
+/* ==== Main =============================================================== */
+int
+main
+(
+    int argc,
+    char **argv
+)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    // Blocked before any thread starts, so only sigwait() below sees them
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    try
+    {
+        auto pMixer = options.bDemo ? createDemoMixer() : vmx::VolumeMixer::create(options.backend);
+        pMixer->setPeakSamplingPeriod(options.peakPeriod);
+        pMixer->setLoudnessSamplingPeriod(options.loudnessPeriod);
+
+        vmx::ControlServer server(*pMixer, options.socketPath, options.meterSegmentName);
+        std::string backend = options.bDemo ? "the demo mixer" : options.backend.empty() ? "the default backend" : options.backend;
+        std::printf("vmxd: serving %s on %s\n", backend.c_str(), options.socketPath.c_str());
+        std::fflush(stdout);
+
+        int signal = 0;
+        sigwait(&signals, &signal);
+        std::printf("vmxd: %s, shutting down\n", signal == SIGINT ? "SIGINT" : "SIGTERM");
+    }
+    catch (const std::exception &e)
+    {
+        std::fprintf(stderr, "vmxd: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
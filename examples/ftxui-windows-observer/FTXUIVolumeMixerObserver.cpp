@@ -3,6 +3,7 @@
 
 /* ==== Standard Library Includes ========================================== */
 #include <chrono>
+#include <cmath>
 using namespace std::chrono_literals;
 
 /* ==== Open Source Includes =============================================== */
@@ -23,6 +24,23 @@ static std::string percentStr(float value)
     return fmt::format("{:3}%", percent(value));
 }
 
+static std::string lufsStr(float value)
+{
+    return (value == vmx::Loudness::kSilence) ? std::string("  -inf") : fmt::format("{:6.1f}", value);
+}
+
+static std::string loudnessStr(const vmx::Loudness &loudness)
+{
+    return fmt::format("M {} / S {} / I {} LUFS", lufsStr(loudness.momentary), lufsStr(loudness.shortTerm), lufsStr(loudness.integrated));
+}
+
+static std::string balanceStr(const std::vector<float> &channelVolumes)
+{
+    float balance = vmx::ChannelVolumes::balance(channelVolumes);
+    if (percent(std::abs(balance)) == 0) return "centre";
+    return fmt::format("{} {}", percentStr(std::abs(balance)), (balance < 0.0f) ? "left" : "right");
+}
+
 /* ==== FTXUIAudioSessionObserver Methods ================================== */
 FTXUIAudioSessionObserver::FTXUIAudioSessionObserver
 (
@@ -65,7 +83,9 @@ FTXUIAudioSessionObserver::FTXUIAudioSessionObserver
             ftxui::vbox(
             {
                 ftxui::hbox({ftxui::text("Peak:   ["), ftxui::gauge(m_peak), ftxui::text("] " + percentStr(m_peak))}),
+                ftxui::hbox({ftxui::text("Loud:   " + loudnessStr(m_loudness))}),
                 ftxui::hbox({ftxui::text("Volume: "), m_volumeSlider->Render(), ftxui::text(" " + percentStr(m_volumeControl))}),
+                ftxui::hbox({ftxui::text("Pan:    " + balanceStr(m_channelVolumes))}),
                 ftxui::hbox({ftxui::text("Mute:   "), m_mutedCheckbox->Render()}),
             }) | ftxui::xflex);
     });
@@ -174,6 +194,32 @@ FTXUIAudioSessionObserver::onPeakSample
     m_updateScreenFunc();
 }
 
+void
+FTXUIAudioSessionObserver::onChannelVolumesChange
+(
+    std::vector<float> channelVolumes
+)
+{
+    {
+        LOCK_GUARD(m_mutex);
+        m_channelVolumes = std::move(channelVolumes);
+    }
+    m_updateScreenFunc();
+}
+
+void
+FTXUIAudioSessionObserver::onLoudnessSample
+(
+    vmx::Loudness loudness
+)
+{
+    {
+        LOCK_GUARD(m_mutex);
+        m_loudness = loudness;
+    }
+    m_updateScreenFunc();
+}
+
 /* ==== FTXUIAudioDeviceObserver Methods =================================== */
 FTXUIAudioDeviceObserver::FTXUIAudioDeviceObserver
 (
@@ -204,7 +250,9 @@ FTXUIAudioDeviceObserver::FTXUIAudioDeviceObserver
         return ftxui::vbox(
             {
                 ftxui::hbox({ftxui::text("Peak:   ["), ftxui::gauge(m_peak), ftxui::text("]  " + percentStr(m_peak))}),
+                ftxui::hbox({ftxui::text("Loud:   " + loudnessStr(m_loudness))}),
                 ftxui::hbox({ftxui::text("Volume: "), m_volumeSlider->Render(), ftxui::text("  " + percentStr(m_volumeControl))}),
+                ftxui::hbox({ftxui::text("Pan:    " + balanceStr(m_channelVolumes))}),
                 ftxui::hbox({ftxui::text("Mute:   "), m_mutedCheckbox->Render()}),
             });
     });
@@ -365,6 +413,30 @@ void FTXUIAudioDeviceObserver::onPeakSample
     m_updateScreenFunc();
 }
 
+void FTXUIAudioDeviceObserver::onChannelVolumesChange
+(
+    std::vector<float> channelVolumes
+)
+{
+    {
+        LOCK_GUARD(m_mutex);
+        m_channelVolumes = std::move(channelVolumes);
+    }
+    m_updateScreenFunc();
+}
+
+void FTXUIAudioDeviceObserver::onLoudnessSample
+(
+    vmx::Loudness loudness
+)
+{
+    {
+        LOCK_GUARD(m_mutex);
+        m_loudness = loudness;
+    }
+    m_updateScreenFunc();
+}
+
 void FTXUIAudioDeviceObserver::onAudioSessionAdded
 (
     const std::string &audioSessionId, std::weak_ptr<vmx::AudioSession> pAudioSession
@@ -10,6 +10,7 @@
 #include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 /* ==== Open Source Includes =============================================== */
 #include <ftxui/component/screen_interactive.hpp>
@@ -27,8 +28,10 @@ public: /* Virtual Methods */
     virtual void onIconPathChange(std::string iconPath) override;
     virtual void onStateChange(vmx::AudioSession::State state) override;
     virtual void onVolumeChange(float volume) override;
+    virtual void onChannelVolumesChange(std::vector<float> channelVolumes) override;
     virtual void onMuteChange(bool bMuted) override;
     virtual void onPeakSample(float peak) override;
+    virtual void onLoudnessSample(vmx::Loudness loudness) override;
 
 private:
     std::recursive_mutex m_mutex;
@@ -44,8 +47,10 @@ private:
     vmx::AudioSession::State m_state;
     float m_volume;
     float m_volumeControl;
+    std::vector<float> m_channelVolumes;
     bool m_bMuted;
     float m_peak;
+    vmx::Loudness m_loudness;
 };
 
 class FTXUIAudioDeviceObserver : public vmx::AudioDevice::Observer
@@ -63,8 +68,10 @@ public: /* Virtual Methods */
     virtual void onStateChange(vmx::AudioDevice::State state) override;
     virtual void onDefaultChange(bool bIsDefaultDevice) override;
     virtual void onVolumeChange(float volume) override;
+    virtual void onChannelVolumesChange(std::vector<float> channelVolumes) override;
     virtual void onMuteChange(bool bMuted) override;
     virtual void onPeakSample(float peak) override;
+    virtual void onLoudnessSample(vmx::Loudness loudness) override;
     virtual void onAudioSessionAdded(const std::string &audioSessionId, std::weak_ptr<vmx::AudioSession> pAudioSession) override;
     virtual void onAudioSessionRemoved(const std::string &audioSessionId) override;
 
@@ -85,8 +92,10 @@ private:
     bool m_bIsDefaultDevice = false;
     float m_volume = 0.f;
     float m_volumeControl = 0.f;
+    std::vector<float> m_channelVolumes;
     bool m_bMuted = false;
     float m_peak = 0.f;
+    vmx::Loudness m_loudness;
 };
 
 class FTXUIVolumeMixerObserver : public vmx::VolumeMixer::Observer
@@ -2,11 +2,12 @@
 #include "FTXUIVolumeMixerObserver.h"
 
 /* ==== VMX Includes ======================================================= */
-#include <vmx/WindowsVolumeMixer.h>
+#include <vmx/VolumeMixer.h>
 
 /* ==== Standard Library Includes ========================================== */
 #include <chrono>
 #include <memory>
+#include <string>
 using namespace std::chrono_literals;
 
 /* ==== Open Source Includes =============================================== */
@@ -24,16 +25,18 @@ throwableMain
 {
     CLI::App app{"VolumeMixer v1.0"};
     unsigned int peakSamplingPeriodMillis = 125;
+    std::string backendName = "";
 
     app.add_option("-p,--peakSamplingPeriod", peakSamplingPeriodMillis, "Sampling period for peak meters in milliseconds; 0 indicates no sampling");
+    app.add_option("-b,--backend", backendName, "Volume mixer backend; empty picks the first one with a reachable audio server");
 
     CLI11_PARSE(app, argc, argv);
 
     auto screen = ftxui::ScreenInteractive::Fullscreen();
     auto obs = std::make_shared<FTXUIVolumeMixerObserver>(screen);
-    vmx::WindowsVolumeMixer mixer{};
-    mixer.addObserver(obs, true);
-    mixer.setPeakSamplingPeriod(std::chrono::milliseconds(peakSamplingPeriodMillis));
+    auto pMixer = vmx::VolumeMixer::create(backendName);
+    pMixer->addObserver(obs, true);
+    pMixer->setPeakSamplingPeriod(std::chrono::milliseconds(peakSamplingPeriodMillis));
     screen.Loop(obs->getRenderer());
 
     return EXIT_SUCCESS;
@@ -0,0 +1,62 @@
+#pragma once
+
+/* ==== Application Includes =============================================== */
+#include <vmx/SpscRing.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace vmx
+{
+
+/* ==== Classes ============================================================ */
+// A stream of the audio a session or device plays, as interleaved float32
+// frames after volume and mute. The backend's audio thread writes into an
+// SpscRing and the one consumer thread reads views straight into that ring, so
+// nothing is copied or allocated per block on either side. When the consumer
+// falls behind, frames that do not fit are dropped and counted rather than
+// blocking the audio thread.
+//
+// Open a tap with AudioSession::openAudioTap() or AudioDevice::openAudioTap().
+// The backend closes it when the session or device goes away; the consumer
+// closes it (or just drops it) when done.
+class AudioTap
+{
+public: /* Methods */
+    AudioTap(unsigned int sampleRate, std::size_t channelCount, std::chrono::milliseconds bufferLength);
+    AudioTap(const AudioTap&) = delete;
+    AudioTap& operator=(const AudioTap&) = delete;
+
+    unsigned int sampleRate() const { return m_sampleRate; };
+    std::size_t channelCount() const { return m_channelCount; };
+
+    // Consumer only: the frames ready to read, a whole number of interleaved
+    // frames. The view stays valid until consume(); after the end of the ring
+    // is consumed, the next call returns the frames from its start.
+    std::span<const float> read();
+    void consume(std::size_t frameCount);
+
+    // Frames the audio thread had to drop because the ring was full
+    std::uint64_t droppedFrames() const { return m_droppedFrames.load(std::memory_order_relaxed); };
+
+    bool isClosed() const { return m_bClosed.load(std::memory_order_acquire); };
+    void close() { m_bClosed.store(true, std::memory_order_release); };
+
+    // Producer only, for backends: copy in planar or interleaved frames and
+    // return how many fit. Never locks, allocates or blocks.
+    std::size_t write(std::span<const float* const> channels, std::size_t frameCount);
+    std::size_t write(const float *pFrames, std::size_t frameCount);
+
+private: /* Members */
+    unsigned int m_sampleRate;
+    std::size_t m_channelCount;
+    SpscRing<float> m_ring;
+    std::atomic<std::uint64_t> m_droppedFrames = 0;
+    std::atomic<bool> m_bClosed = false;
+};
+
+} // namespace vmx
@@ -0,0 +1,163 @@
+#pragma once
+
+/* ==== Standard Library Includes ========================================== */
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * A C API over vmx::VolumeMixer, for bindings from other languages. Devices
+ * and sessions are named by handles rather than shared_ptrs, strings are
+ * copied into caller buffers, and events arrive in batches: one callback
+ * per batch with an array of plain structs, instead of one call per change.
+ * Peak and loudness samples only keep their latest value per handle within
+ * a batch. Only the functions here are part of the ABI; VMX_ABI_VERSION
+ * changes whenever a struct or signature does.
+ *
+ * Every function is thread-safe. Functions returning int return VMX_OK (or
+ * a count) on success and a negative vmx_result on failure, and
+ * vmx_last_error() describes the failure on the calling thread.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==== Constants ========================================================== */
+#define VMX_ABI_VERSION 1
+
+/* ==== Types ============================================================== */
+typedef uint32_t vmx_handle; /* never 0, never reused within a mixer */
+typedef struct vmx_mixer vmx_mixer;
+
+typedef enum vmx_result
+{
+    VMX_OK = 0,
+    VMX_ERROR = -1,             /* the backend failed, see vmx_last_error() */
+    VMX_NOT_FOUND = -2,         /* no device or session with that handle (any more) */
+    VMX_INVALID_ARGUMENT = -3,
+} vmx_result;
+
+/* The same values as vmx::EventKind */
+typedef enum vmx_event_kind
+{
+    VMX_EVENT_NAME,
+    VMX_EVENT_ICON_PATH,
+    VMX_EVENT_STATE,
+    VMX_EVENT_DEFAULT,
+    VMX_EVENT_VOLUME,
+    VMX_EVENT_CHANNEL_VOLUMES,
+    VMX_EVENT_MUTE,
+    VMX_EVENT_PEAK_SAMPLE,
+    VMX_EVENT_LOUDNESS_SAMPLE,
+    VMX_EVENT_SESSION_ADDED,
+    VMX_EVENT_SESSION_REMOVED,
+    VMX_EVENT_DEVICE_ADDED,
+    VMX_EVENT_DEVICE_REMOVED,
+} vmx_event_kind;
+
+typedef enum vmx_string_field
+{
+    VMX_STRING_ID,
+    VMX_STRING_NAME,
+    VMX_STRING_ICON_PATH,
+} vmx_string_field;
+
+/* A device or session as the mixer last reported it. state is an
+ * AudioDevice::State or AudioSession::State, loudness is in LUFS and
+ * -INFINITY for silence. */
+typedef struct vmx_object
+{
+    vmx_handle handle;
+    vmx_handle parent;          /* the device of a session, 0 for a device */
+    uint64_t version;           /* seq of the object's last event */
+    uint8_t is_session;
+    uint8_t state;
+    uint8_t is_default;
+    uint8_t is_muted;
+    uint32_t channel_count;
+    float volume;
+    float peak;
+    float loudness_momentary;
+    float loudness_short_term;
+    float loudness_integrated;
+} vmx_object;
+
+/* One change. The scalar fields hold the values as of this event; names,
+ * icon paths, IDs and channel volumes are read with vmx_mixer_get_string()
+ * and vmx_mixer_get_channel_volumes(), which return the current ones. */
+typedef struct vmx_event
+{
+    uint64_t seq;               /* consecutive across batches */
+    vmx_handle handle;
+    vmx_handle parent;
+    uint32_t kind;              /* vmx_event_kind */
+    uint8_t is_session;
+    uint8_t state;
+    uint8_t is_default;
+    uint8_t is_muted;
+    float volume;
+    float peak;
+    float loudness_momentary;
+    float loudness_short_term;
+    float loudness_integrated;
+} vmx_event;
+
+/* Meters of every device and session, in arrays the mixer owns and updates
+ * in place once per event batch, so a binding can view them without
+ * copying. Slot i belongs to handles[i], 0 marks a free slot; devices and
+ * sessions beyond capacity have no slot. *seq is odd while a batch is being
+ * written, a copy made between two equal even values is consistent. The
+ * pointers are valid until the mixer is destroyed. */
+typedef struct vmx_meters
+{
+    const uint64_t *seq;
+    uint32_t capacity;
+    uint32_t reserved;
+    const vmx_handle *handles;
+    const float *peaks;
+    const float *loudness_momentary;
+    const float *loudness_short_term;
+    const float *loudness_integrated;
+} vmx_meters;
+
+/* Runs on a thread of the mixer's, one batch at a time. events is only
+ * valid during the call. Must not destroy the mixer. */
+typedef void (*vmx_event_callback)(void *user_data, const vmx_event *events, size_t count);
+
+/* ==== Functions ========================================================== */
+uint32_t vmx_abi_version(void);
+
+/* The last failure on this thread, "" if there was none. Valid until the
+ * next vmx call on this thread. */
+const char *vmx_last_error(void);
+
+/* backend_name as for VolumeMixer::create(), NULL or "" picks one. The first
+ * batch has DEVICE_ADDED and SESSION_ADDED for the whole tree. callback may
+ * be NULL. Returns NULL on failure. */
+vmx_mixer *vmx_mixer_create(const char *backend_name, vmx_event_callback callback, void *user_data);
+/* No callback runs after this returns */
+void vmx_mixer_destroy(vmx_mixer *mixer);
+
+int vmx_mixer_set_peak_sampling_period(vmx_mixer *mixer, uint32_t period_ms);
+int vmx_mixer_set_loudness_sampling_period(vmx_mixer *mixer, uint32_t period_ms);
+
+/* Fills up to capacity handles, devices before their sessions, and returns
+ * how many there are in total */
+int vmx_mixer_list(vmx_mixer *mixer, vmx_handle *handles, size_t capacity);
+int vmx_mixer_get_object(vmx_mixer *mixer, vmx_handle handle, vmx_object *object);
+/* Copies as much as fits, always NUL terminated when size > 0, and returns
+ * the full length without the NUL, like snprintf() */
+int vmx_mixer_get_string(vmx_mixer *mixer, vmx_handle handle, vmx_string_field field, char *buffer, size_t size);
+/* Fills up to capacity volumes and returns the channel count */
+int vmx_mixer_get_channel_volumes(vmx_mixer *mixer, vmx_handle handle, float *volumes, size_t capacity);
+
+int vmx_mixer_get_meters(vmx_mixer *mixer, vmx_meters *meters);
+
+/* The outcome arrives as events like any other change */
+int vmx_mixer_set_volume(vmx_mixer *mixer, vmx_handle handle, float volume);
+int vmx_mixer_set_mute(vmx_mixer *mixer, vmx_handle handle, int mute);
+int vmx_mixer_set_channel_volumes(vmx_mixer *mixer, vmx_handle handle, const float *volumes, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
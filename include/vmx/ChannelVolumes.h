@@ -0,0 +1,38 @@
+#pragma once
+
+/* ==== Standard Library Includes ========================================== */
+#include <cstddef>
+#include <span>
+
+namespace vmx
+{
+
+/* ==== Classes ============================================================ */
+// Helpers over the channel volumes of a session or device: one value per
+// channel, on the same scale as its volume, where the volume is the loudest
+// channel. Each helper works on the whole array at once, so a balance change
+// on a 7.1 device is one changeChannelVolumes() call and one notification,
+// not eight. Balance follows the 1.0 to 7.1 layouts in WAVE order (FL FR FC
+// LFE BL BR SL SR); centre channels and the LFE are never attenuated, and
+// other channel counts are taken as alternating left and right.
+class ChannelVolumes
+{
+public: /* Methods */
+    // The loudest channel, 0.0 for none
+    static float volume(std::span<const float> channelVolumes);
+
+    // Scales every channel so the loudest one is volume, keeping the balance
+    static void setVolume(std::span<float> channelVolumes, float volume);
+
+    // -1.0 when only the left side plays, 1.0 when only the right side does
+    static float balance(std::span<const float> channelVolumes);
+
+    // Attenuates the side away from balance, leaving the volume, centre channels,
+    // the LFE and the trim between the channels of each side as they were
+    static void setBalance(std::span<float> channelVolumes, float balance);
+
+    // -1 for a left channel, 1 for a right one, 0 for centre channels and the LFE
+    static int side(std::size_t channel, std::size_t channelCount);
+};
+
+} // namespace vmx
@@ -0,0 +1,74 @@
+#pragma once
+
+/* ==== Application Includes =============================================== */
+#include <vmx/MixerObject.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace vmx
+{
+
+/* ==== Constants ========================================================== */
+constexpr std::uint16_t kControlProtocolVersion = 1;
+
+// $XDG_RUNTIME_DIR/vmxd.sock, or /tmp/vmxd-<uid>.sock without it
+std::string defaultControlSocketPath();
+
+/* ==== Classes ============================================================ */
+namespace detail { class FrameBuffer; }
+
+// A connection to vmxd (see ControlServer). The client keeps a mirror of the
+// daemon's devices and sessions, each stamped with the sequence number of its
+// last change, and the version of the whole mirror. poll() reads whatever the
+// daemon sent, applies it and returns the events; a gap in the sequence
+// numbers makes the client ask for a fresh snapshot, so the mirror never
+// silently diverges. Devices and sessions are named by handles, which the
+// daemon never reuses. Use a client from one thread at a time; fd() can go
+// into the caller's own poll loop.
+class ControlClient
+{
+public: /* Types */
+    using Object = MixerObject;
+    using Event = MixerEvent;
+
+public: /* Methods */
+    // Connects and waits for the daemon's first snapshot; throws std::runtime_error
+    explicit ControlClient(const std::string &socketPath = defaultControlSocketPath());
+    ~ControlClient();
+    ControlClient(const ControlClient&) = delete;
+    ControlClient& operator=(const ControlClient&) = delete;
+
+    int fd() const { return m_fd; };
+    std::uint64_t version() const { return m_version; };
+    const std::map<std::uint32_t, Object> &objects() const { return m_objects; };
+
+    // Waits up to timeout for the daemon, then applies everything that arrived.
+    // A snapshot shows up as no events and a new version(). Throws when the
+    // daemon hangs up or reports an error.
+    std::vector<Event> poll(std::chrono::milliseconds timeout);
+
+    // Fire and forget; the outcome arrives as events like any other change
+    void changeVolume(std::uint32_t handle, float volume);
+    void changeMute(std::uint32_t handle, bool bMute);
+    void changeChannelVolumes(std::uint32_t handle, const std::vector<float> &channelVolumes);
+
+private: /* Methods */
+    void send(const std::vector<std::uint8_t> &frame);
+    bool receive(std::chrono::milliseconds timeout);
+    void apply(const std::vector<std::uint8_t> &body, std::vector<Event> &events);
+
+private: /* Members */
+    int m_fd = -1;
+    std::unique_ptr<detail::FrameBuffer> m_pFrameBuffer;
+    std::uint64_t m_version = 0;
+    bool m_bResyncing = false;
+    std::map<std::uint32_t, Object> m_objects;
+};
+
+} // namespace vmx
@@ -0,0 +1,76 @@
+#pragma once
+
+/* ==== Application Includes =============================================== */
+#include <vmx/ControlClient.h>
+#include <vmx/MeterSegment.h>
+#include <vmx/VolumeMixer.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vmx
+{
+
+/* ==== Classes ============================================================ */
+namespace detail { class ObjectTable; }
+
+// Serves one VolumeMixer to any number of local ControlClients over a Unix
+// domain socket, which is all vmxd is. The server observes the whole tree
+// once and hands each device and session a handle; changes are stamped with
+// a sequence number and collected until the serving thread wakes, which it
+// does once per batch rather than once per change. Each wakeup sends every
+// client one EventBatch frame, where peak and loudness samples only carry
+// the latest value per handle. A client that stops reading has its backlog
+// dropped past kMaxBacklog and gets a fresh snapshot instead, and is not read
+// from until it catches up. Commands from clients run on the serving thread,
+// at most kMaxReceive bytes of them per client and wakeup, so one client
+// writing nonstop cannot starve the others. The mixer has to outlive the server.
+// Given a meter segment name, the serving thread also publishes every peak
+// into a MeterSegmentWriter once per batch, under the same handles.
+class ControlServer
+{
+public: /* Constants */
+    static constexpr std::size_t kMaxBacklog = 4 * 1024 * 1024;
+    static constexpr std::size_t kMaxReceive = 64 * 1024;
+
+public: /* Methods */
+    // Throws std::runtime_error when the socket cannot be bound, another server
+    // already owns it, or the meter segment cannot be created. An empty
+    // meterSegmentName publishes no segment.
+    explicit ControlServer(VolumeMixer &volumeMixer, const std::string &socketPath = defaultControlSocketPath(), const std::string &meterSegmentName = "");
+    ~ControlServer();
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    std::size_t clientCount() const { return m_clientCount.load(std::memory_order_relaxed); };
+
+private: /* Types */
+    struct Connection;
+
+private: /* Methods */
+    void serve(std::stop_token stopToken);
+    void accept(std::vector<Connection> &connections);
+    bool receive(Connection &connection);
+    void handle(Connection &connection, const std::vector<std::uint8_t> &body);
+    void sendSnapshot(Connection &connection);
+    void broadcast(std::vector<Connection> &connections);
+    bool flush(Connection &connection);
+
+private: /* Members */
+    VolumeMixer &m_volumeMixer;
+    std::string m_socketPath = "";
+    int m_listenFd = -1;
+    int m_wakeFds[2] = {-1, -1};
+    std::unique_ptr<MeterSegmentWriter> m_pMeterSegment;
+    std::shared_ptr<detail::ObjectTable> m_pObjectTable;
+    std::atomic<std::size_t> m_clientCount = 0;
+    std::jthread m_thread; // last, so it starts after and joins before the members it uses
+};
+
+} // namespace vmx
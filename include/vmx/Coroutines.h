@@ -0,0 +1,122 @@
+#pragma once
+
+/* ==== Standard Library Includes ========================================== */
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace vmx
+{
+
+/* ==== Helper Classes ===================================================== */
+// The return type of a coroutine that starts right away and frees itself when
+// it finishes, for controllers nobody waits on. An exception escaping it
+// terminates, as it would from a thread.
+class DetachedTask
+{
+public:
+    struct promise_type
+    {
+        DetachedTask get_return_object() noexcept { return {}; };
+        std::suspend_never initial_suspend() noexcept { return {}; };
+        std::suspend_never final_suspend() noexcept { return {}; };
+        void return_void() noexcept {};
+        void unhandled_exception() noexcept { std::terminate(); };
+    };
+};
+
+// A coroutine that co_yields values and may co_await in between. The consumer
+// pulls with `while (auto value = co_await generator.next())`, which resumes
+// the body until its next co_yield (or its end, giving std::nullopt) and
+// rethrows what the body threw. The body starts on the first next() and runs
+// on whatever thread resumes it; one next() at a time.
+template <class T>
+class AsyncGenerator
+{
+public:
+    struct promise_type
+    {
+        std::optional<T> value;
+        std::coroutine_handle<> consumer;
+        std::exception_ptr pException;
+
+        // Hands control straight back to whoever is awaiting next()
+        struct ToConsumer
+        {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> coroutine) noexcept
+            {
+                return coroutine.promise().consumer;
+            }
+            void await_resume() noexcept {}
+        };
+
+        AsyncGenerator get_return_object() noexcept
+        {
+            return AsyncGenerator(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; };
+        ToConsumer final_suspend() noexcept { return {}; };
+        ToConsumer yield_value(T yielded)
+        {
+            value = std::move(yielded);
+            return {};
+        }
+        void return_void() noexcept {};
+        void unhandled_exception() noexcept { pException = std::current_exception(); };
+    };
+
+    class NextAwaiter
+    {
+    public:
+        explicit NextAwaiter(std::coroutine_handle<promise_type> coroutine) : m_coroutine(coroutine) {};
+
+        bool await_ready() const noexcept { return !m_coroutine || m_coroutine.done(); }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> consumer) noexcept
+        {
+            m_coroutine.promise().consumer = consumer;
+            m_coroutine.promise().value.reset();
+            return m_coroutine;
+        }
+        std::optional<T> await_resume()
+        {
+            if (!m_coroutine) return std::nullopt;
+            if (auto pException = std::exchange(m_coroutine.promise().pException, nullptr))
+            {
+                std::rethrow_exception(pException);
+            }
+            return std::exchange(m_coroutine.promise().value, std::nullopt);
+        }
+
+    private:
+        std::coroutine_handle<promise_type> m_coroutine;
+    };
+
+public:
+    AsyncGenerator(AsyncGenerator &&other) noexcept : m_coroutine(std::exchange(other.m_coroutine, nullptr)) {};
+    AsyncGenerator& operator=(AsyncGenerator &&other) noexcept
+    {
+        if (this != &other)
+        {
+            if (m_coroutine) m_coroutine.destroy();
+            m_coroutine = std::exchange(other.m_coroutine, nullptr);
+        }
+        return *this;
+    }
+    ~AsyncGenerator()
+    {
+        if (m_coroutine) m_coroutine.destroy();
+    }
+
+    // Must not be destroyed while a next() is pending
+    NextAwaiter next() { return NextAwaiter(m_coroutine); };
+
+private:
+    explicit AsyncGenerator(std::coroutine_handle<promise_type> coroutine) : m_coroutine(coroutine) {};
+
+private:
+    std::coroutine_handle<promise_type> m_coroutine;
+};
+
+} // namespace vmx
@@ -0,0 +1,95 @@
+#pragma once
+
+/* ==== Application Includes =============================================== */
+#include <vmx/Coroutines.h>
+#include <vmx/MixerObject.h>
+#include <vmx/VolumeMixer.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <coroutine>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace vmx
+{
+
+/* ==== Classes ============================================================ */
+namespace detail { class ObjectTable; }
+
+// The changes of one VolumeMixer for coroutines, so a controller (ducking,
+// auto-mute) can be a loop instead of observer classes. `co_await
+// nextEvents()` suspends until something changed and returns everything that
+// did as one batch, the first one being DeviceAdded and SessionAdded for the
+// whole tree; events() narrows that to one device or session. Devices and
+// sessions are named by handles, as in ControlClient. Meter samples only keep
+// their latest value per handle within a batch.
+//
+// A waiting coroutine is resumed once per batch, through the executor, by the
+// thread that made the batch's first change, once that holds no vmx lock.
+// The stream observes the tree synchronously whatever the dispatch mode, so
+// no thread is started per change. The default executor resumes it right
+// there, where it must not block, as with synchronous observers; pass one
+// that posts to an event loop or a pool to keep the controller on it. A
+// stream has one consumer: two coroutines waiting on it would split the
+// batches between them, so give each controller its own.
+class EventStream
+{
+public: /* Types */
+    // Runs the function, now or later, on a thread of its choice
+    using Executor = std::function<void(std::function<void()>)>;
+
+    class BatchAwaiter
+    {
+    public:
+        explicit BatchAwaiter(EventStream &eventStream) : m_eventStream(eventStream) {};
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> coroutine) { return m_eventStream.suspend(coroutine, m_batch); }
+        std::vector<MixerChange> await_resume() noexcept { return std::move(m_batch); }
+
+    private:
+        EventStream &m_eventStream;
+        std::vector<MixerChange> m_batch;
+    };
+
+public: /* Methods */
+    explicit EventStream(VolumeMixer &volumeMixer, Executor executor = {});
+    // A coroutine still waiting gets an empty batch through the executor, and
+    // must not touch the stream after that
+    ~EventStream();
+    EventStream(const EventStream&) = delete;
+    EventStream& operator=(const EventStream&) = delete;
+
+    // An empty batch means the stream is going away
+    BatchAwaiter nextEvents() { return BatchAwaiter(*this); };
+    // The changes of a session, or of a device and its sessions; ends after
+    // the handle's own removal, or with the stream
+    AsyncGenerator<MixerChange> events(std::uint32_t handle);
+
+    // 0 when there is no such device, or no such session on it
+    std::uint32_t findHandle(const std::string &audioDeviceId, const std::string &audioSessionId = "") const;
+    bool find(std::uint32_t handle, MixerObject &object) const;
+    std::vector<MixerObject> objects() const;
+    std::shared_ptr<AudioDevice> device(std::uint32_t handle) const;
+    std::shared_ptr<AudioSession> session(std::uint32_t handle) const;
+
+private: /* Methods */
+    // false (don't suspend) when batch could be filled right away
+    bool suspend(std::coroutine_handle<> coroutine, std::vector<MixerChange> &batch);
+    void wake();
+
+private: /* Members */
+    VolumeMixer &m_volumeMixer;
+    Executor m_executor;
+    std::mutex m_mutex;
+    bool m_bClosed = false;
+    std::coroutine_handle<> m_waiter;
+    std::vector<MixerChange> *m_pWaiterBatch = nullptr;
+    std::shared_ptr<detail::ObjectTable> m_pObjectTable;
+};
+
+} // namespace vmx
@@ -0,0 +1,69 @@
+#pragma once
+
+/* ==== Standard Library Includes ========================================== */
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <span>
+
+namespace vmx
+{
+
+/* ==== Types ============================================================== */
+namespace detail
+{
+// Scales interleaved samples by a linear ramp, see MixKernels.h; pOut and pBus may each be null
+using GainKernel = void (*)(const float *pIn, float *pOut, float *pBus, std::size_t channelCount,
+                            std::size_t frameCount, float gain, float step);
+} // namespace detail
+
+/* ==== Classes ============================================================ */
+// The fader of one stream in a software mix. setTarget() may be called from
+// any thread; the render thread then moves the applied gain to the new target
+// along a linear ramp of rampFrames() frames, which carries on across render
+// calls, so the ramp does not depend on the period size. process() scales a
+// stream into its output, adds it to a bus, or both in one pass; summing every
+// session of a device into the device's bus and then running the device's own
+// ramp over the bus in place is the whole mix. Render calls never lock or
+// allocate; of the backends using them, only JACK's process callback is lock
+// and allocation free as a whole (the simulated backend renders under its
+// mixer, device and session mutexes). The kernels use AVX2 and FMA when
+// PcmMeter::isa() is AVX2 or better, and SSE2 otherwise.
+class GainRamp
+{
+public: /* Constants */
+    static constexpr std::size_t kMaxChannels = 64;
+    static constexpr std::chrono::microseconds kDefaultRampLength{5000};
+
+public: /* Methods */
+    explicit GainRamp(unsigned int sampleRate, float gain = 1.0f, std::chrono::microseconds rampLength = kDefaultRampLength);
+
+    // Any thread
+    void setTarget(float gain) { m_target.store(gain, std::memory_order_relaxed); };
+    float target() const { return m_target.load(std::memory_order_relaxed); };
+    std::size_t rampFrames() const { return m_rampFrames; };
+
+    // Render thread only. pOut may be pIn; a null pOut or pBus skips it.
+    void process(const float *pIn, float *pOut, float *pBus, std::size_t channelCount, std::size_t frameCount);
+
+    // One plane per channel, the same ramp on each; outputs or bus may be empty
+    void processPlanar(std::span<const float* const> inputs, std::span<float* const> outputs, std::span<float* const> bus, std::size_t frameCount);
+
+    // Applies gain straight away, with no ramp. Render thread, or while nothing renders.
+    void reset(float gain);
+
+private: /* Methods */
+    template <class Apply>
+    void advance(std::size_t frameCount, const Apply &apply);
+
+private: /* Members */
+    std::atomic<float> m_target;
+    std::size_t m_rampFrames;
+    detail::GainKernel m_pKernel;
+    float m_gain;               // render thread only, like the rest
+    float m_rampTarget;
+    float m_step = 0.0f;
+    std::size_t m_framesLeft = 0;
+};
+
+} // namespace vmx
@@ -0,0 +1,211 @@
+#pragma once
+
+/* ==== Application Includes =============================================== */
+#include <vmx/GainRamp.h>
+#include <vmx/ServiceExecutor.h>
+#include <vmx/SpscRing.h>
+#include <vmx/VolumeMixer.h>
+#include <vmx/TimerService.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/* ==== Operating System Includes ========================================== */
+#include <jack/jack.h>
+
+namespace vmx
+{
+
+/* ==== Volume Mixer Classes =============================================== */
+class JackVolumeMixer;
+
+class JackAudioSession : public AudioSession
+{
+public: /* Friends */
+    friend class JackAudioDevice;
+    friend class JackVolumeMixer;
+
+public: /* Methods */
+    JackAudioSession(JackVolumeMixer &volumeMixer, std::size_t slot, const std::string &clientName);
+    std::string getId() const { return m_id; };
+
+public: /* Virtual Methods */
+    virtual ~JackAudioSession() = default;
+    virtual void changeVolume(float volume) override;
+    virtual void changeMute(bool bMute) override;
+    virtual void changeChannelVolumes(std::vector<float> channelVolumes) override;
+    virtual std::shared_ptr<AudioTap> openAudioTap(std::chrono::milliseconds bufferLength) override;
+
+private: /* Methods */
+    void addChannel();
+    void storeChannelGains();
+
+private: /* Members */
+    std::recursive_mutex m_mutex;
+    JackVolumeMixer &m_volumeMixer;
+    std::size_t m_slot;
+    bool m_bExpired = false; // the slot may already belong to another client
+    std::vector<float> m_channelVolumes;
+    std::string m_id = "";
+};
+
+class JackAudioDevice : public AudioDevice
+{
+public: /* Friends */
+    friend class JackVolumeMixer;
+
+public: /* Methods */
+    JackAudioDevice(JackVolumeMixer &volumeMixer, const std::string &serverName, std::size_t channelCount);
+    std::string getId() const { return m_id; };
+
+public: /* Virtual Methods */
+    virtual ~JackAudioDevice() = default;
+    virtual void changeVolume(float volume) override;
+    virtual void changeMute(bool bMute) override;
+    virtual void changeChannelVolumes(std::vector<float> channelVolumes) override;
+    virtual std::shared_ptr<AudioTap> openAudioTap(std::chrono::milliseconds bufferLength) override;
+
+private: /* Methods */
+    void attachSession(std::shared_ptr<JackAudioSession> pJackAudioSession);
+    void detachSession(const std::string &audioSessionId);
+    void storeChannelGains();
+
+private: /* Members */
+    std::recursive_mutex m_mutex;
+    JackVolumeMixer &m_volumeMixer;
+    std::vector<float> m_channelVolumes;
+    std::map<std::string /* AudioSessionId */, std::shared_ptr<JackAudioSession>> m_audioSessionsMirror;
+    std::string m_id = "";
+};
+
+// The JACK server is the one device and every client feeding the physical
+// playback ports is a session. vmx owns a client that is patched in between
+// each session's output ports and the playback ports it was connected to, so
+// gain is applied (through a GainRamp, so changes are click free) and peaks and
+// loudness are measured inside the process callback. That callback never locks
+// or allocates: control values reach it through atomics and measurements leave
+// it through SpscRings that the sampling timers drain. Audio taps are written
+// straight from the callback too, sessions after their gain and the device from
+// the mix of all sessions, up to kMaxTaps of each. Volumes use a cubic taper.
+// JACK ports carry no channel layout, so loudness weighs every channel 1.0 and
+// channel volumes go by port order: a session's channel n is its nth output
+// port, and the device's channel n is the nth physical playback port, which
+// gets the nth channel of every session.
+class JackVolumeMixer : public VolumeMixer
+{
+public: /* Friends */
+    friend class JackAudioSession;
+    friend class JackAudioDevice;
+
+public: /* Constants */
+    static constexpr std::size_t kMaxSessions = 64;
+    static constexpr std::size_t kMaxChannels = 8;
+    static constexpr std::size_t kMaxTaps = 4;
+
+public: /* Methods */
+    // An empty serverName uses $JACK_DEFAULT_SERVER, then "default"; a server is never started
+    explicit JackVolumeMixer(const std::string &serverName = "");
+
+public: /* Virtual Methods */
+    virtual ~JackVolumeMixer();
+    virtual void setPeakSamplingPeriod(std::chrono::milliseconds period) override;
+    virtual void setLoudnessSamplingPeriod(std::chrono::milliseconds period) override;
+
+private: /* Constants */
+    static constexpr std::size_t kMaxMixFrames = 8192; // larger periods skip device loudness and taps
+
+private: /* Types */
+    using AudioTaps = std::array<std::atomic<AudioTap*>, kMaxTaps>;
+
+    // Shared with the process callback
+    struct Slot
+    {
+        std::atomic<bool> bActive = false;
+        std::atomic<std::uint32_t> channelCount = 0;
+        std::array<std::atomic<float>, kMaxChannels> gains = {};
+        std::atomic<bool> bMuted = false;
+        std::array<jack_port_t*, kMaxChannels> inputs = {};
+        std::array<jack_port_t*, kMaxChannels> outputs = {};
+        std::array<std::unique_ptr<GainRamp>, kMaxChannels> gainRamps; // replaced by the graph thread above channelCount
+        std::unique_ptr<LoudnessMeter> pLoudnessMeter;                 // replaced by the graph thread while inactive
+        AudioTaps audioTaps = {};
+    };
+
+    // The original patching, so it can be restored; graph work thread only
+    struct Route
+    {
+        bool bRetired = false; // the process callback may still use the slot, see patchOut()
+        std::string clientName = "";
+        std::vector<std::string> sources;
+        std::vector<std::vector<std::string>> destinations;
+    };
+
+    struct Peak
+    {
+        std::uint32_t slot;
+        float peak;
+    };
+
+    struct SlotLoudness
+    {
+        std::uint32_t slot;
+        Loudness loudness;
+    };
+
+private: /* Methods */
+    static int processCallback(jack_nframes_t nFrames, void *pUserData);
+    static void clientRegistrationCallback(const char *name, int bRegistered, void *pUserData);
+    static void portConnectCallback(jack_port_id_t portA, jack_port_id_t portB, int bConnected, void *pUserData);
+    static void shutdownCallback(void *pUserData);
+    int process(jack_nframes_t nFrames);
+    void queueRescan();
+    void rescan();
+    void patchIn(const std::string &clientName, const std::string &sourcePort, const std::vector<std::string> &destinations);
+    void patchOut(std::size_t slot, bool bRestoreRouting);
+    bool waitForProcessCycles();
+    std::shared_ptr<AudioTap> openAudioTap(std::size_t slotIndex, const JackAudioSession *pJackAudioSession, std::chrono::milliseconds bufferLength);
+    AudioTaps& audioTapsOf(std::size_t slotIndex);
+    void pruneAudioTaps(std::size_t slotIndex);
+    void closeAudioTaps(std::size_t slotIndex);
+    void peakSample();
+    void loudnessSample();
+
+private: /* Members */
+    std::mutex m_mutex;
+    jack_client_t *m_pClient = nullptr;
+    std::string m_clientName = "";
+    std::atomic<bool> m_bServerGone = false;
+
+    // Shared with the process callback
+    std::unique_ptr<Slot[]> m_pSlots;
+    std::array<std::atomic<float>, kMaxChannels> m_masterGains = {};
+    std::atomic<bool> m_bMasterMuted = false;
+    std::atomic<bool> m_bMetering = false;
+    std::atomic<bool> m_bLoudnessMetering = false;
+    std::atomic<std::uint64_t> m_processCycles = 0;
+    SpscRing<Peak> m_peakRing;
+    SpscRing<SlotLoudness> m_loudnessRing;
+    std::unique_ptr<LoudnessMeter> m_pDeviceLoudnessMeter;  // process callback only, once active
+    std::vector<float> m_mix;                               // kMaxChannels planes of kMaxMixFrames, likewise
+    AudioTaps m_deviceAudioTaps = {};
+
+    std::array<Route, kMaxSessions> m_routes;
+    std::array<std::shared_ptr<JackAudioSession>, kMaxSessions> m_sessions;
+    std::array<std::array<std::shared_ptr<AudioTap>, kMaxTaps>, kMaxSessions + 1> m_audioTapOwners; // last is the device
+    std::array<float, kMaxSessions + 1> m_peakAccumulators = {}; // peak sampling timer only, last is the device
+    std::shared_ptr<JackAudioDevice> m_pAudioDevice;
+    std::atomic<bool> m_bRescanQueued = false;
+    ServiceExecutor m_serviceExecutor;
+    Strand m_graphStrand;
+    PeriodicTimer m_peakSamplingTimer;
+    PeriodicTimer m_loudnessSamplingTimer;
+};
+
+} // namespace vmx
@@ -0,0 +1,87 @@
+#pragma once
+
+/* ==== Application Includes =============================================== */
+#include <vmx/PcmMeter.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace vmx
+{
+
+/* ==== Types ============================================================== */
+namespace detail
+{
+// Filters one channel pair, see LoudnessKernels.h; pHi is null for a lone last channel
+using KWeightingKernel = void (*)(const double *pShelf, const double *pHighPass, double *pState,
+                                  const float *pLo, const float *pHi, std::size_t stride, std::size_t frameCount);
+} // namespace detail
+
+// EBU R128 loudness in LUFS; -infinity until there is signal to measure
+struct Loudness
+{
+    static constexpr float kSilence = -std::numeric_limits<float>::infinity();
+
+    float momentary = kSilence;     // the last 400 ms
+    float shortTerm = kSilence;     // the last 3 s
+    float integrated = kSilence;    // gated, since the meter started or was reset
+
+    bool operator==(const Loudness&) const = default;
+};
+
+/* ==== Classes ============================================================ */
+// ITU-R BS.1770-4 / EBU R128 loudness of one stream. Samples pass through the
+// two-stage K-weighting filter (double precision, two channels per SSE2
+// vector, FMA when PcmMeter::isa() is AVX2 or better) into 100 ms blocks.
+// Integrated loudness is gated with a 0.1 LU histogram, so memory stays
+// constant however long the meter runs. process() never locks or allocates;
+// a meter is not thread safe, whoever feeds it also reads loudness().
+class LoudnessMeter
+{
+public: /* Methods */
+    // Channel weights follow BS.1770 for 1.0 to 7.1 layouts in WAVE order
+    // (surrounds 1.41, LFE excluded); other counts weigh every channel 1.0.
+    LoudnessMeter(unsigned int sampleRate, std::size_t channelCount);
+    LoudnessMeter(unsigned int sampleRate, std::vector<double> channelWeights);
+
+    // Return how many 100 ms blocks were completed, i.e. whether loudness() moved.
+    // processPlanar() may be given fewer channels than channelCount(), the rest
+    // are taken as silent and cost nothing.
+    std::size_t process(SampleFormat format, const void *pFrames, std::size_t frameCount);
+    std::size_t processPlanar(std::span<const float* const> channels, std::size_t frameCount);
+
+    Loudness loudness() const;
+    void reset();
+    unsigned int sampleRate() const { return m_sampleRate; };
+    std::size_t channelCount() const { return m_channelWeights.size(); };
+
+private: /* Constants */
+    static constexpr std::size_t kShortTermBlocks = 30;
+    static constexpr std::size_t kMomentaryBlocks = 4;
+    static constexpr std::size_t kHistogramBins = 800; // -70 to +10 LUFS
+
+private: /* Methods */
+    std::size_t processFrames(const float *const *ppChannels, std::size_t activeChannelCount, std::size_t stride, std::size_t frameCount);
+    void closeBlock();
+
+private: /* Members */
+    unsigned int m_sampleRate;
+    std::vector<double> m_channelWeights;
+    std::array<double, 5> m_shelf = {};         // b0, b1, b2, a1, a2
+    std::array<double, 2> m_highPass = {};      // a1, a2; b is {1, -2, 1}
+    std::vector<double> m_filterState;          // per channel pair, see LoudnessKernels.h
+    detail::KWeightingKernel m_pKernel;
+    std::size_t m_framesPerBlock;
+    std::size_t m_framesInBlock = 0;
+    std::array<double, kShortTermBlocks> m_blockEnergies = {};
+    std::size_t m_blockCount = 0;
+    std::array<std::uint32_t, kHistogramBins> m_gatingCounts = {};
+    std::array<double, kHistogramBins> m_gatingEnergies = {};
+};
+
+} // namespace vmx
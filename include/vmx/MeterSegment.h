@@ -0,0 +1,138 @@
+#pragma once
+
+/* ==== Standard Library Includes ========================================== */
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace vmx
+{
+
+/* ==== Constants ========================================================== */
+constexpr std::uint16_t kMeterSegmentVersion = 2;
+
+// "/vmx-meters-<uid>", the name vmxd publishes under by default
+std::string defaultMeterSegmentName();
+
+/* ==== Structures ========================================================= */
+// The start of a meter segment. The rest is a struct-of-arrays with capacity
+// slots each, at the byte offsets given here: u32 handles (0 for a free slot),
+// u32 parents, u8 flags (kMeterSlotSession), idLength-byte NUL-padded IDs and
+// f32 peaks. Slots below slotCount may be in use. Everything after seq is
+// guarded by it: odd while the producer writes, and a reader whose copy
+// started and ended on the same even value has a consistent one. Handles
+// match vmxd's, and generation only moves when the slots change, so readers
+// can skip copying IDs most of the time. producerPid is the writer's process,
+// so that a new writer can tell a segment left behind from a live one.
+struct MeterSegmentHeader
+{
+    std::uint32_t magic;
+    std::uint16_t version;
+    std::uint16_t idLength;
+    std::uint32_t capacity;
+    std::uint32_t headerSize;
+    std::uint64_t handlesOffset;
+    std::uint64_t parentsOffset;
+    std::uint64_t flagsOffset;
+    std::uint64_t idsOffset;
+    std::uint64_t peaksOffset;
+    std::uint64_t size;
+    std::uint32_t producerPid;
+    std::uint32_t reserved;
+    std::atomic<std::uint64_t> seq;
+    std::atomic<std::uint64_t> tick;        // publish() count
+    std::atomic<std::uint64_t> generation;  // slot layout changes
+    std::atomic<std::uint32_t> slotCount;
+};
+
+constexpr std::uint32_t kMeterSegmentMagic = 0x4d584d56; // "VMXM"
+constexpr std::uint8_t kMeterSlotSession = 0x01;
+
+/* ==== Classes ============================================================ */
+// The producing side of a meter segment: a POSIX shared-memory object other
+// processes map read-only to draw meters at their own frame rate, with no
+// socket traffic or callbacks. One thread owns a writer; nothing it does
+// waits on readers. Changes land in the segment on publish(), all at once.
+// The segment is unlinked when the writer goes away. A segment already under
+// the name is only replaced when its writer's process is gone.
+class MeterSegmentWriter
+{
+public: /* Constants */
+    static constexpr std::uint32_t kDefaultCapacity = 512;
+    static constexpr std::uint16_t kIdLength = 128; // longer IDs are cut
+
+public: /* Methods */
+    // Throws std::runtime_error when the segment cannot be created, or a live
+    // writer (or one of another version) already has the name
+    explicit MeterSegmentWriter(const std::string &name = defaultMeterSegmentName(), std::uint32_t capacity = kDefaultCapacity);
+    ~MeterSegmentWriter();
+    MeterSegmentWriter(const MeterSegmentWriter&) = delete;
+    MeterSegmentWriter& operator=(const MeterSegmentWriter&) = delete;
+
+    // Returns false when every slot is taken, the handle then just has no meter
+    bool add(std::uint32_t handle, std::uint32_t parent, bool bSession, const std::string &id);
+    void remove(std::uint32_t handle);
+    void setPeak(std::uint32_t handle, float peak);
+    void publish();
+
+private: /* Types */
+    struct Slot
+    {
+        std::uint32_t handle = 0;
+        std::uint32_t parent = 0;
+        std::uint8_t flags = 0;
+        std::string id = "";
+        float peak = 0.0f;
+        bool bDirty = true; // handle, parent, flags or id changed since publish()
+    };
+
+private: /* Members */
+    std::string m_name = "";
+    MeterSegmentHeader *m_pHeader = nullptr;
+    std::vector<Slot> m_slots;
+    std::vector<std::uint32_t> m_freeSlots;
+    std::map<std::uint32_t, std::uint32_t> m_slotIndices; // handle -> slot
+    bool m_bLayoutChanged = false;
+};
+
+// Maps a meter segment read-only. read() never blocks the producer; it just
+// copies again when a publish() overlapped it.
+class MeterSegmentReader
+{
+public: /* Types */
+    struct Meter
+    {
+        std::uint32_t handle = 0;
+        std::uint32_t parent = 0;
+        bool bSession = false;
+        std::string id = "";
+        float peak = 0.0f;
+    };
+
+public: /* Methods */
+    // Throws std::runtime_error when there is no segment, or an incompatible one
+    explicit MeterSegmentReader(const std::string &name = defaultMeterSegmentName());
+    ~MeterSegmentReader();
+    MeterSegmentReader(const MeterSegmentReader&) = delete;
+    MeterSegmentReader& operator=(const MeterSegmentReader&) = delete;
+
+    // A consistent copy of every meter as of the latest publish(); IDs are
+    // only copied again after the slots changed
+    const std::vector<Meter> &read();
+    std::uint64_t tick() const { return m_tick; };
+
+private: /* Members */
+    const MeterSegmentHeader *m_pHeader = nullptr;
+    std::size_t m_size = 0;
+    std::uint64_t m_tick = 0;
+    std::uint64_t m_generation = ~std::uint64_t(0);
+    std::vector<std::uint32_t> m_slots; // slot of each meter
+    std::vector<Meter> m_meters;
+    std::vector<Meter> m_scratch;       // a copy in progress after the slots changed
+    std::vector<float> m_peaks;         // a copy in progress otherwise
+};
+
+} // namespace vmx
@@ -0,0 +1,117 @@
+#pragma once
+
+/* ==== Application Includes =============================================== */
+#include <vmx/Stats.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace vmx
+{
+
+/* ==== Enums ============================================================== */
+enum class ThreadRole
+{
+    ObserverDispatch,   // one per observer call in flight, in Threaded dispatch
+    Timer,              // the TimerService running periodic sampling
+    Service,            // a mixer's ServiceExecutor, for deferred backend work
+    WorkQueue,          // a QueuedWorkThread
+    ControlServer,      // vmxd serving its clients
+    CApiDelivery,       // the C API calling back into its host
+    TraceWriter,        // writing a Trace::start() capture to disk
+};
+
+constexpr std::size_t kThreadRoleCount = static_cast<std::size_t>(ThreadRole::TraceWriter) + 1;
+
+const char *toString(ThreadRole role);
+
+/* ==== Classes ============================================================ */
+class Counter
+{
+public: /* Methods */
+    void add(std::uint64_t n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); };
+    std::uint64_t value() const { return m_value.load(std::memory_order_relaxed); };
+    void reset() { m_value.store(0, std::memory_order_relaxed); };
+
+private: /* Members */
+    std::atomic<std::uint64_t> m_value{0};
+};
+
+class Gauge
+{
+public: /* Methods */
+    void add(std::int64_t n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); };
+    void sub(std::int64_t n = 1) { m_value.fetch_sub(n, std::memory_order_relaxed); };
+    void set(std::int64_t n) { m_value.store(n, std::memory_order_relaxed); };
+    std::int64_t value() const { return m_value.load(std::memory_order_relaxed); };
+
+private: /* Members */
+    std::atomic<std::int64_t> m_value{0};
+};
+
+// Threads vmx has started and not yet finished, by role. Threads of the
+// audio servers' client libraries (the PulseAudio and PipeWire loops, JACK's
+// process thread) are not vmx's and are not counted.
+struct ThreadInventory
+{
+    std::array<std::int64_t, kThreadRoleCount> threads = {};
+
+    std::int64_t operator[](ThreadRole role) const { return threads[static_cast<std::size_t>(role)]; };
+    std::int64_t total() const;
+};
+
+// Counts the calling thread under role while in scope; the first line of
+// every thread vmx starts.
+class ScopedThreadRole
+{
+public: /* Methods */
+    explicit ScopedThreadRole(ThreadRole role);
+    ~ScopedThreadRole();
+    ScopedThreadRole(const ScopedThreadRole&) = delete;
+    ScopedThreadRole& operator=(const ScopedThreadRole&) = delete;
+
+private: /* Members */
+    ThreadRole m_role;
+};
+
+// Process-wide counters and gauges for the notification pipeline. Every member
+// is a relaxed atomic, so reading them never blocks the library and updating
+// them never takes a lock.
+class Metrics
+{
+public: /* Methods */
+    Metrics() = default;
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+    Counter &eventsProduced(EventKind kind) { return m_eventsProduced[static_cast<std::size_t>(kind)]; };
+    const Counter &eventsProduced(EventKind kind) const { return m_eventsProduced[static_cast<std::size_t>(kind)]; };
+    Gauge &threads(ThreadRole role) { return m_threads[static_cast<std::size_t>(role)]; };
+    const Gauge &threads(ThreadRole role) const { return m_threads[static_cast<std::size_t>(role)]; };
+    ThreadInventory threadInventory() const;
+    std::string toPrometheus() const;
+    void writePrometheus(const std::string &path) const;
+    void reset();
+
+public: /* Members */
+    Counter eventsDelivered;        // observer callbacks that ran to completion
+    Counter eventsCoalesced;        // update*() calls that matched the current value
+    Counter eventsDropped;          // deliveries abandoned because a dispatch could not be started
+    Gauge dispatchQueueDepth;       // observer callbacks dispatched but not yet finished
+    Gauge liveObservers;            // observer registrations currently held
+    Counter observersPruned;        // expired weak observers removed from observer lists
+    Counter peakTicks;              // peak sampling ticks executed
+    LatencyHistogram peakTickDuration; // nanoseconds per peak sampling tick
+    Counter timerDeadlinesMissed;   // periodic task ticks skipped because they ran a period or more late
+    Counter backendCalls;           // calls into the platform audio API
+    Counter backendErrors;          // failed calls into the platform audio API
+
+private: /* Members */
+    std::array<Counter, kEventKindCount> m_eventsProduced;
+    std::array<Gauge, kThreadRoleCount> m_threads;
+};
+
+} // namespace vmx
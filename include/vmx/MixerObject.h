@@ -0,0 +1,52 @@
+#pragma once
+
+/* ==== Application Includes =============================================== */
+#include <vmx/LoudnessMeter.h>
+#include <vmx/Stats.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vmx
+{
+
+/* ==== Structures ========================================================= */
+// A device or session under a handle, as the front ends that cannot hand out
+// shared_ptrs mirror it (vmxd's ControlClient, EventStream). Handles start at
+// 1 and are never reused within one mirror.
+struct MixerObject
+{
+    std::uint32_t handle = 0;
+    bool bSession = false;
+    std::uint32_t parent = 0;       // the device of a session, 0 for a device
+    std::uint64_t version = 0;      // sequence number of the last change
+    std::string id = "";
+    std::string name = "";
+    std::string iconPath = "";
+    std::uint8_t state = 0;         // AudioSession::State or AudioDevice::State
+    bool bDefault = false;
+    float volume = 0.0f;
+    std::vector<float> channelVolumes;
+    bool bMuted = false;
+    float peak = 0.0f;
+    Loudness loudness;
+};
+
+struct MixerEvent
+{
+    std::uint64_t seq = 0;
+    std::uint32_t handle = 0;
+    EventKind kind = EventKind::Name;
+};
+
+// An event with the object's scalars as of that event, and the string or
+// array it is about (name, iconPath, channelVolumes, or id when added)
+struct MixerChange
+{
+    MixerEvent event;
+    MixerObject value;
+};
+
+} // namespace vmx
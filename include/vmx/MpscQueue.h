@@ -0,0 +1,85 @@
+#pragma once
+
+/* ==== Standard Library Includes ========================================== */
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace vmx
+{
+
+/* ==== Helper Classes ===================================================== */
+// A lock-free queue with any number of producers and one consumer. push() is
+// a single compare-and-swap onto the head of a linked list; drain() takes the
+// whole list with one exchange and hands it over oldest first, so the
+// consumer touches the shared head once per batch rather than once per item.
+// Nodes are only ever taken all at once, which rules out ABA. Items only need
+// to be movable; each push() allocates a node.
+template <class T>
+class MpscQueue
+{
+public:
+    MpscQueue() = default;
+    ~MpscQueue()
+    {
+        Node *pNode = m_pHead.load(std::memory_order_acquire);
+        while (pNode)
+        {
+            delete std::exchange(pNode, pNode->pNext);
+        }
+    }
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // From any thread. Returns true when the queue was empty, which is when
+    // a sleeping consumer needs waking.
+    bool push(T item)
+    {
+        Node *pNode = new Node{std::move(item), nullptr};
+        Node *pHead = m_pHead.load(std::memory_order_relaxed);
+        do
+        {
+            pNode->pNext = pHead;
+        } while (!m_pHead.compare_exchange_weak(pHead, pNode, std::memory_order_release, std::memory_order_relaxed));
+        return pHead == nullptr;
+    }
+
+    // Consumer only. Appends everything pushed so far to batch in push order
+    // (per producer) and returns how many items that was.
+    std::size_t drain(std::vector<T> &batch)
+    {
+        // The list is newest first
+        Node *pNode = m_pHead.exchange(nullptr, std::memory_order_acquire);
+        Node *pOldest = nullptr;
+        while (pNode)
+        {
+            Node *pNext = pNode->pNext;
+            pNode->pNext = pOldest;
+            pOldest = pNode;
+            pNode = pNext;
+        }
+
+        std::size_t count = 0;
+        while (pOldest)
+        {
+            batch.push_back(std::move(pOldest->item));
+            delete std::exchange(pOldest, pOldest->pNext);
+            ++count;
+        }
+        return count;
+    }
+
+    bool empty() const { return m_pHead.load(std::memory_order_acquire) == nullptr; };
+
+private:
+    struct Node
+    {
+        T item;
+        Node *pNext;
+    };
+
+    std::atomic<Node*> m_pHead{nullptr};
+};
+
+} // namespace vmx
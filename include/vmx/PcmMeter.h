@@ -0,0 +1,62 @@
+#pragma once
+
+/* ==== Standard Library Includes ========================================== */
+#include <cstddef>
+#include <span>
+
+namespace vmx
+{
+
+/* ==== Enums ============================================================== */
+// Int24 is packed little-endian, three bytes per sample
+enum class SampleFormat
+{
+    Float32,
+    Int16,
+    Int24,
+    Int32,
+};
+
+constexpr std::size_t kSampleFormatCount = static_cast<std::size_t>(SampleFormat::Int32) + 1;
+
+/* ==== Classes ============================================================ */
+// Per-channel level kernels over interleaved PCM, for backends that see raw
+// audio and have to produce the value passed to updatePeakSample() themselves.
+// Levels are linear with 1.0 at full scale; the channel count is the size of
+// the output span. The best instruction set the CPU supports (SSE2, AVX2 or
+// AVX-512 on x86, scalar elsewhere) is picked on first use, and each gives
+// the same levels as scalar to the bit. None of the kernels lock or
+// allocate, so they are safe on a realtime audio thread.
+class PcmMeter
+{
+public: /* Enums */
+    enum class Isa
+    {
+        Scalar,
+        Sse2,
+        Avx2,
+        Avx512,
+    };
+
+public: /* Constants */
+    static constexpr std::size_t kMaxChannels = 64;
+
+public: /* Methods */
+    static void peak(SampleFormat format, const void *pFrames, std::size_t frameCount, std::span<float> channelPeaks);
+    static void rms(SampleFormat format, const void *pFrames, std::size_t frameCount, std::span<float> channelRms);
+
+    // 4x oversampled peak using the ITU-R BS.1770-4 interpolation filter.
+    // Inter-sample peaks closer than 11 frames to the start of the buffer are
+    // not seen, the sample peak still is.
+    static void truePeak(SampleFormat format, const void *pFrames, std::size_t frameCount, std::span<float> channelTruePeaks);
+
+    static Isa isa();
+    static bool isSupported(Isa isa);
+
+    // Pins the kernels to an instruction set, mainly to compare against scalar
+    static void setIsa(Isa isa);
+};
+
+const char *toString(PcmMeter::Isa isa);
+
+} // namespace vmx
@@ -0,0 +1,212 @@
+#pragma once
+
+/* ==== Application Includes =============================================== */
+#include <vmx/VolumeMixer.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+/* ==== Operating System Includes ========================================== */
+#include <pipewire/pipewire.h>
+#include <pipewire/extensions/metadata.h>
+
+namespace vmx
+{
+
+/* ==== Helper Classes ===================================================== */
+// pw_thread_loop callbacks already run with the loop locked, so only lock
+// when called from some other thread.
+class PipeWireLoopLock
+{
+public:
+    explicit PipeWireLoopLock(pw_thread_loop *pLoop)
+      : m_pLoop(pLoop),
+        m_bLocked(!pw_thread_loop_in_thread(pLoop))
+    {
+        if (m_bLocked)
+            pw_thread_loop_lock(m_pLoop);
+    }
+
+    ~PipeWireLoopLock()
+    {
+        if (m_bLocked)
+            pw_thread_loop_unlock(m_pLoop);
+    }
+
+    PipeWireLoopLock(const PipeWireLoopLock&) = delete;
+    PipeWireLoopLock& operator=(const PipeWireLoopLock&) = delete;
+
+private:
+    pw_thread_loop *m_pLoop;
+    bool m_bLocked;
+};
+
+// A bound pw_node proxy subscribed to its Props param. Both sinks and streams
+// are plain nodes as far as volume and mute go, so devices and sessions share
+// this and only differ in what they do with the events. Must be created and
+// released with the loop locked.
+class PipeWireNodeProxy
+{
+public: /* Classes */
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+        virtual void onNodeInfo(const pw_node_info &info) = 0;
+        virtual void onNodeProps(std::optional<std::vector<float>> channelVolumes, std::optional<bool> bMuted) = 0;
+    };
+
+public: /* Methods */
+    PipeWireNodeProxy(pw_registry *pRegistry, std::uint32_t nodeId, Listener &listener);
+    ~PipeWireNodeProxy();
+
+    PipeWireNodeProxy(const PipeWireNodeProxy&) = delete;
+    PipeWireNodeProxy& operator=(const PipeWireNodeProxy&) = delete;
+
+    int setChannelVolumes(const std::vector<float> &channelVolumes);
+    int setMute(bool bMute);
+    void release();
+
+private: /* Methods */
+    static void infoCallback(void *pUserData, const pw_node_info *pInfo);
+    static void paramCallback(void *pUserData, int seq, std::uint32_t id, std::uint32_t index, std::uint32_t next, const spa_pod *pParam);
+
+private: /* Members */
+    pw_node *m_pNode = nullptr;
+    spa_hook m_nodeListener = {};
+    Listener &m_listener;
+};
+
+/* ==== Volume Mixer Classes =============================================== */
+class PipeWireVolumeMixer;
+
+class PipeWireAudioSession : public AudioSession, private PipeWireNodeProxy::Listener
+{
+public: /* Friends */
+    friend class PipeWireAudioDevice;
+    friend class PipeWireVolumeMixer;
+
+public: /* Methods */
+    PipeWireAudioSession(PipeWireVolumeMixer &volumeMixer, std::uint32_t nodeId);
+    std::string getId() const { return m_id; };
+
+public: /* Virtual Methods */
+    virtual ~PipeWireAudioSession() = default;
+    virtual void changeVolume(float volume) override;
+    virtual void changeChannelVolumes(std::vector<float> channelVolumes) override;
+    virtual void changeMute(bool bMute) override;
+
+private: /* Virtual Methods */
+    virtual void onNodeInfo(const pw_node_info &info) override;
+    virtual void onNodeProps(std::optional<std::vector<float>> channelVolumes, std::optional<bool> bMuted) override;
+
+private: /* Members */
+    std::recursive_mutex m_mutex;
+    PipeWireVolumeMixer &m_volumeMixer;
+    std::vector<float> m_channelVolumes;
+    std::string m_id = "";
+    PipeWireNodeProxy m_node;
+};
+
+class PipeWireAudioDevice : public AudioDevice, private PipeWireNodeProxy::Listener
+{
+public: /* Friends */
+    friend class PipeWireVolumeMixer;
+
+public: /* Methods */
+    PipeWireAudioDevice(PipeWireVolumeMixer &volumeMixer, std::uint32_t nodeId, const std::string &nodeName, bool bDefaultDevice);
+    std::string getId() const { return m_id; };
+
+public: /* Virtual Methods */
+    virtual ~PipeWireAudioDevice() = default;
+    virtual void changeVolume(float volume) override;
+    virtual void changeChannelVolumes(std::vector<float> channelVolumes) override;
+    virtual void changeMute(bool bMute) override;
+
+private: /* Methods */
+    void attachSession(std::shared_ptr<PipeWireAudioSession> pPipeWireAudioSession);
+    void detachSession(const std::string &audioSessionId);
+
+private: /* Virtual Methods */
+    virtual void onNodeInfo(const pw_node_info &info) override;
+    virtual void onNodeProps(std::optional<std::vector<float>> channelVolumes, std::optional<bool> bMuted) override;
+
+private: /* Members */
+    std::recursive_mutex m_mutex;
+    PipeWireVolumeMixer &m_volumeMixer;
+    std::vector<float> m_channelVolumes;
+    std::map<std::string /* AudioSessionId */, std::shared_ptr<PipeWireAudioSession>> m_audioSessionsMirror;
+    std::string m_id = "";
+    PipeWireNodeProxy m_node;
+};
+
+// Audio/Sink nodes are devices (keyed by node.name) and Stream/Output/Audio
+// nodes are sessions. A stream belongs to whichever sink its links feed, so
+// links are tracked from the registry as well and a stream only shows up as
+// a session once it is linked. Everything runs on the pw_thread_loop thread.
+// Volumes are reported on the cubic scale pavucontrol and wpctl use. There is
+// no peak metering yet: setPeakSamplingPeriod() does nothing, so onPeakSample
+// never fires for PipeWire sessions and devices.
+class PipeWireVolumeMixer : public VolumeMixer
+{
+public: /* Friends */
+    friend class PipeWireAudioSession;
+    friend class PipeWireAudioDevice;
+
+public: /* Methods */
+    // An empty remoteName connects to the default daemon ($PIPEWIRE_REMOTE, then pipewire-0)
+    explicit PipeWireVolumeMixer(const std::string &remoteName = "");
+
+public: /* Virtual Methods */
+    virtual ~PipeWireVolumeMixer();
+
+    // A no-op: metering would need a monitor capture stream per node, which
+    // this backend does not open. No onPeakSample events are ever reported.
+    virtual void setPeakSamplingPeriod(std::chrono::milliseconds period) override;
+
+private: /* Methods */
+    static void registryGlobalCallback(void *pUserData, std::uint32_t id, std::uint32_t permissions, const char *type, std::uint32_t version, const spa_dict *pProps);
+    static void registryGlobalRemoveCallback(void *pUserData, std::uint32_t id);
+    static void coreDoneCallback(void *pUserData, std::uint32_t id, int seq);
+    static void coreErrorCallback(void *pUserData, std::uint32_t id, int seq, int res, const char *message);
+    static int metadataPropertyCallback(void *pUserData, std::uint32_t subject, const char *key, const char *type, const char *value);
+    void addSink(std::uint32_t nodeId, const std::string &nodeName);
+    void addStream(std::uint32_t nodeId);
+    void addLink(std::uint32_t linkId, std::uint32_t outputNodeId, std::uint32_t inputNodeId);
+    void removeGlobal(std::uint32_t id);
+    void relinkStream(std::uint32_t streamNodeId);
+    void applyDefaultSink();
+    void roundtrip();
+    void teardown();
+
+private: /* Members */
+    std::mutex m_mutex;
+    pw_thread_loop *m_pLoop = nullptr;
+    pw_context *m_pContext = nullptr;
+    pw_core *m_pCore = nullptr;
+    spa_hook m_coreListener = {};
+    pw_registry *m_pRegistry = nullptr;
+    spa_hook m_registryListener = {};
+    pw_metadata *m_pMetadata = nullptr;
+    spa_hook m_metadataListener = {};
+
+    // Loop thread only
+    int m_pendingSeq = 0;
+    int m_doneSeq = -1;
+    bool m_bConnectionLost = false;
+    std::string m_defaultSinkName = "";
+    std::map<std::uint32_t /* link id */, std::pair<std::uint32_t /* output node */, std::uint32_t /* input node */>> m_links;
+    std::map<std::uint32_t /* stream node id */, std::shared_ptr<PipeWireAudioSession>> m_streams;
+    std::map<std::uint32_t /* stream node id */, std::uint32_t /* sink node id */> m_streamSinks;
+
+    std::map<std::uint32_t /* sink node id */, std::shared_ptr<PipeWireAudioDevice>> m_audioDevicesMirror;
+};
+
+} // namespace vmx
@@ -0,0 +1,232 @@
+#pragma once
+
+/* ==== Application Includes =============================================== */
+#include <vmx/VolumeMixer.h>
+#include <vmx/TimerService.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/* ==== Operating System Includes ========================================== */
+#include <pulse/pulseaudio.h>
+
+namespace vmx
+{
+
+/* ==== Helper Classes ===================================================== */
+// pa_threaded_mainloop callbacks already run with the loop locked, so only
+// lock when called from some other thread.
+class PulseMainloopLock
+{
+public:
+    explicit PulseMainloopLock(pa_threaded_mainloop *pMainloop)
+      : m_pMainloop(pMainloop),
+        m_bLocked(!pa_threaded_mainloop_in_thread(pMainloop))
+    {
+        if (m_bLocked)
+            pa_threaded_mainloop_lock(m_pMainloop);
+    }
+
+    ~PulseMainloopLock()
+    {
+        if (m_bLocked)
+            pa_threaded_mainloop_unlock(m_pMainloop);
+    }
+
+    PulseMainloopLock(const PulseMainloopLock&) = delete;
+    PulseMainloopLock& operator=(const PulseMainloopLock&) = delete;
+
+private:
+    pa_threaded_mainloop *m_pMainloop;
+    bool m_bLocked;
+};
+
+// A PA_STREAM_PEAK_DETECT record stream on a sink's monitor source, optionally
+// narrowed to a single sink-input. The server does the peak detection, the
+// client only receives one float per fragment. Must be created and destroyed
+// with the mainloop locked.
+class PulseMonitorStream
+{
+public:
+    PulseMonitorStream(pa_context *pContext, const std::string &monitorSourceName, std::uint32_t sinkInputIndex);
+    ~PulseMonitorStream();
+
+    PulseMonitorStream(const PulseMonitorStream&) = delete;
+    PulseMonitorStream& operator=(const PulseMonitorStream&) = delete;
+
+    // Loudest peak since the previous call
+    float takePeak();
+
+private:
+    static void readCallback(pa_stream *pStream, size_t nBytes, void *pUserData);
+
+private:
+    pa_stream *m_pStream = nullptr;
+    std::atomic<float> m_peak = 0.0f;
+};
+
+// Introspection replies only live for the duration of their callback
+struct PulseSinkInfo
+{
+    std::uint32_t index = PA_INVALID_INDEX;
+    std::string name = "";
+    std::string description = "";
+    std::string iconName = "";
+    std::string monitorSourceName = "";
+    pa_sink_state_t state = PA_SINK_INVALID_STATE;
+    pa_cvolume volume = {};
+    bool bMuted = false;
+};
+
+struct PulseSinkInputInfo
+{
+    std::uint32_t index = PA_INVALID_INDEX;
+    std::uint32_t sinkIndex = PA_INVALID_INDEX;
+    std::string name = "";
+    std::string iconName = "";
+    pa_cvolume volume = {};
+    bool bMuted = false;
+    bool bCorked = false;
+};
+
+/* ==== Volume Mixer Classes =============================================== */
+class PulseVolumeMixer;
+
+class PulseAudioSession : public AudioSession
+{
+public: /* Friends */
+    friend class PulseAudioDevice;
+    friend class PulseVolumeMixer;
+
+public: /* Methods */
+    PulseAudioSession(PulseVolumeMixer &volumeMixer, const PulseSinkInputInfo &info);
+    std::string getId() const { return m_id; };
+
+public: /* Virtual Methods */
+    virtual ~PulseAudioSession() = default;
+    virtual void changeVolume(float volume) override;
+    virtual void changeChannelVolumes(std::vector<float> channelVolumes) override;
+    virtual void changeMute(bool bMute) override;
+
+private: /* Methods */
+    void refresh(const PulseSinkInputInfo &info);
+    void startMonitoring(pa_context *pContext, const std::string &monitorSourceName);
+    void stopMonitoring();
+    void peakSample();
+
+private: /* Members */
+    std::recursive_mutex m_mutex;
+    PulseVolumeMixer &m_volumeMixer;
+    std::uint32_t m_index = PA_INVALID_INDEX;
+    std::uint32_t m_sinkIndex = PA_INVALID_INDEX;
+    pa_cvolume m_channelVolumes = {};
+    std::unique_ptr<PulseMonitorStream> m_pMonitorStream;
+    std::string m_id = "";
+};
+
+class PulseAudioDevice : public AudioDevice
+{
+public: /* Friends */
+    friend class PulseVolumeMixer;
+
+public: /* Methods */
+    PulseAudioDevice(PulseVolumeMixer &volumeMixer, const PulseSinkInfo &info, bool bDefaultDevice);
+    std::string getId() const { return m_id; };
+
+public: /* Virtual Methods */
+    virtual ~PulseAudioDevice() = default;
+    virtual void changeVolume(float volume) override;
+    virtual void changeChannelVolumes(std::vector<float> channelVolumes) override;
+    virtual void changeMute(bool bMute) override;
+
+private: /* Methods */
+    void refresh(const PulseSinkInfo &info);
+    void attachSession(std::shared_ptr<PulseAudioSession> pPulseAudioSession);
+    std::shared_ptr<PulseAudioSession> detachSession(std::uint32_t sinkInputIndex);
+    void startMonitoring(pa_context *pContext);
+    void stopMonitoring();
+    void peakSample();
+
+private: /* Members */
+    std::recursive_mutex m_mutex;
+    PulseVolumeMixer &m_volumeMixer;
+    std::uint32_t m_index = PA_INVALID_INDEX;
+    pa_cvolume m_channelVolumes = {};
+    std::string m_monitorSourceName = "";
+    std::unique_ptr<PulseMonitorStream> m_pMonitorStream;
+    std::map<std::uint32_t /* sink-input index */, std::shared_ptr<PulseAudioSession>> m_audioSessionsMirror;
+    std::string m_id = "";
+};
+
+// Sinks are devices (keyed by sink name, which survives server restarts) and
+// sink-inputs are sessions. Everything runs on the pa_threaded_mainloop thread;
+// subscription events only mark what is stale, and one list request per stale
+// kind is issued once the loop goes idle, so a burst of N changes costs one
+// round-trip and produces a single reconciliation of the tree.
+class PulseVolumeMixer : public VolumeMixer
+{
+public: /* Friends */
+    friend class PulseAudioSession;
+    friend class PulseAudioDevice;
+
+public: /* Methods */
+    // An empty serverAddress connects to the default server ($PULSE_SERVER, then the user's daemon)
+    explicit PulseVolumeMixer(const std::string &serverAddress = "");
+
+public: /* Virtual Methods */
+    virtual ~PulseVolumeMixer();
+    virtual void setPeakSamplingPeriod(std::chrono::milliseconds period) override;
+
+private: /* Methods */
+    static void contextStateCallback(pa_context *pContext, void *pUserData);
+    static void subscribeCallback(pa_context *pContext, pa_subscription_event_type_t type, std::uint32_t index, void *pUserData);
+    static void refreshDeferCallback(pa_mainloop_api *pApi, pa_defer_event *pEvent, void *pUserData);
+    static void serverInfoCallback(pa_context *pContext, const pa_server_info *pInfo, void *pUserData);
+    static void sinkInfoCallback(pa_context *pContext, const pa_sink_info *pInfo, int eol, void *pUserData);
+    static void sinkInputInfoCallback(pa_context *pContext, const pa_sink_input_info *pInfo, int eol, void *pUserData);
+    void markStale(bool bServer, bool bSinks, bool bSinkInputs);
+    void requestRefresh();
+    void replyReceived();
+    void applyRefresh();
+    void applySinks();
+    void applySinkInputs();
+    void applyDefaultSink();
+    void setMonitoring(bool bMonitoring);
+    void teardown();
+    void peakSample();
+    bool sendOperation(pa_operation *pOperation);
+
+private: /* Members */
+    std::mutex m_mutex;
+    pa_threaded_mainloop *m_pMainloop = nullptr;
+    pa_context *m_pContext = nullptr;
+    pa_defer_event *m_pRefreshEvent = nullptr;
+
+    // Mainloop thread only
+    bool m_bServerStale = false;
+    bool m_bSinksStale = false;
+    bool m_bSinkInputsStale = false;
+    bool m_bServerPending = false;
+    bool m_bSinksPending = false;
+    bool m_bSinkInputsPending = false;
+    int m_outstandingReplies = 0;
+    std::uint64_t m_completedRefreshes = 0;
+    std::string m_pendingDefaultSinkName = "";
+    std::vector<PulseSinkInfo> m_pendingSinks;
+    std::vector<PulseSinkInputInfo> m_pendingSinkInputs;
+    std::string m_defaultSinkName = "";
+
+    // Mainloop lock
+    bool m_bMonitoring = false;
+
+    std::map<std::uint32_t /* sink index */, std::shared_ptr<PulseAudioDevice>> m_audioDevicesMirror;
+    PeriodicTimer m_peakSamplingTimer;
+};
+
+} // namespace vmx
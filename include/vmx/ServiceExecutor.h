@@ -0,0 +1,76 @@
+#pragma once
+
+/* ==== Application Includes =============================================== */
+#include <vmx/WorkThreads.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace vmx
+{
+
+/* ==== Classes ============================================================ */
+// One thread for a mixer's deferred backend work (session teardown, metadata
+// refresh, re-initialising a device), in place of a thread per device. Work
+// reaches it through a Strand per device, which keeps that device's jobs in
+// order. Jobs must not throw or block for long, as every device waits behind
+// them. Whatever is still queued at destruction is dropped.
+class ServiceExecutor
+{
+public: /* Methods */
+    ServiceExecutor();
+    ServiceExecutor(const ServiceExecutor&) = delete;
+    ServiceExecutor& operator=(const ServiceExecutor&) = delete;
+
+    void post(std::function<void()> job);
+    std::thread::id threadId() const { return m_workThread.threadId(); };
+
+private: /* Members */
+    QueuedWorkThread<std::function<void()>> m_workThread;
+};
+
+// A device's queue on a ServiceExecutor. Jobs run one at a time, in the order
+// posted; a strand with more work rejoins the back of the executor's queue
+// after each batch, so one busy device does not starve the others. close()
+// drops the jobs not yet started and waits for the one running, after which
+// post() does nothing, so jobs may capture their device by reference as long
+// as the device closes its strand (the destructor does) before it goes. The
+// executor must outlive the strand's last post().
+class Strand
+{
+public: /* Methods */
+    explicit Strand(ServiceExecutor &executor);
+    ~Strand();
+    Strand(const Strand&) = delete;
+    Strand& operator=(const Strand&) = delete;
+
+    void post(std::function<void()> job);
+    // From a job of this strand, returns without waiting for that job
+    void close();
+
+private: /* Types */
+    struct State
+    {
+        std::mutex mutex;
+        std::condition_variable idle;       // close() waiting for a job to finish
+        std::deque<std::function<void()>> jobs;
+        bool bScheduled = false;            // a run() is queued on the executor or running
+        bool bRunning = false;              // a job is running
+        bool bClosed = false;
+    };
+
+private: /* Methods */
+    static void run(ServiceExecutor &executor, const std::shared_ptr<State> &pState);
+
+private: /* Members */
+    ServiceExecutor &m_executor;
+    std::thread::id m_executorThreadId;
+    std::shared_ptr<State> m_pState;
+};
+
+} // namespace vmx
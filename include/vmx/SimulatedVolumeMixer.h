@@ -0,0 +1,152 @@
+#pragma once
+
+/* ==== Application Includes =============================================== */
+#include <vmx/GainRamp.h>
+#include <vmx/VolumeMixer.h>
+#include <vmx/TimerService.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace vmx
+{
+
+namespace detail { class RenderRequest; }
+
+/* ==== Volume Mixer Classes =============================================== */
+// The simulated backend has no audio server behind it. Anything a real backend
+// would learn from OS notifications is instead injected through the simulate*()
+// methods, which makes it usable for benchmarks and stress testing on any host.
+// Audio is rendered in 10 ms periods while loudness metering runs or a tap is
+// open, and not at all otherwise: every session plays white noise at its
+// level through a GainRamp following its volume and mute, and each device
+// plays the mix of its sessions through its own GainRamp. Channel volumes are
+// applied on top without a ramp. Rendering runs on the shared TimerService
+// thread and is not realtime safe: it takes the mixer, device and session
+// mutexes every period and releases closed taps there.
+class SimulatedAudioSession : public AudioSession
+{
+public: /* Methods */
+    // pRenderRequest starts the mixer's rendering when a tap is opened
+    SimulatedAudioSession(const std::string &id, const std::string &name, std::shared_ptr<detail::RenderRequest> pRenderRequest = nullptr);
+    std::string getId() const { return m_id; };
+    void simulateName(std::string name);
+    void simulateIconPath(std::string iconPath);
+    void simulateState(State state);
+    void simulateVolume(float volume);
+    void simulateChannelVolumes(std::vector<float> channelVolumes);
+    void simulateMute(bool bMuted);
+    void simulateLevel(float level);
+    void peakSample();
+    float lastPeak();
+    // Returns whether a tap is still open
+    bool render(std::span<float> mix, std::size_t frameCount, bool bMeterLoudness, bool bReportLoudness);
+
+public: /* Virtual Methods */
+    virtual ~SimulatedAudioSession();
+    virtual void changeVolume(float volume) override;
+    virtual void changeMute(bool bMute) override;
+    virtual void changeChannelVolumes(std::vector<float> channelVolumes) override;
+    virtual std::shared_ptr<AudioTap> openAudioTap(std::chrono::milliseconds bufferLength) override;
+
+private: /* Members */
+    std::recursive_mutex m_mutex;
+    std::string m_id = "";
+    float m_volume = 1.0f;
+    std::vector<float> m_channelVolumes;
+    bool m_bMuted = false;
+    float m_level = 0.5f;
+    float m_lastPeak = 0.0f;
+    std::uint32_t m_noise = 0;
+    GainRamp m_gainRamp;
+    LoudnessMeter m_loudnessMeter;
+    std::vector<float> m_frames;
+    std::vector<std::shared_ptr<AudioTap>> m_audioTaps;
+    std::shared_ptr<detail::RenderRequest> m_pRenderRequest;
+};
+
+class SimulatedAudioDevice : public AudioDevice
+{
+public: /* Methods */
+    SimulatedAudioDevice(const std::string &id, const std::string &name, bool bDefaultDevice,
+                         std::shared_ptr<detail::RenderRequest> pRenderRequest = nullptr);
+    std::string getId() const { return m_id; };
+    std::shared_ptr<SimulatedAudioSession> createSession(const std::string &audioSessionId, const std::string &name);
+    void destroySession(const std::string &audioSessionId);
+    std::shared_ptr<SimulatedAudioSession> findSession(const std::string &audioSessionId);
+    void simulateName(std::string name);
+    void simulateState(State state);
+    void simulateDefault(bool bIsDefaultDevice);
+    void simulateVolume(float volume);
+    void simulateChannelVolumes(std::vector<float> channelVolumes);
+    void simulateMute(bool bMuted);
+    void peakSample();
+    // Returns whether a tap on the device or one of its sessions is still open
+    bool render(std::size_t frameCount, bool bMeterLoudness, bool bReportLoudness);
+
+public: /* Virtual Methods */
+    virtual ~SimulatedAudioDevice();
+    virtual void changeVolume(float volume) override;
+    virtual void changeMute(bool bMute) override;
+    virtual void changeChannelVolumes(std::vector<float> channelVolumes) override;
+    virtual std::shared_ptr<AudioTap> openAudioTap(std::chrono::milliseconds bufferLength) override;
+
+private: /* Members */
+    std::recursive_mutex m_mutex;
+    std::string m_id = "";
+    float m_volume = 1.0f;
+    std::vector<float> m_channelVolumes;
+    bool m_bMuted = false;
+    std::map<std::string /* AudioSessionId */, std::shared_ptr<SimulatedAudioSession>> m_audioSessionsMirror;
+    GainRamp m_gainRamp;
+    LoudnessMeter m_loudnessMeter;
+    std::vector<float> m_mix;
+    std::vector<std::shared_ptr<AudioTap>> m_audioTaps;
+    std::shared_ptr<detail::RenderRequest> m_pRenderRequest;
+};
+
+class SimulatedVolumeMixer : public VolumeMixer
+{
+public: /* Methods */
+    SimulatedVolumeMixer();
+    std::shared_ptr<SimulatedAudioDevice> createDevice(const std::string &audioDeviceId, const std::string &name, bool bDefaultDevice);
+    void destroyDevice(const std::string &audioDeviceId);
+    std::shared_ptr<SimulatedAudioDevice> findDevice(const std::string &audioDeviceId);
+    void simulateDefaultDevice(const std::string &audioDeviceId);
+    void peakSample();
+    void render();
+
+public: /* Virtual Methods */
+    virtual ~SimulatedVolumeMixer();
+    virtual void setPeakSamplingPeriod(std::chrono::milliseconds period) override;
+    virtual void setLoudnessSamplingPeriod(std::chrono::milliseconds period) override;
+
+public: /* Constants */
+    static constexpr unsigned int kSampleRate = 48000;
+    static constexpr std::size_t kChannelCount = 2;
+    static constexpr std::chrono::milliseconds kRenderPeriod{10};
+
+private: /* Methods */
+    // Runs the render timer until render() finds no tap open and loudness off
+    void startRendering();
+
+private: /* Members */
+    std::mutex m_mutex;
+    std::map<std::string /*audioDeviceId*/, std::shared_ptr<SimulatedAudioDevice>> m_audioDevicesMirror;
+    PeriodicTimer m_peakSamplingTimer;
+    std::atomic<std::chrono::milliseconds::rep> m_loudnessPeriodMs = 0;
+    std::mutex m_renderMutex; // orders starting the render timer against render() stopping it
+    bool m_bRendering = false;
+    std::chrono::milliseconds m_sinceLoudnessReport{0};
+    std::shared_ptr<detail::RenderRequest> m_pRenderRequest;
+    PeriodicTimer m_renderTimer;
+};
+
+} // namespace vmx
@@ -0,0 +1,127 @@
+#pragma once
+
+/* ==== Application Includes =============================================== */
+#include <vmx/AudioTap.h>
+#include <vmx/TimerService.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace vmx
+{
+
+/* ==== Classes ============================================================ */
+// Log-frequency band magnitudes of any number of audio taps. Every period the
+// analysis timer drains each tap into a history of the last fftSize frames
+// (mixed down to mono), applies a Hann window and a real FFT, and sums the
+// power into bandCount bands spaced evenly in log frequency from 20 Hz to
+// 20 kHz (or Nyquist). One FFT is done per source however many observers
+// there are, and all sources that received audio are published together in
+// one batch. The FFT plan and every buffer are made when the analyzer or a
+// source is created, so analysis itself never allocates. The FFT and the
+// power spectrum run on SSE2 vectors (scalar off x86).
+class SpectrumAnalyzer
+{
+public: /* Types */
+    using SourceId = std::uint32_t;
+
+public: /* Classes */
+    // Views into the analyzer's buffers, valid for the duration of the callback
+    struct Batch
+    {
+        std::size_t bandCount = 0;
+        std::span<const SourceId> sources;
+        std::span<const float> magnitudes; // one row of bandCount per source
+
+        std::span<const float> row(std::size_t index) const { return magnitudes.subspan(index * bandCount, bandCount); };
+    };
+
+    class Observer
+    {
+    public: /* Virtual Methods */
+        virtual ~Observer() = default;
+
+        // Called on the timer thread with the analyzer locked. Magnitudes are
+        // in dB relative to a full-scale sine, -infinity for silence. Observers
+        // may be added or removed from here, but not sources.
+        virtual void onSpectrum(const Batch &batch) = 0;
+    };
+
+public: /* Constants */
+    static constexpr float kMinFrequency = 20.0f;
+    static constexpr float kMaxFrequency = 20000.0f;
+
+public: /* Methods */
+    // fftSize must be a power of two from 64 to 65536; a period of zero leaves
+    // analysis to explicit analyze() calls
+    SpectrumAnalyzer(std::size_t fftSize, std::size_t bandCount, std::chrono::milliseconds period);
+    SpectrumAnalyzer(const SpectrumAnalyzer&) = delete;
+    SpectrumAnalyzer& operator=(const SpectrumAnalyzer&) = delete;
+    ~SpectrumAnalyzer();
+
+    // The analyzer becomes the tap's consumer. Removing the source closes the
+    // tap; a tap the backend closes is removed at the next analysis.
+    SourceId addSource(std::shared_ptr<AudioTap> pAudioTap);
+    void removeSource(SourceId sourceId);
+
+    void addObserver(std::shared_ptr<Observer> pObserver);
+    void removeObserver(std::shared_ptr<Observer> pObserver);
+
+    void setPeriod(std::chrono::milliseconds period);
+    void analyze();
+
+    std::size_t fftSize() const { return m_fftSize; };
+    std::size_t bandCount() const { return m_bandCount; };
+
+    // bandCount() + 1 band edges in Hz, before clamping to a source's Nyquist frequency
+    std::span<const float> bandEdges() const { return m_bandEdges; };
+
+private: /* Types */
+    struct Source
+    {
+        SourceId id;
+        std::shared_ptr<AudioTap> pAudioTap;
+        std::vector<float> history;             // ring of the last fftSize mono frames
+        std::size_t historyIndex = 0;           // the oldest frame
+        std::vector<std::uint32_t> bandBins;    // bandCount + 1 bin edges
+    };
+
+private: /* Methods */
+    bool drain(Source &source);
+    void transform(const Source &source, float *pMagnitudes);
+
+private: /* Members */
+    std::recursive_mutex m_mutex;
+    std::size_t m_fftSize;
+    std::size_t m_bandCount;
+    std::vector<float> m_bandEdges;
+
+    // The plan, shared by every source
+    std::vector<float> m_window;
+    std::vector<std::uint32_t> m_bitReversal;   // fftSize / 2 entries
+    std::vector<float> m_twiddleRe;             // per stage, see FftKernels.h
+    std::vector<float> m_twiddleIm;
+    std::vector<float> m_unpackRe;              // fftSize / 2 + 1 entries
+    std::vector<float> m_unpackIm;
+    float m_powerScale;
+
+    // Scratch and output, sized for the current sources
+    std::vector<float> m_re;
+    std::vector<float> m_im;
+    std::vector<float> m_power;
+    std::vector<SourceId> m_batchSources;
+    std::vector<float> m_batchMagnitudes;
+
+    std::vector<Source> m_sources;
+    SourceId m_nextSourceId = 0;
+    std::vector<std::weak_ptr<Observer>> m_observers;
+    PeriodicTimer m_analysisTimer;
+};
+
+} // namespace vmx
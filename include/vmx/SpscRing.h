@@ -0,0 +1,125 @@
+#pragma once
+
+/* ==== Standard Library Includes ========================================== */
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace vmx
+{
+
+/* ==== Helper Classes ===================================================== */
+// Bounded wait-free ring for exactly one producer thread and one consumer
+// thread. All storage is allocated up front, so none of the methods allocate,
+// lock or block and they are safe to call from a realtime audio thread.
+//
+// Besides one element at a time (tryPush()/tryPop()) the ring can be used in
+// bulk through spans over its own storage: writable()/commitWrite() and
+// readable()/commitRead(). Bulk users can give a record size, e.g. the channel
+// count of interleaved audio. A record that would wrap is stored whole past the
+// end of the ring instead, so every span holds whole records. Don't mix
+// tryPush()/tryPop() with records larger than one element.
+template <class T>
+class SpscRing
+{
+    static_assert(std::is_trivially_copyable_v<T>, "SpscRing elements are copied with plain stores");
+
+public:
+    // Capacity is rounded up to a power of two
+    explicit SpscRing(std::size_t capacity, std::size_t recordSize = 1)
+      : m_mask(std::bit_ceil(std::max({capacity, recordSize, std::size_t(2)})) - 1),
+        m_recordSize(recordSize < 1 ? 1 : recordSize),
+        m_buffer(m_mask + m_recordSize)
+    {
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Producer only
+    bool tryPush(const T &item)
+    {
+        std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cachedHead > m_mask)
+        {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail - m_cachedHead > m_mask) return false;
+        }
+        m_buffer[tail & m_mask] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only
+    bool tryPop(T &item)
+    {
+        std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cachedTail)
+        {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cachedTail) return false;
+        }
+        item = m_buffer[head & m_mask];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer only: free space from the tail on, in whole records
+    std::span<T> writable()
+    {
+        std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        m_cachedHead = m_head.load(std::memory_order_acquire);
+        return {&m_buffer[tail & m_mask], contiguous(tail, capacity() - (tail - m_cachedHead))};
+    }
+
+    // Producer only: publishes count elements written to the front of writable()
+    void commitWrite(std::size_t count)
+    {
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    // Consumer only: filled space from the head on, in whole records. Once
+    // that is consumed a second call may return more, from the start of the ring.
+    std::span<const T> readable()
+    {
+        std::size_t head = m_head.load(std::memory_order_relaxed);
+        m_cachedTail = m_tail.load(std::memory_order_acquire);
+        return {&m_buffer[head & m_mask], contiguous(head, m_cachedTail - head)};
+    }
+
+    // Consumer only: releases count elements from the front of readable()
+    void commitRead(std::size_t count)
+    {
+        m_head.store(m_head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    std::size_t capacity() const
+    {
+        return m_mask + 1;
+    }
+
+private:
+    // Whole records from index on that start before the end of the buffer
+    std::size_t contiguous(std::size_t index, std::size_t count) const
+    {
+        std::size_t toEnd = capacity() - (index & m_mask);
+        return std::min(count, toEnd + m_recordSize - 1) / m_recordSize * m_recordSize;
+    }
+
+private:
+    // Each side's index and its cached copy of the other side's index share a
+    // cache line, so the two threads only contend when the cache goes stale.
+    alignas(64) std::atomic<std::size_t> m_head = 0;
+    std::size_t m_cachedTail = 0;
+    alignas(64) std::atomic<std::size_t> m_tail = 0;
+    std::size_t m_cachedHead = 0;
+    alignas(64) const std::size_t m_mask;
+    const std::size_t m_recordSize;
+    std::vector<T> m_buffer; // capacity() plus room for one record to run past the end
+};
+
+} // namespace vmx
@@ -0,0 +1,104 @@
+#pragma once
+
+/* ==== Standard Library Includes ========================================== */
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace vmx
+{
+
+/* ==== Enums ============================================================== */
+enum class EventKind
+{
+    Name,
+    IconPath,
+    State,
+    Default,
+    Volume,
+    ChannelVolumes,
+    Mute,
+    PeakSample,
+    LoudnessSample,
+    SessionAdded,
+    SessionRemoved,
+    DeviceAdded,
+    DeviceRemoved,
+};
+
+constexpr std::size_t kEventKindCount = static_cast<std::size_t>(EventKind::DeviceRemoved) + 1;
+
+const char *toString(EventKind kind);
+
+/* ==== Classes ============================================================ */
+// Log-linear histogram in the spirit of HdrHistogram: values below 16 are exact,
+// above that every power of two is split into 16 sub-buckets (~6% resolution).
+// Recording is lock-free and wait-free so it can sit on the notification path.
+class LatencyHistogram
+{
+public: /* Constants */
+    static constexpr std::size_t kSubBucketBits = 4;
+    static constexpr std::size_t kBucketCount = (64 - kSubBucketBits + 1) << kSubBucketBits;
+
+public: /* Classes */
+    class Snapshot
+    {
+    public: /* Methods */
+        std::uint64_t count() const { return m_count; };
+        std::uint64_t min() const { return m_count ? m_min : 0; };
+        std::uint64_t max() const { return m_max; };
+        std::uint64_t sum() const { return m_sum; };
+        double mean() const;
+        std::uint64_t percentile(double percent) const;
+        const std::vector<std::uint64_t> &buckets() const { return m_buckets; };
+
+    private: /* Members */
+        std::vector<std::uint64_t> m_buckets;
+        std::uint64_t m_count = 0;
+        std::uint64_t m_sum = 0;
+        std::uint64_t m_min = 0;
+        std::uint64_t m_max = 0;
+
+    public: /* Friends */
+        friend class LatencyHistogram;
+    };
+
+public: /* Methods */
+    LatencyHistogram() = default;
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+    void record(std::uint64_t value);
+    Snapshot snapshot() const;
+    void reset();
+    static std::size_t bucketOf(std::uint64_t value);
+    static std::uint64_t bucketUpperBound(std::size_t bucket);
+
+private: /* Members */
+    std::array<std::atomic<std::uint64_t>, kBucketCount> m_buckets{};
+    std::atomic<std::uint64_t> m_count{0};
+    std::atomic<std::uint64_t> m_sum{0};
+    std::atomic<std::uint64_t> m_min{std::numeric_limits<std::uint64_t>::max()};
+    std::atomic<std::uint64_t> m_max{0};
+};
+
+// All durations are in nanoseconds on std::chrono::steady_clock. An event is
+// "reported" when the backend hands it to an update*() call.
+struct EventLatency
+{
+    EventKind kind = EventKind::Name;
+    LatencyHistogram::Snapshot dispatch; // reported -> observer callback started
+    LatencyHistogram::Snapshot callback; // observer callback started -> finished
+    LatencyHistogram::Snapshot endToEnd; // reported -> observer callback finished
+};
+
+struct Stats
+{
+    std::array<EventLatency, kEventKindCount> events;
+
+    const EventLatency &operator[](EventKind kind) const { return events[static_cast<std::size_t>(kind)]; };
+};
+
+} // namespace vmx
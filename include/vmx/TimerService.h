@@ -0,0 +1,115 @@
+#pragma once
+
+/* ==== Standard Library Includes ========================================== */
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <utility>
+
+namespace vmx
+{
+
+/* ==== Classes ============================================================ */
+// Periodic tasks on one thread, scheduled on steady_clock. Each deadline is
+// the previous one plus the period, so a slow task or a late wakeup does not
+// shift the ones after it; a task that falls a whole period or more behind
+// skips the ticks it missed instead of running them back to back, and they
+// are counted. A task is run up to slack (at most a quarter of its period)
+// early when the thread is awake for another one anyway, which coalesces
+// wakeups. On Linux the thread sleeps on a timerfd armed at the next absolute
+// deadline. Tasks run without the service's lock held and may call into it.
+class TimerService
+{
+public: /* Types */
+    using Clock = std::chrono::steady_clock;
+    using TimerId = std::uint64_t;
+
+    struct TimerStats
+    {
+        std::uint64_t runs = 0;
+        std::uint64_t missedDeadlines = 0;  // ticks skipped because the task ran a period or more late
+        std::chrono::nanoseconds maxLateness{0};
+    };
+
+public: /* Methods */
+    explicit TimerService(std::chrono::nanoseconds slack = std::chrono::microseconds(500));
+    ~TimerService();
+    TimerService(const TimerService&) = delete;
+    TimerService& operator=(const TimerService&) = delete;
+
+    // The service the backends share. It is never destroyed, so mixers with
+    // static storage duration can still remove their timers at exit.
+    static TimerService &shared();
+
+    // A period of ZERO adds the task paused
+    TimerId add(std::function<void()> task, std::chrono::nanoseconds period);
+    // Restarts the schedule one period from now; ZERO pauses the task
+    void changePeriod(TimerId id, std::chrono::nanoseconds period);
+    // Once this returns the task is not running and never runs again, except
+    // when called from the task itself, which finishes its current run
+    void remove(TimerId id);
+    TimerStats stats(TimerId id) const;
+
+private: /* Types */
+    struct Timer
+    {
+        std::function<void()> task;
+        std::chrono::nanoseconds period{0};
+        Clock::time_point deadline;
+        TimerStats stats;
+        bool bRemoved = false; // by its own task, erased once that run returns
+    };
+
+private: /* Methods */
+    void run(std::stop_token stopToken);
+    // Clock::time_point::max() waits for a change
+    void waitUntil(std::unique_lock<std::mutex> &lock, Clock::time_point deadline, std::stop_token &stopToken);
+    // With m_mutex held
+    void wakeThread();
+
+private: /* Members */
+    std::chrono::nanoseconds m_slack;
+    mutable std::mutex m_mutex;
+    std::condition_variable_any m_condition;    // where there is no timerfd
+    std::condition_variable m_idle;             // remove() waiting for a run to finish
+    bool m_bChanged = false;                    // since the thread last woke up
+    std::map<TimerId, Timer> m_timers;
+    TimerId m_nextId = 1;
+    TimerId m_running = 0;
+    std::thread::id m_threadId;
+#ifdef __linux__
+    int m_timerFd = -1;
+    int m_wakeFd = -1;
+#endif
+    std::jthread m_thread; // last, so it starts after and joins before the members it uses
+};
+
+// One task on a TimerService, in place of a thread of its own; a period of
+// ZERO pauses it. The task is not running once the destructor returns.
+class PeriodicTimer
+{
+public:
+    PeriodicTimer(std::function<void(void)> periodicFunction, std::chrono::nanoseconds period,
+                  TimerService &timerService = TimerService::shared())
+      : m_timerService(timerService),
+        m_id(timerService.add(std::move(periodicFunction), period))
+    {
+    }
+    ~PeriodicTimer() { m_timerService.remove(m_id); };
+    PeriodicTimer(const PeriodicTimer&) = delete;
+    PeriodicTimer& operator=(const PeriodicTimer&) = delete;
+
+    void changePeriod(std::chrono::nanoseconds period) { m_timerService.changePeriod(m_id, period); };
+    TimerService::TimerStats stats() const { return m_timerService.stats(m_id); };
+
+private:
+    TimerService &m_timerService;
+    TimerService::TimerId m_id;
+};
+
+} // namespace vmx
@@ -0,0 +1,24 @@
+#pragma once
+
+/* ==== Standard Library Includes ========================================== */
+#include <string>
+
+namespace vmx
+{
+
+/* ==== Classes ============================================================ */
+// Chrome trace (chrome://tracing, ui.perfetto.dev) capture of vmx internals:
+// backend callbacks, update*() calls, lock waits, dispatch queueing and
+// observer callbacks. Spans are only recorded when vmx is configured with
+// VMX_ENABLE_TRACING; otherwise the instrumentation compiles away entirely
+// and start() throws.
+class Trace
+{
+public: /* Methods */
+    static bool isCompiledIn();
+    static void start(const std::string &path);
+    static void stop();
+    static bool isRecording();
+};
+
+} // namespace vmx
@@ -1,15 +1,48 @@
 #pragma once
 
+/* ==== Application Includes =============================================== */
+#include <vmx/AudioTap.h>
+#include <vmx/ChannelVolumes.h>
+#include <vmx/LoudnessMeter.h>
+#include <vmx/Metrics.h>
+#include <vmx/MixerObject.h>
+#include <vmx/Stats.h>
+
 /* ==== Standard Library Includes ========================================== */
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
 #include <vector>
 
 namespace vmx
 {
 
+/* ==== Enums ============================================================== */
+// How observers are called, see VolumeMixer::setDispatchMode()
+enum class DispatchMode
+{
+    Threaded,       // each observer call on a detached thread of its own
+    Synchronous,    // on the thread that made the change, once it holds no vmx lock
+};
+
+namespace detail
+{
+
+// An observer, and the dispatch mode it was added with if it has one of its own
+template <class Observer>
+struct ObserverEntry
+{
+    std::weak_ptr<Observer> pWeakObserver;
+    std::optional<DispatchMode> dispatchMode;
+};
+
+} // namespace detail
+
 /* ==== Classes ============================================================ */
 class AudioSession
 {
@@ -30,27 +63,45 @@ public: /* Classes */
         virtual void onIconPathChange(std::string iconPath) = 0;
         virtual void onStateChange(State state) = 0;
         virtual void onVolumeChange(float volume) = 0;
+        virtual void onChannelVolumesChange(std::vector<float> channelVolumes) = 0;
         virtual void onMuteChange(bool bMuted) = 0;
         virtual void onPeakSample(float peak) = 0;
+        virtual void onLoudnessSample(Loudness loudness) = 0;
     };
 
 public: /* Methods */
     AudioSession() = default;
     void addObserver(std::shared_ptr<Observer> pObserver, bool bNotifyNow);
+    // Calls this observer in dispatchMode, whatever VolumeMixer::setDispatchMode() says
+    void addObserver(std::shared_ptr<Observer> pObserver, bool bNotifyNow, DispatchMode dispatchMode);
     void removeObserver(std::shared_ptr<Observer> pObserver);
+    std::vector<float> getChannelVolumes();
 
 public: /* Virtual Methods */
-    virtual ~AudioSession() = default;
+    virtual ~AudioSession();
     virtual void changeVolume(float volume) = 0;
     virtual void changeMute(bool bMuted) = 0;
 
+    // Sets every channel in one call, see ChannelVolumes for the scale. The
+    // count has to match getChannelVolumes(); the volume becomes the loudest channel.
+    virtual void changeChannelVolumes(std::vector<float> channelVolumes) = 0;
+
+    // Streams the audio this session plays into a new tap holding up to bufferLength
+    // of it. Returns null when the backend has no access to the audio.
+    virtual std::shared_ptr<AudioTap> openAudioTap(std::chrono::milliseconds bufferLength);
+
 protected: /* Methods */
     void updateName(std::string name);
     void updateIconPath(std::string iconPath);
     void updateState(State state);
     void updateVolume(float volume);
+    void updateChannelVolumes(std::vector<float> channelVolumes);
     void updateMute(bool bMuted);
     void updatePeakSample(float peak);
+    void updateLoudnessSample(Loudness loudness);
+
+private: /* Methods */
+    void insertObserver(std::shared_ptr<Observer> pObserver, bool bNotifyNow, std::optional<DispatchMode> dispatchMode);
 
 private: /* Members */
     std::recursive_mutex m_mutex;
@@ -58,9 +109,11 @@ private: /* Members */
     std::string m_iconPath = "";
     State m_state = State::Unknown;
     float m_volume = 0.0f;
+    std::vector<float> m_channelVolumes;
     bool m_bMuted = false;
     float m_peak = 0.0f;
-    std::vector<std::weak_ptr<Observer>> m_observers;
+    Loudness m_loudness;
+    std::vector<detail::ObserverEntry<Observer>> m_observers;
 };
 
 class AudioDevice
@@ -84,8 +137,10 @@ public: /* Classes */
         virtual void onStateChange(State state) = 0;
         virtual void onDefaultChange(bool bIsDefaultDevice) = 0;
         virtual void onVolumeChange(float volume) = 0;
+        virtual void onChannelVolumesChange(std::vector<float> channelVolumes) = 0;
         virtual void onMuteChange(bool bMuted) = 0;
         virtual void onPeakSample(float peak) = 0;
+        virtual void onLoudnessSample(Loudness loudness) = 0;
         virtual void onAudioSessionAdded(const std::string &audioSessionId, std::weak_ptr<AudioSession> pAudioSession) = 0;
         virtual void onAudioSessionRemoved(const std::string &audioSessionId) = 0;
     };
@@ -93,24 +148,40 @@ public: /* Classes */
 public: /* Methods */
     AudioDevice() = default;
     void addObserver(std::shared_ptr<Observer> pObserver, bool bNotifyNow);
+    // Calls this observer in dispatchMode, whatever VolumeMixer::setDispatchMode() says
+    void addObserver(std::shared_ptr<Observer> pObserver, bool bNotifyNow, DispatchMode dispatchMode);
     void removeObserver(std::shared_ptr<Observer> pObserver);
+    std::vector<float> getChannelVolumes();
 
 public: /* Virtual Methods */
-    virtual ~AudioDevice() = default;
+    virtual ~AudioDevice();
     virtual void changeVolume(float volume) = 0;
     virtual void changeMute(bool bMuted) = 0;
 
+    // Sets every channel in one call, see ChannelVolumes for the scale. The
+    // count has to match getChannelVolumes(); the volume becomes the loudest channel.
+    virtual void changeChannelVolumes(std::vector<float> channelVolumes) = 0;
+
+    // Streams the audio this device plays into a new tap holding up to bufferLength
+    // of it. Returns null when the backend has no access to the audio.
+    virtual std::shared_ptr<AudioTap> openAudioTap(std::chrono::milliseconds bufferLength);
+
 protected: /* Methods */
     void updateName(std::string name);
     void updateIconPath(std::string iconPath);
     void updateState(State state);
     void updateDefault(bool bIsDefaultDevice);
     void updateVolume(float volume);
+    void updateChannelVolumes(std::vector<float> channelVolumes);
     void updateMute(bool bMuted);
     void updatePeakSample(float peak);
+    void updateLoudnessSample(Loudness loudness);
     void addSession(const std::string &audioSessionId, std::shared_ptr<AudioSession> pAudioSession);
     void removeSession(const std::string &audioSessionId);
 
+private: /* Methods */
+    void insertObserver(std::shared_ptr<Observer> pObserver, bool bNotifyNow, std::optional<DispatchMode> dispatchMode);
+
 private: /* Members */
     std::recursive_mutex m_mutex;
     std::string m_name = "";
@@ -118,14 +189,21 @@ private: /* Members */
     State m_state = State::Unknown;
     bool m_bIsDefaultDevice = false;
     float m_volume = 0.0f;
+    std::vector<float> m_channelVolumes;
     bool m_bMuted = false;
     float m_peak = 0.0f;
-    std::vector<std::weak_ptr<Observer>> m_observers;
+    Loudness m_loudness;
+    std::vector<detail::ObserverEntry<Observer>> m_observers;
     std::map<std::string /*audioSessionId*/, std::shared_ptr<AudioSession>> m_audioSessions;
 };
 
+namespace detail { class EventQueue; }
+
 class VolumeMixer
 {
+public: /* Types */
+    using DispatchMode = vmx::DispatchMode;
+
 public: /* Classes */
     class Observer
     {
@@ -137,20 +215,83 @@ public: /* Classes */
 public: /* Methods */
     VolumeMixer() = default;
     void addObserver(std::shared_ptr<Observer> pObserver, bool bNotifyNow);
+    // Calls this observer in dispatchMode, whatever setDispatchMode() says
+    void addObserver(std::shared_ptr<Observer> pObserver, bool bNotifyNow, DispatchMode dispatchMode);
     void removeObserver(std::shared_ptr<Observer> pObserver);
 
+    // Event latency histograms, aggregated across every mixer in the process.
+    static Stats stats();
+    static void resetStats();
+
+    // Pipeline counters and gauges, aggregated across every mixer in the process.
+    static Metrics &metrics();
+
+    // Threads vmx is running across every mixer in the process, by role, so
+    // the cost of a configuration can be checked rather than guessed: each
+    // mixer adds one Service thread at most, however many devices it has.
+    static ThreadInventory threadInventory();
+
+    // How every mixer in the process calls its observers, Threaded by default.
+    // Synchronous saves the thread per call: a change made from inside an
+    // observer is queued behind the calls already pending on that thread
+    // rather than recursing, so controllers can call change*() from their
+    // callbacks. An observer must not block (it holds up the backend's
+    // thread) or throw. Calls already queued or running keep their mode.
+    // PulseAudio and PipeWire report server changes on their client loop's
+    // thread, which keeps that loop locked while it runs: observers there can
+    // call into vmx, but must not wait on another thread that does. Observers
+    // added with a dispatch mode of their own keep it.
+    static void setDispatchMode(DispatchMode dispatchMode);
+    static DispatchMode dispatchMode();
+
+    // Creates the named backend ("windows", "pipewire", "pulseaudio", "jack" or
+    // "simulated"). An empty name picks the first backend in availableBackends()
+    // whose audio server is reachable. Backends built as plugins are loaded on
+    // first use. Throws std::runtime_error when no backend could be created.
+    static std::unique_ptr<VolumeMixer> create(const std::string &backendName = "");
+
+    // Backends known to this build, in auto-detection order
+    static std::vector<std::string> availableBackends();
+
+    // Changes for a poll/epoll loop, instead of observers. The first call to
+    // either starts mirroring the tree under handles (see MixerObject), the
+    // first batch being DeviceAdded and SessionAdded for all of it. eventFd()
+    // turns readable once per batch and drainEvents() replaces buffer's
+    // contents with it without blocking, returning the count (possibly 0).
+    // The fd is an eventfd, or a pipe where there is none, and belongs to the
+    // mixer; -1 on Windows, where drainEvents() can still be polled. The
+    // mirror observes the tree synchronously whatever the dispatch mode, so
+    // no thread is started to make the fd readable: that happens on the
+    // thread that made the change, once it holds no vmx lock. Throws
+    // std::runtime_error when the fd cannot be made.
+    int eventFd();
+    std::size_t drainEvents(std::vector<MixerChange> &buffer);
+    // The device or session behind a handle from drainEvents(), null once it is gone
+    std::shared_ptr<AudioDevice> eventDevice(std::uint32_t handle);
+    std::shared_ptr<AudioSession> eventSession(std::uint32_t handle);
+
 public: /* Virtual Methods */
-    virtual ~VolumeMixer() = default;
+    virtual ~VolumeMixer();
     virtual void setPeakSamplingPeriod(std::chrono::milliseconds period) = 0;
 
+    // How often sessions and devices report onLoudnessSample(); zero stops
+    // loudness metering. Backends without access to the audio never report it.
+    virtual void setLoudnessSamplingPeriod(std::chrono::milliseconds period);
+
 protected: /* Methods */
     void addDevice(const std::string &audioDeviceId, std::shared_ptr<AudioDevice> pAudioDevice);
     void removeDevice(const std::string &audioDeviceId);
 
+private: /* Methods */
+    void insertObserver(std::shared_ptr<Observer> pObserver, bool bNotifyNow, std::optional<DispatchMode> dispatchMode);
+    detail::EventQueue &eventQueue();
+
 private: /* Members */
     std::mutex m_mutex;
-    std::vector<std::weak_ptr<Observer>> m_observers;
+    std::vector<detail::ObserverEntry<Observer>> m_observers;
     std::map<std::string /*audioDeviceId*/, std::shared_ptr<AudioDevice>> m_audioDevices;
+    std::mutex m_eventQueueMutex;
+    std::shared_ptr<detail::EventQueue> m_pEventQueue; // made on first use
 };
 
 } // namespace vmx
\ No newline at end of file
@@ -2,15 +2,13 @@
 
 /* ==== Application Includes =============================================== */
 #include <vmx/VolumeMixer.h>
+#include <vmx/ServiceExecutor.h>
+#include <vmx/TimerService.h>
 
 /* ==== Standard Library Includes ========================================== */
-#include <condition_variable>
-#include <functional>
 #include <mutex>
-#include <queue>
-#include <stop_token>
 #include <string>
-#include <thread>
+#include <vector>
 
 
 /* ==== Operating System Includes ========================================== */
@@ -27,116 +25,6 @@ namespace vmx
 {
 
 /* ==== Helper Classes ===================================================== */
-template <class T>
-class QueuedWorkThread
-{
-public:
-    QueuedWorkThread(std::function<void(const T&)> queuedWorkFunction)
-      : m_queuedWorkFunction(queuedWorkFunction),
-        m_thread(std::bind_front(&QueuedWorkThread::workThreadFunc, this))
-    {
-    }
-
-    void queue(T &&workItem)
-    {
-        {
-            std::lock_guard guard(m_mutex);
-            m_queue.push(workItem);
-        }
-        m_condition.notify_one();
-    }
-
-private:
-    void workThreadFunc(std::stop_token stopToken)
-    {
-        while (true)
-        {
-            std::unique_lock lock(m_mutex);
-            if (!m_condition.wait(lock, stopToken, [this]{return !(this->m_queue.empty());}))
-            {
-                lock.unlock();
-                return;
-            }
-            T workItem = std::move(m_queue.front());
-            m_queue.pop();
-            lock.unlock();
-            m_queuedWorkFunction(workItem);
-        }
-    }
-private:
-    std::function<void(const T&)> m_queuedWorkFunction;
-    std::queue<T> m_queue;
-    std::jthread m_thread;
-    std::mutex m_mutex;
-    std::condition_variable_any m_condition;
-};
-
-class PeriodicWorkThread
-{
-public:
-    // A period of ZERO is special, means the threaded loop will block until destruction or period is changed
-    PeriodicWorkThread(std::function<void(void)> periodicFunction, std::chrono::milliseconds period)
-      : m_periodicFunction(periodicFunction),
-        m_period(period),
-        m_thread(std::bind_front(&PeriodicWorkThread::periodicThreadFunc, this))
-    {
-    }
-
-    void changePeriod(std::chrono::milliseconds period)
-    {
-        {
-            std::lock_guard guard(m_mutex);
-            m_period = period;
-            m_bPeriodUpdated = true;
-        }
-
-        m_condition.notify_all();
-    }
-
-private:
-    void periodicThreadFunc(std::stop_token stopToken)
-    {
-        while (true)
-        {
-            auto now = std::chrono::system_clock::now();
-            std::unique_lock lock(m_mutex);
-
-            if (m_period == std::chrono::milliseconds(0))
-            {
-               m_condition.wait(lock, stopToken,
-                    [this](){return m_bPeriodUpdated;});
-            }
-            else
-            {
-               m_condition.wait_until(lock, stopToken, now + m_period,
-                    [this](){return m_bPeriodUpdated;});
-            }
-            m_bPeriodUpdated = false;
-            if (stopToken.stop_requested())
-            {
-                lock.unlock();
-                return;
-            }
-            if (m_period == std::chrono::milliseconds(0))
-            {
-                lock.unlock();
-                continue;
-            }
-            lock.unlock();
-
-            m_periodicFunction();
-        }
-    }
-
-private:
-    std::function<void(void)> m_periodicFunction;
-    std::chrono::milliseconds m_period;
-    bool m_bPeriodUpdated = false;
-    std::jthread m_thread;
-    std::mutex m_mutex;
-    std::condition_variable_any m_condition;
-};
-
 class CoInitializer
 {
 public:
@@ -233,9 +121,11 @@ public: /* Virtual Methods */
     virtual ~WindowsAudioSession();
     virtual void changeVolume(float volume) override;
     virtual void changeMute(bool bMute) override;
+    virtual void changeChannelVolumes(std::vector<float> channelVolumes) override;
 
 private: /* Methods */
     void peakSample();
+    void refreshChannelVolumes();
 
 private: /* Members */
     std::recursive_mutex m_mutex;
@@ -244,6 +134,7 @@ private: /* Members */
     bool m_bAudioSessionEventsRegistered = false;
     SmartComPtr<IAudioSessionControl2> m_pAudioSessionControl2 = { nullptr, false };
     SmartComPtr<ISimpleAudioVolume> m_pSimpleAudioVolume = { nullptr, false };
+    SmartComPtr<IChannelAudioVolume> m_pChannelAudioVolume = { nullptr, false };
     SmartComPtr<IAudioMeterInformation> m_pAudioMeterInformation = { nullptr, false };
     std::string m_id = "";
     unsigned int m_pid = 0;
@@ -281,13 +172,14 @@ public: /* Friends */
     friend class WindowsVolumeMixer;
 
 public: /* Methods */
-    WindowsAudioDevice(IMMDevice *pMMDevice, bool bDefaultDevice);
+    WindowsAudioDevice(IMMDevice *pMMDevice, bool bDefaultDevice, ServiceExecutor &serviceExecutor);
     std::string getId() const { return m_id; };
 
 public: /* Virtual Methods */
     virtual ~WindowsAudioDevice();
     virtual void changeVolume(float volume) override;
     virtual void changeMute(bool bMute) override;
+    virtual void changeChannelVolumes(std::vector<float> channelVolumes) override;
 
 private: /* Methods */
     void markSessionForDeletion(const std::string &audioSessionId);
@@ -309,7 +201,7 @@ private: /* Members */
     std::map<std::string /* AudioSessionId */, SmartComPtr<CAudioSessionLifetimeObserver>> m_audioSessionLifetimeObservers;
     std::map<std::string /* AudioSessionId */, std::shared_ptr<WindowsAudioSession>> m_audioSessionsMirror;
     std::string m_id = "";
-    QueuedWorkThread<std::string> m_queuedWorkThread;
+    Strand m_strand; // session teardown on the mixer's ServiceExecutor
 
 public: /* Friends */
     friend class WindowsVolumeMixer;
@@ -392,8 +284,9 @@ private: /* Members */
     SmartComPtr<IMMDeviceCollection> m_pMMDeviceCollection = { nullptr, false }; // todo : we don't need to hold onto this past the constructor
     SmartComPtr<IMMNotificationClient> m_pMMNotificationClient = { nullptr, false };
     bool m_bNotificationClientRegistered = false;
+    ServiceExecutor m_serviceExecutor; // before the devices, whose strands post to it
     std::map<std::string /*audioDeviceId*/, std::shared_ptr<WindowsAudioDevice>> m_audioDevicesMirror;
-    PeriodicWorkThread m_peakSamplingThread;
+    PeriodicTimer m_peakSamplingTimer;
 
 public: /* Friends */
     friend class CMMNotificationClient;
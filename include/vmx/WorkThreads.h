@@ -0,0 +1,78 @@
+#pragma once
+
+/* ==== Application Includes =============================================== */
+#include <vmx/Metrics.h>
+#include <vmx/MpscQueue.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace vmx
+{
+
+/* ==== Helper Classes ===================================================== */
+// Runs queuedWorkFunction on its own thread for every item queued, in order.
+// Items go through an MpscQueue, so producers never contend on a lock, and
+// only the item that finds the queue empty wakes the thread, which then takes
+// everything queued by then in one go. Items may be move-only; whatever is
+// still queued at destruction is dropped. The thread is counted under role
+// in VolumeMixer::threadInventory().
+template <class T>
+class QueuedWorkThread
+{
+public:
+    QueuedWorkThread(std::function<void(T)> queuedWorkFunction, ThreadRole role = ThreadRole::WorkQueue)
+      : m_queuedWorkFunction(std::move(queuedWorkFunction)),
+        m_thread([this, role](std::stop_token stopToken){ workThreadFunc(stopToken, role); })
+    {
+    }
+
+    void queue(T &&workItem)
+    {
+        if (m_queue.push(std::move(workItem)))
+        {
+            // Under the mutex, so the wakeup cannot fall between the thread's check and its wait
+            std::lock_guard guard(m_mutex);
+            m_condition.notify_one();
+        }
+    }
+
+    std::thread::id threadId() const { return m_thread.get_id(); };
+
+private:
+    void workThreadFunc(std::stop_token stopToken, ThreadRole role)
+    {
+        ScopedThreadRole threadRole(role);
+        std::vector<T> batch;
+        while (true)
+        {
+            {
+                std::unique_lock lock(m_mutex);
+                if (!m_condition.wait(lock, stopToken, [this]{return !m_queue.empty();}))
+                {
+                    return;
+                }
+            }
+            batch.clear();
+            m_queue.drain(batch);
+            for (T &workItem : batch)
+            {
+                m_queuedWorkFunction(std::move(workItem));
+            }
+        }
+    }
+private:
+    std::function<void(T)> m_queuedWorkFunction;
+    MpscQueue<T> m_queue;
+    std::mutex m_mutex; // only to sleep on, items never wait for it
+    std::condition_variable_any m_condition;
+    std::jthread m_thread; // last, so it starts after and joins before the members it uses
+};
+
+} // namespace vmx
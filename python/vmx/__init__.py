@@ -0,0 +1,329 @@
+"""Python bindings for vmx, over the C API in vmx/CApi.h.
+
+Meters come back as NumPy arrays that view the library's own memory, so
+sampling hundreds of sessions creates no Python objects per sample. Events
+come in batches as NumPy structured arrays, one Python call per batch, and
+``Mixer.events()`` is an async iterator over them. Waiting costs nothing:
+the library's delivery thread only takes the GIL to hand a batch over.
+
+The shared library is libvmx_core (vmx_core.dll on Windows) from a build
+with VMX_BUILD_PLUGINS=ON. Set VMX_LIBRARY to its path if it is not on the
+loader's search path.
+"""
+
+import asyncio
+import ctypes
+import ctypes.util
+import os
+import sys
+import threading
+from dataclasses import dataclass
+
+import numpy as np
+
+__all__ = ["Mixer", "Object", "VmxError", "EVENT_DTYPE", "EventKind"]
+
+ABI_VERSION = 1
+
+# ==== Library ================================================================
+def _load_library():
+    path = os.environ.get("VMX_LIBRARY")
+    if not path:
+        path = ctypes.util.find_library("vmx_core")
+    if not path:
+        path = "vmx_core.dll" if sys.platform == "win32" else "libvmx_core.so"
+    return ctypes.CDLL(path)  # CDLL releases the GIL around every call
+
+
+class _Object(ctypes.Structure):
+    _fields_ = [
+        ("handle", ctypes.c_uint32),
+        ("parent", ctypes.c_uint32),
+        ("version", ctypes.c_uint64),
+        ("is_session", ctypes.c_uint8),
+        ("state", ctypes.c_uint8),
+        ("is_default", ctypes.c_uint8),
+        ("is_muted", ctypes.c_uint8),
+        ("channel_count", ctypes.c_uint32),
+        ("volume", ctypes.c_float),
+        ("peak", ctypes.c_float),
+        ("loudness_momentary", ctypes.c_float),
+        ("loudness_short_term", ctypes.c_float),
+        ("loudness_integrated", ctypes.c_float),
+    ]
+
+
+class _Meters(ctypes.Structure):
+    _fields_ = [
+        ("seq", ctypes.POINTER(ctypes.c_uint64)),
+        ("capacity", ctypes.c_uint32),
+        ("reserved", ctypes.c_uint32),
+        ("handles", ctypes.POINTER(ctypes.c_uint32)),
+        ("peaks", ctypes.POINTER(ctypes.c_float)),
+        ("loudness_momentary", ctypes.POINTER(ctypes.c_float)),
+        ("loudness_short_term", ctypes.POINTER(ctypes.c_float)),
+        ("loudness_integrated", ctypes.POINTER(ctypes.c_float)),
+    ]
+
+
+# The layout of vmx_event
+EVENT_DTYPE = np.dtype([
+    ("seq", np.uint64),
+    ("handle", np.uint32),
+    ("parent", np.uint32),
+    ("kind", np.uint32),
+    ("is_session", np.uint8),
+    ("state", np.uint8),
+    ("is_default", np.uint8),
+    ("is_muted", np.uint8),
+    ("volume", np.float32),
+    ("peak", np.float32),
+    ("loudness_momentary", np.float32),
+    ("loudness_short_term", np.float32),
+    ("loudness_integrated", np.float32),
+], align=True)
+assert EVENT_DTYPE.itemsize == 48
+
+
+class EventKind:
+    """The values of vmx_event_kind (and vmx::EventKind)."""
+    NAME = 0
+    ICON_PATH = 1
+    STATE = 2
+    DEFAULT = 3
+    VOLUME = 4
+    CHANNEL_VOLUMES = 5
+    MUTE = 6
+    PEAK_SAMPLE = 7
+    LOUDNESS_SAMPLE = 8
+    SESSION_ADDED = 9
+    SESSION_REMOVED = 10
+    DEVICE_ADDED = 11
+    DEVICE_REMOVED = 12
+
+
+_EVENT_CALLBACK = ctypes.CFUNCTYPE(None, ctypes.c_void_p, ctypes.c_void_p, ctypes.c_size_t)
+
+_STRING_ID, _STRING_NAME, _STRING_ICON_PATH = 0, 1, 2
+_NOT_FOUND = -2
+
+_lib = _load_library()
+_lib.vmx_abi_version.restype = ctypes.c_uint32
+_lib.vmx_last_error.restype = ctypes.c_char_p
+_lib.vmx_mixer_create.restype = ctypes.c_void_p
+_lib.vmx_mixer_create.argtypes = [ctypes.c_char_p, _EVENT_CALLBACK, ctypes.c_void_p]
+_lib.vmx_mixer_destroy.argtypes = [ctypes.c_void_p]
+_lib.vmx_mixer_set_peak_sampling_period.argtypes = [ctypes.c_void_p, ctypes.c_uint32]
+_lib.vmx_mixer_set_loudness_sampling_period.argtypes = [ctypes.c_void_p, ctypes.c_uint32]
+_lib.vmx_mixer_list.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_uint32), ctypes.c_size_t]
+_lib.vmx_mixer_get_object.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.POINTER(_Object)]
+_lib.vmx_mixer_get_string.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.c_int, ctypes.c_char_p, ctypes.c_size_t]
+_lib.vmx_mixer_get_channel_volumes.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.POINTER(ctypes.c_float), ctypes.c_size_t]
+_lib.vmx_mixer_get_meters.argtypes = [ctypes.c_void_p, ctypes.POINTER(_Meters)]
+_lib.vmx_mixer_set_volume.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.c_float]
+_lib.vmx_mixer_set_mute.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.c_int]
+_lib.vmx_mixer_set_channel_volumes.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.POINTER(ctypes.c_float), ctypes.c_size_t]
+
+if _lib.vmx_abi_version() != ABI_VERSION:
+    raise ImportError(f"vmx: library ABI version {_lib.vmx_abi_version()}, these bindings need {ABI_VERSION}")
+
+
+# ==== Classes ================================================================
+class VmxError(RuntimeError):
+    pass
+
+
+def _check(result):
+    if result < 0:
+        raise VmxError(_lib.vmx_last_error().decode(errors="replace"))
+    return result
+
+
+@dataclass
+class Object:
+    """A device or session as the mixer last reported it."""
+    handle: int
+    parent: int
+    is_session: bool
+    id: str
+    name: str
+    icon_path: str
+    state: int
+    is_default: bool
+    volume: float
+    channel_volumes: list
+    is_muted: bool
+    peak: float
+    loudness: tuple  # momentary, short-term, integrated LUFS
+
+
+class Meters:
+    """Live views of the library's meter arrays.
+
+    handles, peaks and the loudness arrays change under you once per event
+    batch; slot i belongs to handles[i] and a 0 handle is a free slot. Use
+    snapshot() for a consistent copy. The views are only valid until the
+    mixer is closed.
+    """
+
+    def __init__(self, meters, owner):
+        capacity = meters.capacity
+        self._owner = owner  # the arrays live as long as the mixer
+        self._seq = np.ctypeslib.as_array(meters.seq, shape=(1,))
+        self.handles = np.ctypeslib.as_array(meters.handles, shape=(capacity,))
+        self.peaks = np.ctypeslib.as_array(meters.peaks, shape=(capacity,))
+        self.loudness_momentary = np.ctypeslib.as_array(meters.loudness_momentary, shape=(capacity,))
+        self.loudness_short_term = np.ctypeslib.as_array(meters.loudness_short_term, shape=(capacity,))
+        self.loudness_integrated = np.ctypeslib.as_array(meters.loudness_integrated, shape=(capacity,))
+        for array in (self._seq, self.handles, self.peaks, self.loudness_momentary,
+                      self.loudness_short_term, self.loudness_integrated):
+            array.flags.writeable = False
+
+    @property
+    def seq(self):
+        return int(self._seq[0])
+
+    def snapshot(self):
+        """(handles, peaks) of the slots in use, copied from one batch."""
+        while True:
+            seq = int(self._seq[0])
+            if seq % 2:
+                continue
+            handles = self.handles.copy()
+            peaks = self.peaks.copy()
+            if int(self._seq[0]) == seq:
+                used = handles != 0
+                return handles[used], peaks[used]
+
+
+class Mixer:
+    """One VolumeMixer. backend is a name from VolumeMixer::availableBackends(),
+    or None to pick one."""
+
+    def __init__(self, backend=None):
+        self._mixer = None
+        self._lock = threading.Lock()
+        self._subscribers = []  # (loop, queue)
+        self._callback = _EVENT_CALLBACK(self._on_events)  # kept alive for the library
+        self._mixer = _lib.vmx_mixer_create(backend.encode() if backend else None, self._callback, None)
+        if not self._mixer:
+            raise VmxError(_lib.vmx_last_error().decode(errors="replace"))
+        meters = _Meters()
+        _check(_lib.vmx_mixer_get_meters(self._mixer, ctypes.byref(meters)))
+        self.meters = Meters(meters, self)
+
+    def close(self):
+        if self._mixer:
+            _lib.vmx_mixer_destroy(self._mixer)
+            self._mixer = None
+            with self._lock:
+                for loop, queue in self._subscribers:
+                    loop.call_soon_threadsafe(queue.put_nowait, None)
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def __del__(self):
+        if getattr(self, "_mixer", None):
+            self.close()
+
+    # ---- Tree ---------------------------------------------------------------
+    def handles(self):
+        """Every handle, devices before their sessions."""
+        count = _check(_lib.vmx_mixer_list(self._mixer, None, 0))
+        while True:
+            handles = (ctypes.c_uint32 * count)()
+            total = _check(_lib.vmx_mixer_list(self._mixer, handles, count))
+            if total <= count:
+                return list(handles[:total])
+            count = total
+
+    def object(self, handle):
+        """The Object for handle, or None once it is gone."""
+        raw = _Object()
+        if _lib.vmx_mixer_get_object(self._mixer, handle, ctypes.byref(raw)) == _NOT_FOUND:
+            return None
+        return Object(
+            handle=raw.handle,
+            parent=raw.parent,
+            is_session=bool(raw.is_session),
+            id=self._string(handle, _STRING_ID),
+            name=self._string(handle, _STRING_NAME),
+            icon_path=self._string(handle, _STRING_ICON_PATH),
+            state=raw.state,
+            is_default=bool(raw.is_default),
+            volume=raw.volume,
+            channel_volumes=self.channel_volumes(handle),
+            is_muted=bool(raw.is_muted),
+            peak=raw.peak,
+            loudness=(raw.loudness_momentary, raw.loudness_short_term, raw.loudness_integrated),
+        )
+
+    def objects(self):
+        return [o for o in (self.object(h) for h in self.handles()) if o is not None]
+
+    def channel_volumes(self, handle):
+        volumes = (ctypes.c_float * 64)()
+        count = _check(_lib.vmx_mixer_get_channel_volumes(self._mixer, handle, volumes, 64))
+        return list(volumes[:min(count, 64)])
+
+    def _string(self, handle, field):
+        size = 256
+        while True:
+            buffer = ctypes.create_string_buffer(size)
+            length = _lib.vmx_mixer_get_string(self._mixer, handle, field, buffer, size)
+            if length < 0:
+                return ""
+            if length < size:
+                return buffer.value.decode(errors="replace")
+            size = length + 1
+
+    # ---- Control ------------------------------------------------------------
+    def set_peak_sampling_period(self, milliseconds):
+        _check(_lib.vmx_mixer_set_peak_sampling_period(self._mixer, int(milliseconds)))
+
+    def set_loudness_sampling_period(self, milliseconds):
+        _check(_lib.vmx_mixer_set_loudness_sampling_period(self._mixer, int(milliseconds)))
+
+    def set_volume(self, handle, volume):
+        _check(_lib.vmx_mixer_set_volume(self._mixer, handle, float(volume)))
+
+    def set_mute(self, handle, mute):
+        _check(_lib.vmx_mixer_set_mute(self._mixer, handle, 1 if mute else 0))
+
+    def set_channel_volumes(self, handle, volumes):
+        array = np.ascontiguousarray(volumes, dtype=np.float32)
+        pointer = array.ctypes.data_as(ctypes.POINTER(ctypes.c_float))
+        _check(_lib.vmx_mixer_set_channel_volumes(self._mixer, handle, pointer, len(array)))
+
+    # ---- Events -------------------------------------------------------------
+    async def events(self):
+        """Yields each batch of events, from now on, as an EVENT_DTYPE array."""
+        loop = asyncio.get_running_loop()
+        queue = asyncio.Queue()
+        subscriber = (loop, queue)
+        with self._lock:
+            self._subscribers.append(subscriber)
+        try:
+            while True:
+                batch = await queue.get()
+                if batch is None:
+                    return
+                yield batch
+        finally:
+            with self._lock:
+                self._subscribers.remove(subscriber)
+
+    def _on_events(self, _user_data, events, count):
+        # One copy of the whole batch; it is only valid during the call
+        batch = np.frombuffer(ctypes.string_at(events, count * EVENT_DTYPE.itemsize), dtype=EVENT_DTYPE)
+        with self._lock:
+            subscribers = list(self._subscribers)
+        for loop, queue in subscribers:
+            try:
+                loop.call_soon_threadsafe(queue.put_nowait, batch)
+            except RuntimeError:
+                pass  # the loop has closed
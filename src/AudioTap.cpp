@@ -0,0 +1,105 @@
+/* ==== Application Includes =============================================== */
+#include <vmx/AudioTap.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace vmx
+{
+
+/* ==== AudioTap Class ===================================================== */
+AudioTap::AudioTap
+(
+    unsigned int sampleRate,
+    std::size_t channelCount,
+    std::chrono::milliseconds bufferLength
+)
+  : m_sampleRate(sampleRate),
+    m_channelCount(channelCount),
+    m_ring(std::max<std::size_t>(1, static_cast<std::size_t>(bufferLength.count()) * sampleRate / 1000) * channelCount, channelCount)
+{
+    if (channelCount == 0)
+    {
+        throw std::runtime_error("AudioTap needs at least one channel");
+    }
+}
+
+std::span<const float>
+AudioTap::read()
+{
+    return m_ring.readable();
+}
+
+void
+AudioTap::consume
+(
+    std::size_t frameCount
+)
+{
+    m_ring.commitRead(frameCount * m_channelCount);
+}
+
+std::size_t
+AudioTap::write
+(
+    std::span<const float* const> channels,
+    std::size_t frameCount
+)
+{
+    // Channels the backend has no audio for are written as silence
+    const std::size_t channelCount = std::min(channels.size(), m_channelCount);
+    std::size_t written = 0;
+
+    // Twice, because the free space may continue from the start of the ring
+    for (int pass = 0; pass < 2 && written < frameCount && !isClosed(); ++pass)
+    {
+        std::span<float> free = m_ring.writable();
+        std::size_t count = std::min(frameCount - written, free.size() / m_channelCount);
+        for (std::size_t frame = 0; frame < count; ++frame)
+        {
+            float *pFrame = &free[frame * m_channelCount];
+            for (std::size_t channel = 0; channel < channelCount; ++channel)
+            {
+                pFrame[channel] = channels[channel][written + frame];
+            }
+            std::fill(pFrame + channelCount, pFrame + m_channelCount, 0.0f);
+        }
+        m_ring.commitWrite(count * m_channelCount);
+        written += count;
+    }
+
+    if (written < frameCount && !isClosed())
+    {
+        m_droppedFrames.fetch_add(frameCount - written, std::memory_order_relaxed);
+    }
+    return written;
+}
+
+std::size_t
+AudioTap::write
+(
+    const float *pFrames,
+    std::size_t frameCount
+)
+{
+    std::size_t written = 0;
+    for (int pass = 0; pass < 2 && written < frameCount && !isClosed(); ++pass)
+    {
+        std::span<float> free = m_ring.writable();
+        std::size_t count = std::min(frameCount - written, free.size() / m_channelCount);
+        std::memcpy(free.data(), pFrames + written * m_channelCount, count * m_channelCount * sizeof(float));
+        m_ring.commitWrite(count * m_channelCount);
+        written += count;
+    }
+
+    if (written < frameCount && !isClosed())
+    {
+        m_droppedFrames.fetch_add(frameCount - written, std::memory_order_relaxed);
+    }
+    return written;
+}
+
+} // namespace vmx
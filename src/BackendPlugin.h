@@ -0,0 +1,55 @@
+#pragma once
+
+/* ==== Application Includes =============================================== */
+#include <vmx/VolumeMixer.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <cstdint>
+
+/* ==== Macros ============================================================= */
+#ifdef _WIN32
+#define VMX_PLUGIN_EXPORT __declspec(dllexport)
+#else
+#define VMX_PLUGIN_EXPORT __attribute__((visibility("default")))
+#endif
+
+#define VMX_BACKEND_PLUGIN_SYMBOL "vmxBackendPlugin"
+
+// Expands to the one symbol a backend module exports. The module links
+// against the shared vmx_core, so the mixer it creates shares the process
+// wide metrics, stats and trace state with everything else.
+#define VMX_DEFINE_BACKEND_PLUGIN(backendName, MixerClass)                                                  \
+    extern "C" VMX_PLUGIN_EXPORT const vmx::detail::BackendPlugin *vmxBackendPlugin()                       \
+    {                                                                                                       \
+        static const vmx::detail::BackendPlugin plugin = {                                                  \
+            vmx::detail::kBackendPluginAbiVersion,                                                          \
+            (backendName),                                                                                  \
+            []() -> vmx::VolumeMixer* { return new MixerClass(); },                                         \
+        };                                                                                                  \
+        return &plugin;                                                                                     \
+    }
+
+namespace vmx::detail
+{
+
+/* ==== Types ============================================================== */
+// Bumped whenever this struct changes, or the layout or vtable of a class a
+// module compiles against (VolumeMixer, AudioSession, AudioDevice, Metrics),
+// so a stale module left next to a newer vmx_core is skipped instead of
+// crashing. 2: loudness, audio taps, channel volumes, eventFd(), timer and
+// thread inventory metrics.
+inline constexpr std::uint32_t kBackendPluginAbiVersion = 2;
+
+struct BackendPlugin
+{
+    std::uint32_t abiVersion;
+    const char *name;
+    VolumeMixer *(*create)();
+};
+
+using BackendPluginEntryPoint = const BackendPlugin *(*)();
+
+} // namespace vmx::detail
+
+/* ==== Functions ========================================================== */
+extern "C" VMX_PLUGIN_EXPORT const vmx::detail::BackendPlugin *vmxBackendPlugin();
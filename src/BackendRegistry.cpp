@@ -0,0 +1,396 @@
+/* ==== Application Includes =============================================== */
+#include <vmx/VolumeMixer.h>
+#include <vmx/SimulatedVolumeMixer.h>
+#include "BackendPlugin.h"
+
+#if VMX_HAS_WINDOWS
+#include <vmx/WindowsVolumeMixer.h>
+#endif
+#if VMX_HAS_PIPEWIRE
+#include <vmx/PipeWireVolumeMixer.h>
+#endif
+#if VMX_HAS_PULSEAUDIO
+#include <vmx/PulseVolumeMixer.h>
+#endif
+#if VMX_HAS_JACK
+#include <vmx/JackVolumeMixer.h>
+#endif
+
+/* ==== Standard Library Includes ========================================== */
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+
+/* ==== Operating System Includes ========================================== */
+#ifdef VMX_PLUGIN_SUFFIX
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+#endif
+
+/* ==== Types ============================================================== */
+namespace
+{
+
+// isReachable only looks for the server's socket or shared memory, so auto
+// detection never loads a client library it will not use. createBuiltIn is
+// null for backends that live in a plugin module.
+struct Backend
+{
+    const char *name;
+    bool (*isReachable)();
+    vmx::VolumeMixer *(*createBuiltIn)();
+};
+
+} // namespace
+
+/* ==== Forward Declarations =============================================== */
+static const std::vector<Backend> &backends();
+static const Backend *findBackend(const std::string &name);
+static vmx::VolumeMixer *createBackend(const Backend &backend);
+#ifdef _WIN32
+static bool isWindowsReachable();
+#else
+#ifndef __APPLE__
+static bool isPipeWireReachable();
+static bool isPulseAudioReachable();
+static std::filesystem::path environmentPath(const char *name);
+#endif
+static bool isJackReachable();
+#endif
+
+#ifdef VMX_PLUGIN_SUFFIX
+static std::vector<std::filesystem::path> pluginSearchPath();
+static std::filesystem::path findPlugin(const std::string &name);
+static const vmx::detail::BackendPlugin *loadPlugin(const std::string &name);
+static std::filesystem::path coreLibraryDirectory();
+#endif
+
+namespace vmx
+{
+
+/* ==== VolumeMixer Factory ================================================ */
+std::unique_ptr<VolumeMixer>
+VolumeMixer::create
+(
+    const std::string &backendName
+)
+{
+    if (!backendName.empty())
+    {
+        const Backend *pBackend = findBackend(backendName);
+        if (!pBackend)
+        {
+            throw std::runtime_error("Unknown vmx backend " + backendName);
+        }
+        return std::unique_ptr<VolumeMixer>(createBackend(*pBackend));
+    }
+
+    std::string failures = "";
+    for (const auto &backend : backends())
+    {
+        if (!backend.isReachable || !backend.isReachable())
+        {
+            continue;
+        }
+
+        try
+        {
+            return std::unique_ptr<VolumeMixer>(createBackend(backend));
+        }
+        catch (const std::exception &e)
+        {
+            failures += std::string("; ") + backend.name + ": " + e.what();
+        }
+    }
+    throw std::runtime_error("No vmx backend could reach an audio server" + failures);
+}
+
+std::vector<std::string>
+VolumeMixer::availableBackends()
+{
+    std::vector<std::string> names;
+    for (const auto &backend : backends())
+    {
+#ifdef VMX_PLUGIN_SUFFIX
+        if (!backend.createBuiltIn && findPlugin(backend.name).empty())
+        {
+            continue;
+        }
+#endif
+        names.emplace_back(backend.name);
+    }
+    return names;
+}
+
+} // namespace vmx
+
+/* ==== Static Functions =================================================== */
+static const std::vector<Backend> &
+backends()
+{
+    // Auto detection order; simulated is never picked unless asked for by name
+    static const std::vector<Backend> s_backends = {
+#ifdef _WIN32
+        {"windows", isWindowsReachable,
+#if VMX_HAS_WINDOWS
+            []() -> vmx::VolumeMixer* { return new vmx::WindowsVolumeMixer(); }},
+#else
+            nullptr},
+#endif
+#endif
+#if !defined(_WIN32) && !defined(__APPLE__)
+        {"pipewire", isPipeWireReachable,
+#if VMX_HAS_PIPEWIRE
+            []() -> vmx::VolumeMixer* { return new vmx::PipeWireVolumeMixer(); }},
+#else
+            nullptr},
+#endif
+        {"pulseaudio", isPulseAudioReachable,
+#if VMX_HAS_PULSEAUDIO
+            []() -> vmx::VolumeMixer* { return new vmx::PulseVolumeMixer(); }},
+#else
+            nullptr},
+#endif
+#endif
+#ifndef _WIN32
+        {"jack", isJackReachable,
+#if VMX_HAS_JACK
+            []() -> vmx::VolumeMixer* { return new vmx::JackVolumeMixer(); }},
+#else
+            nullptr},
+#endif
+#endif
+        {"simulated", nullptr,
+            []() -> vmx::VolumeMixer* { return new vmx::SimulatedVolumeMixer(); }},
+    };
+    return s_backends;
+}
+
+static const Backend *
+findBackend
+(
+    const std::string &name
+)
+{
+    for (const auto &backend : backends())
+    {
+        if (name == backend.name) return &backend;
+    }
+    return nullptr;
+}
+
+static vmx::VolumeMixer *
+createBackend
+(
+    const Backend &backend
+)
+{
+    if (backend.createBuiltIn)
+    {
+        return backend.createBuiltIn();
+    }
+
+#ifdef VMX_PLUGIN_SUFFIX
+    return loadPlugin(backend.name)->create();
+#else
+    throw std::runtime_error(std::string("vmx was built without the ") + backend.name + " backend");
+#endif
+}
+
+#ifdef _WIN32
+static bool
+isWindowsReachable()
+{
+    return true;
+}
+#else
+#ifndef __APPLE__
+static bool
+isPipeWireReachable()
+{
+    std::filesystem::path remote = environmentPath("PIPEWIRE_REMOTE");
+    if (remote.empty()) remote = "pipewire-0";
+    if (remote.is_relative())
+    {
+        std::filesystem::path runtimeDir = environmentPath("PIPEWIRE_RUNTIME_DIR");
+        if (runtimeDir.empty()) runtimeDir = environmentPath("XDG_RUNTIME_DIR");
+        if (runtimeDir.empty()) return false;
+        remote = runtimeDir / remote;
+    }
+
+    std::error_code error;
+    return std::filesystem::exists(remote, error);
+}
+
+static bool
+isPulseAudioReachable()
+{
+    // Could be a remote server, which only a connection attempt can rule out
+    if (!environmentPath("PULSE_SERVER").empty()) return true;
+
+    std::filesystem::path runtimeDir = environmentPath("PULSE_RUNTIME_PATH");
+    if (runtimeDir.empty())
+    {
+        runtimeDir = environmentPath("XDG_RUNTIME_DIR");
+        if (runtimeDir.empty()) return false;
+        runtimeDir /= "pulse";
+    }
+
+    std::error_code error;
+    return std::filesystem::exists(runtimeDir / "native", error);
+}
+
+static std::filesystem::path
+environmentPath
+(
+    const char *name
+)
+{
+    const char *value = std::getenv(name);
+    return (value && *value) ? std::filesystem::path(value) : std::filesystem::path();
+}
+#endif
+
+static bool
+isJackReachable()
+{
+    // Both jackd implementations keep their server and semaphores in /dev/shm
+    std::error_code error;
+    for (std::filesystem::directory_iterator it("/dev/shm", error), end; !error && it != end; it.increment(error))
+    {
+        if (std::string_view(it->path().filename().native()).starts_with("jack")) return true;
+    }
+    return false;
+}
+#endif
+
+#ifdef VMX_PLUGIN_SUFFIX
+static std::vector<std::filesystem::path>
+pluginSearchPath()
+{
+#ifdef _WIN32
+    constexpr char kSeparator = ';';
+#else
+    constexpr char kSeparator = ':';
+#endif
+
+    std::vector<std::filesystem::path> directories;
+    if (const char *pluginPath = std::getenv("VMX_PLUGIN_PATH"))
+    {
+        std::string_view remaining = pluginPath;
+        while (!remaining.empty())
+        {
+            std::size_t separator = remaining.find(kSeparator);
+            std::string_view directory = remaining.substr(0, separator);
+            if (!directory.empty()) directories.emplace_back(directory);
+            remaining = (separator == std::string_view::npos) ? std::string_view() : remaining.substr(separator + 1);
+        }
+    }
+    directories.push_back(coreLibraryDirectory());
+    return directories;
+}
+
+static std::filesystem::path
+findPlugin
+(
+    const std::string &name
+)
+{
+    std::string fileName = "vmx-" + name + VMX_PLUGIN_SUFFIX;
+    for (const auto &directory : pluginSearchPath())
+    {
+        std::error_code error;
+        if (!directory.empty() && std::filesystem::is_regular_file(directory / fileName, error))
+        {
+            return directory / fileName;
+        }
+    }
+    return {};
+}
+
+static const vmx::detail::BackendPlugin *
+loadPlugin
+(
+    const std::string &name
+)
+{
+    // Modules are never unloaded: mixers and the threads they started may
+    // outlive any reference count we could keep here.
+    static std::mutex s_mutex;
+    static std::map<std::string, const vmx::detail::BackendPlugin*> s_plugins;
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (auto it = s_plugins.find(name); it != s_plugins.end())
+    {
+        return it->second;
+    }
+
+    std::filesystem::path path = findPlugin(name);
+    if (path.empty())
+    {
+        throw std::runtime_error("Unable to find the vmx-" + name + VMX_PLUGIN_SUFFIX + " plugin");
+    }
+
+#ifdef _WIN32
+    HMODULE hModule = LoadLibraryW(path.c_str());
+    if (!hModule)
+    {
+        throw std::runtime_error("Unable to load " + path.string() + ", error " + std::to_string(GetLastError()));
+    }
+    auto entryPoint = reinterpret_cast<vmx::detail::BackendPluginEntryPoint>(
+        reinterpret_cast<void*>(GetProcAddress(hModule, VMX_BACKEND_PLUGIN_SYMBOL)));
+#else
+    void *pModule = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!pModule)
+    {
+        throw std::runtime_error("Unable to load " + path.string() + ": " + dlerror());
+    }
+    auto entryPoint = reinterpret_cast<vmx::detail::BackendPluginEntryPoint>(dlsym(pModule, VMX_BACKEND_PLUGIN_SYMBOL));
+#endif
+    if (!entryPoint)
+    {
+        throw std::runtime_error(path.string() + " is not a vmx backend plugin");
+    }
+
+    const vmx::detail::BackendPlugin *pPlugin = entryPoint();
+    if (!pPlugin || pPlugin->abiVersion != vmx::detail::kBackendPluginAbiVersion)
+    {
+        throw std::runtime_error(path.string() + " was built against a different vmx version");
+    }
+
+    s_plugins.emplace(name, pPlugin);
+    return pPlugin;
+}
+
+static std::filesystem::path
+coreLibraryDirectory()
+{
+    // Any object inside vmx_core identifies the module it was loaded from
+    static const char s_anchor = 0;
+
+#ifdef _WIN32
+    HMODULE hModule = nullptr;
+    if (!GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                            reinterpret_cast<LPCWSTR>(&s_anchor), &hModule))
+    {
+        return {};
+    }
+    std::wstring fileName(MAX_PATH, L'\0');
+    DWORD length = GetModuleFileNameW(hModule, fileName.data(), static_cast<DWORD>(fileName.size()));
+    if (length == 0 || length == fileName.size()) return {};
+    fileName.resize(length);
+    return std::filesystem::path(fileName).parent_path();
+#else
+    Dl_info info = {};
+    if (!dladdr(&s_anchor, &info) || !info.dli_fname) return {};
+    return std::filesystem::path(info.dli_fname).parent_path();
+#endif
+}
+#endif
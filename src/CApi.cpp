@@ -0,0 +1,472 @@
+/* ==== Application Includes =============================================== */
+#include <vmx/CApi.h>
+#include <vmx/VolumeMixer.h>
+#include "ObjectTable.h"
+#include "Tracing.h"
+
+/* ==== Standard Library Includes ========================================== */
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+/* ==== Structures ========================================================= */
+static_assert(std::is_standard_layout_v<vmx_event> && sizeof(vmx_event) == 48, "vmx_event is part of the C ABI");
+static_assert(std::is_standard_layout_v<vmx_object> && sizeof(vmx_object) == 48, "vmx_object is part of the C ABI");
+static_assert(VMX_EVENT_DEVICE_REMOVED + 1 == vmx::kEventKindCount, "vmx_event_kind has to match vmx::EventKind");
+
+// The mixer, its handle table, its meters, and the thread that updates the
+// meters and runs the callback
+struct vmx_mixer
+{
+    static constexpr std::uint32_t kMeterCapacity = 1024;
+
+    void deliver(std::stop_token stopToken);
+    void updateMeters(const std::vector<vmx::detail::ObjectTable::Pending> &pending);
+
+    std::unique_ptr<vmx::VolumeMixer> pVolumeMixer;
+    std::shared_ptr<vmx::detail::ObjectTable> pObjectTable;
+    vmx_event_callback callback = nullptr;
+    void *pUserData = nullptr;
+    std::uint64_t meterSeq = 0;
+    std::vector<vmx_handle> meterHandles = std::vector<vmx_handle>(kMeterCapacity, 0);
+    std::vector<float> peaks = std::vector<float>(kMeterCapacity, 0.0f);
+    std::vector<float> loudnessMomentary = std::vector<float>(kMeterCapacity, vmx::Loudness::kSilence);
+    std::vector<float> loudnessShortTerm = std::vector<float>(kMeterCapacity, vmx::Loudness::kSilence);
+    std::vector<float> loudnessIntegrated = std::vector<float>(kMeterCapacity, vmx::Loudness::kSilence);
+    std::map<vmx_handle, std::uint32_t> meterSlots; // only touched by deliver()
+    std::vector<std::uint32_t> freeMeterSlots;
+    std::mutex wakeMutex;
+    std::condition_variable_any wakeCondition;
+    bool bWake = false;
+    std::jthread thread; // last, so it starts after and joins before the members it uses
+};
+
+/* ==== Forward Declarations =============================================== */
+template <class Call> static int guarded(vmx_mixer *pMixer, Call call);
+static void fill(vmx_object &object, const vmx::MixerObject &from);
+static void fill(vmx_event &event, const vmx::detail::ObjectTable::Pending &from);
+
+/* ==== Globals ============================================================ */
+static thread_local std::string t_lastError = "";
+
+/* ==== vmx_mixer Structure ================================================ */
+void
+vmx_mixer::deliver
+(
+    std::stop_token stopToken
+)
+{
+    VMX_TRACE_THREAD_NAME("vmx C API");
+    vmx::ScopedThreadRole threadRole(vmx::ThreadRole::CApiDelivery);
+    std::vector<vmx_event> events;
+    while (!stopToken.stop_requested())
+    {
+        {
+            std::unique_lock lock(wakeMutex);
+            wakeCondition.wait(lock, stopToken, [this]{ return bWake; });
+            bWake = false;
+        }
+
+        auto pending = pObjectTable->takePending();
+        if (pending.empty()) continue;
+        updateMeters(pending);
+        if (!callback) continue;
+        events.resize(pending.size());
+        for (std::size_t i = 0; i < pending.size(); ++i)
+        {
+            fill(events[i], pending[i]);
+        }
+        VMX_TRACE_SCOPE("vmx_event_callback", "control");
+        callback(pUserData, events.data(), events.size());
+    }
+}
+
+void
+vmx_mixer::updateMeters
+(
+    const std::vector<vmx::detail::ObjectTable::Pending> &pending
+)
+{
+    // Readers are in other threads (or languages) and only see plain memory.
+    // Stores are releases so a reader that sees one also sees the odd seq;
+    // no standalone fence, which ThreadSanitizer cannot model.
+    auto store = [](auto &target, auto value){ std::atomic_ref(target).store(value, std::memory_order_release); };
+    auto setLoudness = [&](std::uint32_t slot, const vmx::Loudness &loudness){
+        store(loudnessMomentary[slot], loudness.momentary);
+        store(loudnessShortTerm[slot], loudness.shortTerm);
+        store(loudnessIntegrated[slot], loudness.integrated);
+    };
+
+    std::atomic_ref(meterSeq).fetch_add(1, std::memory_order_acq_rel);
+    for (const auto &entry : pending)
+    {
+        vmx_handle handle = entry.event.handle;
+        switch (entry.event.kind)
+        {
+            case vmx::EventKind::DeviceAdded:
+            case vmx::EventKind::SessionAdded:
+            {
+                std::uint32_t slot = static_cast<std::uint32_t>(meterSlots.size());
+                if (!freeMeterSlots.empty())
+                {
+                    slot = freeMeterSlots.back();
+                    freeMeterSlots.pop_back();
+                }
+                else if (slot >= kMeterCapacity)
+                {
+                    break;
+                }
+                meterSlots[handle] = slot;
+                store(peaks[slot], 0.0f);
+                setLoudness(slot, vmx::Loudness());
+                store(meterHandles[slot], handle);
+                break;
+            }
+            case vmx::EventKind::DeviceRemoved:
+            case vmx::EventKind::SessionRemoved:
+                if (auto slot = meterSlots.find(handle); slot != meterSlots.end())
+                {
+                    store(meterHandles[slot->second], vmx_handle(0));
+                    freeMeterSlots.push_back(slot->second);
+                    meterSlots.erase(slot);
+                }
+                break;
+            case vmx::EventKind::PeakSample:
+                if (auto slot = meterSlots.find(handle); slot != meterSlots.end()) store(peaks[slot->second], entry.value.peak);
+                break;
+            case vmx::EventKind::LoudnessSample:
+                if (auto slot = meterSlots.find(handle); slot != meterSlots.end()) setLoudness(slot->second, entry.value.loudness);
+                break;
+            default:
+                break;
+        }
+    }
+    std::atomic_ref(meterSeq).fetch_add(1, std::memory_order_release);
+}
+
+/* ==== Functions ========================================================== */
+extern "C" uint32_t
+vmx_abi_version(void)
+{
+    return VMX_ABI_VERSION;
+}
+
+extern "C" const char *
+vmx_last_error(void)
+{
+    return t_lastError.c_str();
+}
+
+extern "C" vmx_mixer *
+vmx_mixer_create
+(
+    const char *backend_name,
+    vmx_event_callback callback,
+    void *user_data
+)
+{
+    try
+    {
+        auto pMixer = std::make_unique<vmx_mixer>();
+        pMixer->callback = callback;
+        pMixer->pUserData = user_data;
+        pMixer->pVolumeMixer = vmx::VolumeMixer::create(backend_name ? backend_name : "");
+
+        vmx_mixer *pRawMixer = pMixer.get();
+        pMixer->pObjectTable = std::make_shared<vmx::detail::ObjectTable>([pRawMixer]{
+            std::lock_guard guard(pRawMixer->wakeMutex);
+            pRawMixer->bWake = true;
+            pRawMixer->wakeCondition.notify_one();
+        });
+        pMixer->pObjectTable->attach(*pMixer->pVolumeMixer);
+        pMixer->thread = std::jthread([pRawMixer](std::stop_token stopToken){ pRawMixer->deliver(stopToken); });
+        t_lastError.clear();
+        return pMixer.release();
+    }
+    catch (const std::exception &e)
+    {
+        t_lastError = e.what();
+        return nullptr;
+    }
+}
+
+extern "C" void
+vmx_mixer_destroy
+(
+    vmx_mixer *mixer
+)
+{
+    if (!mixer) return;
+    mixer->pObjectTable->detach(*mixer->pVolumeMixer);
+    mixer->thread.request_stop();
+    mixer->thread.join();
+    delete mixer;
+}
+
+extern "C" int
+vmx_mixer_set_peak_sampling_period
+(
+    vmx_mixer *mixer,
+    uint32_t period_ms
+)
+{
+    return guarded(mixer, [&]{
+        mixer->pVolumeMixer->setPeakSamplingPeriod(std::chrono::milliseconds(period_ms));
+        return VMX_OK;
+    });
+}
+
+extern "C" int
+vmx_mixer_set_loudness_sampling_period
+(
+    vmx_mixer *mixer,
+    uint32_t period_ms
+)
+{
+    return guarded(mixer, [&]{
+        mixer->pVolumeMixer->setLoudnessSamplingPeriod(std::chrono::milliseconds(period_ms));
+        return VMX_OK;
+    });
+}
+
+extern "C" int
+vmx_mixer_list
+(
+    vmx_mixer *mixer,
+    vmx_handle *handles,
+    size_t capacity
+)
+{
+    return guarded(mixer, [&]{
+        if (!handles && capacity > 0) return static_cast<int>(VMX_INVALID_ARGUMENT);
+        // Handles only grow, so a device always comes before its sessions
+        std::vector<vmx::MixerObject> objects;
+        mixer->pObjectTable->snapshot(objects);
+        for (std::size_t i = 0; i < std::min(capacity, objects.size()); ++i)
+        {
+            handles[i] = objects[i].handle;
+        }
+        return static_cast<int>(objects.size());
+    });
+}
+
+extern "C" int
+vmx_mixer_get_object
+(
+    vmx_mixer *mixer,
+    vmx_handle handle,
+    vmx_object *object
+)
+{
+    return guarded(mixer, [&]{
+        if (!object) return static_cast<int>(VMX_INVALID_ARGUMENT);
+        vmx::MixerObject found;
+        if (!mixer->pObjectTable->find(handle, found)) return static_cast<int>(VMX_NOT_FOUND);
+        fill(*object, found);
+        return static_cast<int>(VMX_OK);
+    });
+}
+
+extern "C" int
+vmx_mixer_get_string
+(
+    vmx_mixer *mixer,
+    vmx_handle handle,
+    vmx_string_field field,
+    char *buffer,
+    size_t size
+)
+{
+    return guarded(mixer, [&]{
+        if (!buffer && size > 0) return static_cast<int>(VMX_INVALID_ARGUMENT);
+        vmx::MixerObject found;
+        if (!mixer->pObjectTable->find(handle, found)) return static_cast<int>(VMX_NOT_FOUND);
+
+        const std::string *pString = nullptr;
+        switch (field)
+        {
+            case VMX_STRING_ID:         pString = &found.id; break;
+            case VMX_STRING_NAME:       pString = &found.name; break;
+            case VMX_STRING_ICON_PATH:  pString = &found.iconPath; break;
+            default:                    return static_cast<int>(VMX_INVALID_ARGUMENT);
+        }
+        if (size > 0)
+        {
+            std::size_t length = std::min(size - 1, pString->size());
+            std::memcpy(buffer, pString->data(), length);
+            buffer[length] = '\0';
+        }
+        return static_cast<int>(pString->size());
+    });
+}
+
+extern "C" int
+vmx_mixer_get_channel_volumes
+(
+    vmx_mixer *mixer,
+    vmx_handle handle,
+    float *volumes,
+    size_t capacity
+)
+{
+    return guarded(mixer, [&]{
+        if (!volumes && capacity > 0) return static_cast<int>(VMX_INVALID_ARGUMENT);
+        vmx::MixerObject found;
+        if (!mixer->pObjectTable->find(handle, found)) return static_cast<int>(VMX_NOT_FOUND);
+        std::copy_n(found.channelVolumes.begin(), std::min(capacity, found.channelVolumes.size()), volumes);
+        return static_cast<int>(found.channelVolumes.size());
+    });
+}
+
+extern "C" int
+vmx_mixer_get_meters
+(
+    vmx_mixer *mixer,
+    vmx_meters *meters
+)
+{
+    return guarded(mixer, [&]{
+        if (!meters) return static_cast<int>(VMX_INVALID_ARGUMENT);
+        *meters = {};
+        meters->seq = &mixer->meterSeq;
+        meters->capacity = vmx_mixer::kMeterCapacity;
+        meters->handles = mixer->meterHandles.data();
+        meters->peaks = mixer->peaks.data();
+        meters->loudness_momentary = mixer->loudnessMomentary.data();
+        meters->loudness_short_term = mixer->loudnessShortTerm.data();
+        meters->loudness_integrated = mixer->loudnessIntegrated.data();
+        return static_cast<int>(VMX_OK);
+    });
+}
+
+extern "C" int
+vmx_mixer_set_volume
+(
+    vmx_mixer *mixer,
+    vmx_handle handle,
+    float volume
+)
+{
+    return guarded(mixer, [&]{
+        if (auto pAudioDevice = mixer->pObjectTable->findDevice(handle)) pAudioDevice->changeVolume(volume);
+        else if (auto pAudioSession = mixer->pObjectTable->findSession(handle)) pAudioSession->changeVolume(volume);
+        else return static_cast<int>(VMX_NOT_FOUND);
+        return static_cast<int>(VMX_OK);
+    });
+}
+
+extern "C" int
+vmx_mixer_set_mute
+(
+    vmx_mixer *mixer,
+    vmx_handle handle,
+    int mute
+)
+{
+    return guarded(mixer, [&]{
+        if (auto pAudioDevice = mixer->pObjectTable->findDevice(handle)) pAudioDevice->changeMute(mute != 0);
+        else if (auto pAudioSession = mixer->pObjectTable->findSession(handle)) pAudioSession->changeMute(mute != 0);
+        else return static_cast<int>(VMX_NOT_FOUND);
+        return static_cast<int>(VMX_OK);
+    });
+}
+
+extern "C" int
+vmx_mixer_set_channel_volumes
+(
+    vmx_mixer *mixer,
+    vmx_handle handle,
+    const float *volumes,
+    size_t count
+)
+{
+    return guarded(mixer, [&]{
+        if (!volumes && count > 0) return static_cast<int>(VMX_INVALID_ARGUMENT);
+        std::vector<float> channelVolumes(volumes, volumes + count);
+        if (auto pAudioDevice = mixer->pObjectTable->findDevice(handle)) pAudioDevice->changeChannelVolumes(std::move(channelVolumes));
+        else if (auto pAudioSession = mixer->pObjectTable->findSession(handle)) pAudioSession->changeChannelVolumes(std::move(channelVolumes));
+        else return static_cast<int>(VMX_NOT_FOUND);
+        return static_cast<int>(VMX_OK);
+    });
+}
+
+/* ==== Static Helper Functions ============================================ */
+// Nothing may throw across the C boundary
+template <class Call>
+static int
+guarded
+(
+    vmx_mixer *pMixer,
+    Call call
+)
+{
+    if (!pMixer)
+    {
+        t_lastError = "mixer is NULL";
+        return VMX_INVALID_ARGUMENT;
+    }
+    try
+    {
+        int result = call();
+        if (result == VMX_NOT_FOUND) t_lastError = "No device or session with that handle";
+        else if (result == VMX_INVALID_ARGUMENT) t_lastError = "Invalid argument";
+        else t_lastError.clear();
+        return result;
+    }
+    catch (const std::exception &e)
+    {
+        t_lastError = e.what();
+        return VMX_ERROR;
+    }
+}
+
+static void
+fill
+(
+    vmx_object &object,
+    const vmx::MixerObject &from
+)
+{
+    object.handle = from.handle;
+    object.parent = from.parent;
+    object.version = from.version;
+    object.is_session = from.bSession ? 1 : 0;
+    object.state = from.state;
+    object.is_default = from.bDefault ? 1 : 0;
+    object.is_muted = from.bMuted ? 1 : 0;
+    object.channel_count = static_cast<uint32_t>(from.channelVolumes.size());
+    object.volume = from.volume;
+    object.peak = from.peak;
+    object.loudness_momentary = from.loudness.momentary;
+    object.loudness_short_term = from.loudness.shortTerm;
+    object.loudness_integrated = from.loudness.integrated;
+}
+
+static void
+fill
+(
+    vmx_event &event,
+    const vmx::detail::ObjectTable::Pending &from
+)
+{
+    event.seq = from.event.seq;
+    event.handle = from.event.handle;
+    event.parent = from.value.parent;
+    event.kind = static_cast<uint32_t>(from.event.kind);
+    event.is_session = from.value.bSession ? 1 : 0;
+    event.state = from.value.state;
+    event.is_default = from.value.bDefault ? 1 : 0;
+    event.is_muted = from.value.bMuted ? 1 : 0;
+    event.volume = from.value.volume;
+    event.peak = from.value.peak;
+    event.loudness_momentary = from.value.loudness.momentary;
+    event.loudness_short_term = from.value.loudness.shortTerm;
+    event.loudness_integrated = from.value.loudness.integrated;
+}
@@ -0,0 +1,133 @@
+/* ==== Application Includes =============================================== */
+#include <vmx/ChannelVolumes.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <algorithm>
+
+namespace vmx
+{
+
+/* ==== ChannelVolumes Class =============================================== */
+float
+ChannelVolumes::volume
+(
+    std::span<const float> channelVolumes
+)
+{
+    float loudest = 0.0f;
+    for (float channelVolume : channelVolumes)
+    {
+        loudest = std::max(loudest, channelVolume);
+    }
+    return loudest;
+}
+
+void
+ChannelVolumes::setVolume
+(
+    std::span<float> channelVolumes,
+    float volume
+)
+{
+    volume = std::min(1.0f, volume);
+    volume = std::max(0.0f, volume);
+
+    // Silent channels have no balance left to keep, they all come back at volume
+    float loudest = ChannelVolumes::volume(channelVolumes);
+    if (loudest <= 0.0f)
+    {
+        std::fill(channelVolumes.begin(), channelVolumes.end(), volume);
+        return;
+    }
+    // The loudest channels are set outright, so volume() returns exactly volume
+    float scale = volume / loudest;
+    for (float &channelVolume : channelVolumes)
+    {
+        channelVolume = (channelVolume == loudest) ? volume : std::min(volume, channelVolume * scale);
+    }
+}
+
+float
+ChannelVolumes::balance
+(
+    std::span<const float> channelVolumes
+)
+{
+    float left = 0.0f;
+    float right = 0.0f;
+    for (std::size_t channel = 0; channel < channelVolumes.size(); ++channel)
+    {
+        int channelSide = side(channel, channelVolumes.size());
+        if (channelSide < 0) left = std::max(left, channelVolumes[channel]);
+        if (channelSide > 0) right = std::max(right, channelVolumes[channel]);
+    }
+
+    if (left == right) return 0.0f;
+    return (left > right) ? right / left - 1.0f : 1.0f - left / right;
+}
+
+void
+ChannelVolumes::setBalance
+(
+    std::span<float> channelVolumes,
+    float balance
+)
+{
+    balance = std::min(1.0f, balance);
+    balance = std::max(-1.0f, balance);
+
+    // The loudest channel of each side, the quieter one is what the current balance attenuated
+    float loudest[3] = {}; // left, centre, right
+    for (std::size_t channel = 0; channel < channelVolumes.size(); ++channel)
+    {
+        float &sideLoudest = loudest[side(channel, channelVolumes.size()) + 1];
+        sideLoudest = std::max(sideLoudest, channelVolumes[channel]);
+    }
+    float level = std::max(loudest[0], loudest[2]);
+    if (level <= 0.0f) level = loudest[1];
+
+    // Each side is brought back up to level and attenuated again, so the trim
+    // between its channels survives; a side that was silenced has none left
+    // and comes back with all of its channels at the same volume
+    float scales[3] = {std::min(1.0f, 1.0f - balance), 1.0f, std::min(1.0f, 1.0f + balance)};
+    for (std::size_t channel = 0; channel < channelVolumes.size(); ++channel)
+    {
+        int channelSide = side(channel, channelVolumes.size()) + 1;
+        if (channelSide == 1) continue;
+
+        float &channelVolume = channelVolumes[channel];
+        if (channelVolume == loudest[channelSide])
+        {
+            channelVolume = level * scales[channelSide];
+        }
+        else
+        {
+            channelVolume *= (level / loudest[channelSide]) * scales[channelSide];
+        }
+    }
+}
+
+int
+ChannelVolumes::side
+(
+    std::size_t channel,
+    std::size_t channelCount
+)
+{
+    static constexpr int kSides[9][8] = {
+        {},
+        { 0},                                   // FC
+        {-1,  1},                               // FL FR
+        {-1,  1,  0},                           // FL FR FC
+        {-1,  1, -1,  1},                       // FL FR BL BR
+        {-1,  1,  0, -1,  1},                   // FL FR FC BL BR
+        {-1,  1,  0,  0, -1,  1},               // FL FR FC LFE BL BR
+        {-1,  1,  0,  0,  0, -1,  1},           // FL FR FC LFE BC SL SR
+        {-1,  1,  0,  0, -1,  1, -1,  1},       // FL FR FC LFE BL BR SL SR
+    };
+    if (channel >= channelCount) return 0;
+    if (channelCount < 9) return kSides[channelCount][channel];
+    return (channel % 2 == 0) ? -1 : 1;
+}
+
+} // namespace vmx
@@ -0,0 +1,290 @@
+/* ==== Application Includes =============================================== */
+#include <vmx/ControlClient.h>
+#include "ControlProtocol.h"
+
+/* ==== Standard Library Includes ========================================== */
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+/* ==== Operating System Includes ========================================== */
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/* ==== Macros ============================================================= */
+#ifdef MSG_NOSIGNAL
+#define VMX_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define VMX_SEND_FLAGS 0
+#endif
+
+namespace vmx
+{
+
+/* ==== Functions ========================================================== */
+std::string
+defaultControlSocketPath()
+{
+    const char *pRuntimeDir = std::getenv("XDG_RUNTIME_DIR");
+    if (pRuntimeDir && *pRuntimeDir)
+    {
+        return std::string(pRuntimeDir) + "/vmxd.sock";
+    }
+    return "/tmp/vmxd-" + std::to_string(::getuid()) + ".sock";
+}
+
+/* ==== ControlClient Class ================================================ */
+ControlClient::ControlClient
+(
+    const std::string &socketPath
+)
+  : m_pFrameBuffer(std::make_unique<detail::FrameBuffer>())
+{
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path))
+    {
+        throw std::runtime_error("Bad vmxd socket path \"" + socketPath + "\"");
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    m_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_fd < 0 || ::connect(m_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        std::string error = std::strerror(errno);
+        if (m_fd >= 0) ::close(m_fd);
+        throw std::runtime_error("Unable to connect to vmxd at " + socketPath + ": " + error);
+    }
+    ::fcntl(m_fd, F_SETFL, ::fcntl(m_fd, F_GETFL) | O_NONBLOCK);
+#ifdef SO_NOSIGPIPE
+    int one = 1;
+    ::setsockopt(m_fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+
+    try
+    {
+        detail::FrameWriter writer(detail::MessageType::Hello);
+        writer.u32(detail::kProtocolMagic);
+        writer.u16(kControlProtocolVersion);
+        send(writer.finish());
+
+        // The first snapshot is what makes the mirror usable
+        m_bResyncing = true;
+        for (int attempt = 0; m_bResyncing && attempt < 50; ++attempt)
+        {
+            poll(std::chrono::milliseconds(100));
+        }
+        if (m_bResyncing)
+        {
+            throw std::runtime_error("vmxd at " + socketPath + " did not answer");
+        }
+    }
+    catch (...)
+    {
+        ::close(m_fd);
+        throw;
+    }
+}
+
+ControlClient::~ControlClient()
+{
+    ::close(m_fd);
+}
+
+std::vector<ControlClient::Event>
+ControlClient::poll
+(
+    std::chrono::milliseconds timeout
+)
+{
+    std::vector<Event> events;
+    if (!receive(timeout)) return events;
+    while (auto body = m_pFrameBuffer->next())
+    {
+        apply(*body, events);
+    }
+    return events;
+}
+
+void
+ControlClient::changeVolume
+(
+    std::uint32_t handle,
+    float volume
+)
+{
+    detail::FrameWriter writer(detail::MessageType::ChangeVolume);
+    writer.u32(handle);
+    writer.f32(volume);
+    send(writer.finish());
+}
+
+void
+ControlClient::changeMute
+(
+    std::uint32_t handle,
+    bool bMute
+)
+{
+    detail::FrameWriter writer(detail::MessageType::ChangeMute);
+    writer.u32(handle);
+    writer.u8(bMute ? 1 : 0);
+    send(writer.finish());
+}
+
+void
+ControlClient::changeChannelVolumes
+(
+    std::uint32_t handle,
+    const std::vector<float> &channelVolumes
+)
+{
+    detail::FrameWriter writer(detail::MessageType::ChangeChannelVolumes);
+    writer.u32(handle);
+    writer.floats(channelVolumes);
+    send(writer.finish());
+}
+
+void
+ControlClient::send
+(
+    const std::vector<std::uint8_t> &frame
+)
+{
+    // Commands are tiny, so the socket buffer only fills when the daemon has stopped reading
+    std::size_t offset = 0;
+    while (offset < frame.size())
+    {
+        ssize_t size = ::send(m_fd, frame.data() + offset, frame.size() - offset, VMX_SEND_FLAGS);
+        if (size >= 0)
+        {
+            offset += static_cast<std::size_t>(size);
+        }
+        else if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            pollfd pollFd = {m_fd, POLLOUT, 0};
+            ::poll(&pollFd, 1, 1000);
+        }
+        else if (errno != EINTR)
+        {
+            throw std::runtime_error(std::string("Lost vmxd: ") + std::strerror(errno));
+        }
+    }
+}
+
+bool
+ControlClient::receive
+(
+    std::chrono::milliseconds timeout
+)
+{
+    pollfd pollFd = {m_fd, POLLIN, 0};
+    if (::poll(&pollFd, 1, static_cast<int>(timeout.count())) <= 0) return false;
+
+    std::uint8_t bytes[16384];
+    bool bReceived = false;
+    while (true)
+    {
+        ssize_t size = ::recv(m_fd, bytes, sizeof(bytes), 0);
+        if (size == 0)
+        {
+            throw std::runtime_error("vmxd hung up");
+        }
+        if (size < 0)
+        {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            throw std::runtime_error(std::string("Lost vmxd: ") + std::strerror(errno));
+        }
+        m_pFrameBuffer->append(bytes, static_cast<std::size_t>(size));
+        bReceived = true;
+    }
+    return bReceived;
+}
+
+void
+ControlClient::apply
+(
+    const std::vector<std::uint8_t> &body,
+    std::vector<Event> &events
+)
+{
+    detail::FrameReader reader(body);
+    switch (reader.type())
+    {
+        case detail::MessageType::Welcome:
+            break;
+
+        case detail::MessageType::Snapshot:
+        {
+            m_version = reader.u64();
+            std::uint32_t count = reader.u32();
+            m_objects.clear();
+            for (std::uint32_t i = 0; i < count; ++i)
+            {
+                Object object = detail::readObject(reader);
+                m_objects[object.handle] = std::move(object);
+            }
+            m_bResyncing = false;
+            break;
+        }
+
+        case detail::MessageType::EventBatch:
+        {
+            std::uint64_t firstSeq = reader.u64();
+            std::uint32_t count = reader.u32();
+            if (m_bResyncing) break; // the snapshot on its way covers this batch
+            if (firstSeq > m_version + 1)
+            {
+                send(detail::FrameWriter(detail::MessageType::Resync).finish());
+                m_bResyncing = true;
+                break;
+            }
+
+            Object discard;
+            for (std::uint32_t i = 0; i < count; ++i)
+            {
+                std::uint64_t seq = firstSeq + i;
+                // Peek at the handle to pick the object, readEvent reads it again
+                detail::FrameReader peek = reader;
+                std::uint32_t handle = peek.u32();
+                auto object = m_objects.find(handle);
+                bool bKnown = (object != m_objects.end());
+                if (seq <= m_version)
+                {
+                    (void)detail::readEvent(reader, seq, discard); // already in the snapshot
+                    continue;
+                }
+
+                Object added;
+                Event event = detail::readEvent(reader, seq, bKnown ? object->second : added);
+                if (event.kind == EventKind::DeviceAdded || event.kind == EventKind::SessionAdded)
+                {
+                    m_objects[handle] = std::move(added);
+                }
+                else if (event.kind == EventKind::DeviceRemoved || event.kind == EventKind::SessionRemoved)
+                {
+                    m_objects.erase(handle);
+                }
+                if (bKnown || event.kind == EventKind::DeviceAdded || event.kind == EventKind::SessionAdded)
+                {
+                    events.push_back(event);
+                }
+                m_version = seq;
+            }
+            break;
+        }
+
+        case detail::MessageType::Error:
+            throw std::runtime_error("vmxd: " + reader.string());
+
+        default:
+            throw std::runtime_error("Unexpected vmxd message");
+    }
+}
+
+} // namespace vmx
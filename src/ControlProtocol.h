@@ -0,0 +1,316 @@
+#pragma once
+
+/* ==== Application Includes =============================================== */
+#include <vmx/ControlClient.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace vmx::detail
+{
+
+/* ==== Wire Format ======================================================== */
+// Every frame is a little-endian u32 length, then that many bytes: a u8
+// MessageType and its payload. Strings are a u32 length and UTF-8 bytes,
+// floats travel as their IEEE-754 bits. The client opens with Hello, the
+// server answers with Welcome and a Snapshot, then sends EventBatch frames.
+// A batch holds every change since the previous one; event i of a batch has
+// sequence number firstSeq + i, so a client knows it missed something when a
+// batch does not start right after its version.
+enum class MessageType : std::uint8_t
+{
+    Hello = 1,              // u32 magic, u16 protocol version
+    Welcome,                // u16 protocol version
+    Snapshot,               // u64 version, u32 count, count objects
+    EventBatch,             // u64 firstSeq, u32 count, count events
+    ChangeVolume,           // u32 handle, f32 volume
+    ChangeMute,             // u32 handle, u8 muted
+    ChangeChannelVolumes,   // u32 handle, u32 count, count f32
+    Resync,                 // nothing, answered with a Snapshot
+    Error,                  // string message
+};
+
+constexpr std::uint32_t kProtocolMagic = 0x44584d56; // "VMXD"
+constexpr std::size_t kMaxFrameLength = 16 * 1024 * 1024;
+
+/* ==== Frame Writer ======================================================= */
+class FrameWriter
+{
+public: /* Methods */
+    explicit FrameWriter(MessageType type) : m_bytes(4, 0) { u8(static_cast<std::uint8_t>(type)); };
+
+    void u8(std::uint8_t value) { m_bytes.push_back(value); };
+    void u16(std::uint16_t value) { put(value, 2); };
+    void u32(std::uint32_t value) { put(value, 4); };
+    void u64(std::uint64_t value) { put(value, 8); };
+    void f32(float value)
+    {
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        u32(bits);
+    };
+    void string(const std::string &value)
+    {
+        u32(static_cast<std::uint32_t>(value.size()));
+        m_bytes.insert(m_bytes.end(), value.begin(), value.end());
+    };
+    void floats(const std::vector<float> &values)
+    {
+        u32(static_cast<std::uint32_t>(values.size()));
+        for (float value : values) f32(value);
+    };
+
+    // Fills in the length prefix; the writer is spent afterwards
+    std::vector<std::uint8_t> finish()
+    {
+        std::uint32_t length = static_cast<std::uint32_t>(m_bytes.size() - 4);
+        for (std::size_t i = 0; i < 4; ++i) m_bytes[i] = static_cast<std::uint8_t>(length >> (8 * i));
+        return std::move(m_bytes);
+    };
+
+private: /* Methods */
+    void put(std::uint64_t value, std::size_t size)
+    {
+        for (std::size_t i = 0; i < size; ++i) m_bytes.push_back(static_cast<std::uint8_t>(value >> (8 * i)));
+    };
+
+private: /* Members */
+    std::vector<std::uint8_t> m_bytes;
+};
+
+/* ==== Frame Reader ======================================================= */
+// Reads one frame body (after the length prefix); running off the end throws
+class FrameReader
+{
+public: /* Methods */
+    explicit FrameReader(std::span<const std::uint8_t> body) : m_body(body) {};
+
+    MessageType type() { return static_cast<MessageType>(u8()); };
+    std::uint8_t u8() { return static_cast<std::uint8_t>(get(1)); };
+    std::uint16_t u16() { return static_cast<std::uint16_t>(get(2)); };
+    std::uint32_t u32() { return static_cast<std::uint32_t>(get(4)); };
+    std::uint64_t u64() { return get(8); };
+    float f32()
+    {
+        std::uint32_t bits = u32();
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    };
+    std::string string()
+    {
+        std::size_t size = u32();
+        need(size);
+        std::string value(reinterpret_cast<const char*>(m_body.data() + m_offset), size);
+        m_offset += size;
+        return value;
+    };
+    std::vector<float> floats()
+    {
+        std::size_t count = u32();
+        need(count * 4);
+        std::vector<float> values(count);
+        for (auto &value : values) value = f32();
+        return values;
+    };
+
+private: /* Methods */
+    void need(std::size_t size)
+    {
+        if (size > m_body.size() - m_offset) throw std::runtime_error("Truncated vmxd frame");
+    };
+    std::uint64_t get(std::size_t size)
+    {
+        need(size);
+        std::uint64_t value = 0;
+        for (std::size_t i = 0; i < size; ++i) value |= static_cast<std::uint64_t>(m_body[m_offset + i]) << (8 * i);
+        m_offset += size;
+        return value;
+    };
+
+private: /* Members */
+    std::span<const std::uint8_t> m_body;
+    std::size_t m_offset = 0;
+};
+
+/* ==== Frame Buffer ======================================================= */
+// Collects bytes off a stream socket and hands out whole frame bodies
+class FrameBuffer
+{
+public: /* Methods */
+    // Bytes of frames already taken are dropped first, so at most one partial frame is held
+    void append(const std::uint8_t *pBytes, std::size_t size)
+    {
+        m_bytes.erase(m_bytes.begin(), m_bytes.begin() + static_cast<std::ptrdiff_t>(m_offset));
+        m_offset = 0;
+        m_bytes.insert(m_bytes.end(), pBytes, pBytes + size);
+    };
+
+    // The next whole frame body, if one has arrived; throws on an oversized frame
+    std::optional<std::vector<std::uint8_t>> next()
+    {
+        if (m_bytes.size() - m_offset < 4) return std::nullopt;
+        std::size_t length = 0;
+        for (std::size_t i = 0; i < 4; ++i) length |= static_cast<std::size_t>(m_bytes[m_offset + i]) << (8 * i);
+        if (length == 0 || length > kMaxFrameLength) throw std::runtime_error("Bad vmxd frame length " + std::to_string(length));
+        if (m_bytes.size() - m_offset - 4 < length) return std::nullopt;
+
+        std::vector<std::uint8_t> body(m_bytes.begin() + static_cast<std::ptrdiff_t>(m_offset + 4),
+                                       m_bytes.begin() + static_cast<std::ptrdiff_t>(m_offset + 4 + length));
+        m_offset += 4 + length;
+        if (m_offset == m_bytes.size())
+        {
+            m_bytes.clear();
+            m_offset = 0;
+        }
+        return body;
+    };
+
+private: /* Members */
+    std::vector<std::uint8_t> m_bytes;
+    std::size_t m_offset = 0;
+};
+
+/* ==== Payloads =========================================================== */
+inline void
+writeObject
+(
+    FrameWriter &writer,
+    const ControlClient::Object &object
+)
+{
+    writer.u32(object.handle);
+    writer.u8(object.bSession ? 1 : 0);
+    writer.u32(object.parent);
+    writer.u64(object.version);
+    writer.string(object.id);
+    writer.string(object.name);
+    writer.string(object.iconPath);
+    writer.u8(object.state);
+    writer.u8(object.bDefault ? 1 : 0);
+    writer.f32(object.volume);
+    writer.floats(object.channelVolumes);
+    writer.u8(object.bMuted ? 1 : 0);
+    writer.f32(object.peak);
+    writer.f32(object.loudness.momentary);
+    writer.f32(object.loudness.shortTerm);
+    writer.f32(object.loudness.integrated);
+}
+
+inline ControlClient::Object
+readObject
+(
+    FrameReader &reader
+)
+{
+    ControlClient::Object object;
+    object.handle = reader.u32();
+    object.bSession = reader.u8() != 0;
+    object.parent = reader.u32();
+    object.version = reader.u64();
+    object.id = reader.string();
+    object.name = reader.string();
+    object.iconPath = reader.string();
+    object.state = reader.u8();
+    object.bDefault = reader.u8() != 0;
+    object.volume = reader.f32();
+    object.channelVolumes = reader.floats();
+    object.bMuted = reader.u8() != 0;
+    object.peak = reader.f32();
+    object.loudness.momentary = reader.f32();
+    object.loudness.shortTerm = reader.f32();
+    object.loudness.integrated = reader.f32();
+    return object;
+}
+
+// An event is a u32 handle, a u8 EventKind and the new value. DeviceAdded and
+// SessionAdded carry the parent handle and the ID; the removals carry nothing.
+inline void
+writeEvent
+(
+    FrameWriter &writer,
+    const ControlClient::Event &event,
+    const ControlClient::Object &object
+)
+{
+    writer.u32(event.handle);
+    writer.u8(static_cast<std::uint8_t>(event.kind));
+    switch (event.kind)
+    {
+        case EventKind::Name:            writer.string(object.name); break;
+        case EventKind::IconPath:        writer.string(object.iconPath); break;
+        case EventKind::State:           writer.u8(object.state); break;
+        case EventKind::Default:         writer.u8(object.bDefault ? 1 : 0); break;
+        case EventKind::Volume:          writer.f32(object.volume); break;
+        case EventKind::ChannelVolumes:  writer.floats(object.channelVolumes); break;
+        case EventKind::Mute:            writer.u8(object.bMuted ? 1 : 0); break;
+        case EventKind::PeakSample:      writer.f32(object.peak); break;
+        case EventKind::LoudnessSample:
+            writer.f32(object.loudness.momentary);
+            writer.f32(object.loudness.shortTerm);
+            writer.f32(object.loudness.integrated);
+            break;
+        case EventKind::SessionAdded:
+        case EventKind::DeviceAdded:
+            writer.u32(object.parent);
+            writer.string(object.id);
+            break;
+        case EventKind::SessionRemoved:
+        case EventKind::DeviceRemoved:
+            break;
+    }
+}
+
+// Applies the event's value to object and returns the event
+inline ControlClient::Event
+readEvent
+(
+    FrameReader &reader,
+    std::uint64_t seq,
+    ControlClient::Object &object
+)
+{
+    ControlClient::Event event;
+    event.seq = seq;
+    event.handle = reader.u32();
+    std::uint8_t kind = reader.u8();
+    if (kind >= kEventKindCount) throw std::runtime_error("Unknown vmxd event kind " + std::to_string(kind));
+    event.kind = static_cast<EventKind>(kind);
+    switch (event.kind)
+    {
+        case EventKind::Name:            object.name = reader.string(); break;
+        case EventKind::IconPath:        object.iconPath = reader.string(); break;
+        case EventKind::State:           object.state = reader.u8(); break;
+        case EventKind::Default:         object.bDefault = reader.u8() != 0; break;
+        case EventKind::Volume:          object.volume = reader.f32(); break;
+        case EventKind::ChannelVolumes:  object.channelVolumes = reader.floats(); break;
+        case EventKind::Mute:            object.bMuted = reader.u8() != 0; break;
+        case EventKind::PeakSample:      object.peak = reader.f32(); break;
+        case EventKind::LoudnessSample:
+            object.loudness.momentary = reader.f32();
+            object.loudness.shortTerm = reader.f32();
+            object.loudness.integrated = reader.f32();
+            break;
+        case EventKind::SessionAdded:
+        case EventKind::DeviceAdded:
+            object.handle = event.handle;
+            object.bSession = (event.kind == EventKind::SessionAdded);
+            object.parent = reader.u32();
+            object.id = reader.string();
+            break;
+        case EventKind::SessionRemoved:
+        case EventKind::DeviceRemoved:
+            break;
+    }
+    object.version = seq;
+    return event;
+}
+
+} // namespace vmx::detail
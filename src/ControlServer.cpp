@@ -0,0 +1,470 @@
+/* ==== Application Includes =============================================== */
+#include <vmx/ControlServer.h>
+#include "ControlProtocol.h"
+#include "ObjectTable.h"
+#include "Tracing.h"
+
+/* ==== Standard Library Includes ========================================== */
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+/* ==== Operating System Includes ========================================== */
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/* ==== Macros ============================================================= */
+#ifdef MSG_NOSIGNAL
+#define VMX_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define VMX_SEND_FLAGS 0 // SO_NOSIGPIPE is set on the socket instead
+#endif
+
+/* ==== Forward Declarations =============================================== */
+static std::runtime_error systemError(const std::string &what);
+static sockaddr_un socketAddress(const std::string &socketPath);
+static void setNonBlocking(int fd);
+
+namespace vmx
+{
+
+/* ==== ControlServer::Connection ========================================== */
+struct ControlServer::Connection
+{
+    int fd = -1;
+    bool bWelcomed = false;
+    detail::FrameBuffer frameBuffer;
+    std::vector<std::uint8_t> backlog;
+    std::size_t backlogOffset = 0;
+};
+
+/* ==== ControlServer Class ================================================ */
+ControlServer::ControlServer
+(
+    VolumeMixer &volumeMixer,
+    const std::string &socketPath,
+    const std::string &meterSegmentName
+)
+  : m_volumeMixer(volumeMixer),
+    m_socketPath(socketPath)
+{
+    sockaddr_un address = socketAddress(socketPath);
+
+    // A socket someone still answers on belongs to a running server; anything else is stale
+    int probeFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probeFd >= 0)
+    {
+        bool bAnswered = ::connect(probeFd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+        ::close(probeFd);
+        if (bAnswered)
+        {
+            throw std::runtime_error("Another vmxd is already serving " + socketPath);
+        }
+    }
+    ::unlink(socketPath.c_str());
+
+    m_listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_listenFd < 0)
+    {
+        throw systemError("socket");
+    }
+    if (::bind(m_listenFd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::chmod(socketPath.c_str(), S_IRUSR | S_IWUSR) != 0 ||
+        ::listen(m_listenFd, 16) != 0)
+    {
+        auto error = systemError("Unable to listen on " + socketPath);
+        ::close(m_listenFd);
+        throw error;
+    }
+    setNonBlocking(m_listenFd);
+
+    if (::pipe(m_wakeFds) != 0)
+    {
+        ::close(m_listenFd);
+        ::unlink(socketPath.c_str());
+        throw systemError("pipe");
+    }
+    setNonBlocking(m_wakeFds[0]);
+    setNonBlocking(m_wakeFds[1]);
+
+    if (!meterSegmentName.empty())
+    {
+        try
+        {
+            m_pMeterSegment = std::make_unique<MeterSegmentWriter>(meterSegmentName);
+        }
+        catch (...)
+        {
+            ::close(m_listenFd);
+            ::close(m_wakeFds[0]);
+            ::close(m_wakeFds[1]);
+            ::unlink(socketPath.c_str());
+            throw;
+        }
+    }
+
+    // One byte per batch, the serving thread drains the pipe before taking the batch
+    int wakeFd = m_wakeFds[1];
+    m_pObjectTable = std::make_shared<detail::ObjectTable>([wakeFd]{ char byte = 0; (void)!::write(wakeFd, &byte, 1); });
+    m_pObjectTable->attach(m_volumeMixer);
+    m_thread = std::jthread([this](std::stop_token stopToken){ serve(stopToken); });
+}
+
+ControlServer::~ControlServer()
+{
+    m_pObjectTable->detach(m_volumeMixer);
+    m_thread.request_stop();
+    char byte = 0;
+    (void)!::write(m_wakeFds[1], &byte, 1);
+    m_thread.join();
+    ::close(m_listenFd);
+    ::close(m_wakeFds[0]);
+    ::close(m_wakeFds[1]);
+    ::unlink(m_socketPath.c_str());
+}
+
+void
+ControlServer::serve
+(
+    std::stop_token stopToken
+)
+{
+    VMX_TRACE_THREAD_NAME("vmxd server");
+    ScopedThreadRole threadRole(ThreadRole::ControlServer);
+    std::vector<Connection> connections;
+    std::vector<pollfd> pollFds;
+
+    while (!stopToken.stop_requested())
+    {
+        pollFds.assign({{m_listenFd, POLLIN, 0}, {m_wakeFds[0], POLLIN, 0}});
+        for (const auto &connection : connections)
+        {
+            // Commands from a client that does not read what they produce wait
+            short events = (connection.backlog.size() - connection.backlogOffset <= kMaxBacklog) ? POLLIN : 0;
+            if (connection.backlogOffset < connection.backlog.size()) events |= POLLOUT;
+            pollFds.push_back({connection.fd, events, 0});
+        }
+        if (::poll(pollFds.data(), pollFds.size(), -1) < 0 && errno != EINTR)
+        {
+            break;
+        }
+
+        if (pollFds[1].revents & POLLIN)
+        {
+            char bytes[64];
+            while (::read(m_wakeFds[0], bytes, sizeof(bytes)) > 0) {}
+            broadcast(connections);
+        }
+
+        // Connections are indexed 2 onwards in pollFds, in the same order
+        for (std::size_t i = connections.size(); i-- > 0;)
+        {
+            short revents = pollFds[i + 2].revents;
+            bool bOpen = true;
+            if (revents & (POLLIN | POLLHUP | POLLERR)) bOpen = receive(connections[i]);
+            if (bOpen) bOpen = flush(connections[i]);
+            if (!bOpen)
+            {
+                ::close(connections[i].fd);
+                connections.erase(connections.begin() + static_cast<std::ptrdiff_t>(i));
+            }
+        }
+
+        if (pollFds[0].revents & POLLIN)
+        {
+            accept(connections);
+        }
+        m_clientCount.store(connections.size(), std::memory_order_relaxed);
+    }
+
+    for (const auto &connection : connections)
+    {
+        ::close(connection.fd);
+    }
+    m_clientCount.store(0, std::memory_order_relaxed);
+}
+
+void
+ControlServer::accept
+(
+    std::vector<Connection> &connections
+)
+{
+    int fd;
+    while ((fd = ::accept(m_listenFd, nullptr, nullptr)) >= 0)
+    {
+        setNonBlocking(fd);
+#ifdef SO_NOSIGPIPE
+        int one = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+        connections.emplace_back().fd = fd;
+    }
+}
+
+bool
+ControlServer::receive
+(
+    Connection &connection
+)
+{
+    // Frames are taken after every chunk, so a bad length is caught before
+    // anything more is read; poll() reports whatever is left past kMaxReceive.
+    // A command sent right before hanging up still runs.
+    std::uint8_t bytes[4096];
+    bool bOpen = true;
+    try
+    {
+        for (std::size_t received = 0; received < kMaxReceive;)
+        {
+            ssize_t size = ::recv(connection.fd, bytes, sizeof(bytes), 0);
+            if (size > 0)
+            {
+                received += static_cast<std::size_t>(size);
+                connection.frameBuffer.append(bytes, static_cast<std::size_t>(size));
+                while (auto body = connection.frameBuffer.next())
+                {
+                    handle(connection, *body);
+                }
+                continue;
+            }
+            if (size < 0 && errno == EINTR) continue;
+            bOpen = (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+            break;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        // A client that breaks the protocol is told why and dropped
+        detail::FrameWriter writer(detail::MessageType::Error);
+        writer.string(e.what());
+        auto frame = writer.finish();
+        (void)!::send(connection.fd, frame.data(), frame.size(), VMX_SEND_FLAGS);
+        return false;
+    }
+    return bOpen;
+}
+
+void
+ControlServer::handle
+(
+    Connection &connection,
+    const std::vector<std::uint8_t> &body
+)
+{
+    VMX_TRACE_SCOPE("ControlServer::handle", "control");
+    detail::FrameReader reader(body);
+    auto type = reader.type();
+    if (!connection.bWelcomed)
+    {
+        if (type != detail::MessageType::Hello || reader.u32() != detail::kProtocolMagic)
+        {
+            throw std::runtime_error("Expected a vmxd Hello");
+        }
+        std::uint16_t version = reader.u16();
+        if (version != kControlProtocolVersion)
+        {
+            throw std::runtime_error("vmxd speaks protocol version " + std::to_string(kControlProtocolVersion) + ", not " + std::to_string(version));
+        }
+        detail::FrameWriter writer(detail::MessageType::Welcome);
+        writer.u16(kControlProtocolVersion);
+        auto frame = writer.finish();
+        connection.backlog.insert(connection.backlog.end(), frame.begin(), frame.end());
+        connection.bWelcomed = true;
+        sendSnapshot(connection);
+        return;
+    }
+
+    if (type == detail::MessageType::Resync)
+    {
+        sendSnapshot(connection);
+        return;
+    }
+
+    std::uint32_t handle = reader.u32();
+    auto pAudioDevice = m_pObjectTable->findDevice(handle);
+    auto pAudioSession = m_pObjectTable->findSession(handle);
+    if (!pAudioDevice && !pAudioSession)
+    {
+        // The object may have gone since the client last heard; not worth dropping it for
+        detail::FrameWriter writer(detail::MessageType::Error);
+        writer.string("No device or session with handle " + std::to_string(handle));
+        auto frame = writer.finish();
+        connection.backlog.insert(connection.backlog.end(), frame.begin(), frame.end());
+        return;
+    }
+
+    // The backend reports back through the table's observers
+    switch (type)
+    {
+        case detail::MessageType::ChangeVolume:
+        {
+            float volume = reader.f32();
+            pAudioDevice ? pAudioDevice->changeVolume(volume) : pAudioSession->changeVolume(volume);
+            break;
+        }
+        case detail::MessageType::ChangeMute:
+        {
+            bool bMute = reader.u8() != 0;
+            pAudioDevice ? pAudioDevice->changeMute(bMute) : pAudioSession->changeMute(bMute);
+            break;
+        }
+        case detail::MessageType::ChangeChannelVolumes:
+        {
+            auto channelVolumes = reader.floats();
+            pAudioDevice ? pAudioDevice->changeChannelVolumes(std::move(channelVolumes)) : pAudioSession->changeChannelVolumes(std::move(channelVolumes));
+            break;
+        }
+        default:
+            throw std::runtime_error("Unexpected vmxd message " + std::to_string(static_cast<unsigned>(type)));
+    }
+}
+
+void
+ControlServer::sendSnapshot
+(
+    Connection &connection
+)
+{
+    std::vector<ControlClient::Object> objects;
+    std::uint64_t seq = m_pObjectTable->snapshot(objects);
+    detail::FrameWriter writer(detail::MessageType::Snapshot);
+    writer.u64(seq);
+    writer.u32(static_cast<std::uint32_t>(objects.size()));
+    for (const auto &object : objects)
+    {
+        detail::writeObject(writer, object);
+    }
+    auto frame = writer.finish();
+    connection.backlog.insert(connection.backlog.end(), frame.begin(), frame.end());
+}
+
+void
+ControlServer::broadcast
+(
+    std::vector<Connection> &connections
+)
+{
+    auto pending = m_pObjectTable->takePending();
+    if (pending.empty()) return;
+
+    VMX_TRACE_SCOPE("ControlServer::broadcast", "backend");
+    if (m_pMeterSegment)
+    {
+        for (const auto &entry : pending)
+        {
+            switch (entry.event.kind)
+            {
+                case EventKind::DeviceAdded:
+                case EventKind::SessionAdded:
+                    m_pMeterSegment->add(entry.event.handle, entry.value.parent, entry.event.kind == EventKind::SessionAdded, entry.value.id);
+                    break;
+                case EventKind::DeviceRemoved:
+                case EventKind::SessionRemoved:
+                    m_pMeterSegment->remove(entry.event.handle);
+                    break;
+                case EventKind::PeakSample:
+                    m_pMeterSegment->setPeak(entry.event.handle, entry.value.peak);
+                    break;
+                default:
+                    break;
+            }
+        }
+        m_pMeterSegment->publish();
+    }
+
+    detail::FrameWriter writer(detail::MessageType::EventBatch);
+    writer.u64(pending.front().event.seq);
+    writer.u32(static_cast<std::uint32_t>(pending.size()));
+    for (const auto &entry : pending)
+    {
+        detail::writeEvent(writer, entry.event, entry.value);
+    }
+    auto frame = writer.finish();
+
+    for (auto &connection : connections)
+    {
+        if (!connection.bWelcomed) continue;
+
+        // Whatever the client has not read yet is superseded by a snapshot
+        if (connection.backlog.size() - connection.backlogOffset + frame.size() > kMaxBacklog)
+        {
+            // The backlog starts on a frame, and the one being sent has to go out whole
+            std::size_t cut = 0;
+            while (cut < connection.backlogOffset)
+            {
+                std::size_t length = 0;
+                for (std::size_t i = 0; i < 4; ++i) length |= static_cast<std::size_t>(connection.backlog[cut + i]) << (8 * i);
+                cut += 4 + length;
+            }
+            connection.backlog.erase(connection.backlog.begin() + static_cast<std::ptrdiff_t>(cut), connection.backlog.end());
+            sendSnapshot(connection);
+            continue;
+        }
+        connection.backlog.insert(connection.backlog.end(), frame.begin(), frame.end());
+    }
+}
+
+bool
+ControlServer::flush
+(
+    Connection &connection
+)
+{
+    while (connection.backlogOffset < connection.backlog.size())
+    {
+        ssize_t size = ::send(connection.fd, connection.backlog.data() + connection.backlogOffset,
+                              connection.backlog.size() - connection.backlogOffset, VMX_SEND_FLAGS);
+        if (size < 0)
+        {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+        connection.backlogOffset += static_cast<std::size_t>(size);
+    }
+    connection.backlog.clear();
+    connection.backlogOffset = 0;
+    return true;
+}
+
+} // namespace vmx
+
+/* ==== Static Helper Functions ============================================ */
+static std::runtime_error
+systemError
+(
+    const std::string &what
+)
+{
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+static sockaddr_un
+socketAddress
+(
+    const std::string &socketPath
+)
+{
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path))
+    {
+        throw std::runtime_error("Bad vmxd socket path \"" + socketPath + "\"");
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+    return address;
+}
+
+static void
+setNonBlocking
+(
+    int fd
+)
+{
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+namespace vmx::detail
+{
+
+/* ==== Classes ============================================================ */
+// Marks the calling thread as holding a vmx lock while in scope. Synchronous
+// dispatch queues observer calls rather than making them, and the queue runs
+// when the outermost scope on the thread ends. Every lock that can be held
+// around an update*() call takes one first (see LOCK_GUARD in each backend),
+// so no observer runs under a backend's mutex. Client loop locks taken from
+// other threads do the same; the loop's own thread always holds its lock.
+class DispatchScope
+{
+public: /* Methods */
+    DispatchScope();
+    ~DispatchScope();
+    DispatchScope(const DispatchScope&) = delete;
+    DispatchScope& operator=(const DispatchScope&) = delete;
+};
+
+} // namespace vmx::detail
@@ -0,0 +1,106 @@
+/* ==== Application Includes =============================================== */
+#include "EventQueue.h"
+#include "Tracing.h"
+
+/* ==== Standard Library Includes ========================================== */
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+/* ==== Operating System Includes ========================================== */
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+namespace vmx::detail
+{
+
+/* ==== EventQueue Class =================================================== */
+EventQueue::EventQueue
+(
+    VolumeMixer &volumeMixer
+)
+  : m_volumeMixer(volumeMixer)
+{
+#if defined(__linux__)
+    m_readFd = m_writeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_readFd < 0)
+    {
+        throw std::runtime_error(std::string("eventfd: ") + std::strerror(errno));
+    }
+#elif !defined(_WIN32)
+    int fds[2];
+    if (::pipe(fds) != 0)
+    {
+        throw std::runtime_error(std::string("pipe: ") + std::strerror(errno));
+    }
+    for (int fd : fds)
+    {
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    m_readFd = fds[0];
+    m_writeFd = fds[1];
+#endif
+
+    m_pObjectTable = std::make_shared<ObjectTable>([this]{ signal(); });
+    m_pObjectTable->attach(m_volumeMixer);
+}
+
+EventQueue::~EventQueue()
+{
+    // No signal() runs once this returns
+    m_pObjectTable->detach(m_volumeMixer);
+#ifndef _WIN32
+    ::close(m_readFd);
+    if (m_writeFd != m_readFd)
+    {
+        ::close(m_writeFd);
+    }
+#endif
+}
+
+std::size_t
+EventQueue::drain
+(
+    std::vector<MixerChange> &buffer
+)
+{
+    VMX_TRACE_SCOPE("EventQueue::drain", "control");
+    clear();
+    m_pObjectTable->takePending(buffer);
+    return buffer.size();
+}
+
+void
+EventQueue::signal()
+{
+#if defined(__linux__)
+    std::uint64_t one = 1;
+    (void)!::write(m_writeFd, &one, sizeof(one));
+#elif !defined(_WIN32)
+    // A full pipe is readable already
+    char byte = 0;
+    (void)!::write(m_writeFd, &byte, 1);
+#endif
+}
+
+void
+EventQueue::clear()
+{
+#if defined(__linux__)
+    std::uint64_t count;
+    (void)!::read(m_readFd, &count, sizeof(count));
+#elif !defined(_WIN32)
+    char bytes[64];
+    while (::read(m_readFd, bytes, sizeof(bytes)) > 0) {}
+#endif
+}
+
+} // namespace vmx::detail
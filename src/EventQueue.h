@@ -0,0 +1,45 @@
+#pragma once
+
+/* ==== Application Includes =============================================== */
+#include <vmx/MixerObject.h>
+#include <vmx/VolumeMixer.h>
+#include "ObjectTable.h"
+
+/* ==== Standard Library Includes ========================================== */
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace vmx::detail
+{
+
+/* ==== Classes ============================================================ */
+// What is behind VolumeMixer::eventFd() and drainEvents(): an ObjectTable
+// whose wake makes an eventfd (a pipe where there is none) readable. The fd
+// is set once per batch and cleared by drain() before it takes the batch, so
+// a change landing in between sets it again. Windows has no fd, only drain().
+class EventQueue
+{
+public: /* Methods */
+    // Throws std::runtime_error when the fd cannot be made
+    explicit EventQueue(VolumeMixer &volumeMixer);
+    ~EventQueue();
+    EventQueue(const EventQueue&) = delete;
+    EventQueue& operator=(const EventQueue&) = delete;
+
+    int fd() const { return m_readFd; };
+    std::size_t drain(std::vector<MixerChange> &buffer);
+    ObjectTable &table() { return *m_pObjectTable; };
+
+private: /* Methods */
+    void signal();
+    void clear();
+
+private: /* Members */
+    VolumeMixer &m_volumeMixer;
+    int m_readFd = -1;
+    int m_writeFd = -1; // the same fd as m_readFd for an eventfd
+    std::shared_ptr<ObjectTable> m_pObjectTable;
+};
+
+} // namespace vmx::detail
@@ -0,0 +1,161 @@
+/* ==== Application Includes =============================================== */
+#include <vmx/EventStream.h>
+#include "ObjectTable.h"
+#include "Tracing.h"
+
+/* ==== Standard Library Includes ========================================== */
+#include <utility>
+
+namespace vmx
+{
+
+/* ==== EventStream Class ================================================== */
+EventStream::EventStream
+(
+    VolumeMixer &volumeMixer,
+    Executor executor
+)
+  : m_volumeMixer(volumeMixer),
+    m_executor(executor ? std::move(executor) : [](std::function<void()> resume){ resume(); })
+{
+    m_pObjectTable = std::make_shared<detail::ObjectTable>([this]{ wake(); });
+    m_pObjectTable->attach(m_volumeMixer);
+}
+
+EventStream::~EventStream()
+{
+    // No wake() runs once this returns
+    m_pObjectTable->detach(m_volumeMixer);
+
+    std::coroutine_handle<> waiter;
+    {
+        std::lock_guard guard(m_mutex);
+        m_bClosed = true;
+        waiter = std::exchange(m_waiter, nullptr);
+    }
+    if (waiter)
+    {
+        m_executor([waiter]{ waiter.resume(); });
+    }
+}
+
+AsyncGenerator<MixerChange>
+EventStream::events
+(
+    std::uint32_t handle
+)
+{
+    while (true)
+    {
+        std::vector<MixerChange> batch = co_await nextEvents();
+        if (batch.empty()) co_return;
+
+        for (MixerChange &change : batch)
+        {
+            if (change.event.handle != handle && change.value.parent != handle) continue;
+
+            bool bGone = (change.event.handle == handle) &&
+                         (change.event.kind == EventKind::SessionRemoved || change.event.kind == EventKind::DeviceRemoved);
+            co_yield std::move(change);
+            if (bGone) co_return;
+        }
+    }
+}
+
+std::uint32_t
+EventStream::findHandle
+(
+    const std::string &audioDeviceId,
+    const std::string &audioSessionId
+) const
+{
+    std::vector<MixerObject> all = objects();
+    std::uint32_t deviceHandle = 0;
+    for (const MixerObject &object : all)
+    {
+        if (!object.bSession && object.id == audioDeviceId) deviceHandle = object.handle;
+    }
+    if (deviceHandle == 0 || audioSessionId.empty()) return deviceHandle;
+
+    for (const MixerObject &object : all)
+    {
+        if (object.bSession && object.parent == deviceHandle && object.id == audioSessionId) return object.handle;
+    }
+    return 0;
+}
+
+bool
+EventStream::find
+(
+    std::uint32_t handle,
+    MixerObject &object
+) const
+{
+    return m_pObjectTable->find(handle, object);
+}
+
+std::vector<MixerObject>
+EventStream::objects() const
+{
+    std::vector<MixerObject> all;
+    m_pObjectTable->snapshot(all);
+    return all;
+}
+
+std::shared_ptr<AudioDevice>
+EventStream::device
+(
+    std::uint32_t handle
+) const
+{
+    return m_pObjectTable->findDevice(handle);
+}
+
+std::shared_ptr<AudioSession>
+EventStream::session
+(
+    std::uint32_t handle
+) const
+{
+    return m_pObjectTable->findSession(handle);
+}
+
+bool
+EventStream::suspend
+(
+    std::coroutine_handle<> coroutine,
+    std::vector<MixerChange> &batch
+)
+{
+    // Taking the batch and registering happen under one lock, so a change in
+    // between finds the waiter in wake()
+    std::lock_guard guard(m_mutex);
+    if (m_bClosed) return false;
+    batch = m_pObjectTable->takePending();
+    if (!batch.empty()) return false;
+    m_waiter = coroutine;
+    m_pWaiterBatch = &batch;
+    return true;
+}
+
+void
+EventStream::wake()
+{
+    VMX_TRACE_SCOPE("EventStream::wake", "backend");
+
+    std::coroutine_handle<> waiter;
+    {
+        std::lock_guard guard(m_mutex);
+        if (!m_waiter) return;
+        // The waiter may have taken this batch before it suspended
+        std::vector<MixerChange> batch = m_pObjectTable->takePending();
+        if (batch.empty()) return;
+        // Filled here rather than on resume, so a late executor never touches the stream
+        *m_pWaiterBatch = std::move(batch);
+        m_pWaiterBatch = nullptr;
+        waiter = std::exchange(m_waiter, nullptr);
+    }
+    m_executor([waiter]{ waiter.resume(); });
+}
+
+} // namespace vmx
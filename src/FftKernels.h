@@ -0,0 +1,145 @@
+#pragma once
+
+/* ==== Application Includes =============================================== */
+#include <vmx/SpectrumAnalyzer.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <cstddef>
+
+namespace vmx::detail
+{
+
+// Templates over the vector operations SpectrumAnalyzer.cpp provides
+namespace
+{
+
+/* ==== Radix-2 Transform ================================================== */
+// Decimation in time over input already in bit-reversed order, size >= 4.
+// The first two stages only multiply by 1 and -i and run as one radix-4
+// pass. Twiddles for the stage joining halves of length h sit at [h, 2h), so
+// each later stage reads them contiguously and a butterfly group is a run of
+// whole vectors once h reaches the vector width; narrower stages are scalar.
+template <class Ops>
+void
+fftKernel
+(
+    float *pRe,
+    float *pIm,
+    const float *pTwiddleRe,
+    const float *pTwiddleIm,
+    std::size_t size
+)
+{
+    using V = typename Ops::V;
+
+    for (std::size_t group = 0; group < size; group += 4)
+    {
+        float *pR = pRe + group;
+        float *pI = pIm + group;
+        float r0 = pR[0] + pR[1], i0 = pI[0] + pI[1];
+        float r1 = pR[0] - pR[1], i1 = pI[0] - pI[1];
+        float r2 = pR[2] + pR[3], i2 = pI[2] + pI[3];
+        float r3 = pR[2] - pR[3], i3 = pI[2] - pI[3];
+        pR[0] = r0 + r2; pI[0] = i0 + i2;
+        pR[2] = r0 - r2; pI[2] = i0 - i2;
+        pR[1] = r1 + i3; pI[1] = i1 - r3;
+        pR[3] = r1 - i3; pI[3] = i1 + r3;
+    }
+
+    for (std::size_t half = 4; half < size; half *= 2)
+    {
+        const float *pWr = pTwiddleRe + half;
+        const float *pWi = pTwiddleIm + half;
+        for (std::size_t group = 0; group < size; group += 2 * half)
+        {
+            float *pAr = pRe + group;
+            float *pAi = pIm + group;
+            float *pBr = pAr + half;
+            float *pBi = pAi + half;
+            std::size_t j = 0;
+
+            if (half >= Ops::kWidth)
+            {
+                for (; j < half; j += Ops::kWidth)
+                {
+                    V wr = Ops::load(pWr + j), wi = Ops::load(pWi + j);
+                    V br = Ops::load(pBr + j), bi = Ops::load(pBi + j);
+                    V tr = Ops::mulSub(bi, wi, Ops::mul(br, wr));
+                    V ti = Ops::mulAdd(bi, wr, Ops::mul(br, wi));
+                    V ar = Ops::load(pAr + j), ai = Ops::load(pAi + j);
+                    Ops::store(pBr + j, Ops::sub(ar, tr));
+                    Ops::store(pBi + j, Ops::sub(ai, ti));
+                    Ops::store(pAr + j, Ops::add(ar, tr));
+                    Ops::store(pAi + j, Ops::add(ai, ti));
+                }
+            }
+            for (; j < half; ++j)
+            {
+                float tr = pBr[j] * pWr[j] - pBi[j] * pWi[j];
+                float ti = pBr[j] * pWi[j] + pBi[j] * pWr[j];
+                pBr[j] = pAr[j] - tr;
+                pBi[j] = pAi[j] - ti;
+                pAr[j] += tr;
+                pAi[j] += ti;
+            }
+        }
+    }
+}
+
+/* ==== Real Spectrum ====================================================== */
+// Power of bins 0 to size of a real signal of 2 * size frames whose even
+// frames went through the transform as the real parts and odd frames as the
+// imaginary parts. Bin k joins Z[k] and Z[size - k] (Z[0] for both ends), so
+// vectors of bins from 1 up meet a reversed vector of their partners.
+template <class Ops>
+void
+powerKernel
+(
+    const float *pRe,
+    const float *pIm,
+    const float *pUnpackRe,
+    const float *pUnpackIm,
+    float *pPower,
+    std::size_t size
+)
+{
+    using V = typename Ops::V;
+
+    auto bin = [&](std::size_t k)
+    {
+        std::size_t a = k & (size - 1);
+        std::size_t b = (size - k) & (size - 1);
+        float evenRe = 0.5f * (pRe[a] + pRe[b]);
+        float evenIm = 0.5f * (pIm[a] - pIm[b]);
+        float oddRe = 0.5f * (pIm[a] + pIm[b]);
+        float oddIm = -0.5f * (pRe[a] - pRe[b]);
+        float re = evenRe + pUnpackRe[k] * oddRe + pUnpackIm[k] * oddIm;
+        float im = evenIm + pUnpackRe[k] * oddIm - pUnpackIm[k] * oddRe;
+        pPower[k] = re * re + im * im;
+    };
+
+    bin(0);
+    std::size_t k = 1;
+    const V halves = Ops::broadcast(0.5f);
+    for (; k + Ops::kWidth <= size; k += Ops::kWidth)
+    {
+        V ar = Ops::load(pRe + k), ai = Ops::load(pIm + k);
+        V br = Ops::loadReversed(pRe + size - k), bi = Ops::loadReversed(pIm + size - k);
+        V evenRe = Ops::mul(halves, Ops::add(ar, br));
+        V evenIm = Ops::mul(halves, Ops::sub(ai, bi));
+        V oddRe = Ops::mul(halves, Ops::add(ai, bi));
+        V oddIm = Ops::mul(halves, Ops::sub(br, ar));
+        V wr = Ops::load(pUnpackRe + k), wi = Ops::load(pUnpackIm + k);
+        V re = Ops::mulAdd(wi, oddIm, Ops::mulAdd(wr, oddRe, evenRe));
+        V im = Ops::mulSub(wi, oddRe, Ops::mulAdd(wr, oddIm, evenIm));
+        Ops::store(pPower + k, Ops::mulAdd(im, im, Ops::mul(re, re)));
+    }
+    for (; k <= size; ++k)
+    {
+        bin(k);
+    }
+}
+
+} // namespace
+
+} // namespace vmx::detail
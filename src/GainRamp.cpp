@@ -0,0 +1,185 @@
+/* ==== Application Includes =============================================== */
+#include <vmx/GainRamp.h>
+#include <vmx/PcmMeter.h>
+#include "MixKernels.h"
+
+/* ==== Standard Library Includes ========================================== */
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+/* ==== Operating System Includes ========================================== */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VMX_MIX_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace vmx::detail
+{
+
+namespace
+{
+
+/* ==== Baseline Operations ================================================ */
+// SSE2 is part of every x86-64 target, so this needs no runtime check
+#if VMX_MIX_SSE2
+struct BaselineOps
+{
+    using V = __m128;
+    static constexpr std::size_t kWidth = 4;
+
+    static V broadcast(float value) { return _mm_set1_ps(value); };
+    static V load(const float *p) { return _mm_loadu_ps(p); };
+    static void store(float *p, V v) { _mm_storeu_ps(p, v); };
+    static V add(V a, V b) { return _mm_add_ps(a, b); };
+    static V mul(V a, V b) { return _mm_mul_ps(a, b); };
+    static V mulAdd(V a, V b, V c) { return _mm_add_ps(_mm_mul_ps(a, b), c); };
+};
+#else
+struct BaselineOps
+{
+    using V = float;
+    static constexpr std::size_t kWidth = 1;
+
+    static V broadcast(float value) { return value; };
+    static V load(const float *p) { return *p; };
+    static void store(float *p, V v) { *p = v; };
+    static V add(V a, V b) { return a + b; };
+    static V mul(V a, V b) { return a * b; };
+    static V mulAdd(V a, V b, V c) { return a * b + c; };
+};
+#endif
+
+} // namespace
+
+GainKernel
+gainKernelBaseline()
+{
+    return &gainKernel<BaselineOps>;
+}
+
+} // namespace vmx::detail
+
+/* ==== Forward Declarations =============================================== */
+static vmx::detail::GainKernel selectKernel();
+
+namespace vmx
+{
+
+/* ==== GainRamp Class ===================================================== */
+GainRamp::GainRamp
+(
+    unsigned int sampleRate,
+    float gain,
+    std::chrono::microseconds rampLength
+)
+  : m_target(gain),
+    m_rampFrames(std::max<std::size_t>(1, static_cast<std::size_t>(static_cast<double>(sampleRate) * std::chrono::duration<double>(rampLength).count()))),
+    m_pKernel(selectKernel()),
+    m_gain(gain),
+    m_rampTarget(gain)
+{
+    if (sampleRate == 0)
+    {
+        throw std::runtime_error("GainRamp needs a sample rate above zero");
+    }
+}
+
+// Splits frameCount frames into the part still on the ramp and the part at
+// a constant gain, restarting the ramp from wherever it is when the target
+// moved. apply(frame, count, gain, step) runs the kernel over each part.
+template <class Apply>
+void
+GainRamp::advance
+(
+    std::size_t frameCount,
+    const Apply &apply
+)
+{
+    float target = m_target.load(std::memory_order_relaxed);
+    if (target != m_rampTarget)
+    {
+        m_rampTarget = target;
+        m_step = (target - m_gain) / static_cast<float>(m_rampFrames);
+        m_framesLeft = m_rampFrames;
+    }
+
+    std::size_t rampFrames = std::min(m_framesLeft, frameCount);
+    if (rampFrames > 0)
+    {
+        apply(0, rampFrames, m_gain, m_step);
+        m_framesLeft -= rampFrames;
+        m_gain = (m_framesLeft == 0) ? m_rampTarget : m_gain + m_step * static_cast<float>(rampFrames);
+    }
+    if (rampFrames < frameCount)
+    {
+        apply(rampFrames, frameCount - rampFrames, m_gain, 0.0f);
+    }
+}
+
+void
+GainRamp::process
+(
+    const float *pIn,
+    float *pOut,
+    float *pBus,
+    std::size_t channelCount,
+    std::size_t frameCount
+)
+{
+    if (channelCount == 0 || channelCount > kMaxChannels)
+    {
+        throw std::runtime_error("GainRamp supports 1 to " + std::to_string(kMaxChannels) + " channels");
+    }
+
+    advance(frameCount, [&](std::size_t frame, std::size_t count, float gain, float step)
+    {
+        std::size_t offset = frame * channelCount;
+        m_pKernel(pIn + offset, pOut ? pOut + offset : nullptr, pBus ? pBus + offset : nullptr, channelCount, count, gain, step);
+    });
+}
+
+void
+GainRamp::processPlanar
+(
+    std::span<const float* const> inputs,
+    std::span<float* const> outputs,
+    std::span<float* const> bus,
+    std::size_t frameCount
+)
+{
+    advance(frameCount, [&](std::size_t frame, std::size_t count, float gain, float step)
+    {
+        for (std::size_t channel = 0; channel < inputs.size(); ++channel)
+        {
+            float *pOut = channel < outputs.size() ? outputs[channel] + frame : nullptr;
+            float *pBus = channel < bus.size() ? bus[channel] + frame : nullptr;
+            m_pKernel(inputs[channel] + frame, pOut, pBus, 1, count, gain, step);
+        }
+    });
+}
+
+void
+GainRamp::reset
+(
+    float gain
+)
+{
+    m_target.store(gain, std::memory_order_relaxed);
+    m_gain = gain;
+    m_rampTarget = gain;
+    m_step = 0.0f;
+    m_framesLeft = 0;
+}
+
+} // namespace vmx
+
+/* ==== Static Helper Functions ============================================ */
+static vmx::detail::GainKernel
+selectKernel()
+{
+#if VMX_PCM_X86
+    if (vmx::PcmMeter::isa() >= vmx::PcmMeter::Isa::Avx2) return vmx::detail::gainKernelAvx2();
+#endif
+    return vmx::detail::gainKernelBaseline();
+}
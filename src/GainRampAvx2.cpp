@@ -0,0 +1,35 @@
+/* ==== Application Includes =============================================== */
+#include "MixKernels.h"
+
+/* ==== Operating System Includes ========================================== */
+#include <immintrin.h>
+
+namespace vmx::detail
+{
+
+namespace
+{
+
+/* ==== AVX2 Operations ==================================================== */
+struct Avx2Ops
+{
+    using V = __m256;
+    static constexpr std::size_t kWidth = 8;
+
+    static V broadcast(float value) { return _mm256_set1_ps(value); };
+    static V load(const float *p) { return _mm256_loadu_ps(p); };
+    static void store(float *p, V v) { _mm256_storeu_ps(p, v); };
+    static V add(V a, V b) { return _mm256_add_ps(a, b); };
+    static V mul(V a, V b) { return _mm256_mul_ps(a, b); };
+    static V mulAdd(V a, V b, V c) { return _mm256_fmadd_ps(a, b, c); };
+};
+
+} // namespace
+
+GainKernel
+gainKernelAvx2()
+{
+    return &gainKernel<Avx2Ops>;
+}
+
+} // namespace vmx::detail
@@ -0,0 +1,58 @@
+#pragma once
+
+/* ==== Application Includes =============================================== */
+#include <vmx/Metrics.h>
+#include <vmx/Stats.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <chrono>
+#include <cstdint>
+
+namespace vmx::detail
+{
+
+/* ==== Functions ========================================================== */
+inline std::uint64_t
+timestampNs()
+{
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+Metrics &metrics();
+void recordObserverCall(EventKind kind, std::uint64_t reportedNs, std::uint64_t startedNs, std::uint64_t finishedNs);
+Stats snapshotStats();
+void resetStats();
+
+inline void
+countBackendCall
+(
+    bool bSucceeded
+)
+{
+    metrics().backendCalls.add();
+    if (!bSucceeded)
+    {
+        metrics().backendErrors.add();
+    }
+}
+
+/* ==== Classes ============================================================ */
+class ScopedPeakTick
+{
+public: /* Methods */
+    ScopedPeakTick() : m_startedNs(timestampNs()) {};
+    ~ScopedPeakTick()
+    {
+        metrics().peakTicks.add();
+        metrics().peakTickDuration.record(timestampNs() - m_startedNs);
+    };
+    ScopedPeakTick(const ScopedPeakTick&) = delete;
+    ScopedPeakTick& operator=(const ScopedPeakTick&) = delete;
+
+private: /* Members */
+    std::uint64_t m_startedNs;
+};
+
+} // namespace vmx::detail
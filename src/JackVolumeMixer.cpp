@@ -0,0 +1,927 @@
+/* ==== Application Includes =============================================== */
+#include <vmx/JackVolumeMixer.h>
+#include <vmx/PcmMeter.h>
+#include "BackendPlugin.h"
+#include "Dispatch.h"
+#include "Instrumentation.h"
+#include "Tracing.h"
+
+/* ==== Standard Library Includes ========================================== */
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+/* ==== Macros ============================================================= */
+// The DispatchScope comes first so that synchronous observer calls wait for the lock's release
+#define LOCK_GUARD(mutex_var)                                                           \
+    const detail::DispatchScope dispatchScope;                                          \
+    const detail::LockGuard<decltype(mutex_var)> lock(mutex_var)
+
+/* ==== Forward Declarations =============================================== */
+static float toGain(float volume);
+static std::vector<float> clampChannelVolumes(std::vector<float> channelVolumes, std::size_t channelCount);
+static std::string clientOf(const std::string &portName);
+static std::vector<std::string> takePortNames(const char **ppPortNames);
+
+namespace vmx
+{
+
+/* ==== JackAudioSession Class ============================================= */
+JackAudioSession::JackAudioSession
+(
+    JackVolumeMixer &volumeMixer,
+    std::size_t slot,
+    const std::string &clientName
+)
+  : m_volumeMixer(volumeMixer),
+    m_slot(slot),
+    m_channelVolumes(1, 1.0f),
+    m_id(clientName)
+{
+    updateName(clientName);
+    updateState(State::Active);
+    updateVolume(1.0f);
+    updateChannelVolumes(m_channelVolumes);
+    updateMute(false);
+}
+
+void
+JackAudioSession::changeVolume
+(
+    float volume
+)
+{
+    VMX_TRACE_SCOPE("JackAudioSession::changeVolume", "control");
+    LOCK_GUARD(m_mutex);
+    if (m_bExpired) return;
+    volume = std::min(1.0f, volume);
+    volume = std::max(0.0f, volume);
+    ChannelVolumes::setVolume(m_channelVolumes, volume);
+    storeChannelGains();
+    detail::countBackendCall(true);
+    updateVolume(volume);
+    updateChannelVolumes(m_channelVolumes);
+}
+
+void
+JackAudioSession::changeMute
+(
+    bool bMute
+)
+{
+    VMX_TRACE_SCOPE("JackAudioSession::changeMute", "control");
+    LOCK_GUARD(m_mutex);
+    if (m_bExpired) return;
+    m_volumeMixer.m_pSlots[m_slot].bMuted.store(bMute, std::memory_order_relaxed);
+    detail::countBackendCall(true);
+    updateMute(bMute);
+}
+
+void
+JackAudioSession::changeChannelVolumes
+(
+    std::vector<float> channelVolumes
+)
+{
+    VMX_TRACE_SCOPE("JackAudioSession::changeChannelVolumes", "control");
+    LOCK_GUARD(m_mutex);
+    if (m_bExpired) return;
+    m_channelVolumes = clampChannelVolumes(std::move(channelVolumes), m_channelVolumes.size());
+    storeChannelGains();
+    detail::countBackendCall(true);
+    updateVolume(ChannelVolumes::volume(m_channelVolumes));
+    updateChannelVolumes(m_channelVolumes);
+}
+
+std::shared_ptr<AudioTap>
+JackAudioSession::openAudioTap
+(
+    std::chrono::milliseconds bufferLength
+)
+{
+    VMX_TRACE_SCOPE("JackAudioSession::openAudioTap", "control");
+
+    // Not under m_mutex, the mixer locks the other way round when it patches a session out
+    return m_volumeMixer.openAudioTap(m_slot, this, bufferLength);
+}
+
+// Graph thread, before the channel is published to the process callback
+void
+JackAudioSession::addChannel()
+{
+    LOCK_GUARD(m_mutex);
+    m_channelVolumes.push_back(ChannelVolumes::volume(m_channelVolumes));
+    storeChannelGains();
+    updateChannelVolumes(m_channelVolumes);
+}
+
+void
+JackAudioSession::storeChannelGains()
+{
+    auto &gains = m_volumeMixer.m_pSlots[m_slot].gains;
+    for (std::size_t channel = 0; channel < m_channelVolumes.size(); ++channel)
+    {
+        gains[channel].store(toGain(m_channelVolumes[channel]), std::memory_order_relaxed);
+    }
+}
+
+/* ==== JackAudioDevice Class ============================================== */
+JackAudioDevice::JackAudioDevice
+(
+    JackVolumeMixer &volumeMixer,
+    const std::string &serverName,
+    std::size_t channelCount
+)
+  : m_volumeMixer(volumeMixer),
+    m_channelVolumes(channelCount, 1.0f),
+    m_id(serverName)
+{
+    storeChannelGains();
+    updateName("JACK (" + serverName + ")");
+    updateState(State::Active);
+    updateDefault(true);
+    updateVolume(1.0f);
+    updateChannelVolumes(m_channelVolumes);
+    updateMute(false);
+}
+
+void
+JackAudioDevice::changeVolume
+(
+    float volume
+)
+{
+    VMX_TRACE_SCOPE("JackAudioDevice::changeVolume", "control");
+    LOCK_GUARD(m_mutex);
+    volume = std::min(1.0f, volume);
+    volume = std::max(0.0f, volume);
+    ChannelVolumes::setVolume(m_channelVolumes, volume);
+    storeChannelGains();
+    detail::countBackendCall(true);
+    updateVolume(volume);
+    updateChannelVolumes(m_channelVolumes);
+}
+
+void
+JackAudioDevice::changeMute
+(
+    bool bMute
+)
+{
+    VMX_TRACE_SCOPE("JackAudioDevice::changeMute", "control");
+    LOCK_GUARD(m_mutex);
+    m_volumeMixer.m_bMasterMuted.store(bMute, std::memory_order_relaxed);
+    detail::countBackendCall(true);
+    updateMute(bMute);
+}
+
+void
+JackAudioDevice::changeChannelVolumes
+(
+    std::vector<float> channelVolumes
+)
+{
+    VMX_TRACE_SCOPE("JackAudioDevice::changeChannelVolumes", "control");
+    LOCK_GUARD(m_mutex);
+    m_channelVolumes = clampChannelVolumes(std::move(channelVolumes), m_channelVolumes.size());
+    storeChannelGains();
+    detail::countBackendCall(true);
+    updateVolume(ChannelVolumes::volume(m_channelVolumes));
+    updateChannelVolumes(m_channelVolumes);
+}
+
+std::shared_ptr<AudioTap>
+JackAudioDevice::openAudioTap
+(
+    std::chrono::milliseconds bufferLength
+)
+{
+    VMX_TRACE_SCOPE("JackAudioDevice::openAudioTap", "control");
+    return m_volumeMixer.openAudioTap(JackVolumeMixer::kMaxSessions, nullptr, bufferLength);
+}
+
+void
+JackAudioDevice::attachSession
+(
+    std::shared_ptr<JackAudioSession> pJackAudioSession
+)
+{
+    LOCK_GUARD(m_mutex);
+    m_audioSessionsMirror[pJackAudioSession->getId()] = pJackAudioSession;
+    addSession(pJackAudioSession->getId(), pJackAudioSession);
+}
+
+void
+JackAudioDevice::detachSession
+(
+    const std::string &audioSessionId
+)
+{
+    LOCK_GUARD(m_mutex);
+    m_audioSessionsMirror.erase(audioSessionId);
+    removeSession(audioSessionId);
+}
+
+// Session channels past the last playback port follow the loudest device channel
+void
+JackAudioDevice::storeChannelGains()
+{
+    auto &gains = m_volumeMixer.m_masterGains;
+    float loudest = toGain(ChannelVolumes::volume(m_channelVolumes));
+    for (std::size_t channel = 0; channel < JackVolumeMixer::kMaxChannels; ++channel)
+    {
+        gains[channel].store(channel < m_channelVolumes.size() ? toGain(m_channelVolumes[channel]) : loudest, std::memory_order_relaxed);
+    }
+}
+
+/* ==== JackVolumeMixer Class ============================================== */
+JackVolumeMixer::JackVolumeMixer
+(
+    const std::string &serverName
+)
+  : m_pSlots(std::make_unique<Slot[]>(kMaxSessions)),
+    m_peakRing(16384),
+    m_loudnessRing(4096),
+    m_mix(kMaxChannels * kMaxMixFrames),
+    m_graphStrand(m_serviceExecutor),
+    m_peakSamplingTimer([this](){peakSample();}, std::chrono::milliseconds(0)),
+    m_loudnessSamplingTimer([this](){loudnessSample();}, std::chrono::milliseconds(0))
+{
+    jack_status_t status;
+    auto options = static_cast<jack_options_t>(JackNoStartServer | (serverName.empty() ? 0 : JackServerName));
+    m_pClient = jack_client_open("vmx", options, &status, serverName.c_str());
+    if (!m_pClient)
+    {
+        throw std::runtime_error("Unable to connect to the JACK server, status " + std::to_string(static_cast<unsigned>(status)));
+    }
+    m_clientName = jack_get_client_name(m_pClient);
+    m_pDeviceLoudnessMeter = std::make_unique<LoudnessMeter>(jack_get_sample_rate(m_pClient), std::vector<double>(kMaxChannels, 1.0));
+
+    jack_set_process_callback(m_pClient, &JackVolumeMixer::processCallback, this);
+    jack_set_client_registration_callback(m_pClient, &JackVolumeMixer::clientRegistrationCallback, this);
+    jack_set_port_connect_callback(m_pClient, &JackVolumeMixer::portConnectCallback, this);
+    jack_on_shutdown(m_pClient, &JackVolumeMixer::shutdownCallback, this);
+    if (jack_activate(m_pClient) != 0)
+    {
+        jack_client_close(m_pClient);
+        m_pClient = nullptr;
+        throw std::runtime_error("Unable to activate the vmx JACK client");
+    }
+
+    auto playbackPorts = takePortNames(jack_get_ports(m_pClient, nullptr, JACK_DEFAULT_AUDIO_TYPE, JackPortIsPhysical | JackPortIsInput));
+    std::size_t channelCount = std::clamp<std::size_t>(playbackPorts.size(), 1, kMaxChannels);
+    m_pAudioDevice = std::make_shared<JackAudioDevice>(*this, serverName.empty() ? "default" : serverName, channelCount);
+    addDevice(m_pAudioDevice->getId(), m_pAudioDevice);
+
+    // Populate the tree before returning, the same as the other backends
+    rescan();
+}
+
+JackVolumeMixer::~JackVolumeMixer()
+{
+    // Before the lock, which a running rescan() may be waiting for
+    m_graphStrand.close();
+    LOCK_GUARD(m_mutex);
+    if (!m_pClient) return;
+
+    // Put every session back the way it was patched before vmx was inserted
+    if (!m_bServerGone)
+    {
+        for (std::size_t slot = 0; slot < kMaxSessions; ++slot)
+        {
+            if (m_pSlots[slot].bActive.load(std::memory_order_relaxed))
+            {
+                patchOut(slot, true);
+            }
+        }
+        jack_deactivate(m_pClient);
+    }
+    jack_client_close(m_pClient);
+    m_pClient = nullptr;
+
+    // Only now is the process callback certainly done with taps a stalled cycle kept alive
+    for (std::size_t slot = 0; slot <= kMaxSessions; ++slot)
+    {
+        closeAudioTaps(slot);
+    }
+}
+
+void
+JackVolumeMixer::setPeakSamplingPeriod
+(
+    std::chrono::milliseconds period
+)
+{
+    m_bMetering.store(period.count() > 0, std::memory_order_relaxed);
+    m_peakSamplingTimer.changePeriod(period);
+}
+
+void
+JackVolumeMixer::setLoudnessSamplingPeriod
+(
+    std::chrono::milliseconds period
+)
+{
+    m_bLoudnessMetering.store(period.count() > 0, std::memory_order_relaxed);
+    m_loudnessSamplingTimer.changePeriod(period);
+}
+
+int
+JackVolumeMixer::processCallback
+(
+    jack_nframes_t nFrames,
+    void *pUserData
+)
+{
+    return static_cast<JackVolumeMixer*>(pUserData)->process(nFrames);
+}
+
+void
+JackVolumeMixer::clientRegistrationCallback
+(
+    const char *,
+    int,
+    void *pUserData
+)
+{
+    static_cast<JackVolumeMixer*>(pUserData)->queueRescan();
+}
+
+void
+JackVolumeMixer::portConnectCallback
+(
+    jack_port_id_t,
+    jack_port_id_t,
+    int,
+    void *pUserData
+)
+{
+    static_cast<JackVolumeMixer*>(pUserData)->queueRescan();
+}
+
+void
+JackVolumeMixer::shutdownCallback
+(
+    void *pUserData
+)
+{
+    auto *pThis = static_cast<JackVolumeMixer*>(pUserData);
+    pThis->m_bServerGone = true;
+    if (pThis->m_pAudioDevice)
+    {
+        pThis->m_pAudioDevice->updateState(AudioDevice::State::NotPresent);
+    }
+}
+
+int
+JackVolumeMixer::process
+(
+    jack_nframes_t nFrames
+)
+{
+    // Realtime thread: no locks, no allocation, no tracing (spans take a mutex)
+    bool bMasterMuted = m_bMasterMuted.load(std::memory_order_relaxed);
+    bool bMetering = m_bMetering.load(std::memory_order_relaxed);
+    bool bLoudnessMetering = m_bLoudnessMetering.load(std::memory_order_relaxed);
+    std::array<AudioTap*, kMaxTaps> deviceAudioTaps;
+    bool bDeviceTapped = false;
+    for (std::size_t tap = 0; tap < kMaxTaps; ++tap)
+    {
+        deviceAudioTaps[tap] = m_deviceAudioTaps[tap].load(std::memory_order_acquire);
+        bDeviceTapped |= deviceAudioTaps[tap] != nullptr;
+    }
+    bool bMixing = (bLoudnessMetering || bDeviceTapped) && nFrames <= kMaxMixFrames;
+    std::size_t mixChannelCount = 0;
+    float loudest = 0.0f;
+
+    for (std::uint32_t index = 0; index < kMaxSessions; ++index)
+    {
+        Slot &slot = m_pSlots[index];
+        if (!slot.bActive.load(std::memory_order_acquire)) continue;
+
+        std::uint32_t channelCount = slot.channelCount.load(std::memory_order_acquire);
+        bool bMuted = bMasterMuted || slot.bMuted.load(std::memory_order_relaxed);
+        std::array<const float*, kMaxChannels> inputs;
+        std::array<float*, kMaxChannels> outputs;
+        std::array<float*, kMaxChannels> mix;
+
+        for (std::uint32_t channel = 0; channel < channelCount; ++channel)
+        {
+            inputs[channel] = static_cast<const jack_default_audio_sample_t*>(jack_port_get_buffer(slot.inputs[channel], nFrames));
+            outputs[channel] = static_cast<jack_default_audio_sample_t*>(jack_port_get_buffer(slot.outputs[channel], nFrames));
+
+            // The device hears every session summed channel by channel
+            mix[channel] = nullptr;
+            if (bMixing)
+            {
+                mix[channel] = &m_mix[channel * kMaxMixFrames];
+                if (channel >= mixChannelCount)
+                {
+                    std::fill(mix[channel], mix[channel] + nFrames, 0.0f);
+                    mixChannelCount = channel + 1;
+                }
+            }
+
+            // The master gain is folded into every session, there is no separate bus to apply it to
+            GainRamp &gainRamp = *slot.gainRamps[channel];
+            gainRamp.setTarget(bMuted ? 0.0f : slot.gains[channel].load(std::memory_order_relaxed) * m_masterGains[channel].load(std::memory_order_relaxed));
+            gainRamp.process(inputs[channel], outputs[channel], mix[channel], 1, nFrames);
+        }
+
+        float peak = 0.0f;
+        if (bMetering)
+        {
+            for (std::uint32_t channel = 0; channel < channelCount; ++channel)
+            {
+                float channelPeak;
+                PcmMeter::peak(SampleFormat::Float32, outputs[channel], nFrames, {&channelPeak, 1});
+                peak = std::max(peak, channelPeak);
+            }
+        }
+        loudest = std::max(loudest, peak);
+
+        // A full ring means the sampler fell behind, dropping a peak is harmless
+        if (bMetering)
+        {
+            m_peakRing.tryPush({index, peak});
+        }
+        if (bLoudnessMetering && slot.pLoudnessMeter->processPlanar({outputs.data(), channelCount}, nFrames) > 0)
+        {
+            m_loudnessRing.tryPush({index, slot.pLoudnessMeter->loudness()});
+        }
+        for (auto &audioTap : slot.audioTaps)
+        {
+            if (AudioTap *pAudioTap = audioTap.load(std::memory_order_acquire))
+            {
+                pAudioTap->write({outputs.data(), channelCount}, nFrames);
+            }
+        }
+    }
+
+    if (bMetering)
+    {
+        m_peakRing.tryPush({static_cast<std::uint32_t>(kMaxSessions), loudest});
+    }
+    if (bMixing)
+    {
+        std::array<const float*, kMaxChannels> mix;
+        for (std::size_t channel = 0; channel < mixChannelCount; ++channel)
+        {
+            mix[channel] = &m_mix[channel * kMaxMixFrames];
+        }
+        if (bLoudnessMetering && m_pDeviceLoudnessMeter->processPlanar({mix.data(), mixChannelCount}, nFrames) > 0)
+        {
+            m_loudnessRing.tryPush({static_cast<std::uint32_t>(kMaxSessions), m_pDeviceLoudnessMeter->loudness()});
+        }
+
+        // Playback channels no session feeds are written as silence
+        for (AudioTap *pAudioTap : deviceAudioTaps)
+        {
+            if (pAudioTap)
+            {
+                pAudioTap->write({mix.data(), mixChannelCount}, nFrames);
+            }
+        }
+    }
+    m_processCycles.fetch_add(1, std::memory_order_release);
+    return 0;
+}
+
+void
+JackVolumeMixer::queueRescan()
+{
+    // JACK forbids graph changes from its notification thread, and bursts of
+    // notifications only need one rescan
+    if (!m_bRescanQueued.exchange(true))
+    {
+        m_graphStrand.post([this]{rescan();});
+    }
+}
+
+void
+JackVolumeMixer::rescan()
+{
+    VMX_TRACE_SCOPE("JackVolumeMixer::rescan", "backend");
+    m_bRescanQueued = false;
+    LOCK_GUARD(m_mutex);
+    if (!m_pClient || m_bServerGone) return;
+
+    auto playbackPorts = takePortNames(jack_get_ports(m_pClient, nullptr, JACK_DEFAULT_AUDIO_TYPE, JackPortIsPhysical | JackPortIsInput));
+    std::set<std::string> playbackPortSet(playbackPorts.begin(), playbackPorts.end());
+    auto outputPorts = takePortNames(jack_get_ports(m_pClient, nullptr, JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput));
+    detail::countBackendCall(true);
+
+    std::set<std::string> liveClients;
+    for (const auto &outputPort : outputPorts)
+    {
+        std::string clientName = clientOf(outputPort);
+        liveClients.insert(clientName);
+        if (clientName == m_clientName) continue;
+
+        jack_port_t *pPort = jack_port_by_name(m_pClient, outputPort.c_str());
+        if (!pPort || (jack_port_flags(pPort) & JackPortIsPhysical)) continue;
+
+        // Only ports still patched straight into the playback ports need vmx inserted
+        std::vector<std::string> destinations;
+        for (const auto &connection : takePortNames(jack_port_get_all_connections(m_pClient, pPort)))
+        {
+            if (playbackPortSet.contains(connection))
+            {
+                destinations.push_back(connection);
+            }
+        }
+        if (!destinations.empty())
+        {
+            patchIn(clientName, outputPort, destinations);
+        }
+    }
+
+    for (std::size_t slot = 0; slot < kMaxSessions; ++slot)
+    {
+        if (m_pSlots[slot].bActive.load(std::memory_order_relaxed) && !liveClients.contains(m_routes[slot].clientName))
+        {
+            patchOut(slot, false);
+        }
+    }
+}
+
+void
+JackVolumeMixer::patchIn
+(
+    const std::string &clientName,
+    const std::string &sourcePort,
+    const std::vector<std::string> &destinations
+)
+{
+    auto isClient = [&clientName](const Route &route) { return route.clientName == clientName; };
+    auto route = std::find_if(m_routes.begin(), m_routes.end(), isClient);
+    if (route == m_routes.end())
+    {
+        route = std::find_if(m_routes.begin(), m_routes.end(), [](const Route &candidate) { return candidate.clientName.empty() && !candidate.bRetired; });
+        if (route == m_routes.end()) return; // out of slots, the client simply stays unmanaged
+        route->clientName = clientName;
+    }
+    auto slotIndex = static_cast<std::size_t>(route - m_routes.begin());
+    Slot &slot = m_pSlots[slotIndex];
+
+    auto source = std::find(route->sources.begin(), route->sources.end(), sourcePort);
+    auto channel = static_cast<std::size_t>(source - route->sources.begin());
+    if (source == route->sources.end())
+    {
+        if (channel == kMaxChannels) return;
+
+        std::string shortName = clientName.substr(0, 40) + "-" + std::to_string(channel);
+        jack_port_t *pInput = jack_port_register(m_pClient, (shortName + "-in").c_str(), JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
+        jack_port_t *pOutput = jack_port_register(m_pClient, (shortName + "-out").c_str(), JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
+        detail::countBackendCall(pInput && pOutput);
+        if (!pInput || !pOutput)
+        {
+            if (pInput) jack_port_unregister(m_pClient, pInput);
+            if (pOutput) jack_port_unregister(m_pClient, pOutput);
+            if (route->sources.empty()) route->clientName.clear();
+            return;
+        }
+        detail::countBackendCall(jack_connect(m_pClient, sourcePort.c_str(), jack_port_name(pInput)) == 0);
+
+        // A new channel starts at the session's volume; the ports, gain and ramp
+        // are published by the channel count, the slot by bActive
+        float channelGain = 1.0f;
+        if (channel > 0)
+        {
+            m_sessions[slotIndex]->addChannel();
+            channelGain = slot.gains[channel].load(std::memory_order_relaxed);
+        }
+        slot.gains[channel].store(channelGain, std::memory_order_relaxed);
+        channelGain *= m_bMasterMuted ? 0.0f : m_masterGains[channel].load(std::memory_order_relaxed);
+        slot.gainRamps[channel] = std::make_unique<GainRamp>(jack_get_sample_rate(m_pClient), channelGain);
+        slot.inputs[channel] = pInput;
+        slot.outputs[channel] = pOutput;
+        slot.channelCount.store(static_cast<std::uint32_t>(channel + 1), std::memory_order_release);
+        route->sources.push_back(sourcePort);
+        route->destinations.emplace_back();
+
+        if (channel == 0)
+        {
+            slot.pLoudnessMeter = std::make_unique<LoudnessMeter>(jack_get_sample_rate(m_pClient), std::vector<double>(kMaxChannels, 1.0));
+            slot.bMuted.store(false, std::memory_order_relaxed);
+            slot.bActive.store(true, std::memory_order_release);
+
+            auto pJackAudioSession = std::make_shared<JackAudioSession>(*this, slotIndex, clientName);
+            m_sessions[slotIndex] = pJackAudioSession;
+            m_pAudioDevice->attachSession(pJackAudioSession);
+        }
+    }
+
+    // vmx's output is live before the direct path is cut, so nothing drops out
+    const char *outputName = jack_port_name(slot.outputs[channel]);
+    for (const auto &destination : destinations)
+    {
+        detail::countBackendCall(jack_connect(m_pClient, outputName, destination.c_str()) == 0);
+        detail::countBackendCall(jack_disconnect(m_pClient, sourcePort.c_str(), destination.c_str()) == 0);
+        auto &channelDestinations = route->destinations[channel];
+        if (std::find(channelDestinations.begin(), channelDestinations.end(), destination) == channelDestinations.end())
+        {
+            channelDestinations.push_back(destination);
+        }
+    }
+}
+
+void
+JackVolumeMixer::patchOut
+(
+    std::size_t slotIndex,
+    bool bRestoreRouting
+)
+{
+    Slot &slot = m_pSlots[slotIndex];
+    Route &route = m_routes[slotIndex];
+
+    if (bRestoreRouting)
+    {
+        for (std::size_t channel = 0; channel < route.sources.size(); ++channel)
+        {
+            for (const auto &destination : route.destinations[channel])
+            {
+                jack_connect(m_pClient, route.sources[channel].c_str(), destination.c_str());
+            }
+        }
+    }
+
+    // The ports can only go once the process callback is guaranteed to be done
+    // with them. When it stalled, it may still be in the middle of this slot:
+    // the ports, ramps and taps are left as they are and the slot is never
+    // reused, jack_deactivate() in the destructor makes it safe to free them.
+    slot.bActive.store(false, std::memory_order_release);
+    bool bRetired = !waitForProcessCycles();
+    if (!bRetired)
+    {
+        std::uint32_t channelCount = slot.channelCount.exchange(0, std::memory_order_relaxed);
+        for (std::uint32_t channel = 0; channel < channelCount; ++channel)
+        {
+            jack_port_unregister(m_pClient, slot.inputs[channel]);
+            jack_port_unregister(m_pClient, slot.outputs[channel]);
+            slot.inputs[channel] = nullptr;
+            slot.outputs[channel] = nullptr;
+        }
+        closeAudioTaps(slotIndex);
+    }
+    else
+    {
+        for (const auto &pAudioTap : m_audioTapOwners[slotIndex])
+        {
+            if (pAudioTap) pAudioTap->close();
+        }
+    }
+
+    auto pJackAudioSession = std::move(m_sessions[slotIndex]);
+    if (pJackAudioSession)
+    {
+        {
+            LOCK_GUARD(pJackAudioSession->m_mutex);
+            pJackAudioSession->m_bExpired = true;
+        }
+        pJackAudioSession->updateState(AudioSession::State::Expired);
+        m_pAudioDevice->detachSession(pJackAudioSession->getId());
+    }
+    route = Route{};
+    route.bRetired = bRetired;
+}
+
+bool
+JackVolumeMixer::waitForProcessCycles()
+{
+    // Two cycle ends guarantee a cycle started after the caller's last store
+    // has finished. Gives up after a while in case the server stopped calling
+    // us, returning false: the callback may then still be using what the
+    // caller unpublished, which has to be kept alive.
+    std::uint64_t startCycle = m_processCycles.load(std::memory_order_acquire);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+    while (m_processCycles.load(std::memory_order_acquire) < startCycle + 2)
+    {
+        if (std::chrono::steady_clock::now() >= deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+std::shared_ptr<AudioTap>
+JackVolumeMixer::openAudioTap
+(
+    std::size_t slotIndex,
+    const JackAudioSession *pJackAudioSession,
+    std::chrono::milliseconds bufferLength
+)
+{
+    LOCK_GUARD(m_mutex);
+    if (!m_pClient || m_bServerGone) return nullptr;
+
+    std::size_t channelCount = 0;
+    if (slotIndex < kMaxSessions)
+    {
+        // The session may have been patched out, and its slot reused, meanwhile
+        if (m_sessions[slotIndex].get() != pJackAudioSession) return nullptr;
+        channelCount = m_pSlots[slotIndex].channelCount.load(std::memory_order_relaxed);
+    }
+    else
+    {
+        auto playbackPorts = takePortNames(jack_get_ports(m_pClient, nullptr, JACK_DEFAULT_AUDIO_TYPE, JackPortIsPhysical | JackPortIsInput));
+        detail::countBackendCall(true);
+        channelCount = std::clamp<std::size_t>(playbackPorts.size(), 1, kMaxChannels);
+    }
+
+    pruneAudioTaps(slotIndex);
+    auto &owners = m_audioTapOwners[slotIndex];
+    auto owner = std::find(owners.begin(), owners.end(), nullptr);
+    if (owner == owners.end())
+    {
+        throw std::runtime_error("At most " + std::to_string(kMaxTaps) + " audio taps can be open on one JACK session or device");
+    }
+
+    *owner = std::make_shared<AudioTap>(jack_get_sample_rate(m_pClient), channelCount, bufferLength);
+    audioTapsOf(slotIndex)[owner - owners.begin()].store(owner->get(), std::memory_order_release);
+    return *owner;
+}
+
+JackVolumeMixer::AudioTaps&
+JackVolumeMixer::audioTapsOf
+(
+    std::size_t slotIndex
+)
+{
+    return slotIndex < kMaxSessions ? m_pSlots[slotIndex].audioTaps : m_deviceAudioTaps;
+}
+
+void
+JackVolumeMixer::pruneAudioTaps
+(
+    std::size_t slotIndex
+)
+{
+    // Taps the consumer closed or let go of are unpublished first, and only
+    // freed once the process callback can no longer be writing to them
+    auto &audioTaps = audioTapsOf(slotIndex);
+    auto &owners = m_audioTapOwners[slotIndex];
+    std::array<bool, kMaxTaps> finished = {};
+    bool bAnyFinished = false;
+    for (std::size_t tap = 0; tap < kMaxTaps; ++tap)
+    {
+        finished[tap] = owners[tap] && (owners[tap]->isClosed() || owners[tap].use_count() == 1);
+        if (finished[tap])
+        {
+            audioTaps[tap].store(nullptr, std::memory_order_relaxed);
+            bAnyFinished = true;
+        }
+    }
+    // A stalled callback may still be writing to them; they stay owned and
+    // unpublished, and the next prune (or the destructor) tries again
+    if (!bAnyFinished || !waitForProcessCycles()) return;
+
+    for (std::size_t tap = 0; tap < kMaxTaps; ++tap)
+    {
+        if (finished[tap])
+        {
+            owners[tap]->close();
+            owners[tap].reset();
+        }
+    }
+}
+
+void
+JackVolumeMixer::closeAudioTaps
+(
+    std::size_t slotIndex
+)
+{
+    // Callers have already made sure the process callback is done with them
+    auto &audioTaps = audioTapsOf(slotIndex);
+    auto &owners = m_audioTapOwners[slotIndex];
+    for (std::size_t tap = 0; tap < kMaxTaps; ++tap)
+    {
+        audioTaps[tap].store(nullptr, std::memory_order_relaxed);
+        if (owners[tap])
+        {
+            owners[tap]->close();
+            owners[tap].reset();
+        }
+    }
+}
+
+void
+JackVolumeMixer::peakSample()
+{
+    VMX_TRACE_THREAD_NAME("peak sampler");
+    VMX_TRACE_SCOPE("JackVolumeMixer::peakSample", "peak");
+    detail::ScopedPeakTick tick{};
+
+    Peak peak;
+    while (m_peakRing.tryPop(peak))
+    {
+        m_peakAccumulators[peak.slot] = std::max(m_peakAccumulators[peak.slot], peak.peak);
+    }
+
+    {
+        LOCK_GUARD(m_mutex);
+        for (std::size_t slot = 0; slot < kMaxSessions; ++slot)
+        {
+            if (m_sessions[slot])
+            {
+                m_sessions[slot]->updatePeakSample(m_peakAccumulators[slot]);
+            }
+        }
+    }
+    m_pAudioDevice->updatePeakSample(m_peakAccumulators[kMaxSessions]);
+    m_peakAccumulators.fill(0.0f);
+}
+
+void
+JackVolumeMixer::loudnessSample()
+{
+    VMX_TRACE_THREAD_NAME("loudness sampler");
+    VMX_TRACE_SCOPE("JackVolumeMixer::loudnessSample", "peak");
+
+    // Loudness is already integrated over time, only the newest value counts
+    std::array<std::optional<Loudness>, kMaxSessions + 1> latest;
+    SlotLoudness entry;
+    while (m_loudnessRing.tryPop(entry))
+    {
+        latest[entry.slot] = entry.loudness;
+    }
+
+    {
+        LOCK_GUARD(m_mutex);
+        for (std::size_t slot = 0; slot < kMaxSessions; ++slot)
+        {
+            if (m_sessions[slot] && latest[slot])
+            {
+                m_sessions[slot]->updateLoudnessSample(*latest[slot]);
+            }
+        }
+    }
+    if (latest[kMaxSessions])
+    {
+        m_pAudioDevice->updateLoudnessSample(*latest[kMaxSessions]);
+    }
+}
+
+} // namespace vmx
+
+/* ==== Static Helper Functions ============================================ */
+static float
+toGain
+(
+    float volume
+)
+{
+    return volume * volume * volume;
+}
+
+static std::vector<float>
+clampChannelVolumes
+(
+    std::vector<float> channelVolumes,
+    std::size_t channelCount
+)
+{
+    if (channelVolumes.size() != channelCount)
+    {
+        throw std::runtime_error("Expected " + std::to_string(channelCount) + " channel volumes, got " + std::to_string(channelVolumes.size()));
+    }
+    for (auto &channelVolume : channelVolumes)
+    {
+        channelVolume = std::max(0.0f, std::min(1.0f, channelVolume));
+    }
+    return channelVolumes;
+}
+
+static std::string
+clientOf
+(
+    const std::string &portName
+)
+{
+    return portName.substr(0, portName.find(':'));
+}
+
+static std::vector<std::string>
+takePortNames
+(
+    const char **ppPortNames
+)
+{
+    std::vector<std::string> portNames;
+    if (!ppPortNames) return portNames;
+    for (const char **ppPortName = ppPortNames; *ppPortName; ++ppPortName)
+    {
+        portNames.emplace_back(*ppPortName);
+    }
+    jack_free(ppPortNames);
+    return portNames;
+}
+
+#if VMX_BACKEND_PLUGIN
+/* ==== Plugin Entry Point ================================================= */
+VMX_DEFINE_BACKEND_PLUGIN("jack", vmx::JackVolumeMixer)
+#endif
@@ -0,0 +1,102 @@
+#pragma once
+
+/* ==== Application Includes =============================================== */
+#include <vmx/LoudnessMeter.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <cstddef>
+
+namespace vmx::detail
+{
+
+/* ==== Types ============================================================== */
+// Per channel pair: x1 x2 (input), y1 y2 (shelf output), z1 z2 (high-pass
+// output) and the K-weighted energy of the current block, two lanes each
+enum KWeightingState : std::size_t
+{
+    kX1 = 0, kX2 = 2, kY1 = 4, kY2 = 6, kZ1 = 8, kZ2 = 10, kEnergy = 12,
+    kKWeightingStateDoubles = 14,
+};
+
+/* ==== Functions ========================================================== */
+KWeightingKernel kWeightingKernelBaseline();
+KWeightingKernel kWeightingKernelFma();
+
+// Internal linkage on purpose, for the same reason as in PcmKernels.h
+namespace
+{
+
+/* ==== K-Weighting Filter ================================================= */
+// Both biquads in direct form I, one channel per lane. The recursive terms are
+// added last so only one multiply-subtract per stage sits on the dependency
+// chain from one frame to the next.
+template <class Ops, bool bHasHi>
+void
+kWeightingLoop
+(
+    const double *pShelf,
+    const double *pHighPass,
+    double *pState,
+    const float *pLo,
+    const float *pHi,
+    std::size_t stride,
+    std::size_t frameCount
+)
+{
+    using V = typename Ops::V;
+    const V b0 = Ops::broadcast(pShelf[0]);
+    const V b1 = Ops::broadcast(pShelf[1]);
+    const V b2 = Ops::broadcast(pShelf[2]);
+    const V a1 = Ops::broadcast(pShelf[3]);
+    const V a2 = Ops::broadcast(pShelf[4]);
+    const V ha1 = Ops::broadcast(pHighPass[0]);
+    const V ha2 = Ops::broadcast(pHighPass[1]);
+
+    V x1 = Ops::load(pState + kX1), x2 = Ops::load(pState + kX2);
+    V y1 = Ops::load(pState + kY1), y2 = Ops::load(pState + kY2);
+    V z1 = Ops::load(pState + kZ1), z2 = Ops::load(pState + kZ2);
+    V energy = Ops::load(pState + kEnergy);
+
+    for (std::size_t frame = 0; frame < frameCount; ++frame)
+    {
+        V x = Ops::pair(pLo[frame * stride], bHasHi ? pHi[frame * stride] : 0.0f);
+        V y = Ops::mulSub(a1, y1, Ops::mulSub(a2, y2, Ops::mulAdd(b2, x2, Ops::mulAdd(b1, x1, Ops::mul(b0, x)))));
+        V z = Ops::mulSub(ha1, z1, Ops::mulSub(ha2, z2, Ops::add(Ops::sub(y, Ops::add(y1, y1)), y2)));
+        x2 = x1; x1 = x;
+        y2 = y1; y1 = y;
+        z2 = z1; z1 = z;
+        energy = Ops::mulAdd(z, z, energy);
+    }
+
+    Ops::store(pState + kX1, x1); Ops::store(pState + kX2, x2);
+    Ops::store(pState + kY1, y1); Ops::store(pState + kY2, y2);
+    Ops::store(pState + kZ1, z1); Ops::store(pState + kZ2, z2);
+    Ops::store(pState + kEnergy, energy);
+}
+
+template <class Ops>
+void
+kWeightingKernel
+(
+    const double *pShelf,
+    const double *pHighPass,
+    double *pState,
+    const float *pLo,
+    const float *pHi,
+    std::size_t stride,
+    std::size_t frameCount
+)
+{
+    if (pHi)
+    {
+        kWeightingLoop<Ops, true>(pShelf, pHighPass, pState, pLo, pHi, stride, frameCount);
+    }
+    else
+    {
+        kWeightingLoop<Ops, false>(pShelf, pHighPass, pState, pLo, pHi, stride, frameCount);
+    }
+}
+
+} // namespace
+
+} // namespace vmx::detail
@@ -0,0 +1,371 @@
+/* ==== Application Includes =============================================== */
+#include <vmx/LoudnessMeter.h>
+#include "LoudnessKernels.h"
+#include "PcmKernels.h"
+
+/* ==== Standard Library Includes ========================================== */
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numbers>
+#include <stdexcept>
+#include <string>
+
+/* ==== Operating System Includes ========================================== */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VMX_LOUDNESS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace vmx::detail
+{
+
+namespace
+{
+
+/* ==== Baseline Operations ================================================ */
+// SSE2 is part of every x86-64 target, so this needs no runtime check
+#if VMX_LOUDNESS_SSE2
+struct BaselineOps
+{
+    using V = __m128d;
+
+    static V broadcast(double value) { return _mm_set1_pd(value); };
+    static V pair(float lo, float hi) { return _mm_set_pd(hi, lo); };
+    static V load(const double *p) { return _mm_loadu_pd(p); };
+    static void store(double *p, V v) { _mm_storeu_pd(p, v); };
+    static V add(V a, V b) { return _mm_add_pd(a, b); };
+    static V sub(V a, V b) { return _mm_sub_pd(a, b); };
+    static V mul(V a, V b) { return _mm_mul_pd(a, b); };
+    static V mulAdd(V a, V b, V c) { return _mm_add_pd(_mm_mul_pd(a, b), c); };
+    static V mulSub(V a, V b, V c) { return _mm_sub_pd(c, _mm_mul_pd(a, b)); };
+};
+#else
+struct BaselineOps
+{
+    struct V { double lo; double hi; };
+
+    static V broadcast(double value) { return {value, value}; };
+    static V pair(float lo, float hi) { return {lo, hi}; };
+    static V load(const double *p) { return {p[0], p[1]}; };
+    static void store(double *p, V v) { p[0] = v.lo; p[1] = v.hi; };
+    static V add(V a, V b) { return {a.lo + b.lo, a.hi + b.hi}; };
+    static V sub(V a, V b) { return {a.lo - b.lo, a.hi - b.hi}; };
+    static V mul(V a, V b) { return {a.lo * b.lo, a.hi * b.hi}; };
+    static V mulAdd(V a, V b, V c) { return {a.lo * b.lo + c.lo, a.hi * b.hi + c.hi}; };
+    static V mulSub(V a, V b, V c) { return {c.lo - a.lo * b.lo, c.hi - a.hi * b.hi}; };
+};
+#endif
+
+/* ==== Sample Conversion ================================================== */
+template <SampleFormat format>
+void
+convertSamples
+(
+    const void *pFrames,
+    std::size_t first,
+    std::size_t count,
+    float *pSamples
+)
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        pSamples[i] = loadSamples<ScalarOps, format>(pFrames, first + i);
+    }
+}
+
+} // namespace
+
+KWeightingKernel
+kWeightingKernelBaseline()
+{
+    return &kWeightingKernel<BaselineOps>;
+}
+
+} // namespace vmx::detail
+
+/* ==== Forward Declarations =============================================== */
+static std::vector<double> defaultChannelWeights(std::size_t channelCount);
+static vmx::detail::KWeightingKernel selectKernel();
+static double toLufs(double energy);
+
+namespace vmx
+{
+
+/* ==== LoudnessMeter Class ================================================ */
+LoudnessMeter::LoudnessMeter
+(
+    unsigned int sampleRate,
+    std::size_t channelCount
+)
+  : LoudnessMeter(sampleRate, defaultChannelWeights(channelCount))
+{
+}
+
+LoudnessMeter::LoudnessMeter
+(
+    unsigned int sampleRate,
+    std::vector<double> channelWeights
+)
+  : m_sampleRate(sampleRate),
+    m_channelWeights(std::move(channelWeights)),
+    m_pKernel(selectKernel()),
+    m_framesPerBlock(sampleRate / 10)
+{
+    if (m_channelWeights.empty() || m_channelWeights.size() > PcmMeter::kMaxChannels)
+    {
+        throw std::runtime_error("LoudnessMeter supports 1 to " + std::to_string(PcmMeter::kMaxChannels) + " channels");
+    }
+    if (m_framesPerBlock == 0)
+    {
+        throw std::runtime_error("LoudnessMeter sample rate " + std::to_string(sampleRate) + " is too low");
+    }
+
+    // K-weighting for any sample rate, the BS.1770 48 kHz coefficients are
+    // what these formulas produce at 48000
+    double K = std::tan(std::numbers::pi * 1681.974450955533 / sampleRate);
+    double Q = 0.7071752369554196;
+    double Vh = std::pow(10.0, 3.999843853973347 / 20.0);
+    double Vb = std::pow(Vh, 0.4996667741545416);
+    double a0 = 1.0 + K / Q + K * K;
+    m_shelf = {
+        (Vh + Vb * K / Q + K * K) / a0,
+        2.0 * (K * K - Vh) / a0,
+        (Vh - Vb * K / Q + K * K) / a0,
+        2.0 * (K * K - 1.0) / a0,
+        (1.0 - K / Q + K * K) / a0,
+    };
+
+    K = std::tan(std::numbers::pi * 38.13547087602444 / sampleRate);
+    Q = 0.5003270373238773;
+    a0 = 1.0 + K / Q + K * K;
+    m_highPass = {
+        2.0 * (K * K - 1.0) / a0,
+        (1.0 - K / Q + K * K) / a0,
+    };
+
+    m_filterState.assign((m_channelWeights.size() + 1) / 2 * detail::kKWeightingStateDoubles, 0.0);
+}
+
+std::size_t
+LoudnessMeter::process
+(
+    SampleFormat format,
+    const void *pFrames,
+    std::size_t frameCount
+)
+{
+    const std::size_t channelCount = m_channelWeights.size();
+    std::array<const float*, PcmMeter::kMaxChannels> channels;
+    if (format == SampleFormat::Float32)
+    {
+        for (std::size_t channel = 0; channel < channelCount; ++channel)
+        {
+            channels[channel] = static_cast<const float*>(pFrames) + channel;
+        }
+        return processFrames(channels.data(), channelCount, channelCount, frameCount);
+    }
+
+    // Integer samples go through a small float buffer on the stack, so the
+    // filter kernels only ever read floats
+    using Converter = void (*)(const void*, std::size_t, std::size_t, float*);
+    Converter convert = (format == SampleFormat::Int16) ? &detail::convertSamples<SampleFormat::Int16>
+                      : (format == SampleFormat::Int24) ? &detail::convertSamples<SampleFormat::Int24>
+                      : &detail::convertSamples<SampleFormat::Int32>;
+    std::array<float, 4096> samples;
+    for (std::size_t channel = 0; channel < channelCount; ++channel)
+    {
+        channels[channel] = samples.data() + channel;
+    }
+
+    const std::size_t chunkFrames = samples.size() / channelCount;
+    std::size_t blocks = 0;
+    for (std::size_t frame = 0; frame < frameCount; frame += chunkFrames)
+    {
+        std::size_t count = std::min(chunkFrames, frameCount - frame);
+        convert(pFrames, frame * channelCount, count * channelCount, samples.data());
+        blocks += processFrames(channels.data(), channelCount, channelCount, count);
+    }
+    return blocks;
+}
+
+std::size_t
+LoudnessMeter::processPlanar
+(
+    std::span<const float* const> channels,
+    std::size_t frameCount
+)
+{
+    if (channels.size() > m_channelWeights.size())
+    {
+        throw std::runtime_error("LoudnessMeter was given " + std::to_string(channels.size()) + " channels, expected at most " + std::to_string(m_channelWeights.size()));
+    }
+    return processFrames(channels.data(), channels.size(), 1, frameCount);
+}
+
+Loudness
+LoudnessMeter::loudness() const
+{
+    // The windows start out filled with silence, like a meter that has been
+    // listening to nothing before the stream began
+    Loudness loudness{};
+    double momentary = 0.0;
+    double shortTerm = 0.0;
+    for (std::size_t i = 0; i < kShortTermBlocks; ++i)
+    {
+        double energy = m_blockEnergies[(m_blockCount + kShortTermBlocks - 1 - i) % kShortTermBlocks];
+        if (i < kMomentaryBlocks) momentary += energy;
+        shortTerm += energy;
+    }
+    loudness.momentary = static_cast<float>(toLufs(momentary / kMomentaryBlocks));
+    loudness.shortTerm = static_cast<float>(toLufs(shortTerm / kShortTermBlocks));
+
+    // Absolute gate (-70 LUFS) is applied as blocks enter the histogram, the
+    // relative gate sits 10 LU below the loudness of everything above it
+    std::uint64_t count = 0;
+    double energy = 0.0;
+    for (std::size_t bin = 0; bin < kHistogramBins; ++bin)
+    {
+        count += m_gatingCounts[bin];
+        energy += m_gatingEnergies[bin];
+    }
+    if (count == 0) return loudness;
+
+    double relativeGate = toLufs(energy / static_cast<double>(count)) - 10.0;
+    count = 0;
+    energy = 0.0;
+    for (std::size_t bin = 0; bin < kHistogramBins; ++bin)
+    {
+        if (-70.0 + (static_cast<double>(bin) + 0.5) / 10.0 > relativeGate)
+        {
+            count += m_gatingCounts[bin];
+            energy += m_gatingEnergies[bin];
+        }
+    }
+    if (count > 0)
+    {
+        loudness.integrated = static_cast<float>(toLufs(energy / static_cast<double>(count)));
+    }
+    return loudness;
+}
+
+void
+LoudnessMeter::reset()
+{
+    std::fill(m_filterState.begin(), m_filterState.end(), 0.0);
+    m_framesInBlock = 0;
+    m_blockEnergies.fill(0.0);
+    m_blockCount = 0;
+    m_gatingCounts.fill(0);
+    m_gatingEnergies.fill(0.0);
+}
+
+std::size_t
+LoudnessMeter::processFrames
+(
+    const float *const *ppChannels,
+    std::size_t activeChannelCount,
+    std::size_t stride,
+    std::size_t frameCount
+)
+{
+    std::size_t blocks = 0;
+    std::size_t frame = 0;
+    while (frame < frameCount)
+    {
+        std::size_t count = std::min(frameCount - frame, m_framesPerBlock - m_framesInBlock);
+        for (std::size_t channel = 0; channel < activeChannelCount; channel += 2)
+        {
+            const float *pHi = (channel + 1 < activeChannelCount) ? ppChannels[channel + 1] + frame * stride : nullptr;
+            m_pKernel(m_shelf.data(), m_highPass.data(), &m_filterState[channel / 2 * detail::kKWeightingStateDoubles],
+                      ppChannels[channel] + frame * stride, pHi, stride, count);
+        }
+
+        frame += count;
+        m_framesInBlock += count;
+        if (m_framesInBlock == m_framesPerBlock)
+        {
+            closeBlock();
+            ++blocks;
+        }
+    }
+    return blocks;
+}
+
+void
+LoudnessMeter::closeBlock()
+{
+    double energy = 0.0;
+    for (std::size_t channel = 0; channel < m_channelWeights.size(); ++channel)
+    {
+        double &channelEnergy = m_filterState[channel / 2 * detail::kKWeightingStateDoubles + detail::kEnergy + channel % 2];
+        energy += m_channelWeights[channel] * channelEnergy;
+        channelEnergy = 0.0;
+    }
+    energy /= static_cast<double>(m_framesPerBlock);
+    m_framesInBlock = 0;
+
+    // A decaying IIR reaches denormals after a second or two of silence,
+    // which costs ~100x per operation on most CPUs
+    for (auto &state : m_filterState)
+    {
+        if (std::fabs(state) < 1e-30) state = 0.0;
+    }
+
+    m_blockEnergies[m_blockCount % kShortTermBlocks] = energy;
+    ++m_blockCount;
+    if (m_blockCount < kMomentaryBlocks) return;
+
+    // Gating blocks are 400 ms long and overlap by 75%
+    double gatingEnergy = 0.0;
+    for (std::size_t i = 0; i < kMomentaryBlocks; ++i)
+    {
+        gatingEnergy += m_blockEnergies[(m_blockCount - 1 - i) % kShortTermBlocks];
+    }
+    gatingEnergy /= kMomentaryBlocks;
+
+    double lufs = toLufs(gatingEnergy);
+    if (lufs > -70.0)
+    {
+        auto bin = std::min(static_cast<std::size_t>((lufs + 70.0) * 10.0), kHistogramBins - 1);
+        ++m_gatingCounts[bin];
+        m_gatingEnergies[bin] += gatingEnergy;
+    }
+}
+
+} // namespace vmx
+
+/* ==== Static Functions =================================================== */
+static std::vector<double>
+defaultChannelWeights
+(
+    std::size_t channelCount
+)
+{
+    switch (channelCount)
+    {
+        case 4: return {1.0, 1.0, 1.41, 1.41};                              // FL FR BL BR
+        case 5: return {1.0, 1.0, 1.0, 1.41, 1.41};                         // FL FR FC BL BR
+        case 6: return {1.0, 1.0, 1.0, 0.0, 1.41, 1.41};                    // FL FR FC LFE BL BR
+        case 8: return {1.0, 1.0, 1.0, 0.0, 1.41, 1.41, 1.41, 1.41};        // FL FR FC LFE BL BR SL SR
+        default: return std::vector<double>(channelCount, 1.0);
+    }
+}
+
+static vmx::detail::KWeightingKernel
+selectKernel()
+{
+#if VMX_PCM_X86
+    if (vmx::PcmMeter::isa() >= vmx::PcmMeter::Isa::Avx2) return vmx::detail::kWeightingKernelFma();
+#endif
+    return vmx::detail::kWeightingKernelBaseline();
+}
+
+static double
+toLufs
+(
+    double energy
+)
+{
+    return (energy > 0.0) ? -0.691 + 10.0 * std::log10(energy) : -std::numeric_limits<double>::infinity();
+}
@@ -0,0 +1,39 @@
+/* ==== Application Includes =============================================== */
+#include "LoudnessKernels.h"
+
+/* ==== Operating System Includes ========================================== */
+#include <immintrin.h>
+
+namespace vmx::detail
+{
+
+namespace
+{
+
+/* ==== FMA Operations ===================================================== */
+// Still two lanes: the filters are recursive, so the gain over SSE2 comes from
+// the fused multiply-subtract halving the latency of each stage's feedback
+struct FmaOps
+{
+    using V = __m128d;
+
+    static V broadcast(double value) { return _mm_set1_pd(value); };
+    static V pair(float lo, float hi) { return _mm_set_pd(hi, lo); };
+    static V load(const double *p) { return _mm_loadu_pd(p); };
+    static void store(double *p, V v) { _mm_storeu_pd(p, v); };
+    static V add(V a, V b) { return _mm_add_pd(a, b); };
+    static V sub(V a, V b) { return _mm_sub_pd(a, b); };
+    static V mul(V a, V b) { return _mm_mul_pd(a, b); };
+    static V mulAdd(V a, V b, V c) { return _mm_fmadd_pd(a, b, c); };
+    static V mulSub(V a, V b, V c) { return _mm_fnmadd_pd(a, b, c); };
+};
+
+} // namespace
+
+KWeightingKernel
+kWeightingKernelFma()
+{
+    return &kWeightingKernel<FmaOps>;
+}
+
+} // namespace vmx::detail
@@ -0,0 +1,412 @@
+/* ==== Application Includes =============================================== */
+#include <vmx/MeterSegment.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+/* ==== Operating System Includes ========================================== */
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* ==== Forward Declarations =============================================== */
+static void removeStaleSegment(const std::string &name);
+template <class T> static std::atomic<T> *segmentArray(vmx::MeterSegmentHeader *pHeader, std::uint64_t offset);
+template <class T> static const std::atomic<T> *segmentArray(const vmx::MeterSegmentHeader *pHeader, std::uint64_t offset);
+
+namespace vmx
+{
+
+// Plain loads and stores on shared memory, the layout is the same in every process
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free && sizeof(std::atomic<std::uint64_t>) == 8);
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free && sizeof(std::atomic<std::uint32_t>) == 4);
+static_assert(std::atomic<std::uint8_t>::is_always_lock_free && sizeof(std::atomic<std::uint8_t>) == 1);
+static_assert(std::atomic<char>::is_always_lock_free && sizeof(std::atomic<char>) == 1);
+static_assert(std::atomic<float>::is_always_lock_free && sizeof(std::atomic<float>) == 4);
+
+/* ==== Functions ========================================================== */
+std::string
+defaultMeterSegmentName()
+{
+    return "/vmx-meters-" + std::to_string(::getuid());
+}
+
+/* ==== MeterSegmentWriter Class =========================================== */
+MeterSegmentWriter::MeterSegmentWriter
+(
+    const std::string &name,
+    std::uint32_t capacity
+)
+  : m_name(name)
+{
+    auto align = [](std::uint64_t offset){ return (offset + 63) & ~std::uint64_t(63); };
+    std::uint64_t handlesOffset = align(sizeof(MeterSegmentHeader));
+    std::uint64_t parentsOffset = align(handlesOffset + 4ull * capacity);
+    std::uint64_t flagsOffset = align(parentsOffset + 4ull * capacity);
+    std::uint64_t idsOffset = align(flagsOffset + capacity);
+    std::uint64_t peaksOffset = align(idsOffset + std::uint64_t(kIdLength) * capacity);
+    std::uint64_t size = align(peaksOffset + 4ull * capacity);
+
+    // A segment already under the name is only unlinked once its writer is
+    // known to be gone; readers still mapping a stale one keep their copy
+    int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+    for (int attempt = 0; fd < 0 && errno == EEXIST && attempt < 3; ++attempt)
+    {
+        removeStaleSegment(name);
+        fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+    }
+    if (fd < 0)
+    {
+        throw std::runtime_error("Unable to create meter segment " + name + ": " + std::strerror(errno));
+    }
+    void *pMapping = MAP_FAILED;
+    if (::ftruncate(fd, static_cast<off_t>(size)) == 0)
+    {
+        pMapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    int error = errno;
+    ::close(fd);
+    if (pMapping == MAP_FAILED)
+    {
+        ::shm_unlink(name.c_str());
+        throw std::runtime_error("Unable to map meter segment " + name + ": " + std::strerror(error));
+    }
+
+    // A new shared memory object is zero filled, which is an empty segment at seq 0
+    m_pHeader = static_cast<MeterSegmentHeader*>(pMapping);
+    m_pHeader->version = kMeterSegmentVersion;
+    m_pHeader->idLength = kIdLength;
+    m_pHeader->capacity = capacity;
+    m_pHeader->headerSize = sizeof(MeterSegmentHeader);
+    m_pHeader->handlesOffset = handlesOffset;
+    m_pHeader->parentsOffset = parentsOffset;
+    m_pHeader->flagsOffset = flagsOffset;
+    m_pHeader->idsOffset = idsOffset;
+    m_pHeader->peaksOffset = peaksOffset;
+    m_pHeader->size = size;
+    m_pHeader->producerPid = static_cast<std::uint32_t>(::getpid());
+    std::atomic_ref<std::uint32_t>(m_pHeader->magic).store(kMeterSegmentMagic, std::memory_order_release);
+}
+
+MeterSegmentWriter::~MeterSegmentWriter()
+{
+    ::munmap(m_pHeader, m_pHeader->size);
+    ::shm_unlink(m_name.c_str());
+}
+
+bool
+MeterSegmentWriter::add
+(
+    std::uint32_t handle,
+    std::uint32_t parent,
+    bool bSession,
+    const std::string &id
+)
+{
+    if (m_slotIndices.contains(handle)) return true;
+
+    std::uint32_t index;
+    if (!m_freeSlots.empty())
+    {
+        index = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else if (m_slots.size() < m_pHeader->capacity)
+    {
+        index = static_cast<std::uint32_t>(m_slots.size());
+        m_slots.emplace_back();
+    }
+    else
+    {
+        return false;
+    }
+
+    m_slots[index] = {handle, parent, bSession ? kMeterSlotSession : std::uint8_t(0), id.substr(0, kIdLength), 0.0f, true};
+    m_slotIndices[handle] = index;
+    m_bLayoutChanged = true;
+    return true;
+}
+
+void
+MeterSegmentWriter::remove
+(
+    std::uint32_t handle
+)
+{
+    auto slotIndex = m_slotIndices.find(handle);
+    if (slotIndex == m_slotIndices.end()) return;
+
+    m_slots[slotIndex->second] = Slot();
+    m_freeSlots.push_back(slotIndex->second);
+    m_slotIndices.erase(slotIndex);
+    m_bLayoutChanged = true;
+}
+
+void
+MeterSegmentWriter::setPeak
+(
+    std::uint32_t handle,
+    float peak
+)
+{
+    auto slotIndex = m_slotIndices.find(handle);
+    if (slotIndex != m_slotIndices.end())
+    {
+        m_slots[slotIndex->second].peak = peak;
+    }
+}
+
+void
+MeterSegmentWriter::publish()
+{
+    auto *pPeaks = segmentArray<float>(m_pHeader, m_pHeader->peaksOffset);
+    // Every store below is a release, so a reader that sees any of them also
+    // sees the odd seq, and its recheck fails. On x86 these are plain stores;
+    // standalone fences would do the same but ThreadSanitizer cannot model them.
+    std::uint64_t seq = m_pHeader->seq.load(std::memory_order_relaxed);
+    m_pHeader->seq.store(seq + 1, std::memory_order_relaxed);
+
+    if (m_bLayoutChanged)
+    {
+        auto *pHandles = segmentArray<std::uint32_t>(m_pHeader, m_pHeader->handlesOffset);
+        auto *pParents = segmentArray<std::uint32_t>(m_pHeader, m_pHeader->parentsOffset);
+        auto *pFlags = segmentArray<std::uint8_t>(m_pHeader, m_pHeader->flagsOffset);
+        auto *pIds = segmentArray<char>(m_pHeader, m_pHeader->idsOffset);
+        for (std::size_t index = 0; index < m_slots.size(); ++index)
+        {
+            Slot &slot = m_slots[index];
+            if (!slot.bDirty) continue;
+            pHandles[index].store(slot.handle, std::memory_order_release);
+            pParents[index].store(slot.parent, std::memory_order_release);
+            pFlags[index].store(slot.flags, std::memory_order_release);
+            for (std::size_t i = 0; i < kIdLength; ++i)
+            {
+                pIds[index * kIdLength + i].store(i < slot.id.size() ? slot.id[i] : '\0', std::memory_order_release);
+            }
+            slot.bDirty = false;
+        }
+        m_pHeader->slotCount.store(static_cast<std::uint32_t>(m_slots.size()), std::memory_order_release);
+        m_pHeader->generation.fetch_add(1, std::memory_order_release);
+        m_bLayoutChanged = false;
+    }
+    for (std::size_t index = 0; index < m_slots.size(); ++index)
+    {
+        pPeaks[index].store(m_slots[index].peak, std::memory_order_release);
+    }
+    m_pHeader->tick.fetch_add(1, std::memory_order_release);
+
+    m_pHeader->seq.store(seq + 2, std::memory_order_release);
+}
+
+/* ==== MeterSegmentReader Class =========================================== */
+MeterSegmentReader::MeterSegmentReader
+(
+    const std::string &name
+)
+{
+    int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Unable to open meter segment " + name + ": " + std::strerror(errno));
+    }
+    struct stat status = {};
+    void *pMapping = MAP_FAILED;
+    if (::fstat(fd, &status) == 0 && static_cast<std::size_t>(status.st_size) >= sizeof(MeterSegmentHeader))
+    {
+        m_size = static_cast<std::size_t>(status.st_size);
+        pMapping = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (pMapping == MAP_FAILED)
+    {
+        throw std::runtime_error("Unable to map meter segment " + name);
+    }
+
+    m_pHeader = static_cast<const MeterSegmentHeader*>(pMapping);
+    std::atomic_ref<std::uint32_t> magic(const_cast<MeterSegmentHeader*>(m_pHeader)->magic);
+    bool bValid = magic.load(std::memory_order_acquire) == kMeterSegmentMagic &&
+        m_pHeader->version == kMeterSegmentVersion && m_pHeader->size <= m_size &&
+        m_pHeader->handlesOffset + 4ull * m_pHeader->capacity <= m_size &&
+        m_pHeader->parentsOffset + 4ull * m_pHeader->capacity <= m_size &&
+        m_pHeader->flagsOffset + m_pHeader->capacity <= m_size &&
+        m_pHeader->idsOffset + std::uint64_t(m_pHeader->idLength) * m_pHeader->capacity <= m_size &&
+        m_pHeader->peaksOffset + 4ull * m_pHeader->capacity <= m_size;
+    if (!bValid)
+    {
+        ::munmap(const_cast<MeterSegmentHeader*>(m_pHeader), m_size);
+        throw std::runtime_error("Meter segment " + name + " is not a version " + std::to_string(kMeterSegmentVersion) + " vmx meter segment");
+    }
+}
+
+MeterSegmentReader::~MeterSegmentReader()
+{
+    ::munmap(const_cast<MeterSegmentHeader*>(m_pHeader), m_size);
+}
+
+const std::vector<MeterSegmentReader::Meter> &
+MeterSegmentReader::read()
+{
+    const auto *pHandles = segmentArray<std::uint32_t>(m_pHeader, m_pHeader->handlesOffset);
+    const auto *pParents = segmentArray<std::uint32_t>(m_pHeader, m_pHeader->parentsOffset);
+    const auto *pFlags = segmentArray<std::uint8_t>(m_pHeader, m_pHeader->flagsOffset);
+    const auto *pIds = segmentArray<char>(m_pHeader, m_pHeader->idsOffset);
+    const auto *pPeaks = segmentArray<float>(m_pHeader, m_pHeader->peaksOffset);
+    std::size_t idLength = m_pHeader->idLength;
+
+    for (unsigned int attempt = 0;; ++attempt)
+    {
+        if (attempt >= 64) std::this_thread::yield(); // the producer is descheduled mid-publish
+
+        std::uint64_t seq = m_pHeader->seq.load(std::memory_order_acquire);
+        if (seq % 2 != 0) continue;
+
+        // Acquire loads pair with the producer's release stores: having read
+        // anything from a publish() in progress, the recheck sees its odd seq
+        std::uint64_t tick = m_pHeader->tick.load(std::memory_order_acquire);
+        std::uint64_t generation = m_pHeader->generation.load(std::memory_order_acquire);
+        bool bLayoutChanged = (generation != m_generation);
+        if (bLayoutChanged)
+        {
+            std::size_t slotCount = std::min<std::size_t>(m_pHeader->slotCount.load(std::memory_order_acquire), m_pHeader->capacity);
+            m_scratch.clear();
+            m_slots.clear();
+            for (std::size_t slot = 0; slot < slotCount; ++slot)
+            {
+                Meter meter;
+                meter.handle = pHandles[slot].load(std::memory_order_acquire);
+                if (meter.handle == 0) continue;
+                meter.parent = pParents[slot].load(std::memory_order_acquire);
+                meter.bSession = (pFlags[slot].load(std::memory_order_acquire) & kMeterSlotSession) != 0;
+                for (std::size_t i = 0; i < idLength; ++i)
+                {
+                    char c = pIds[slot * idLength + i].load(std::memory_order_acquire);
+                    if (c == '\0') break;
+                    meter.id.push_back(c);
+                }
+                meter.peak = pPeaks[slot].load(std::memory_order_acquire);
+                m_scratch.push_back(std::move(meter));
+                m_slots.push_back(static_cast<std::uint32_t>(slot));
+            }
+        }
+        else
+        {
+            m_peaks.resize(m_slots.size());
+            for (std::size_t i = 0; i < m_slots.size(); ++i)
+            {
+                m_peaks[i] = pPeaks[m_slots[i]].load(std::memory_order_acquire);
+            }
+        }
+
+        if (m_pHeader->seq.load(std::memory_order_acquire) != seq)
+        {
+            if (bLayoutChanged) m_generation = ~std::uint64_t(0); // m_slots is torn
+            continue;
+        }
+
+        if (bLayoutChanged)
+        {
+            m_meters.swap(m_scratch);
+            m_generation = generation;
+        }
+        else
+        {
+            for (std::size_t i = 0; i < m_meters.size(); ++i) m_meters[i].peak = m_peaks[i];
+        }
+        m_tick = tick;
+        return m_meters;
+    }
+}
+
+} // namespace vmx
+
+/* ==== Static Helper Functions ============================================ */
+// Unlinks the segment under name when the process that wrote it is gone, and
+// throws when it is still running. A segment without its magic yet is either
+// being set up or was left half done; it is only taken as stale after a second.
+static void
+removeStaleSegment
+(
+    const std::string &name
+)
+{
+    for (int check = 0;; ++check)
+    {
+        int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0)
+        {
+            if (errno == ENOENT) return;
+            throw std::runtime_error("Unable to open meter segment " + name + ": " + std::strerror(errno));
+        }
+
+        struct stat status = {};
+        bool bComplete = false;
+        std::uint16_t version = 0;
+        pid_t producerPid = 0;
+        if (::fstat(fd, &status) == 0 && static_cast<std::size_t>(status.st_size) >= sizeof(vmx::MeterSegmentHeader))
+        {
+            void *pMapping = ::mmap(nullptr, sizeof(vmx::MeterSegmentHeader), PROT_READ, MAP_SHARED, fd, 0);
+            if (pMapping != MAP_FAILED)
+            {
+                auto *pHeader = static_cast<vmx::MeterSegmentHeader*>(pMapping);
+                bComplete = std::atomic_ref<std::uint32_t>(pHeader->magic).load(std::memory_order_acquire) == vmx::kMeterSegmentMagic;
+                version = pHeader->version;
+                producerPid = static_cast<pid_t>(pHeader->producerPid);
+                ::munmap(pMapping, sizeof(vmx::MeterSegmentHeader));
+            }
+        }
+        ::close(fd);
+
+        if (!bComplete && check < 100)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+        if (bComplete && version != vmx::kMeterSegmentVersion)
+        {
+            throw std::runtime_error("Meter segment " + name + " belongs to a version " + std::to_string(version) +
+                                     " writer; remove it if that is no longer running");
+        }
+        if (bComplete && (::kill(producerPid, 0) == 0 || errno != ESRCH))
+        {
+            throw std::runtime_error("Meter segment " + name + " is in use by process " + std::to_string(producerPid));
+        }
+
+        // Only while the name still refers to the segment checked above
+        struct stat current = {};
+        fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+        bool bSame = fd >= 0 && ::fstat(fd, &current) == 0 && current.st_dev == status.st_dev && current.st_ino == status.st_ino;
+        if (fd >= 0) ::close(fd);
+        if (bSame) ::shm_unlink(name.c_str());
+        return;
+    }
+}
+
+template <class T>
+static std::atomic<T> *
+segmentArray
+(
+    vmx::MeterSegmentHeader *pHeader,
+    std::uint64_t offset
+)
+{
+    return reinterpret_cast<std::atomic<T>*>(reinterpret_cast<char*>(pHeader) + offset);
+}
+
+template <class T>
+static const std::atomic<T> *
+segmentArray
+(
+    const vmx::MeterSegmentHeader *pHeader,
+    std::uint64_t offset
+)
+{
+    return reinterpret_cast<const std::atomic<T>*>(reinterpret_cast<const char*>(pHeader) + offset);
+}
@@ -0,0 +1,277 @@
+/* ==== Application Includes =============================================== */
+#include <vmx/Metrics.h>
+#include "Instrumentation.h"
+
+/* ==== Standard Library Includes ========================================== */
+#include <charconv>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+/* ==== Forward Declarations =============================================== */
+static void appendHeader(std::string &out, const char *name, const char *type, const char *help);
+static void appendSample(std::string &out, const std::string &series, std::uint64_t value);
+static void appendSample(std::string &out, const std::string &series, std::int64_t value);
+static void appendSample(std::string &out, const std::string &series, double value);
+static std::string formatDouble(double value);
+static void appendSummary(std::string &out, const std::string &name, const std::string &labels, const vmx::LatencyHistogram::Snapshot &snapshot);
+
+namespace vmx
+{
+
+/* ==== Free Functions ===================================================== */
+const char *
+toString
+(
+    ThreadRole role
+)
+{
+    switch (role)
+    {
+        case ThreadRole::ObserverDispatch:  return "observer_dispatch";
+        case ThreadRole::Timer:             return "timer";
+        case ThreadRole::Service:           return "service";
+        case ThreadRole::WorkQueue:         return "work_queue";
+        case ThreadRole::ControlServer:     return "control_server";
+        case ThreadRole::CApiDelivery:      return "c_api_delivery";
+        case ThreadRole::TraceWriter:       return "trace_writer";
+        default:                            return "unknown";
+    }
+}
+
+/* ==== ThreadInventory Struct ============================================= */
+std::int64_t
+ThreadInventory::total() const
+{
+    std::int64_t total = 0;
+    for (std::int64_t count : threads)
+    {
+        total += count;
+    }
+    return total;
+}
+
+/* ==== ScopedThreadRole Class ============================================= */
+ScopedThreadRole::ScopedThreadRole
+(
+    ThreadRole role
+)
+  : m_role(role)
+{
+    detail::metrics().threads(m_role).add();
+}
+
+ScopedThreadRole::~ScopedThreadRole()
+{
+    detail::metrics().threads(m_role).sub();
+}
+
+/* ==== Metrics Class ====================================================== */
+std::string
+Metrics::toPrometheus() const
+{
+    std::string out;
+
+    appendHeader(out, "vmx_events_produced_total", "counter", "State changes reported by backends, by event kind.");
+    for (std::size_t i = 0; i < kEventKindCount; i++)
+    {
+        appendSample(out, std::string("vmx_events_produced_total{kind=\"") + toString(static_cast<EventKind>(i)) + "\"}", m_eventsProduced[i].value());
+    }
+
+    appendHeader(out, "vmx_events_delivered_total", "counter", "Observer callbacks that ran to completion.");
+    appendSample(out, "vmx_events_delivered_total", eventsDelivered.value());
+
+    appendHeader(out, "vmx_events_coalesced_total", "counter", "Updates dropped because they matched the current value.");
+    appendSample(out, "vmx_events_coalesced_total", eventsCoalesced.value());
+
+    appendHeader(out, "vmx_events_dropped_total", "counter", "Observer deliveries abandoned because a dispatch could not be started.");
+    appendSample(out, "vmx_events_dropped_total", eventsDropped.value());
+
+    appendHeader(out, "vmx_dispatch_queue_depth", "gauge", "Observer callbacks dispatched but not yet finished.");
+    appendSample(out, "vmx_dispatch_queue_depth", dispatchQueueDepth.value());
+
+    appendHeader(out, "vmx_observers", "gauge", "Observer registrations currently held.");
+    appendSample(out, "vmx_observers", liveObservers.value());
+
+    appendHeader(out, "vmx_observers_pruned_total", "counter", "Expired weak observers removed from observer lists.");
+    appendSample(out, "vmx_observers_pruned_total", observersPruned.value());
+
+    appendHeader(out, "vmx_peak_ticks_total", "counter", "Peak sampling ticks executed.");
+    appendSample(out, "vmx_peak_ticks_total", peakTicks.value());
+
+    appendHeader(out, "vmx_peak_tick_duration_seconds", "summary", "Duration of a peak sampling tick.");
+    appendSummary(out, "vmx_peak_tick_duration_seconds", "", peakTickDuration.snapshot());
+
+    appendHeader(out, "vmx_timer_deadlines_missed_total", "counter", "Periodic task ticks skipped because they ran a period or more late.");
+    appendSample(out, "vmx_timer_deadlines_missed_total", timerDeadlinesMissed.value());
+
+    appendHeader(out, "vmx_threads", "gauge", "Threads vmx has started and not yet finished, by role.");
+    for (std::size_t i = 0; i < kThreadRoleCount; i++)
+    {
+        appendSample(out, std::string("vmx_threads{role=\"") + toString(static_cast<ThreadRole>(i)) + "\"}", m_threads[i].value());
+    }
+
+    appendHeader(out, "vmx_backend_calls_total", "counter", "Calls into the platform audio API.");
+    appendSample(out, "vmx_backend_calls_total", backendCalls.value());
+
+    appendHeader(out, "vmx_backend_errors_total", "counter", "Failed calls into the platform audio API.");
+    appendSample(out, "vmx_backend_errors_total", backendErrors.value());
+
+    appendHeader(out, "vmx_event_latency_seconds", "summary", "Backend report to observer callback completion, by event kind.");
+    for (const auto &event : detail::snapshotStats().events)
+    {
+        appendSummary(out, "vmx_event_latency_seconds", std::string("kind=\"") + toString(event.kind) + "\"", event.endToEnd);
+    }
+
+    return out;
+}
+
+void
+Metrics::writePrometheus
+(
+    const std::string &path
+) const
+{
+    // Write then rename so a scraper never reads a half written file
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        file << toPrometheus();
+        if (!file)
+        {
+            throw std::runtime_error("Unable to write metrics to " + tmpPath);
+        }
+    }
+
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0)
+    {
+        std::remove(tmpPath.c_str());
+        throw std::runtime_error("Unable to move metrics into place at " + path);
+    }
+}
+
+ThreadInventory
+Metrics::threadInventory() const
+{
+    ThreadInventory inventory;
+    for (std::size_t i = 0; i < kThreadRoleCount; i++)
+    {
+        inventory.threads[i] = m_threads[i].value();
+    }
+    return inventory;
+}
+
+void
+Metrics::reset()
+{
+    for (auto &counter : m_eventsProduced)
+    {
+        counter.reset();
+    }
+    eventsDelivered.reset();
+    eventsCoalesced.reset();
+    eventsDropped.reset();
+    observersPruned.reset();
+    peakTicks.reset();
+    peakTickDuration.reset();
+    timerDeadlinesMissed.reset();
+    backendCalls.reset();
+    backendErrors.reset();
+}
+
+} // namespace vmx
+
+namespace vmx::detail
+{
+
+/* ==== Process-wide Registry ============================================== */
+Metrics &
+metrics()
+{
+    static Metrics s_metrics;
+    return s_metrics;
+}
+
+} // namespace vmx::detail
+
+/* ==== Static Helper Functions ============================================ */
+static void
+appendHeader
+(
+    std::string &out,
+    const char *name,
+    const char *type,
+    const char *help
+)
+{
+    out += std::string("# HELP ") + name + " " + help + "\n";
+    out += std::string("# TYPE ") + name + " " + type + "\n";
+}
+
+static void
+appendSample
+(
+    std::string &out,
+    const std::string &series,
+    std::uint64_t value
+)
+{
+    out += series + " " + std::to_string(value) + "\n";
+}
+
+static void
+appendSample
+(
+    std::string &out,
+    const std::string &series,
+    std::int64_t value
+)
+{
+    out += series + " " + std::to_string(value) + "\n";
+}
+
+static void
+appendSample
+(
+    std::string &out,
+    const std::string &series,
+    double value
+)
+{
+    out += series + " " + formatDouble(value) + "\n";
+}
+
+// std::to_chars never consults the C locale, so a comma-decimal LC_NUMERIC
+// cannot leak into the exposition format
+static std::string
+formatDouble
+(
+    double value
+)
+{
+    char buffer[32];
+    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general, 9);
+    return std::string(buffer, ec == std::errc() ? end : buffer);
+}
+
+static void
+appendSummary
+(
+    std::string &out,
+    const std::string &name,
+    const std::string &labels,
+    const vmx::LatencyHistogram::Snapshot &snapshot
+)
+{
+    const std::string prefix = labels.empty() ? "" : labels + ",";
+    for (double quantile : {0.5, 0.9, 0.99, 0.999})
+    {
+        double seconds = static_cast<double>(snapshot.percentile(quantile * 100.0)) / 1e9;
+        appendSample(out, name + "{" + prefix + "quantile=\"" + formatDouble(quantile) + "\"}", seconds);
+    }
+    const std::string braces = labels.empty() ? "" : "{" + labels + "}";
+    double sumSeconds = static_cast<double>(snapshot.sum()) / 1e9;
+    appendSample(out, name + "_sum" + braces, sumSeconds);
+    appendSample(out, name + "_count" + braces, snapshot.count());
+}
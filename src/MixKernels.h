@@ -0,0 +1,126 @@
+#pragma once
+
+/* ==== Application Includes =============================================== */
+#include <vmx/GainRamp.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <cstddef>
+
+namespace vmx::detail
+{
+
+/* ==== Functions ========================================================== */
+GainKernel gainKernelBaseline();
+GainKernel gainKernelAvx2();
+
+// Internal linkage on purpose, for the same reason as in PcmKernels.h
+namespace
+{
+
+/* ==== Gain Loop ========================================================== */
+// Frame f (from 0) is scaled by gain + step * (f + 1), so a ramp ends exactly
+// on its target and a step of zero is a constant gain. While ramping, samples
+// go in blocks of kWidth frames: that is channelCount whole vectors, and lane
+// l of vector v in a block belongs to frame (v * kWidth + l) / channelCount of
+// it, whatever the channel count. Those frame offsets are worked out once per
+// call on the stack.
+template <class Ops, bool bOut, bool bBus>
+void
+gainLoop
+(
+    const float *pIn,
+    float *pOut,
+    float *pBus,
+    std::size_t channelCount,
+    std::size_t frameCount,
+    float gain,
+    float step
+)
+{
+    using V = typename Ops::V;
+    const std::size_t sampleCount = frameCount * channelCount;
+    std::size_t i = 0;
+
+    auto emit = [&](std::size_t index, V scaled)
+    {
+        if constexpr (bOut) Ops::store(pOut + index, scaled);
+        if constexpr (bBus) Ops::store(pBus + index, Ops::add(Ops::load(pBus + index), scaled));
+    };
+    auto emitScalar = [&](std::size_t index, float scaled)
+    {
+        if constexpr (bOut) pOut[index] = scaled;
+        if constexpr (bBus) pBus[index] += scaled;
+    };
+
+    if (step != 0.0f)
+    {
+        const std::size_t blockSamples = channelCount * Ops::kWidth;
+        float offsets[GainRamp::kMaxChannels * Ops::kWidth];
+        for (std::size_t sample = 0, frame = 1, channel = 0; sample < blockSamples; ++sample)
+        {
+            offsets[sample] = static_cast<float>(frame);
+            if (++channel == channelCount)
+            {
+                channel = 0;
+                ++frame;
+            }
+        }
+
+        const V steps = Ops::broadcast(step);
+        for (std::size_t frame = 0; i + blockSamples <= sampleCount; i += blockSamples, frame += Ops::kWidth)
+        {
+            const V base = Ops::broadcast(gain + step * static_cast<float>(frame));
+            for (std::size_t v = 0; v < channelCount; ++v)
+            {
+                std::size_t index = i + v * Ops::kWidth;
+                emit(index, Ops::mul(Ops::load(pIn + index), Ops::mulAdd(Ops::load(offsets + v * Ops::kWidth), steps, base)));
+            }
+        }
+        for (; i < sampleCount; ++i)
+        {
+            emitScalar(i, pIn[i] * (gain + step * static_cast<float>(i / channelCount + 1)));
+        }
+        return;
+    }
+
+    const V gains = Ops::broadcast(gain);
+    for (; i + Ops::kWidth <= sampleCount; i += Ops::kWidth)
+    {
+        emit(i, Ops::mul(Ops::load(pIn + i), gains));
+    }
+    for (; i < sampleCount; ++i)
+    {
+        emitScalar(i, pIn[i] * gain);
+    }
+}
+
+template <class Ops>
+void
+gainKernel
+(
+    const float *pIn,
+    float *pOut,
+    float *pBus,
+    std::size_t channelCount,
+    std::size_t frameCount,
+    float gain,
+    float step
+)
+{
+    if (pOut && pBus)
+    {
+        gainLoop<Ops, true, true>(pIn, pOut, pBus, channelCount, frameCount, gain, step);
+    }
+    else if (pOut)
+    {
+        gainLoop<Ops, true, false>(pIn, pOut, pBus, channelCount, frameCount, gain, step);
+    }
+    else if (pBus && (gain != 0.0f || step != 0.0f)) // a silent stream adds nothing
+    {
+        gainLoop<Ops, false, true>(pIn, pOut, pBus, channelCount, frameCount, gain, step);
+    }
+}
+
+} // namespace
+
+} // namespace vmx::detail
@@ -0,0 +1,401 @@
+/* ==== Application Includes =============================================== */
+#include "ObjectTable.h"
+
+namespace vmx::detail
+{
+
+/* ==== Observers ========================================================== */
+namespace
+{
+
+// Session and device observers only differ in the callbacks they have
+#define VMX_OBJECT_TABLE_CHANGE(kind, apply) \
+    if (auto pTable = m_pTable.lock()) pTable->change(m_handle, (kind), [&](ObjectTable::Object &object){ apply; })
+
+class TableSessionObserver : public AudioSession::Observer
+{
+public: /* Methods */
+    TableSessionObserver(std::weak_ptr<ObjectTable> pTable, std::uint32_t handle) : m_pTable(std::move(pTable)), m_handle(handle) {};
+
+public: /* Virtual Methods */
+    virtual void onNameChange(std::string name) override { VMX_OBJECT_TABLE_CHANGE(EventKind::Name, object.name = std::move(name)); };
+    virtual void onIconPathChange(std::string iconPath) override { VMX_OBJECT_TABLE_CHANGE(EventKind::IconPath, object.iconPath = std::move(iconPath)); };
+    virtual void onStateChange(AudioSession::State state) override { VMX_OBJECT_TABLE_CHANGE(EventKind::State, object.state = static_cast<std::uint8_t>(state)); };
+    virtual void onVolumeChange(float volume) override { VMX_OBJECT_TABLE_CHANGE(EventKind::Volume, object.volume = volume); };
+    virtual void onChannelVolumesChange(std::vector<float> channelVolumes) override { VMX_OBJECT_TABLE_CHANGE(EventKind::ChannelVolumes, object.channelVolumes = std::move(channelVolumes)); };
+    virtual void onMuteChange(bool bMuted) override { VMX_OBJECT_TABLE_CHANGE(EventKind::Mute, object.bMuted = bMuted); };
+    virtual void onPeakSample(float peak) override { VMX_OBJECT_TABLE_CHANGE(EventKind::PeakSample, object.peak = peak); };
+    virtual void onLoudnessSample(Loudness loudness) override { VMX_OBJECT_TABLE_CHANGE(EventKind::LoudnessSample, object.loudness = loudness); };
+
+private: /* Members */
+    std::weak_ptr<ObjectTable> m_pTable;
+    std::uint32_t m_handle;
+};
+
+class TableDeviceObserver : public AudioDevice::Observer
+{
+public: /* Methods */
+    TableDeviceObserver(std::weak_ptr<ObjectTable> pTable, std::uint32_t handle) : m_pTable(std::move(pTable)), m_handle(handle) {};
+
+public: /* Virtual Methods */
+    virtual void onNameChange(std::string name) override { VMX_OBJECT_TABLE_CHANGE(EventKind::Name, object.name = std::move(name)); };
+    virtual void onIconPathChange(std::string iconPath) override { VMX_OBJECT_TABLE_CHANGE(EventKind::IconPath, object.iconPath = std::move(iconPath)); };
+    virtual void onStateChange(AudioDevice::State state) override { VMX_OBJECT_TABLE_CHANGE(EventKind::State, object.state = static_cast<std::uint8_t>(state)); };
+    virtual void onDefaultChange(bool bIsDefaultDevice) override { VMX_OBJECT_TABLE_CHANGE(EventKind::Default, object.bDefault = bIsDefaultDevice); };
+    virtual void onVolumeChange(float volume) override { VMX_OBJECT_TABLE_CHANGE(EventKind::Volume, object.volume = volume); };
+    virtual void onChannelVolumesChange(std::vector<float> channelVolumes) override { VMX_OBJECT_TABLE_CHANGE(EventKind::ChannelVolumes, object.channelVolumes = std::move(channelVolumes)); };
+    virtual void onMuteChange(bool bMuted) override { VMX_OBJECT_TABLE_CHANGE(EventKind::Mute, object.bMuted = bMuted); };
+    virtual void onPeakSample(float peak) override { VMX_OBJECT_TABLE_CHANGE(EventKind::PeakSample, object.peak = peak); };
+    virtual void onLoudnessSample(Loudness loudness) override { VMX_OBJECT_TABLE_CHANGE(EventKind::LoudnessSample, object.loudness = loudness); };
+    virtual void onAudioSessionAdded(const std::string &audioSessionId, std::weak_ptr<AudioSession> pWeakAudioSession) override
+    {
+        if (auto pTable = m_pTable.lock()) pTable->addSession(m_handle, audioSessionId, std::move(pWeakAudioSession));
+    };
+    virtual void onAudioSessionRemoved(const std::string &audioSessionId) override
+    {
+        if (auto pTable = m_pTable.lock()) pTable->removeSession(m_handle, audioSessionId);
+    };
+
+private: /* Members */
+    std::weak_ptr<ObjectTable> m_pTable;
+    std::uint32_t m_handle;
+};
+
+#undef VMX_OBJECT_TABLE_CHANGE
+
+class TableMixerObserver : public VolumeMixer::Observer
+{
+public: /* Methods */
+    explicit TableMixerObserver(std::weak_ptr<ObjectTable> pTable) : m_pTable(std::move(pTable)) {};
+
+public: /* Virtual Methods */
+    virtual void onAudioDeviceAdded(const std::string &audioDeviceId, std::weak_ptr<AudioDevice> pWeakAudioDevice) override
+    {
+        if (auto pTable = m_pTable.lock()) pTable->addDevice(audioDeviceId, std::move(pWeakAudioDevice));
+    };
+    virtual void onAudioDeviceRemoved(const std::string &audioDeviceId) override
+    {
+        if (auto pTable = m_pTable.lock()) pTable->removeDevice(audioDeviceId);
+    };
+
+private: /* Members */
+    std::weak_ptr<ObjectTable> m_pTable;
+};
+
+} // namespace
+
+/* ==== ObjectTable Class ================================================== */
+void
+ObjectTable::attach
+(
+    VolumeMixer &volumeMixer
+)
+{
+    m_pMixerObserver = std::make_shared<TableMixerObserver>(weak_from_this());
+    volumeMixer.addObserver(m_pMixerObserver, true, DispatchMode::Synchronous);
+}
+
+void
+ObjectTable::detach
+(
+    VolumeMixer &volumeMixer
+)
+{
+    volumeMixer.removeObserver(m_pMixerObserver);
+
+    std::unique_lock lock(m_mutex);
+    m_bDetached = true;
+    m_wakesDone.wait(lock, [this]{ return m_wakesRunning == 0; });
+    m_wake = nullptr;
+    m_objects.clear();
+    m_devices.clear();
+    m_sessions.clear();
+    m_observers.clear();
+    m_pending.clear();
+    m_meterEvents.clear();
+}
+
+std::vector<ObjectTable::Pending>
+ObjectTable::takePending()
+{
+    std::vector<Pending> pending;
+    takePending(pending);
+    return pending;
+}
+
+void
+ObjectTable::takePending
+(
+    std::vector<Pending> &pending
+)
+{
+    pending.clear();
+    std::lock_guard guard(m_mutex);
+    pending.swap(m_pending);
+    m_meterEvents.clear();
+}
+
+std::uint64_t
+ObjectTable::snapshot
+(
+    std::vector<Object> &objects
+) const
+{
+    std::lock_guard guard(m_mutex);
+    objects.clear();
+    objects.reserve(m_objects.size());
+    for (const auto &[handle, object] : m_objects)
+    {
+        objects.push_back(object);
+    }
+    return m_seq;
+}
+
+bool
+ObjectTable::find
+(
+    std::uint32_t handle,
+    Object &object
+) const
+{
+    std::lock_guard guard(m_mutex);
+    auto found = m_objects.find(handle);
+    if (found == m_objects.end()) return false;
+    object = found->second;
+    return true;
+}
+
+std::shared_ptr<AudioDevice>
+ObjectTable::findDevice
+(
+    std::uint32_t handle
+) const
+{
+    std::lock_guard guard(m_mutex);
+    auto device = m_devices.find(handle);
+    return (device != m_devices.end()) ? device->second.lock() : nullptr;
+}
+
+std::shared_ptr<AudioSession>
+ObjectTable::findSession
+(
+    std::uint32_t handle
+) const
+{
+    std::lock_guard guard(m_mutex);
+    auto session = m_sessions.find(handle);
+    return (session != m_sessions.end()) ? session->second.lock() : nullptr;
+}
+
+void
+ObjectTable::addDevice
+(
+    const std::string &audioDeviceId,
+    std::weak_ptr<AudioDevice> pWeakAudioDevice
+)
+{
+    auto pAudioDevice = pWeakAudioDevice.lock();
+    if (!pAudioDevice) return;
+
+    std::shared_ptr<TableDeviceObserver> pObserver;
+    {
+        std::unique_lock lock(m_mutex);
+        if (m_bDetached) return;
+        for (const auto &[handle, object] : m_objects)
+        {
+            if (!object.bSession && object.id == audioDeviceId) return;
+        }
+        std::uint32_t handle = addObject(false, 0, audioDeviceId);
+        pObserver = std::make_shared<TableDeviceObserver>(weak_from_this(), handle);
+        m_devices[handle] = pAudioDevice;
+        m_observers[handle] = pObserver;
+        wake(lock);
+    }
+    // Outside the lock, the current values come straight back through the observer
+    pAudioDevice->addObserver(pObserver, true, DispatchMode::Synchronous);
+}
+
+void
+ObjectTable::addSession
+(
+    std::uint32_t deviceHandle,
+    const std::string &audioSessionId,
+    std::weak_ptr<AudioSession> pWeakAudioSession
+)
+{
+    auto pAudioSession = pWeakAudioSession.lock();
+    if (!pAudioSession) return;
+
+    std::shared_ptr<TableSessionObserver> pObserver;
+    {
+        std::unique_lock lock(m_mutex);
+        if (!m_objects.contains(deviceHandle)) return;
+        for (const auto &[handle, object] : m_objects)
+        {
+            if (object.bSession && object.parent == deviceHandle && object.id == audioSessionId) return;
+        }
+        std::uint32_t handle = addObject(true, deviceHandle, audioSessionId);
+        pObserver = std::make_shared<TableSessionObserver>(weak_from_this(), handle);
+        m_sessions[handle] = pAudioSession;
+        m_observers[handle] = pObserver;
+        wake(lock);
+    }
+    pAudioSession->addObserver(pObserver, true, DispatchMode::Synchronous);
+}
+
+void
+ObjectTable::removeDevice
+(
+    const std::string &audioDeviceId
+)
+{
+    std::unique_lock lock(m_mutex);
+    for (const auto &[handle, object] : m_objects)
+    {
+        if (!object.bSession && object.id == audioDeviceId)
+        {
+            removeObject(handle);
+            break;
+        }
+    }
+    wake(lock);
+}
+
+void
+ObjectTable::removeSession
+(
+    std::uint32_t deviceHandle,
+    const std::string &audioSessionId
+)
+{
+    std::unique_lock lock(m_mutex);
+    for (const auto &[handle, object] : m_objects)
+    {
+        if (object.bSession && object.parent == deviceHandle && object.id == audioSessionId)
+        {
+            removeObject(handle);
+            break;
+        }
+    }
+    wake(lock);
+}
+
+void
+ObjectTable::record
+(
+    const Object &object,
+    EventKind kind
+)
+{
+    // Meter samples only matter at their latest value, so one per handle per batch
+    bool bMeter = (kind == EventKind::PeakSample || kind == EventKind::LoudnessSample);
+    if (bMeter)
+    {
+        auto existing = m_meterEvents.find({object.handle, kind});
+        if (existing != m_meterEvents.end())
+        {
+            m_pending[existing->second].value.peak = object.peak;
+            m_pending[existing->second].value.loudness = object.loudness;
+            return;
+        }
+    }
+
+    Pending entry;
+    entry.event = {++m_seq, object.handle, kind};
+    entry.value.handle = object.handle;
+    entry.value.bSession = object.bSession;
+    entry.value.parent = object.parent;
+    entry.value.state = object.state;
+    entry.value.bDefault = object.bDefault;
+    entry.value.volume = object.volume;
+    entry.value.bMuted = object.bMuted;
+    entry.value.peak = object.peak;
+    entry.value.loudness = object.loudness;
+    switch (kind)
+    {
+        case EventKind::Name:           entry.value.name = object.name; break;
+        case EventKind::IconPath:       entry.value.iconPath = object.iconPath; break;
+        case EventKind::ChannelVolumes: entry.value.channelVolumes = object.channelVolumes; break;
+        case EventKind::SessionAdded:
+        case EventKind::DeviceAdded:    entry.value.id = object.id; break;
+        default:                        break;
+    }
+    if (bMeter)
+    {
+        m_meterEvents[{object.handle, kind}] = m_pending.size();
+    }
+    m_pending.push_back(std::move(entry));
+
+    if (m_pending.size() == 1)
+    {
+        m_bWakeDue = true;
+    }
+}
+
+void
+ObjectTable::wake
+(
+    std::unique_lock<std::mutex> &lock
+)
+{
+    if (!m_bWakeDue) return;
+    m_bWakeDue = false;
+    if (m_bDetached || !m_wake) return;
+
+    // detach() leaves m_wake alone until this is done with it
+    ++m_wakesRunning;
+    lock.unlock();
+    m_wake();
+    lock.lock();
+    if (--m_wakesRunning == 0)
+    {
+        m_wakesDone.notify_all();
+    }
+}
+
+std::uint32_t
+ObjectTable::addObject
+(
+    bool bSession,
+    std::uint32_t parent,
+    const std::string &id
+)
+{
+    Object &object = m_objects[m_nextHandle];
+    object.handle = m_nextHandle++;
+    object.bSession = bSession;
+    object.parent = parent;
+    object.id = id;
+    record(object, bSession ? EventKind::SessionAdded : EventKind::DeviceAdded);
+    return object.handle;
+}
+
+void
+ObjectTable::removeObject
+(
+    std::uint32_t handle
+)
+{
+    auto object = m_objects.find(handle);
+    if (object == m_objects.end()) return;
+
+    // A device takes its sessions with it
+    if (!object->second.bSession)
+    {
+        for (auto it = m_objects.begin(); it != m_objects.end();)
+        {
+            auto child = it++;
+            if (child->second.bSession && child->second.parent == handle)
+            {
+                removeObject(child->first);
+            }
+        }
+    }
+    record(object->second, object->second.bSession ? EventKind::SessionRemoved : EventKind::DeviceRemoved);
+    m_objects.erase(handle);
+    m_devices.erase(handle);
+    m_sessions.erase(handle);
+    m_observers.erase(handle);
+}
+
+} // namespace vmx::detail
@@ -0,0 +1,98 @@
+#pragma once
+
+/* ==== Application Includes =============================================== */
+#include <vmx/MixerObject.h>
+#include <vmx/VolumeMixer.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace vmx::detail
+{
+
+/* ==== Classes ============================================================ */
+// A handle-keyed mirror of one VolumeMixer's devices and sessions, for the
+// front ends that cannot hand out shared_ptrs (vmxd, the C API). attach()
+// observes the whole tree with synchronous dispatch, whatever the global
+// mode, so no thread is started per change; every change updates the mirror
+// and is queued with the next sequence number until takePending(). Peak and
+// loudness samples only keep their latest value per handle in the queue.
+// wake runs when the queue goes from empty to not, so a consumer is woken
+// once per batch; it runs on the thread that made the change, once that
+// holds no vmx lock, and outside the table's lock, so it may call back into
+// the table (but not detach() it). Handles start at 1 and are never reused.
+class ObjectTable : public std::enable_shared_from_this<ObjectTable>
+{
+public: /* Types */
+    using Object = MixerObject;
+    using Event = MixerEvent;
+    using Pending = MixerChange;
+
+public: /* Methods */
+    explicit ObjectTable(std::function<void()> wake) : m_wake(std::move(wake)) {};
+
+    // The mirror fills in (and the queue with it) before attach() returns,
+    // or right after when it is called from inside an observer
+    void attach(VolumeMixer &volumeMixer);
+    // Stops observing and waits for a wake that is running; late callbacks
+    // find an empty, detached table
+    void detach(VolumeMixer &volumeMixer);
+
+    std::vector<Pending> takePending();
+    // Swaps with pending, so the table reuses the buffer's allocation
+    void takePending(std::vector<Pending> &pending);
+    // Copies every object, returns the sequence number they are current to
+    std::uint64_t snapshot(std::vector<Object> &objects) const;
+    bool find(std::uint32_t handle, Object &object) const;
+    std::shared_ptr<AudioDevice> findDevice(std::uint32_t handle) const;
+    std::shared_ptr<AudioSession> findSession(std::uint32_t handle) const;
+
+    // For the observers in ObjectTable.cpp
+    template <class Change>
+    void change(std::uint32_t handle, EventKind kind, const Change &apply)
+    {
+        std::unique_lock lock(m_mutex);
+        auto object = m_objects.find(handle);
+        if (object == m_objects.end()) return;
+        apply(object->second);
+        record(object->second, kind);
+        wake(lock);
+    }
+    void addDevice(const std::string &audioDeviceId, std::weak_ptr<AudioDevice> pWeakAudioDevice);
+    void addSession(std::uint32_t deviceHandle, const std::string &audioSessionId, std::weak_ptr<AudioSession> pWeakAudioSession);
+    void removeDevice(const std::string &audioDeviceId);
+    void removeSession(std::uint32_t deviceHandle, const std::string &audioSessionId);
+
+private: /* Methods */
+    void record(const Object &object, EventKind kind);
+    // Runs m_wake if record() asked for it, unlocking around the call
+    void wake(std::unique_lock<std::mutex> &lock);
+    std::uint32_t addObject(bool bSession, std::uint32_t parent, const std::string &id);
+    void removeObject(std::uint32_t handle);
+
+private: /* Members */
+    mutable std::mutex m_mutex;
+    std::function<void()> m_wake;
+    bool m_bWakeDue = false;
+    int m_wakesRunning = 0;
+    std::condition_variable m_wakesDone;
+    bool m_bDetached = false;
+    std::uint64_t m_seq = 0;
+    std::uint32_t m_nextHandle = 1;
+    std::map<std::uint32_t, Object> m_objects;
+    std::map<std::uint32_t, std::weak_ptr<AudioDevice>> m_devices;
+    std::map<std::uint32_t, std::weak_ptr<AudioSession>> m_sessions;
+    std::map<std::uint32_t, std::shared_ptr<void>> m_observers; // kept alive here, the tree only holds weak_ptrs
+    std::shared_ptr<VolumeMixer::Observer> m_pMixerObserver;
+    std::vector<Pending> m_pending;
+    std::map<std::pair<std::uint32_t, EventKind>, std::size_t> m_meterEvents; // index into m_pending
+};
+
+} // namespace vmx::detail
@@ -0,0 +1,438 @@
+#pragma once
+
+/* ==== Application Includes =============================================== */
+#include <vmx/PcmMeter.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace vmx::detail
+{
+
+/* ==== Types ============================================================== */
+// One table per instruction set, each built in its own translation unit with
+// that instruction set's compiler flags.
+struct PcmKernels
+{
+    using Kernel = void (*)(const void *pFrames, std::size_t frameCount, float *pLevels, std::size_t channelCount);
+
+    PcmMeter::Isa isa;
+    Kernel peak[kSampleFormatCount];
+    Kernel rms[kSampleFormatCount];
+    Kernel truePeak[kSampleFormatCount];
+};
+
+/* ==== Functions ========================================================== */
+const PcmKernels *pcmKernelsScalar();
+const PcmKernels *pcmKernelsSse2();
+const PcmKernels *pcmKernelsAvx2();
+const PcmKernels *pcmKernelsAvx512();
+
+// Everything below has internal linkage on purpose. Each ISA translation unit
+// compiles its own copy with its own target flags; a shared inline symbol (or
+// a std:: template instantiated here) could let the linker hand AVX-512 code
+// to the scalar path of a CPU that lacks it.
+namespace
+{
+
+/* ==== Constants ========================================================== */
+constexpr std::size_t kTruePeakPhases = 4;
+constexpr std::size_t kTruePeakTaps = 12;
+
+// ITU-R BS.1770-4 Annex 2, 48 tap polyphase interpolator, y[n] = sum h[t] * x[n - t]
+constexpr float kTruePeakCoefficients[kTruePeakPhases][kTruePeakTaps] = {
+    { 0.0017089843750f,  0.0109863281250f, -0.0196533203125f,  0.0332031250000f, -0.0594482421875f,  0.1373291015625f,
+      0.9721679687500f, -0.1022949218750f,  0.0476074218750f, -0.0266113281250f,  0.0148925781250f, -0.0083007812500f },
+    {-0.0291748046875f,  0.0292968750000f, -0.0517578125000f,  0.0891113281250f, -0.1665039062500f,  0.4650878906250f,
+      0.7797851562500f, -0.2003173828125f,  0.1015625000000f, -0.0582275390625f,  0.0330810546875f, -0.0189208984375f },
+    {-0.0189208984375f,  0.0330810546875f, -0.0582275390625f,  0.1015625000000f, -0.2003173828125f,  0.7797851562500f,
+      0.4650878906250f, -0.1665039062500f,  0.0891113281250f, -0.0517578125000f,  0.0292968750000f, -0.0291748046875f },
+    {-0.0083007812500f,  0.0148925781250f, -0.0266113281250f,  0.0476074218750f, -0.1022949218750f,  0.9721679687500f,
+      0.1373291015625f, -0.0594482421875f,  0.0332031250000f, -0.0196533203125f,  0.0109863281250f,  0.0017089843750f },
+};
+
+// Lane accumulators are folded into double totals this often, so long
+// buffers do not lose RMS precision to float rounding
+constexpr std::size_t kFlushSamples = std::size_t(1) << 16;
+
+// Sums split the stream as if every ISA were this many lanes wide, so each
+// one adds the same samples into the same partial sums in the same order and
+// gets the same RMS to the bit. Nothing is fused into an FMA either (the
+// kernel translation units are built with -ffp-contract=off).
+constexpr std::size_t kReductionLanes = 16;
+
+/* ==== Helper Functions =================================================== */
+inline std::size_t
+greatestCommonDivisor
+(
+    std::size_t a,
+    std::size_t b
+)
+{
+    while (b != 0)
+    {
+        std::size_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+inline std::int32_t
+readInt24
+(
+    const std::uint8_t *pSample
+)
+{
+    std::uint32_t bits = (std::uint32_t(pSample[0]) << 8) | (std::uint32_t(pSample[1]) << 16) | (std::uint32_t(pSample[2]) << 24);
+    return static_cast<std::int32_t>(bits) >> 8;
+}
+
+/* ==== Scalar Operations ================================================== */
+// The vector operations every ISA provides; kWidth lanes per vector
+struct ScalarOps
+{
+    using V = float;
+    static constexpr std::size_t kWidth = 1;
+
+    static V zero() { return 0.0f; };
+    static V broadcast(float value) { return value; };
+    static V load(const float *p) { return *p; };
+    static V loadInt16(const std::int16_t *p) { return static_cast<float>(*p); };
+    static V loadInt24(const std::uint8_t *p) { return static_cast<float>(readInt24(p)); };
+    static V loadInt32(const std::int32_t *p) { return static_cast<float>(*p); };
+    static V abs(V x) { return x < 0.0f ? -x : x; };
+    static V max(V a, V b) { return a > b ? a : b; };
+    static V add(V a, V b) { return a + b; };
+    static V mul(V a, V b) { return a * b; };
+    static void store(float *p, V x) { *p = x; };
+};
+
+/* ==== Sample Loading ===================================================== */
+// What a sample is multiplied by to land in [-1.0, 1.0). Being a power of two,
+// applying it to a peak or a sum of squares instead of every sample gives the
+// same result to the bit.
+template <SampleFormat format>
+constexpr float kSampleScale = (format == SampleFormat::Int16) ? 1.0f / 32768.0f :
+                               (format == SampleFormat::Int24) ? 1.0f / 8388608.0f :
+                               (format == SampleFormat::Int32) ? 1.0f / 2147483648.0f : 1.0f;
+
+// Loads Ops::kWidth consecutive samples starting at sample index, not scaled
+template <class Ops, SampleFormat format>
+inline typename Ops::V
+loadUnscaledSamples
+(
+    const void *pFrames,
+    std::size_t index
+)
+{
+    if constexpr (format == SampleFormat::Float32)
+    {
+        return Ops::load(static_cast<const float*>(pFrames) + index);
+    }
+    else if constexpr (format == SampleFormat::Int16)
+    {
+        return Ops::loadInt16(static_cast<const std::int16_t*>(pFrames) + index);
+    }
+    else if constexpr (format == SampleFormat::Int24)
+    {
+        return Ops::loadInt24(static_cast<const std::uint8_t*>(pFrames) + 3 * index);
+    }
+    else
+    {
+        return Ops::loadInt32(static_cast<const std::int32_t*>(pFrames) + index);
+    }
+}
+
+// Loads Ops::kWidth consecutive samples starting at sample index, scaled to
+// [-1.0, 1.0)
+template <class Ops, SampleFormat format>
+inline typename Ops::V
+loadSamples
+(
+    const void *pFrames,
+    std::size_t index
+)
+{
+    if constexpr (format == SampleFormat::Float32)
+    {
+        return loadUnscaledSamples<Ops, format>(pFrames, index);
+    }
+    else
+    {
+        return Ops::mul(loadUnscaledSamples<Ops, format>(pFrames, index), Ops::broadcast(kSampleScale<format>));
+    }
+}
+
+/* ==== Reductions ========================================================= */
+// kLanes is the width the stream is split at, kReductionLanes unless the
+// result does not depend on the order
+struct PeakReduction
+{
+    template <class Ops>
+    static constexpr std::size_t kLanes = Ops::kWidth;
+    template <class Ops>
+    static typename Ops::V step(typename Ops::V acc, typename Ops::V x) { return Ops::max(acc, Ops::abs(x)); }
+    static double combine(double total, float lane) { return lane > total ? lane : total; };
+    static float finish(double total, std::size_t, double scale) { return static_cast<float>(total * scale); };
+};
+
+struct RmsReduction
+{
+    template <class Ops>
+    static constexpr std::size_t kLanes = kReductionLanes;
+    template <class Ops>
+    static typename Ops::V step(typename Ops::V acc, typename Ops::V x) { return Ops::add(Ops::mul(x, x), acc); }
+    static double combine(double total, float lane) { return total + lane; };
+    static float finish(double total, std::size_t frameCount, double scale)
+    {
+        return static_cast<float>(std::sqrt(total * scale * scale / static_cast<double>(frameCount)));
+    };
+};
+
+/* ==== Kernels ============================================================ */
+// Folds lane j of accumulator k into the total of channel (k * kWidth + j) % C;
+// callers keep every vector of accumulator k at a sample index with that same
+// channel layout.
+template <class Ops, class Reduction>
+inline void
+foldLanes
+(
+    const typename Ops::V *pAccumulators,
+    std::size_t accumulatorCount,
+    double *pTotals,
+    std::size_t channelCount
+)
+{
+    float lanes[Ops::kWidth];
+    for (std::size_t k = 0; k < accumulatorCount; ++k)
+    {
+        Ops::store(lanes, pAccumulators[k]);
+        for (std::size_t j = 0; j < Ops::kWidth; ++j)
+        {
+            std::size_t channel = (k * Ops::kWidth + j) % channelCount;
+            pTotals[channel] = Reduction::combine(pTotals[channel], lanes[j]);
+        }
+    }
+}
+
+// The interleaved stream is walked as one flat array of samples. A vector
+// spans samples of different channels, but after lcm(kLanes, C) samples the
+// pattern repeats, so P = C / gcd(C, kLanes) blocks of kLanes samples each
+// see a fixed channel per lane. P is rounded up to at least four blocks to
+// hide the latency of the reduction; a block is kLanes / kWidth accumulators.
+template <class Ops, SampleFormat format, class Reduction, std::size_t kFixedAccumulators>
+inline void
+reduceSamples
+(
+    const void *pFrames,
+    std::size_t sampleCount,
+    std::size_t accumulatorCount,
+    double *pTotals,
+    std::size_t channelCount,
+    std::size_t &index
+)
+{
+    using V = typename Ops::V;
+    constexpr std::size_t kWidth = Ops::kWidth;
+    const std::size_t count = kFixedAccumulators ? kFixedAccumulators : accumulatorCount;
+    const std::size_t stride = count * kWidth;
+    const std::size_t flushStride = (kFlushSamples / stride + 1) * stride;
+
+    V accumulators[kFixedAccumulators ? kFixedAccumulators : PcmMeter::kMaxChannels * (kReductionLanes / kWidth)];
+    while (index + stride <= sampleCount)
+    {
+        std::size_t flushEnd = (sampleCount - index < flushStride) ? sampleCount : index + flushStride;
+        for (std::size_t k = 0; k < count; ++k)
+        {
+            accumulators[k] = Ops::zero();
+        }
+        for (; index + stride <= flushEnd; index += stride)
+        {
+            for (std::size_t k = 0; k < count; ++k)
+            {
+                accumulators[k] = Reduction::template step<Ops>(accumulators[k], loadUnscaledSamples<Ops, format>(pFrames, index + k * kWidth));
+            }
+        }
+        foldLanes<Ops, Reduction>(accumulators, count, pTotals, channelCount);
+    }
+}
+
+template <class Ops, SampleFormat format, class Reduction>
+void
+reduceKernel
+(
+    const void *pFrames,
+    std::size_t frameCount,
+    float *pLevels,
+    std::size_t channelCount
+)
+{
+    constexpr std::size_t kLanes = Reduction::template kLanes<Ops>;
+    static_assert(kLanes % Ops::kWidth == 0);
+    constexpr std::size_t kBlockAccumulators = kLanes / Ops::kWidth;
+    const std::size_t sampleCount = frameCount * channelCount;
+    const std::size_t period = channelCount / greatestCommonDivisor(channelCount, kLanes);
+    const std::size_t accumulatorCount = ((period < 4) ? (4 / period) * period : period) * kBlockAccumulators;
+
+    double totals[PcmMeter::kMaxChannels];
+    for (std::size_t channel = 0; channel < channelCount; ++channel)
+    {
+        totals[channel] = 0.0;
+    }
+
+    std::size_t index = 0;
+    if (accumulatorCount == 4 * kBlockAccumulators)
+    {
+        reduceSamples<Ops, format, Reduction, 4 * kBlockAccumulators>(pFrames, sampleCount, accumulatorCount, totals, channelCount, index);
+    }
+    else
+    {
+        reduceSamples<Ops, format, Reduction, 0>(pFrames, sampleCount, accumulatorCount, totals, channelCount, index);
+    }
+
+    for (; index < sampleCount; ++index)
+    {
+        std::size_t channel = index % channelCount;
+        float lane = Reduction::template step<ScalarOps>(0.0f, loadUnscaledSamples<ScalarOps, format>(pFrames, index));
+        totals[channel] = Reduction::combine(totals[channel], lane);
+    }
+
+    for (std::size_t channel = 0; channel < channelCount; ++channel)
+    {
+        pLevels[channel] = (frameCount == 0) ? 0.0f : Reduction::finish(totals[channel], frameCount, kSampleScale<format>);
+    }
+}
+
+// Largest |interpolated sample| over the four phases ending at index; needs
+// kTruePeakTaps - 1 frames of history before it
+template <class Ops, SampleFormat format>
+inline typename Ops::V
+interpolatedPeak
+(
+    const void *pFrames,
+    std::size_t index,
+    std::size_t channelCount
+)
+{
+    using V = typename Ops::V;
+    V taps[kTruePeakTaps];
+    for (std::size_t t = 0; t < kTruePeakTaps; ++t)
+    {
+        taps[t] = loadSamples<Ops, format>(pFrames, index - t * channelCount);
+    }
+
+    V peak = Ops::zero();
+    for (std::size_t phase = 0; phase < kTruePeakPhases; ++phase)
+    {
+        V y = Ops::zero();
+        for (std::size_t t = 0; t < kTruePeakTaps; ++t)
+        {
+            y = Ops::add(Ops::mul(Ops::broadcast(kTruePeakCoefficients[phase][t]), taps[t]), y);
+        }
+        peak = Ops::max(peak, Ops::abs(y));
+    }
+    return peak;
+}
+
+template <class Ops, SampleFormat format>
+void
+truePeakKernel
+(
+    const void *pFrames,
+    std::size_t frameCount,
+    float *pLevels,
+    std::size_t channelCount
+)
+{
+    using V = typename Ops::V;
+    constexpr std::size_t kWidth = Ops::kWidth;
+
+    // Interpolation never goes below the sample peak, and the sample peak
+    // covers the frames without enough history
+    reduceKernel<Ops, format, PeakReduction>(pFrames, frameCount, pLevels, channelCount);
+    if (frameCount < kTruePeakTaps) return;
+
+    const std::size_t sampleCount = frameCount * channelCount;
+    const std::size_t period = channelCount / greatestCommonDivisor(channelCount, kWidth);
+    const std::size_t repeat = period * kWidth;
+    const std::size_t first = (kTruePeakTaps - 1) * channelCount;
+    std::size_t vectorStart = (first + repeat - 1) / repeat * repeat;
+    if (vectorStart > sampleCount) vectorStart = sampleCount;
+
+    double totals[PcmMeter::kMaxChannels];
+    for (std::size_t channel = 0; channel < channelCount; ++channel)
+    {
+        totals[channel] = pLevels[channel];
+    }
+
+    for (std::size_t index = first; index < vectorStart; ++index)
+    {
+        float lane = interpolatedPeak<ScalarOps, format>(pFrames, index, channelCount);
+        totals[index % channelCount] = PeakReduction::combine(totals[index % channelCount], lane);
+    }
+
+    V accumulators[PcmMeter::kMaxChannels];
+    for (std::size_t k = 0; k < period; ++k)
+    {
+        accumulators[k] = Ops::zero();
+    }
+
+    std::size_t index = vectorStart;
+    for (; index + repeat <= sampleCount; index += repeat)
+    {
+        for (std::size_t k = 0; k < period; ++k)
+        {
+            accumulators[k] = Ops::max(accumulators[k], interpolatedPeak<Ops, format>(pFrames, index + k * kWidth, channelCount));
+        }
+    }
+    foldLanes<Ops, PeakReduction>(accumulators, period, totals, channelCount);
+
+    for (; index < sampleCount; ++index)
+    {
+        float lane = interpolatedPeak<ScalarOps, format>(pFrames, index, channelCount);
+        totals[index % channelCount] = PeakReduction::combine(totals[index % channelCount], lane);
+    }
+
+    for (std::size_t channel = 0; channel < channelCount; ++channel)
+    {
+        pLevels[channel] = static_cast<float>(totals[channel]);
+    }
+}
+
+/* ==== Kernel Tables ====================================================== */
+template <class Ops>
+constexpr PcmKernels
+makePcmKernels
+(
+    PcmMeter::Isa isa
+)
+{
+    return PcmKernels{
+        isa,
+        {
+            reduceKernel<Ops, SampleFormat::Float32, PeakReduction>,
+            reduceKernel<Ops, SampleFormat::Int16, PeakReduction>,
+            reduceKernel<Ops, SampleFormat::Int24, PeakReduction>,
+            reduceKernel<Ops, SampleFormat::Int32, PeakReduction>,
+        },
+        {
+            reduceKernel<Ops, SampleFormat::Float32, RmsReduction>,
+            reduceKernel<Ops, SampleFormat::Int16, RmsReduction>,
+            reduceKernel<Ops, SampleFormat::Int24, RmsReduction>,
+            reduceKernel<Ops, SampleFormat::Int32, RmsReduction>,
+        },
+        {
+            truePeakKernel<Ops, SampleFormat::Float32>,
+            truePeakKernel<Ops, SampleFormat::Int16>,
+            truePeakKernel<Ops, SampleFormat::Int24>,
+            truePeakKernel<Ops, SampleFormat::Int32>,
+        },
+    };
+}
+
+} // namespace
+
+} // namespace vmx::detail
@@ -0,0 +1,223 @@
+/* ==== Application Includes =============================================== */
+#include <vmx/PcmMeter.h>
+#include "PcmKernels.h"
+
+/* ==== Standard Library Includes ========================================== */
+#include <atomic>
+#include <stdexcept>
+#include <string>
+
+/* ==== Operating System Includes ========================================== */
+#if VMX_PCM_X86 && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+/* ==== Forward Declarations =============================================== */
+static const vmx::detail::PcmKernels *kernels();
+static const vmx::detail::PcmKernels *kernelsFor(vmx::PcmMeter::Isa isa);
+static bool cpuSupports(vmx::PcmMeter::Isa isa);
+static void checkChannelCount(std::size_t channelCount);
+
+/* ==== Static Variables =================================================== */
+// Filled on first use without a lock, so the first call from a realtime
+// thread does not block; racing initialisations store the same table
+static std::atomic<const vmx::detail::PcmKernels*> s_pKernels = nullptr;
+
+namespace vmx
+{
+
+/* ==== Scalar Kernels ===================================================== */
+namespace detail
+{
+
+namespace
+{
+
+constexpr PcmKernels kScalarKernels = makePcmKernels<ScalarOps>(PcmMeter::Isa::Scalar);
+
+} // namespace
+
+const PcmKernels *
+pcmKernelsScalar()
+{
+    return &kScalarKernels;
+}
+
+} // namespace detail
+
+/* ==== PcmMeter Class ===================================================== */
+void
+PcmMeter::peak
+(
+    SampleFormat format,
+    const void *pFrames,
+    std::size_t frameCount,
+    std::span<float> channelPeaks
+)
+{
+    checkChannelCount(channelPeaks.size());
+    kernels()->peak[static_cast<std::size_t>(format)](pFrames, frameCount, channelPeaks.data(), channelPeaks.size());
+}
+
+void
+PcmMeter::rms
+(
+    SampleFormat format,
+    const void *pFrames,
+    std::size_t frameCount,
+    std::span<float> channelRms
+)
+{
+    checkChannelCount(channelRms.size());
+    kernels()->rms[static_cast<std::size_t>(format)](pFrames, frameCount, channelRms.data(), channelRms.size());
+}
+
+void
+PcmMeter::truePeak
+(
+    SampleFormat format,
+    const void *pFrames,
+    std::size_t frameCount,
+    std::span<float> channelTruePeaks
+)
+{
+    checkChannelCount(channelTruePeaks.size());
+    kernels()->truePeak[static_cast<std::size_t>(format)](pFrames, frameCount, channelTruePeaks.data(), channelTruePeaks.size());
+}
+
+PcmMeter::Isa
+PcmMeter::isa()
+{
+    return kernels()->isa;
+}
+
+bool
+PcmMeter::isSupported
+(
+    Isa isa
+)
+{
+    return kernelsFor(isa) && cpuSupports(isa);
+}
+
+void
+PcmMeter::setIsa
+(
+    Isa isa
+)
+{
+    if (!isSupported(isa))
+    {
+        throw std::runtime_error(std::string("PcmMeter kernels for ") + toString(isa) + " are not available on this CPU");
+    }
+    s_pKernels.store(kernelsFor(isa), std::memory_order_release);
+}
+
+const char *
+toString
+(
+    PcmMeter::Isa isa
+)
+{
+    switch (isa)
+    {
+        case PcmMeter::Isa::Scalar: return "scalar";
+        case PcmMeter::Isa::Sse2:   return "sse2";
+        case PcmMeter::Isa::Avx2:   return "avx2";
+        case PcmMeter::Isa::Avx512: return "avx512";
+        default:                    return "unknown";
+    }
+}
+
+} // namespace vmx
+
+/* ==== Static Functions =================================================== */
+static const vmx::detail::PcmKernels *
+kernels()
+{
+    const vmx::detail::PcmKernels *pKernels = s_pKernels.load(std::memory_order_acquire);
+    if (!pKernels)
+    {
+        pKernels = vmx::detail::pcmKernelsScalar();
+        for (auto isa : {vmx::PcmMeter::Isa::Sse2, vmx::PcmMeter::Isa::Avx2, vmx::PcmMeter::Isa::Avx512})
+        {
+            if (vmx::PcmMeter::isSupported(isa)) pKernels = kernelsFor(isa);
+        }
+
+        const vmx::detail::PcmKernels *pExpected = nullptr;
+        if (!s_pKernels.compare_exchange_strong(pExpected, pKernels, std::memory_order_acq_rel))
+        {
+            pKernels = pExpected; // lost to setIsa() or another first caller
+        }
+    }
+    return pKernels;
+}
+
+static const vmx::detail::PcmKernels *
+kernelsFor
+(
+    vmx::PcmMeter::Isa isa
+)
+{
+    switch (isa)
+    {
+        case vmx::PcmMeter::Isa::Scalar: return vmx::detail::pcmKernelsScalar();
+#if VMX_PCM_X86
+        case vmx::PcmMeter::Isa::Sse2:   return vmx::detail::pcmKernelsSse2();
+        case vmx::PcmMeter::Isa::Avx2:   return vmx::detail::pcmKernelsAvx2();
+        case vmx::PcmMeter::Isa::Avx512: return vmx::detail::pcmKernelsAvx512();
+#endif
+        default:                         return nullptr;
+    }
+}
+
+static bool
+cpuSupports
+(
+    vmx::PcmMeter::Isa isa
+)
+{
+    if (isa == vmx::PcmMeter::Isa::Scalar) return true;
+
+#if VMX_PCM_X86 && defined(_MSC_VER) && !defined(__clang__)
+    // The OS has to save the wider registers too: XCR0 bits 1-2 for AVX,
+    // 5-7 as well for AVX-512
+    int info[4] = {};
+    __cpuid(info, 1);
+    bool bSse2 = (info[3] & (1 << 26)) != 0;
+    bool bOsAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28));
+    bool bFma = (info[2] & (1 << 12)) != 0;
+    unsigned long long xcr0 = bOsAvx ? _xgetbv(0) : 0;
+    __cpuidex(info, 7, 0);
+    switch (isa)
+    {
+        case vmx::PcmMeter::Isa::Sse2:   return bSse2;
+        case vmx::PcmMeter::Isa::Avx2:   return bFma && (xcr0 & 0x06) == 0x06 && (info[1] & (1 << 5));
+        case vmx::PcmMeter::Isa::Avx512: return (xcr0 & 0xe6) == 0xe6 && (info[1] & (1 << 16)) && (info[1] & (1 << 30));
+        default:                         return false;
+    }
+#elif VMX_PCM_X86
+    __builtin_cpu_init();
+    switch (isa)
+    {
+        case vmx::PcmMeter::Isa::Sse2:   return __builtin_cpu_supports("sse2");
+        case vmx::PcmMeter::Isa::Avx2:   return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case vmx::PcmMeter::Isa::Avx512: return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+        default:                         return false;
+    }
+#else
+    return false;
+#endif
+}
+
+static void
+checkChannelCount
+(
+    std::size_t channelCount
+)
+{
+    if (channelCount == 0 || channelCount > vmx::PcmMeter::kMaxChannels)
+    {
+        throw std::runtime_error("PcmMeter supports 1 to " + std::to_string(vmx::PcmMeter::kMaxChannels) + " channels");
+    }
+}
@@ -0,0 +1,57 @@
+/* ==== Application Includes =============================================== */
+#include "PcmKernels.h"
+
+/* ==== Operating System Includes ========================================== */
+#include <immintrin.h>
+
+namespace vmx::detail
+{
+
+namespace
+{
+
+/* ==== AVX2 Operations ==================================================== */
+struct Avx2Ops
+{
+    using V = __m256;
+    static constexpr std::size_t kWidth = 8;
+
+    static V zero() { return _mm256_setzero_ps(); };
+    static V broadcast(float value) { return _mm256_set1_ps(value); };
+    static V load(const float *p) { return _mm256_loadu_ps(p); };
+    static V loadInt16(const std::int16_t *p)
+    {
+        return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))));
+    };
+    // 24 bytes are loaded without touching the next 8, each 128 bit half gets
+    // the 12 bytes of its four samples, and a byte shuffle moves every sample
+    // into the top of its lane so the arithmetic shift sign extends it
+    static V loadInt24(const std::uint8_t *p)
+    {
+        __m256i bytes = _mm256_maskload_epi32(reinterpret_cast<const int*>(p), _mm256_setr_epi32(-1, -1, -1, -1, -1, -1, 0, 0));
+        bytes = _mm256_permutevar8x32_epi32(bytes, _mm256_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6));
+        bytes = _mm256_shuffle_epi8(bytes, _mm256_setr_epi8(
+            -128, 0, 1, 2, -128, 3, 4, 5, -128, 6, 7, 8, -128, 9, 10, 11,
+            -128, 0, 1, 2, -128, 3, 4, 5, -128, 6, 7, 8, -128, 9, 10, 11));
+        return _mm256_cvtepi32_ps(_mm256_srai_epi32(bytes, 8));
+    };
+    static V loadInt32(const std::int32_t *p) { return _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))); };
+    static V abs(V x) { return _mm256_and_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff))); };
+    static V max(V a, V b) { return _mm256_max_ps(a, b); };
+    static V add(V a, V b) { return _mm256_add_ps(a, b); };
+    static V mul(V a, V b) { return _mm256_mul_ps(a, b); };
+    static void store(float *p, V x) { _mm256_storeu_ps(p, x); };
+};
+
+constexpr PcmKernels kAvx2Kernels = makePcmKernels<Avx2Ops>(PcmMeter::Isa::Avx2);
+
+} // namespace
+
+/* ==== Functions ========================================================== */
+const PcmKernels *
+pcmKernelsAvx2()
+{
+    return &kAvx2Kernels;
+}
+
+} // namespace vmx::detail
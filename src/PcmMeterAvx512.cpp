@@ -0,0 +1,56 @@
+/* ==== Application Includes =============================================== */
+#include "PcmKernels.h"
+
+/* ==== Operating System Includes ========================================== */
+#include <immintrin.h>
+
+namespace vmx::detail
+{
+
+namespace
+{
+
+/* ==== AVX-512 Operations ================================================= */
+// AVX-512F plus BW for the byte shuffle
+struct Avx512Ops
+{
+    using V = __m512;
+    static constexpr std::size_t kWidth = 16;
+
+    static V zero() { return _mm512_setzero_ps(); };
+    static V broadcast(float value) { return _mm512_set1_ps(value); };
+    static V load(const float *p) { return _mm512_loadu_ps(p); };
+    static V loadInt16(const std::int16_t *p)
+    {
+        return _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))));
+    };
+    // Same scheme as AVX2: a masked 48 byte load, 12 bytes per 128 bit lane,
+    // then a per-lane byte shuffle into the top of each 32 bit lane
+    static V loadInt24(const std::uint8_t *p)
+    {
+        __m512i bytes = _mm512_maskz_loadu_epi32(0x0fff, p);
+        bytes = _mm512_permutexvar_epi32(_mm512_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6, 6, 7, 8, 9, 9, 10, 11, 12), bytes);
+        bytes = _mm512_shuffle_epi8(bytes, _mm512_broadcast_i32x4(_mm_setr_epi8(
+            -128, 0, 1, 2, -128, 3, 4, 5, -128, 6, 7, 8, -128, 9, 10, 11)));
+        return _mm512_cvtepi32_ps(_mm512_srai_epi32(bytes, 8));
+    };
+    static V loadInt32(const std::int32_t *p) { return _mm512_cvtepi32_ps(_mm512_loadu_si512(p)); };
+    static V abs(V x) { return _mm512_abs_ps(x); };
+    static V max(V a, V b) { return _mm512_max_ps(a, b); };
+    static V add(V a, V b) { return _mm512_add_ps(a, b); };
+    static V mul(V a, V b) { return _mm512_mul_ps(a, b); };
+    static void store(float *p, V x) { _mm512_storeu_ps(p, x); };
+};
+
+constexpr PcmKernels kAvx512Kernels = makePcmKernels<Avx512Ops>(PcmMeter::Isa::Avx512);
+
+} // namespace
+
+/* ==== Functions ========================================================== */
+const PcmKernels *
+pcmKernelsAvx512()
+{
+    return &kAvx512Kernels;
+}
+
+} // namespace vmx::detail
@@ -0,0 +1,51 @@
+/* ==== Application Includes =============================================== */
+#include "PcmKernels.h"
+
+/* ==== Operating System Includes ========================================== */
+#include <emmintrin.h>
+
+namespace vmx::detail
+{
+
+namespace
+{
+
+/* ==== SSE2 Operations ==================================================== */
+struct Sse2Ops
+{
+    using V = __m128;
+    static constexpr std::size_t kWidth = 4;
+
+    static V zero() { return _mm_setzero_ps(); };
+    static V broadcast(float value) { return _mm_set1_ps(value); };
+    static V load(const float *p) { return _mm_loadu_ps(p); };
+    static V loadInt16(const std::int16_t *p)
+    {
+        __m128i samples = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+        return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16));
+    };
+    // No byte shuffle before SSSE3, so packed 24 bit samples are widened one by one
+    static V loadInt24(const std::uint8_t *p)
+    {
+        return _mm_cvtepi32_ps(_mm_setr_epi32(readInt24(p), readInt24(p + 3), readInt24(p + 6), readInt24(p + 9)));
+    };
+    static V loadInt32(const std::int32_t *p) { return _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))); };
+    static V abs(V x) { return _mm_and_ps(x, _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff))); };
+    static V max(V a, V b) { return _mm_max_ps(a, b); };
+    static V add(V a, V b) { return _mm_add_ps(a, b); };
+    static V mul(V a, V b) { return _mm_mul_ps(a, b); };
+    static void store(float *p, V x) { _mm_storeu_ps(p, x); };
+};
+
+constexpr PcmKernels kSse2Kernels = makePcmKernels<Sse2Ops>(PcmMeter::Isa::Sse2);
+
+} // namespace
+
+/* ==== Functions ========================================================== */
+const PcmKernels *
+pcmKernelsSse2()
+{
+    return &kSse2Kernels;
+}
+
+} // namespace vmx::detail
@@ -0,0 +1,967 @@
+/* ==== Application Includes =============================================== */
+#include <vmx/PipeWireVolumeMixer.h>
+#include "BackendPlugin.h"
+#include "Dispatch.h"
+#include "Instrumentation.h"
+#include "Tracing.h"
+
+/* ==== Standard Library Includes ========================================== */
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+/* ==== Operating System Includes ========================================== */
+#include <spa/param/props.h>
+#include <spa/pod/builder.h>
+#include <spa/pod/iter.h>
+
+/* ==== Macros ============================================================= */
+// The DispatchScope comes first so that synchronous observer calls wait for the lock's release
+#define LOCK_GUARD(mutex_var)                                                           \
+    const detail::DispatchScope dispatchScope;                                          \
+    const detail::LockGuard<decltype(mutex_var)> lock(mutex_var)
+
+#define LOOP_LOCK(pLoop)                                                                \
+    const detail::DispatchScope loopDispatchScope;                                      \
+    const PipeWireLoopLock loopLock(pLoop)
+
+#define CHECK_RESULT(res)                                                                                   \
+    do                                                                                                      \
+    {                                                                                                       \
+        int checkedResult = (res);                                                                          \
+        vmx::detail::countBackendCall(checkedResult >= 0);                                                  \
+        if (checkedResult < 0)                                                                              \
+        {                                                                                                   \
+            throw std::runtime_error(std::string("Error encountered at " __FILE__ ":") +                    \
+                std::to_string(__LINE__) + " " + std::strerror(-checkedResult));                            \
+        }                                                                                                   \
+    } while (false)
+
+/* ==== Forward Declarations =============================================== */
+static std::string lookupOr(const spa_dict *pDict, const char *key, const std::string &fallback);
+static std::string defaultNameFromJson(const char *json);
+static float toCubicVolume(const std::vector<float> &channelVolumes);
+static std::vector<float> scaleChannelVolumes(std::vector<float> channelVolumes, float volume);
+static std::vector<float> toCubicChannelVolumes(std::vector<float> channelVolumes);
+static std::vector<float> fromCubicChannelVolumes(std::vector<float> channelVolumes, std::size_t channelCount);
+
+/* ==== Constants ========================================================== */
+static constexpr std::uint32_t kMaxChannels = 64;
+
+namespace vmx
+{
+
+/* ==== PipeWireNodeProxy Class ============================================ */
+PipeWireNodeProxy::PipeWireNodeProxy
+(
+    pw_registry *pRegistry,
+    std::uint32_t nodeId,
+    Listener &listener
+)
+  : m_listener(listener)
+{
+    static const pw_node_events nodeEvents = []{
+        pw_node_events events = {};
+        events.version = PW_VERSION_NODE_EVENTS;
+        events.info = &PipeWireNodeProxy::infoCallback;
+        events.param = &PipeWireNodeProxy::paramCallback;
+        return events;
+    }();
+
+    m_pNode = static_cast<pw_node*>(pw_registry_bind(pRegistry, nodeId, PW_TYPE_INTERFACE_Node, PW_VERSION_NODE, 0));
+    detail::countBackendCall(m_pNode != nullptr);
+    if (!m_pNode) return;
+
+    pw_node_add_listener(m_pNode, &m_nodeListener, &nodeEvents, this);
+    std::uint32_t params[] = { SPA_PARAM_Props };
+    pw_node_subscribe_params(m_pNode, params, 1);
+}
+
+PipeWireNodeProxy::~PipeWireNodeProxy()
+{
+    release();
+}
+
+int
+PipeWireNodeProxy::setChannelVolumes
+(
+    const std::vector<float> &channelVolumes
+)
+{
+    if (!m_pNode) return -ENOENT;
+
+    std::uint8_t buffer[1024];
+    spa_pod_builder builder;
+    spa_pod_builder_init(&builder, buffer, sizeof(buffer));
+    spa_pod_frame frame;
+    spa_pod_builder_push_object(&builder, &frame, SPA_TYPE_OBJECT_Props, SPA_PARAM_Props);
+    spa_pod_builder_prop(&builder, SPA_PROP_channelVolumes, 0);
+    spa_pod_builder_array(&builder, sizeof(float), SPA_TYPE_Float, static_cast<std::uint32_t>(channelVolumes.size()), channelVolumes.data());
+    auto *pParam = static_cast<spa_pod*>(spa_pod_builder_pop(&builder, &frame));
+    return pw_node_set_param(m_pNode, SPA_PARAM_Props, 0, pParam);
+}
+
+int
+PipeWireNodeProxy::setMute
+(
+    bool bMute
+)
+{
+    if (!m_pNode) return -ENOENT;
+
+    std::uint8_t buffer[128];
+    spa_pod_builder builder;
+    spa_pod_builder_init(&builder, buffer, sizeof(buffer));
+    spa_pod_frame frame;
+    spa_pod_builder_push_object(&builder, &frame, SPA_TYPE_OBJECT_Props, SPA_PARAM_Props);
+    spa_pod_builder_prop(&builder, SPA_PROP_mute, 0);
+    spa_pod_builder_bool(&builder, bMute);
+    auto *pParam = static_cast<spa_pod*>(spa_pod_builder_pop(&builder, &frame));
+    return pw_node_set_param(m_pNode, SPA_PARAM_Props, 0, pParam);
+}
+
+void
+PipeWireNodeProxy::release()
+{
+    if (m_pNode)
+    {
+        spa_hook_remove(&m_nodeListener);
+        pw_proxy_destroy(reinterpret_cast<pw_proxy*>(m_pNode));
+        m_pNode = nullptr;
+    }
+}
+
+void
+PipeWireNodeProxy::infoCallback
+(
+    void *pUserData,
+    const pw_node_info *pInfo
+)
+{
+    VMX_TRACE_THREAD_NAME("pipewire loop");
+    VMX_TRACE_SCOPE("PipeWireNodeProxy::infoCallback", "backend");
+    static_cast<PipeWireNodeProxy*>(pUserData)->m_listener.onNodeInfo(*pInfo);
+}
+
+void
+PipeWireNodeProxy::paramCallback
+(
+    void *pUserData,
+    int,
+    std::uint32_t id,
+    std::uint32_t,
+    std::uint32_t,
+    const spa_pod *pParam
+)
+{
+    VMX_TRACE_THREAD_NAME("pipewire loop");
+    VMX_TRACE_SCOPE("PipeWireNodeProxy::paramCallback", "backend");
+    if (id != SPA_PARAM_Props || !pParam || !spa_pod_is_object_type(pParam, SPA_TYPE_OBJECT_Props)) return;
+
+    std::optional<std::vector<float>> channelVolumes;
+    std::optional<bool> bMuted;
+    const auto *pObject = reinterpret_cast<const spa_pod_object*>(pParam);
+    const spa_pod_prop *pProp;
+    SPA_POD_OBJECT_FOREACH(pObject, pProp)
+    {
+        switch (pProp->key)
+        {
+            case SPA_PROP_channelVolumes:
+            {
+                float values[kMaxChannels];
+                std::uint32_t count = spa_pod_copy_array(&pProp->value, SPA_TYPE_Float, values, kMaxChannels);
+                if (count > 0)
+                {
+                    channelVolumes.emplace(values, values + count);
+                }
+                break;
+            }
+            case SPA_PROP_mute:
+            {
+                bool bValue = false;
+                if (spa_pod_get_bool(&pProp->value, &bValue) >= 0)
+                {
+                    bMuted = bValue;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    if (channelVolumes || bMuted)
+    {
+        static_cast<PipeWireNodeProxy*>(pUserData)->m_listener.onNodeProps(std::move(channelVolumes), bMuted);
+    }
+}
+
+/* ==== PipeWireAudioSession Class ========================================= */
+PipeWireAudioSession::PipeWireAudioSession
+(
+    PipeWireVolumeMixer &volumeMixer,
+    std::uint32_t nodeId
+)
+  : m_volumeMixer(volumeMixer),
+    m_id(std::to_string(nodeId)),
+    m_node(volumeMixer.m_pRegistry, nodeId, *this)
+{
+}
+
+void
+PipeWireAudioSession::changeVolume
+(
+    float volume
+)
+{
+    VMX_TRACE_SCOPE("PipeWireAudioSession::changeVolume", "control");
+    std::vector<float> channelVolumes;
+    {
+        LOCK_GUARD(m_mutex);
+        m_channelVolumes = scaleChannelVolumes(m_channelVolumes, volume);
+        channelVolumes = m_channelVolumes;
+    }
+
+    // Never hold m_mutex while taking the loop lock, the loop thread takes them the other way around
+    {
+        LOOP_LOCK(m_volumeMixer.m_pLoop);
+        CHECK_RESULT(m_node.setChannelVolumes(channelVolumes));
+    }
+    updateVolume(toCubicVolume(channelVolumes));
+    updateChannelVolumes(toCubicChannelVolumes(channelVolumes));
+}
+
+void
+PipeWireAudioSession::changeChannelVolumes
+(
+    std::vector<float> channelVolumes
+)
+{
+    VMX_TRACE_SCOPE("PipeWireAudioSession::changeChannelVolumes", "control");
+    {
+        LOCK_GUARD(m_mutex);
+        m_channelVolumes = fromCubicChannelVolumes(std::move(channelVolumes), m_channelVolumes.size());
+        channelVolumes = m_channelVolumes;
+    }
+
+    {
+        LOOP_LOCK(m_volumeMixer.m_pLoop);
+        CHECK_RESULT(m_node.setChannelVolumes(channelVolumes));
+    }
+    updateVolume(toCubicVolume(channelVolumes));
+    updateChannelVolumes(toCubicChannelVolumes(channelVolumes));
+}
+
+void
+PipeWireAudioSession::changeMute
+(
+    bool bMute
+)
+{
+    VMX_TRACE_SCOPE("PipeWireAudioSession::changeMute", "control");
+    {
+        LOOP_LOCK(m_volumeMixer.m_pLoop);
+        CHECK_RESULT(m_node.setMute(bMute));
+    }
+    updateMute(bMute);
+}
+
+void
+PipeWireAudioSession::onNodeInfo
+(
+    const pw_node_info &info
+)
+{
+    if (info.change_mask & PW_NODE_CHANGE_MASK_PROPS)
+    {
+        std::string name = lookupOr(info.props, PW_KEY_NODE_DESCRIPTION, m_id);
+        name = lookupOr(info.props, PW_KEY_MEDIA_NAME, name);
+        updateName(lookupOr(info.props, PW_KEY_APP_NAME, name));
+        updateIconPath(lookupOr(info.props, PW_KEY_APP_ICON_NAME, ""));
+    }
+    if (info.change_mask & PW_NODE_CHANGE_MASK_STATE)
+    {
+        updateState(info.state == PW_NODE_STATE_RUNNING ? State::Active : State::Inactive);
+    }
+}
+
+void
+PipeWireAudioSession::onNodeProps
+(
+    std::optional<std::vector<float>> channelVolumes,
+    std::optional<bool> bMuted
+)
+{
+    if (channelVolumes)
+    {
+        {
+            LOCK_GUARD(m_mutex);
+            m_channelVolumes = *channelVolumes;
+        }
+        updateVolume(toCubicVolume(*channelVolumes));
+        updateChannelVolumes(toCubicChannelVolumes(std::move(*channelVolumes)));
+    }
+    if (bMuted)
+    {
+        updateMute(*bMuted);
+    }
+}
+
+/* ==== PipeWireAudioDevice Class ========================================== */
+PipeWireAudioDevice::PipeWireAudioDevice
+(
+    PipeWireVolumeMixer &volumeMixer,
+    std::uint32_t nodeId,
+    const std::string &nodeName,
+    bool bDefaultDevice
+)
+  : m_volumeMixer(volumeMixer),
+    m_id(nodeName),
+    m_node(volumeMixer.m_pRegistry, nodeId, *this)
+{
+    updateName(nodeName);
+    updateDefault(bDefaultDevice);
+}
+
+void
+PipeWireAudioDevice::changeVolume
+(
+    float volume
+)
+{
+    VMX_TRACE_SCOPE("PipeWireAudioDevice::changeVolume", "control");
+    std::vector<float> channelVolumes;
+    {
+        LOCK_GUARD(m_mutex);
+        m_channelVolumes = scaleChannelVolumes(m_channelVolumes, volume);
+        channelVolumes = m_channelVolumes;
+    }
+
+    {
+        LOOP_LOCK(m_volumeMixer.m_pLoop);
+        CHECK_RESULT(m_node.setChannelVolumes(channelVolumes));
+    }
+    updateVolume(toCubicVolume(channelVolumes));
+    updateChannelVolumes(toCubicChannelVolumes(channelVolumes));
+}
+
+void
+PipeWireAudioDevice::changeChannelVolumes
+(
+    std::vector<float> channelVolumes
+)
+{
+    VMX_TRACE_SCOPE("PipeWireAudioDevice::changeChannelVolumes", "control");
+    {
+        LOCK_GUARD(m_mutex);
+        m_channelVolumes = fromCubicChannelVolumes(std::move(channelVolumes), m_channelVolumes.size());
+        channelVolumes = m_channelVolumes;
+    }
+
+    {
+        LOOP_LOCK(m_volumeMixer.m_pLoop);
+        CHECK_RESULT(m_node.setChannelVolumes(channelVolumes));
+    }
+    updateVolume(toCubicVolume(channelVolumes));
+    updateChannelVolumes(toCubicChannelVolumes(channelVolumes));
+}
+
+void
+PipeWireAudioDevice::changeMute
+(
+    bool bMute
+)
+{
+    VMX_TRACE_SCOPE("PipeWireAudioDevice::changeMute", "control");
+    {
+        LOOP_LOCK(m_volumeMixer.m_pLoop);
+        CHECK_RESULT(m_node.setMute(bMute));
+    }
+    updateMute(bMute);
+}
+
+void
+PipeWireAudioDevice::attachSession
+(
+    std::shared_ptr<PipeWireAudioSession> pPipeWireAudioSession
+)
+{
+    LOCK_GUARD(m_mutex);
+    m_audioSessionsMirror[pPipeWireAudioSession->getId()] = pPipeWireAudioSession;
+    addSession(pPipeWireAudioSession->getId(), pPipeWireAudioSession);
+}
+
+void
+PipeWireAudioDevice::detachSession
+(
+    const std::string &audioSessionId
+)
+{
+    LOCK_GUARD(m_mutex);
+    m_audioSessionsMirror.erase(audioSessionId);
+    removeSession(audioSessionId);
+}
+
+void
+PipeWireAudioDevice::onNodeInfo
+(
+    const pw_node_info &info
+)
+{
+    if (info.change_mask & PW_NODE_CHANGE_MASK_PROPS)
+    {
+        updateName(lookupOr(info.props, PW_KEY_NODE_DESCRIPTION, m_id));
+        updateIconPath(lookupOr(info.props, PW_KEY_DEVICE_ICON_NAME, ""));
+    }
+    if (info.change_mask & PW_NODE_CHANGE_MASK_STATE)
+    {
+        updateState(info.state == PW_NODE_STATE_ERROR ? State::Unknown : State::Active);
+    }
+}
+
+void
+PipeWireAudioDevice::onNodeProps
+(
+    std::optional<std::vector<float>> channelVolumes,
+    std::optional<bool> bMuted
+)
+{
+    if (channelVolumes)
+    {
+        {
+            LOCK_GUARD(m_mutex);
+            m_channelVolumes = *channelVolumes;
+        }
+        updateVolume(toCubicVolume(*channelVolumes));
+        updateChannelVolumes(toCubicChannelVolumes(std::move(*channelVolumes)));
+    }
+    if (bMuted)
+    {
+        updateMute(*bMuted);
+    }
+}
+
+/* ==== PipeWireVolumeMixer Class ========================================== */
+PipeWireVolumeMixer::PipeWireVolumeMixer
+(
+    const std::string &remoteName
+)
+{
+    static const pw_core_events coreEvents = []{
+        pw_core_events events = {};
+        events.version = PW_VERSION_CORE_EVENTS;
+        events.done = &PipeWireVolumeMixer::coreDoneCallback;
+        events.error = &PipeWireVolumeMixer::coreErrorCallback;
+        return events;
+    }();
+    static const pw_registry_events registryEvents = []{
+        pw_registry_events events = {};
+        events.version = PW_VERSION_REGISTRY_EVENTS;
+        events.global = &PipeWireVolumeMixer::registryGlobalCallback;
+        events.global_remove = &PipeWireVolumeMixer::registryGlobalRemoveCallback;
+        return events;
+    }();
+
+    pw_init(nullptr, nullptr);
+    try
+    {
+        m_pLoop = pw_thread_loop_new("vmx", nullptr);
+        if (!m_pLoop)
+        {
+            throw std::runtime_error("Unable to create a PipeWire thread loop");
+        }
+        m_pContext = pw_context_new(pw_thread_loop_get_loop(m_pLoop), nullptr, 0);
+        if (!m_pContext)
+        {
+            throw std::runtime_error("Unable to create a PipeWire context");
+        }
+        if (pw_thread_loop_start(m_pLoop) < 0)
+        {
+            throw std::runtime_error("Unable to start the PipeWire thread loop");
+        }
+
+        LOOP_LOCK(m_pLoop);
+        pw_properties *pProperties = remoteName.empty() ? nullptr : pw_properties_new(PW_KEY_REMOTE_NAME, remoteName.c_str(), nullptr);
+        m_pCore = pw_context_connect(m_pContext, pProperties, 0);
+        if (!m_pCore)
+        {
+            throw std::runtime_error(std::string("Unable to connect to PipeWire: ") + std::strerror(errno));
+        }
+        pw_core_add_listener(m_pCore, &m_coreListener, &coreEvents, this);
+
+        m_pRegistry = pw_core_get_registry(m_pCore, PW_VERSION_REGISTRY, 0);
+        if (!m_pRegistry)
+        {
+            throw std::runtime_error("Unable to get the PipeWire registry");
+        }
+        pw_registry_add_listener(m_pRegistry, &m_registryListener, &registryEvents, this);
+
+        // The first roundtrip delivers the globals, the second the info and
+        // Props of the nodes bound while handling them, so the whole tree is
+        // populated before returning, the same as the other backends.
+        roundtrip();
+        roundtrip();
+    }
+    catch (...)
+    {
+        teardown();
+        throw;
+    }
+}
+
+PipeWireVolumeMixer::~PipeWireVolumeMixer()
+{
+    teardown();
+}
+
+void
+PipeWireVolumeMixer::setPeakSamplingPeriod
+(
+    std::chrono::milliseconds
+)
+{
+    // Metering would need a monitor capture stream per node; not implemented
+    // for this backend yet, so no onPeakSample events are produced.
+}
+
+void
+PipeWireVolumeMixer::registryGlobalCallback
+(
+    void *pUserData,
+    std::uint32_t id,
+    std::uint32_t,
+    const char *type,
+    std::uint32_t,
+    const spa_dict *pProps
+)
+{
+    VMX_TRACE_THREAD_NAME("pipewire loop");
+    VMX_TRACE_SCOPE("PipeWireVolumeMixer::registryGlobalCallback", "backend");
+    auto *pThis = static_cast<PipeWireVolumeMixer*>(pUserData);
+    if (!pProps) return;
+
+    if (std::strcmp(type, PW_TYPE_INTERFACE_Node) == 0)
+    {
+        std::string mediaClass = lookupOr(pProps, PW_KEY_MEDIA_CLASS, "");
+        if (mediaClass == "Audio/Sink")
+        {
+            pThis->addSink(id, lookupOr(pProps, PW_KEY_NODE_NAME, std::to_string(id)));
+        }
+        else if (mediaClass == "Stream/Output/Audio")
+        {
+            pThis->addStream(id);
+        }
+    }
+    else if (std::strcmp(type, PW_TYPE_INTERFACE_Link) == 0)
+    {
+        const char *outputNode = spa_dict_lookup(pProps, PW_KEY_LINK_OUTPUT_NODE);
+        const char *inputNode = spa_dict_lookup(pProps, PW_KEY_LINK_INPUT_NODE);
+        if (outputNode && inputNode)
+        {
+            auto outputNodeId = static_cast<std::uint32_t>(std::strtoul(outputNode, nullptr, 10));
+            auto inputNodeId = static_cast<std::uint32_t>(std::strtoul(inputNode, nullptr, 10));
+            pThis->addLink(id, outputNodeId, inputNodeId);
+        }
+    }
+    else if (std::strcmp(type, PW_TYPE_INTERFACE_Metadata) == 0)
+    {
+        if (pThis->m_pMetadata || lookupOr(pProps, "metadata.name", "") != "default") return;
+
+        static const pw_metadata_events metadataEvents = []{
+            pw_metadata_events events = {};
+            events.version = PW_VERSION_METADATA_EVENTS;
+            events.property = &PipeWireVolumeMixer::metadataPropertyCallback;
+            return events;
+        }();
+        pThis->m_pMetadata = static_cast<pw_metadata*>(pw_registry_bind(pThis->m_pRegistry, id, PW_TYPE_INTERFACE_Metadata, PW_VERSION_METADATA, 0));
+        detail::countBackendCall(pThis->m_pMetadata != nullptr);
+        if (pThis->m_pMetadata)
+        {
+            pw_metadata_add_listener(pThis->m_pMetadata, &pThis->m_metadataListener, &metadataEvents, pThis);
+        }
+    }
+}
+
+void
+PipeWireVolumeMixer::registryGlobalRemoveCallback
+(
+    void *pUserData,
+    std::uint32_t id
+)
+{
+    VMX_TRACE_THREAD_NAME("pipewire loop");
+    VMX_TRACE_SCOPE("PipeWireVolumeMixer::registryGlobalRemoveCallback", "backend");
+    static_cast<PipeWireVolumeMixer*>(pUserData)->removeGlobal(id);
+}
+
+void
+PipeWireVolumeMixer::coreDoneCallback
+(
+    void *pUserData,
+    std::uint32_t id,
+    int seq
+)
+{
+    auto *pThis = static_cast<PipeWireVolumeMixer*>(pUserData);
+    if (id != PW_ID_CORE) return;
+    pThis->m_doneSeq = seq;
+    pw_thread_loop_signal(pThis->m_pLoop, false);
+}
+
+void
+PipeWireVolumeMixer::coreErrorCallback
+(
+    void *pUserData,
+    std::uint32_t id,
+    int,
+    int res,
+    const char *
+)
+{
+    VMX_TRACE_SCOPE("PipeWireVolumeMixer::coreErrorCallback", "backend");
+    auto *pThis = static_cast<PipeWireVolumeMixer*>(pUserData);
+    if (id != PW_ID_CORE || res != -EPIPE) return;
+
+    pThis->m_bConnectionLost = true;
+    {
+        LOCK_GUARD(pThis->m_mutex);
+        for (auto &entry : pThis->m_audioDevicesMirror)
+        {
+            entry.second->updateState(AudioDevice::State::NotPresent);
+        }
+    }
+    pw_thread_loop_signal(pThis->m_pLoop, false);
+}
+
+int
+PipeWireVolumeMixer::metadataPropertyCallback
+(
+    void *pUserData,
+    std::uint32_t subject,
+    const char *key,
+    const char *,
+    const char *value
+)
+{
+    VMX_TRACE_SCOPE("PipeWireVolumeMixer::metadataPropertyCallback", "backend");
+    auto *pThis = static_cast<PipeWireVolumeMixer*>(pUserData);
+    if (subject != PW_ID_CORE) return 0;
+
+    // A null key means every property was cleared
+    if (!key || std::strcmp(key, "default.audio.sink") == 0)
+    {
+        LOCK_GUARD(pThis->m_mutex);
+        pThis->m_defaultSinkName = (key && value) ? defaultNameFromJson(value) : "";
+        pThis->applyDefaultSink();
+    }
+    return 0;
+}
+
+void
+PipeWireVolumeMixer::addSink
+(
+    std::uint32_t nodeId,
+    const std::string &nodeName
+)
+{
+    LOCK_GUARD(m_mutex);
+    auto pPipeWireAudioDevice = std::make_shared<PipeWireAudioDevice>(*this, nodeId, nodeName, nodeName == m_defaultSinkName);
+    m_audioDevicesMirror[nodeId] = pPipeWireAudioDevice;
+    addDevice(pPipeWireAudioDevice->getId(), pPipeWireAudioDevice);
+
+    // Links can be announced before the nodes they connect
+    for (auto &entry : m_links)
+    {
+        if (entry.second.second == nodeId && m_streams.contains(entry.second.first))
+        {
+            relinkStream(entry.second.first);
+        }
+    }
+}
+
+void
+PipeWireVolumeMixer::addStream
+(
+    std::uint32_t nodeId
+)
+{
+    LOCK_GUARD(m_mutex);
+    m_streams[nodeId] = std::make_shared<PipeWireAudioSession>(*this, nodeId);
+    relinkStream(nodeId);
+}
+
+void
+PipeWireVolumeMixer::addLink
+(
+    std::uint32_t linkId,
+    std::uint32_t outputNodeId,
+    std::uint32_t inputNodeId
+)
+{
+    LOCK_GUARD(m_mutex);
+    m_links[linkId] = { outputNodeId, inputNodeId };
+    if (m_streams.contains(outputNodeId))
+    {
+        relinkStream(outputNodeId);
+    }
+}
+
+void
+PipeWireVolumeMixer::removeGlobal
+(
+    std::uint32_t id
+)
+{
+    LOCK_GUARD(m_mutex);
+
+    if (auto link = m_links.find(id); link != m_links.end())
+    {
+        std::uint32_t outputNodeId = link->second.first;
+        m_links.erase(link);
+        if (m_streams.contains(outputNodeId))
+        {
+            relinkStream(outputNodeId);
+        }
+        return;
+    }
+
+    if (auto stream = m_streams.find(id); stream != m_streams.end())
+    {
+        auto pPipeWireAudioSession = stream->second;
+        pPipeWireAudioSession->updateState(AudioSession::State::Expired);
+        if (auto sink = m_streamSinks.find(id); sink != m_streamSinks.end())
+        {
+            m_audioDevicesMirror[sink->second]->detachSession(pPipeWireAudioSession->getId());
+            m_streamSinks.erase(sink);
+        }
+        pPipeWireAudioSession->m_node.release();
+        m_streams.erase(stream);
+        return;
+    }
+
+    if (auto device = m_audioDevicesMirror.find(id); device != m_audioDevicesMirror.end())
+    {
+        auto pPipeWireAudioDevice = device->second;
+        std::erase_if(m_streamSinks, [id](const auto &entry) { return entry.second == id; });
+        pPipeWireAudioDevice->m_node.release();
+        m_audioDevicesMirror.erase(device);
+        removeDevice(pPipeWireAudioDevice->getId());
+    }
+}
+
+void
+PipeWireVolumeMixer::relinkStream
+(
+    std::uint32_t streamNodeId
+)
+{
+    // Each channel has its own link, any one that ends on a known sink decides
+    std::uint32_t sinkNodeId = PW_ID_ANY;
+    for (auto &entry : m_links)
+    {
+        if (entry.second.first == streamNodeId && m_audioDevicesMirror.contains(entry.second.second))
+        {
+            sinkNodeId = entry.second.second;
+            break;
+        }
+    }
+
+    auto current = m_streamSinks.find(streamNodeId);
+    std::uint32_t currentSinkNodeId = (current == m_streamSinks.end()) ? PW_ID_ANY : current->second;
+    if (sinkNodeId == currentSinkNodeId) return;
+
+    auto pPipeWireAudioSession = m_streams[streamNodeId];
+    if (currentSinkNodeId != PW_ID_ANY)
+    {
+        m_audioDevicesMirror[currentSinkNodeId]->detachSession(pPipeWireAudioSession->getId());
+        m_streamSinks.erase(streamNodeId);
+    }
+    if (sinkNodeId != PW_ID_ANY)
+    {
+        m_audioDevicesMirror[sinkNodeId]->attachSession(pPipeWireAudioSession);
+        m_streamSinks[streamNodeId] = sinkNodeId;
+    }
+}
+
+void
+PipeWireVolumeMixer::applyDefaultSink()
+{
+    for (auto &entry : m_audioDevicesMirror)
+    {
+        entry.second->updateDefault(entry.second->getId() == m_defaultSinkName);
+    }
+}
+
+void
+PipeWireVolumeMixer::roundtrip()
+{
+    m_pendingSeq = pw_core_sync(m_pCore, PW_ID_CORE, m_pendingSeq);
+    while (m_doneSeq != m_pendingSeq)
+    {
+        if (m_bConnectionLost)
+        {
+            throw std::runtime_error("PipeWire connection lost");
+        }
+        pw_thread_loop_wait(m_pLoop);
+    }
+}
+
+void
+PipeWireVolumeMixer::teardown()
+{
+    // Once the loop thread is stopped nothing else touches PipeWire, no locking needed
+    if (m_pLoop)
+    {
+        pw_thread_loop_stop(m_pLoop);
+    }
+
+    {
+        LOCK_GUARD(m_mutex);
+        for (auto &entry : m_streams)
+        {
+            entry.second->m_node.release();
+        }
+        for (auto &entry : m_audioDevicesMirror)
+        {
+            entry.second->m_node.release();
+        }
+    }
+
+    if (m_pMetadata)
+    {
+        spa_hook_remove(&m_metadataListener);
+        pw_proxy_destroy(reinterpret_cast<pw_proxy*>(m_pMetadata));
+        m_pMetadata = nullptr;
+    }
+    if (m_pRegistry)
+    {
+        spa_hook_remove(&m_registryListener);
+        pw_proxy_destroy(reinterpret_cast<pw_proxy*>(m_pRegistry));
+        m_pRegistry = nullptr;
+    }
+    if (m_pCore)
+    {
+        spa_hook_remove(&m_coreListener);
+        pw_core_disconnect(m_pCore);
+        m_pCore = nullptr;
+    }
+    if (m_pContext)
+    {
+        pw_context_destroy(m_pContext);
+        m_pContext = nullptr;
+    }
+    if (m_pLoop)
+    {
+        pw_thread_loop_destroy(m_pLoop);
+        m_pLoop = nullptr;
+    }
+}
+
+} // namespace vmx
+
+/* ==== Static Helper Functions ============================================ */
+static std::string
+lookupOr
+(
+    const spa_dict *pDict,
+    const char *key,
+    const std::string &fallback
+)
+{
+    const char *value = pDict ? spa_dict_lookup(pDict, key) : nullptr;
+    return (value && *value) ? value : fallback;
+}
+
+static std::string
+defaultNameFromJson
+(
+    const char *json
+)
+{
+    // The value is always {"name":"<node.name>"}, not worth a JSON parser
+    const char *name = std::strstr(json, "\"name\"");
+    if (!name) return "";
+    const char *begin = std::strchr(name + 6, '"');
+    if (!begin) return "";
+    const char *end = std::strchr(begin + 1, '"');
+    if (!end) return "";
+    return std::string(begin + 1, end);
+}
+
+static float
+toCubicVolume
+(
+    const std::vector<float> &channelVolumes
+)
+{
+    // The loudest channel is the master volume, the others keep their balance relative to it
+    if (channelVolumes.empty()) return 0.0f;
+    float loudest = *std::max_element(channelVolumes.begin(), channelVolumes.end());
+    return std::min(1.0f, std::cbrt(loudest));
+}
+
+static std::vector<float>
+scaleChannelVolumes
+(
+    std::vector<float> channelVolumes,
+    float volume
+)
+{
+    volume = std::min(1.0f, volume);
+    volume = std::max(0.0f, volume);
+    float target = volume * volume * volume;
+    if (channelVolumes.empty())
+    {
+        channelVolumes.push_back(target);
+        return channelVolumes;
+    }
+
+    float loudest = *std::max_element(channelVolumes.begin(), channelVolumes.end());
+    for (auto &channelVolume : channelVolumes)
+    {
+        channelVolume = (loudest > 0.0f) ? channelVolume * target / loudest : target;
+    }
+    return channelVolumes;
+}
+
+// SPA_PROP_channelVolumes are linear, the library's channel volumes are on the cubic volume scale
+static std::vector<float>
+toCubicChannelVolumes
+(
+    std::vector<float> channelVolumes
+)
+{
+    for (auto &channelVolume : channelVolumes)
+    {
+        channelVolume = std::min(1.0f, std::cbrt(std::max(0.0f, channelVolume)));
+    }
+    return channelVolumes;
+}
+
+static std::vector<float>
+fromCubicChannelVolumes
+(
+    std::vector<float> channelVolumes,
+    std::size_t channelCount
+)
+{
+    if (channelVolumes.size() != channelCount)
+    {
+        throw std::runtime_error("Expected " + std::to_string(channelCount) + " channel volumes, got " + std::to_string(channelVolumes.size()));
+    }
+    for (auto &channelVolume : channelVolumes)
+    {
+        float volume = std::max(0.0f, std::min(1.0f, channelVolume));
+        channelVolume = volume * volume * volume;
+    }
+    return channelVolumes;
+}
+
+#if VMX_BACKEND_PLUGIN
+/* ==== Plugin Entry Point ================================================= */
+VMX_DEFINE_BACKEND_PLUGIN("pipewire", vmx::PipeWireVolumeMixer)
+#endif
@@ -0,0 +1,1060 @@
+/* ==== Application Includes =============================================== */
+#include <vmx/PulseVolumeMixer.h>
+#include "BackendPlugin.h"
+#include "Dispatch.h"
+#include "Instrumentation.h"
+#include "Tracing.h"
+
+/* ==== Standard Library Includes ========================================== */
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/* ==== Macros ============================================================= */
+// The DispatchScope comes first so that synchronous observer calls wait for the lock's release
+#define LOCK_GUARD(mutex_var)                                                           \
+    const detail::DispatchScope dispatchScope;                                          \
+    const detail::LockGuard<decltype(mutex_var)> lock(mutex_var)
+
+#define MAINLOOP_LOCK(pMainloop)                                                        \
+    const detail::DispatchScope mainloopDispatchScope;                                  \
+    const PulseMainloopLock mainloopLock(pMainloop)
+
+// Only for the control path; mainloop callbacks must never throw into libpulse
+#define CHECK_OPERATION(pContext, pOperation)                                                               \
+    do                                                                                                      \
+    {                                                                                                       \
+        pa_operation *pCheckedOperation = (pOperation);                                                     \
+        vmx::detail::countBackendCall(pCheckedOperation != nullptr);                                        \
+        if (!pCheckedOperation)                                                                             \
+        {                                                                                                   \
+            throw pulseError((pContext), __FILE__ ":" + std::to_string(__LINE__));                          \
+        }                                                                                                   \
+        pa_operation_unref(pCheckedOperation);                                                              \
+    } while (false)
+
+/* ==== Forward Declarations =============================================== */
+static std::runtime_error pulseError(pa_context *pContext, const std::string &what);
+static std::string propertyOr(pa_proplist *pProperties, const char *key, const char *fallback);
+static float toLinearVolume(const pa_cvolume &volume);
+static pa_cvolume scaleVolume(pa_cvolume volume, float linearVolume);
+static std::vector<float> toChannelVolumes(const pa_cvolume &volume);
+static pa_cvolume fromChannelVolumes(const std::vector<float> &channelVolumes, std::uint8_t channelCount);
+static vmx::AudioDevice::State toDeviceState(pa_sink_state_t state);
+
+namespace vmx
+{
+
+/* ==== PulseMonitorStream Class =========================================== */
+PulseMonitorStream::PulseMonitorStream
+(
+    pa_context *pContext,
+    const std::string &monitorSourceName,
+    std::uint32_t sinkInputIndex
+)
+{
+    // One float per fragment at 50Hz is plenty for any sensible sampling period
+    const pa_sample_spec sampleSpec = { PA_SAMPLE_FLOAT32NE, 50, 1 };
+    m_pStream = pa_stream_new(pContext, "vmx peak meter", &sampleSpec, nullptr);
+    detail::countBackendCall(m_pStream != nullptr);
+    if (!m_pStream) return; // metering is best effort, the session itself is still usable
+
+    if (sinkInputIndex != PA_INVALID_INDEX)
+    {
+        pa_stream_set_monitor_stream(m_pStream, sinkInputIndex);
+    }
+    pa_stream_set_read_callback(m_pStream, &PulseMonitorStream::readCallback, this);
+
+    pa_buffer_attr bufferAttr = {};
+    bufferAttr.maxlength = static_cast<std::uint32_t>(-1);
+    bufferAttr.fragsize = sizeof(float);
+    auto flags = static_cast<pa_stream_flags_t>(PA_STREAM_DONT_MOVE | PA_STREAM_PEAK_DETECT | PA_STREAM_ADJUST_LATENCY);
+    int result = pa_stream_connect_record(m_pStream, monitorSourceName.c_str(), &bufferAttr, flags);
+    detail::countBackendCall(result >= 0);
+    if (result < 0)
+    {
+        pa_stream_unref(m_pStream);
+        m_pStream = nullptr;
+    }
+}
+
+PulseMonitorStream::~PulseMonitorStream()
+{
+    if (m_pStream)
+    {
+        pa_stream_set_read_callback(m_pStream, nullptr, nullptr);
+        pa_stream_disconnect(m_pStream);
+        pa_stream_unref(m_pStream);
+        m_pStream = nullptr;
+    }
+}
+
+float
+PulseMonitorStream::takePeak()
+{
+    return m_peak.exchange(0.0f, std::memory_order_relaxed);
+}
+
+void
+PulseMonitorStream::readCallback
+(
+    pa_stream *pStream,
+    size_t,
+    void *pUserData
+)
+{
+    auto *pThis = static_cast<PulseMonitorStream*>(pUserData);
+    float peak = 0.0f;
+    while (pa_stream_readable_size(pStream) > 0)
+    {
+        const void *pData = nullptr;
+        size_t length = 0;
+        if (pa_stream_peek(pStream, &pData, &length) < 0 || length == 0) break;
+
+        // A null pointer with a length is a hole in the stream, it still has to be dropped
+        if (pData)
+        {
+            const float *pSamples = static_cast<const float*>(pData);
+            for (size_t i = 0; i < length / sizeof(float); ++i)
+            {
+                peak = std::max(peak, std::fabs(pSamples[i]));
+            }
+        }
+        pa_stream_drop(pStream);
+    }
+
+    float previous = pThis->m_peak.load(std::memory_order_relaxed);
+    while (previous < peak && !pThis->m_peak.compare_exchange_weak(previous, peak, std::memory_order_relaxed))
+    {
+    }
+}
+
+/* ==== PulseAudioSession Class ============================================ */
+PulseAudioSession::PulseAudioSession
+(
+    PulseVolumeMixer &volumeMixer,
+    const PulseSinkInputInfo &info
+)
+  : m_volumeMixer(volumeMixer),
+    m_index(info.index),
+    m_id(std::to_string(info.index))
+{
+    refresh(info);
+}
+
+void
+PulseAudioSession::changeVolume
+(
+    float volume
+)
+{
+    VMX_TRACE_SCOPE("PulseAudioSession::changeVolume", "control");
+    pa_cvolume channelVolumes;
+    {
+        LOCK_GUARD(m_mutex);
+        m_channelVolumes = scaleVolume(m_channelVolumes, volume);
+        channelVolumes = m_channelVolumes;
+    }
+
+    // Never hold m_mutex while taking the mainloop lock, the mainloop thread takes them the other way around
+    {
+        MAINLOOP_LOCK(m_volumeMixer.m_pMainloop);
+        pa_context *pContext = m_volumeMixer.m_pContext;
+        CHECK_OPERATION(pContext, pa_context_set_sink_input_volume(pContext, m_index, &channelVolumes, nullptr, nullptr));
+    }
+    updateVolume(toLinearVolume(channelVolumes));
+    updateChannelVolumes(toChannelVolumes(channelVolumes));
+}
+
+void
+PulseAudioSession::changeChannelVolumes
+(
+    std::vector<float> channelVolumes
+)
+{
+    VMX_TRACE_SCOPE("PulseAudioSession::changeChannelVolumes", "control");
+    pa_cvolume volume;
+    {
+        LOCK_GUARD(m_mutex);
+        m_channelVolumes = fromChannelVolumes(channelVolumes, m_channelVolumes.channels);
+        volume = m_channelVolumes;
+    }
+
+    {
+        MAINLOOP_LOCK(m_volumeMixer.m_pMainloop);
+        pa_context *pContext = m_volumeMixer.m_pContext;
+        CHECK_OPERATION(pContext, pa_context_set_sink_input_volume(pContext, m_index, &volume, nullptr, nullptr));
+    }
+    updateVolume(toLinearVolume(volume));
+    updateChannelVolumes(toChannelVolumes(volume));
+}
+
+void
+PulseAudioSession::changeMute
+(
+    bool bMute
+)
+{
+    VMX_TRACE_SCOPE("PulseAudioSession::changeMute", "control");
+    {
+        MAINLOOP_LOCK(m_volumeMixer.m_pMainloop);
+        pa_context *pContext = m_volumeMixer.m_pContext;
+        CHECK_OPERATION(pContext, pa_context_set_sink_input_mute(pContext, m_index, bMute, nullptr, nullptr));
+    }
+    updateMute(bMute);
+}
+
+void
+PulseAudioSession::refresh
+(
+    const PulseSinkInputInfo &info
+)
+{
+    {
+        LOCK_GUARD(m_mutex);
+        m_sinkIndex = info.sinkIndex;
+        m_channelVolumes = info.volume;
+    }
+
+    // Unchanged values are coalesced by the update*() methods, so pushing everything is cheap
+    updateName(info.name);
+    updateIconPath(info.iconName);
+    updateState(info.bCorked ? State::Inactive : State::Active);
+    updateVolume(toLinearVolume(info.volume));
+    updateChannelVolumes(toChannelVolumes(info.volume));
+    updateMute(info.bMuted);
+}
+
+void
+PulseAudioSession::startMonitoring
+(
+    pa_context *pContext,
+    const std::string &monitorSourceName
+)
+{
+    LOCK_GUARD(m_mutex);
+    m_pMonitorStream = std::make_unique<PulseMonitorStream>(pContext, monitorSourceName, m_index);
+}
+
+void
+PulseAudioSession::stopMonitoring()
+{
+    LOCK_GUARD(m_mutex);
+    m_pMonitorStream.reset();
+}
+
+void
+PulseAudioSession::peakSample()
+{
+    LOCK_GUARD(m_mutex);
+    updatePeakSample(m_pMonitorStream ? m_pMonitorStream->takePeak() : 0.0f);
+}
+
+/* ==== PulseAudioDevice Class ============================================= */
+PulseAudioDevice::PulseAudioDevice
+(
+    PulseVolumeMixer &volumeMixer,
+    const PulseSinkInfo &info,
+    bool bDefaultDevice
+)
+  : m_volumeMixer(volumeMixer),
+    m_index(info.index),
+    m_monitorSourceName(info.monitorSourceName),
+    m_id(info.name)
+{
+    updateDefault(bDefaultDevice);
+    refresh(info);
+}
+
+void
+PulseAudioDevice::changeVolume
+(
+    float volume
+)
+{
+    VMX_TRACE_SCOPE("PulseAudioDevice::changeVolume", "control");
+    pa_cvolume channelVolumes;
+    {
+        LOCK_GUARD(m_mutex);
+        m_channelVolumes = scaleVolume(m_channelVolumes, volume);
+        channelVolumes = m_channelVolumes;
+    }
+
+    {
+        MAINLOOP_LOCK(m_volumeMixer.m_pMainloop);
+        pa_context *pContext = m_volumeMixer.m_pContext;
+        CHECK_OPERATION(pContext, pa_context_set_sink_volume_by_index(pContext, m_index, &channelVolumes, nullptr, nullptr));
+    }
+    updateVolume(toLinearVolume(channelVolumes));
+    updateChannelVolumes(toChannelVolumes(channelVolumes));
+}
+
+void
+PulseAudioDevice::changeChannelVolumes
+(
+    std::vector<float> channelVolumes
+)
+{
+    VMX_TRACE_SCOPE("PulseAudioDevice::changeChannelVolumes", "control");
+    pa_cvolume volume;
+    {
+        LOCK_GUARD(m_mutex);
+        m_channelVolumes = fromChannelVolumes(channelVolumes, m_channelVolumes.channels);
+        volume = m_channelVolumes;
+    }
+
+    {
+        MAINLOOP_LOCK(m_volumeMixer.m_pMainloop);
+        pa_context *pContext = m_volumeMixer.m_pContext;
+        CHECK_OPERATION(pContext, pa_context_set_sink_volume_by_index(pContext, m_index, &volume, nullptr, nullptr));
+    }
+    updateVolume(toLinearVolume(volume));
+    updateChannelVolumes(toChannelVolumes(volume));
+}
+
+void
+PulseAudioDevice::changeMute
+(
+    bool bMute
+)
+{
+    VMX_TRACE_SCOPE("PulseAudioDevice::changeMute", "control");
+    {
+        MAINLOOP_LOCK(m_volumeMixer.m_pMainloop);
+        pa_context *pContext = m_volumeMixer.m_pContext;
+        CHECK_OPERATION(pContext, pa_context_set_sink_mute_by_index(pContext, m_index, bMute, nullptr, nullptr));
+    }
+    updateMute(bMute);
+}
+
+void
+PulseAudioDevice::refresh
+(
+    const PulseSinkInfo &info
+)
+{
+    {
+        LOCK_GUARD(m_mutex);
+        m_channelVolumes = info.volume;
+    }
+
+    updateName(info.description);
+    updateIconPath(info.iconName);
+    updateState(toDeviceState(info.state));
+    updateVolume(toLinearVolume(info.volume));
+    updateChannelVolumes(toChannelVolumes(info.volume));
+    updateMute(info.bMuted);
+}
+
+void
+PulseAudioDevice::attachSession
+(
+    std::shared_ptr<PulseAudioSession> pPulseAudioSession
+)
+{
+    LOCK_GUARD(m_mutex);
+    m_audioSessionsMirror[pPulseAudioSession->m_index] = pPulseAudioSession;
+    addSession(pPulseAudioSession->getId(), pPulseAudioSession);
+}
+
+std::shared_ptr<PulseAudioSession>
+PulseAudioDevice::detachSession
+(
+    std::uint32_t sinkInputIndex
+)
+{
+    LOCK_GUARD(m_mutex);
+    auto it = m_audioSessionsMirror.find(sinkInputIndex);
+    if (it == m_audioSessionsMirror.end()) return nullptr;
+    auto pPulseAudioSession = it->second;
+    m_audioSessionsMirror.erase(it);
+    removeSession(pPulseAudioSession->getId());
+    return pPulseAudioSession;
+}
+
+void
+PulseAudioDevice::startMonitoring
+(
+    pa_context *pContext
+)
+{
+    LOCK_GUARD(m_mutex);
+    m_pMonitorStream = std::make_unique<PulseMonitorStream>(pContext, m_monitorSourceName, PA_INVALID_INDEX);
+    for (auto &entry : m_audioSessionsMirror)
+    {
+        entry.second->startMonitoring(pContext, m_monitorSourceName);
+    }
+}
+
+void
+PulseAudioDevice::stopMonitoring()
+{
+    LOCK_GUARD(m_mutex);
+    m_pMonitorStream.reset();
+    for (auto &entry : m_audioSessionsMirror)
+    {
+        entry.second->stopMonitoring();
+    }
+}
+
+void
+PulseAudioDevice::peakSample()
+{
+    LOCK_GUARD(m_mutex);
+    for (auto &entry : m_audioSessionsMirror)
+    {
+        entry.second->peakSample();
+    }
+    updatePeakSample(m_pMonitorStream ? m_pMonitorStream->takePeak() : 0.0f);
+}
+
+/* ==== PulseVolumeMixer Class ============================================= */
+PulseVolumeMixer::PulseVolumeMixer
+(
+    const std::string &serverAddress
+)
+  : m_peakSamplingTimer([this](){peakSample();}, std::chrono::milliseconds(0))
+{
+    try
+    {
+        m_pMainloop = pa_threaded_mainloop_new();
+        if (!m_pMainloop)
+        {
+            throw std::runtime_error("Unable to create a PulseAudio mainloop");
+        }
+
+        pa_mainloop_api *pApi = pa_threaded_mainloop_get_api(m_pMainloop);
+        m_pContext = pa_context_new(pApi, "vmx");
+        if (!m_pContext)
+        {
+            throw std::runtime_error("Unable to create a PulseAudio context");
+        }
+        pa_context_set_state_callback(m_pContext, &PulseVolumeMixer::contextStateCallback, this);
+        pa_context_set_subscribe_callback(m_pContext, &PulseVolumeMixer::subscribeCallback, this);
+        m_pRefreshEvent = pApi->defer_new(pApi, &PulseVolumeMixer::refreshDeferCallback, this);
+        pApi->defer_enable(m_pRefreshEvent, 0);
+
+        if (pa_threaded_mainloop_start(m_pMainloop) < 0)
+        {
+            throw std::runtime_error("Unable to start the PulseAudio mainloop");
+        }
+
+        MAINLOOP_LOCK(m_pMainloop);
+        const char *pServer = serverAddress.empty() ? nullptr : serverAddress.c_str();
+        if (pa_context_connect(m_pContext, pServer, PA_CONTEXT_NOAUTOSPAWN, nullptr) < 0)
+        {
+            throw pulseError(m_pContext, "Unable to connect to PulseAudio");
+        }
+
+        pa_context_state_t state;
+        while ((state = pa_context_get_state(m_pContext)) != PA_CONTEXT_READY)
+        {
+            if (!PA_CONTEXT_IS_GOOD(state))
+            {
+                throw pulseError(m_pContext, "Unable to connect to PulseAudio");
+            }
+            pa_threaded_mainloop_wait(m_pMainloop);
+        }
+
+        auto mask = static_cast<pa_subscription_mask_t>(PA_SUBSCRIPTION_MASK_SINK | PA_SUBSCRIPTION_MASK_SINK_INPUT | PA_SUBSCRIPTION_MASK_SERVER);
+        CHECK_OPERATION(m_pContext, pa_context_subscribe(m_pContext, mask, nullptr, nullptr));
+
+        // Populate the whole tree before returning, the same as the other backends
+        markStale(true, true, true);
+        while (m_completedRefreshes == 0)
+        {
+            if (!PA_CONTEXT_IS_GOOD(pa_context_get_state(m_pContext)))
+            {
+                throw pulseError(m_pContext, "PulseAudio connection lost");
+            }
+            pa_threaded_mainloop_wait(m_pMainloop);
+        }
+    }
+    catch (...)
+    {
+        teardown();
+        throw;
+    }
+}
+
+PulseVolumeMixer::~PulseVolumeMixer()
+{
+    teardown();
+}
+
+void
+PulseVolumeMixer::setPeakSamplingPeriod
+(
+    std::chrono::milliseconds period
+)
+{
+    // Monitor streams cost server-side work, so only keep them while sampling
+    setMonitoring(period.count() > 0);
+    m_peakSamplingTimer.changePeriod(period);
+}
+
+void
+PulseVolumeMixer::contextStateCallback
+(
+    pa_context *pContext,
+    void *pUserData
+)
+{
+    VMX_TRACE_THREAD_NAME("pulse mainloop");
+    VMX_TRACE_SCOPE("PulseVolumeMixer::contextStateCallback", "backend");
+    auto *pThis = static_cast<PulseVolumeMixer*>(pUserData);
+    if (!PA_CONTEXT_IS_GOOD(pa_context_get_state(pContext)))
+    {
+        LOCK_GUARD(pThis->m_mutex);
+        for (auto &entry : pThis->m_audioDevicesMirror)
+        {
+            entry.second->updateState(AudioDevice::State::NotPresent);
+        }
+    }
+    pa_threaded_mainloop_signal(pThis->m_pMainloop, 0);
+}
+
+void
+PulseVolumeMixer::subscribeCallback
+(
+    pa_context *,
+    pa_subscription_event_type_t type,
+    std::uint32_t,
+    void *pUserData
+)
+{
+    VMX_TRACE_THREAD_NAME("pulse mainloop");
+    VMX_TRACE_SCOPE("PulseVolumeMixer::subscribeCallback", "backend");
+    auto *pThis = static_cast<PulseVolumeMixer*>(pUserData);
+    switch (type & PA_SUBSCRIPTION_EVENT_FACILITY_MASK)
+    {
+        case PA_SUBSCRIPTION_EVENT_SINK:
+            pThis->markStale(false, true, false);
+            break;
+        case PA_SUBSCRIPTION_EVENT_SINK_INPUT:
+            pThis->markStale(false, false, true);
+            break;
+        case PA_SUBSCRIPTION_EVENT_SERVER:
+            pThis->markStale(true, false, false);
+            break;
+        default:
+            break;
+    }
+}
+
+void
+PulseVolumeMixer::refreshDeferCallback
+(
+    pa_mainloop_api *pApi,
+    pa_defer_event *pEvent,
+    void *pUserData
+)
+{
+    pApi->defer_enable(pEvent, 0);
+    static_cast<PulseVolumeMixer*>(pUserData)->requestRefresh();
+}
+
+void
+PulseVolumeMixer::serverInfoCallback
+(
+    pa_context *,
+    const pa_server_info *pInfo,
+    void *pUserData
+)
+{
+    auto *pThis = static_cast<PulseVolumeMixer*>(pUserData);
+    if (pInfo)
+    {
+        pThis->m_pendingDefaultSinkName = pInfo->default_sink_name ? pInfo->default_sink_name : "";
+    }
+    else
+    {
+        pThis->m_bServerPending = false;
+    }
+    pThis->replyReceived();
+}
+
+void
+PulseVolumeMixer::sinkInfoCallback
+(
+    pa_context *,
+    const pa_sink_info *pInfo,
+    int eol,
+    void *pUserData
+)
+{
+    auto *pThis = static_cast<PulseVolumeMixer*>(pUserData);
+    if (eol < 0)
+    {
+        // A partial list would look like removed sinks, drop it and keep the current tree
+        pThis->m_bSinksPending = false;
+        pThis->m_pendingSinks.clear();
+    }
+    if (eol != 0)
+    {
+        pThis->replyReceived();
+        return;
+    }
+
+    PulseSinkInfo info;
+    info.index = pInfo->index;
+    info.name = pInfo->name ? pInfo->name : "";
+    info.description = pInfo->description ? pInfo->description : info.name;
+    info.iconName = propertyOr(pInfo->proplist, PA_PROP_DEVICE_ICON_NAME, "");
+    info.monitorSourceName = pInfo->monitor_source_name ? pInfo->monitor_source_name : "";
+    info.state = pInfo->state;
+    info.volume = pInfo->volume;
+    info.bMuted = pInfo->mute != 0;
+    pThis->m_pendingSinks.push_back(std::move(info));
+}
+
+void
+PulseVolumeMixer::sinkInputInfoCallback
+(
+    pa_context *,
+    const pa_sink_input_info *pInfo,
+    int eol,
+    void *pUserData
+)
+{
+    auto *pThis = static_cast<PulseVolumeMixer*>(pUserData);
+    if (eol < 0)
+    {
+        pThis->m_bSinkInputsPending = false;
+        pThis->m_pendingSinkInputs.clear();
+    }
+    if (eol != 0)
+    {
+        pThis->replyReceived();
+        return;
+    }
+
+    PulseSinkInputInfo info;
+    info.index = pInfo->index;
+    info.sinkIndex = pInfo->sink;
+    info.name = propertyOr(pInfo->proplist, PA_PROP_APPLICATION_NAME, pInfo->name ? pInfo->name : "");
+    info.iconName = propertyOr(pInfo->proplist, PA_PROP_APPLICATION_ICON_NAME, "");
+    info.volume = pInfo->volume;
+    info.bMuted = pInfo->mute != 0;
+    info.bCorked = pInfo->corked != 0;
+    pThis->m_pendingSinkInputs.push_back(std::move(info));
+}
+
+void
+PulseVolumeMixer::markStale
+(
+    bool bServer,
+    bool bSinks,
+    bool bSinkInputs
+)
+{
+    m_bServerStale |= bServer;
+    m_bSinksStale |= bSinks;
+    m_bSinkInputsStale |= bSinkInputs;
+
+    // Runs after every event already queued on the loop has been dispatched
+    pa_mainloop_api *pApi = pa_threaded_mainloop_get_api(m_pMainloop);
+    pApi->defer_enable(m_pRefreshEvent, 1);
+}
+
+void
+PulseVolumeMixer::requestRefresh()
+{
+    VMX_TRACE_SCOPE("PulseVolumeMixer::requestRefresh", "backend");
+
+    // Whatever goes stale while a refresh is in flight is picked up when it completes
+    if (m_outstandingReplies > 0) return;
+
+    if (m_bServerStale)
+    {
+        m_bServerStale = false;
+        m_bServerPending = sendOperation(pa_context_get_server_info(m_pContext, &PulseVolumeMixer::serverInfoCallback, this));
+        m_outstandingReplies += m_bServerPending ? 1 : 0;
+    }
+    if (m_bSinksStale)
+    {
+        m_bSinksStale = false;
+        m_bSinksPending = sendOperation(pa_context_get_sink_info_list(m_pContext, &PulseVolumeMixer::sinkInfoCallback, this));
+        m_outstandingReplies += m_bSinksPending ? 1 : 0;
+    }
+    if (m_bSinkInputsStale)
+    {
+        m_bSinkInputsStale = false;
+        m_bSinkInputsPending = sendOperation(pa_context_get_sink_input_info_list(m_pContext, &PulseVolumeMixer::sinkInputInfoCallback, this));
+        m_outstandingReplies += m_bSinkInputsPending ? 1 : 0;
+    }
+}
+
+void
+PulseVolumeMixer::replyReceived()
+{
+    if (--m_outstandingReplies > 0) return;
+
+    applyRefresh();
+    ++m_completedRefreshes;
+    pa_threaded_mainloop_signal(m_pMainloop, 0);
+
+    if (m_bServerStale || m_bSinksStale || m_bSinkInputsStale)
+    {
+        markStale(false, false, false);
+    }
+}
+
+void
+PulseVolumeMixer::applyRefresh()
+{
+    VMX_TRACE_SCOPE("PulseVolumeMixer::applyRefresh", "backend");
+    LOCK_GUARD(m_mutex);
+
+    if (m_bServerPending)
+    {
+        m_defaultSinkName = m_pendingDefaultSinkName;
+    }
+    if (m_bSinksPending)
+    {
+        applySinks();
+    }
+    if (m_bSinkInputsPending)
+    {
+        applySinkInputs();
+    }
+    if (m_bServerPending || m_bSinksPending)
+    {
+        applyDefaultSink();
+    }
+
+    m_bServerPending = false;
+    m_bSinksPending = false;
+    m_bSinkInputsPending = false;
+    m_pendingSinks.clear();
+    m_pendingSinkInputs.clear();
+}
+
+void
+PulseVolumeMixer::applySinks()
+{
+    std::set<std::uint32_t> presentSinks;
+    for (const auto &info : m_pendingSinks)
+    {
+        presentSinks.insert(info.index);
+    }
+
+    // Removals first, a sink recreated under the same name gets a new index but the same device id
+    for (auto it = m_audioDevicesMirror.begin(); it != m_audioDevicesMirror.end();)
+    {
+        if (presentSinks.contains(it->first))
+        {
+            ++it;
+            continue;
+        }
+        it->second->stopMonitoring();
+        removeDevice(it->second->getId());
+        it = m_audioDevicesMirror.erase(it);
+    }
+
+    for (const auto &info : m_pendingSinks)
+    {
+        auto it = m_audioDevicesMirror.find(info.index);
+        if (it != m_audioDevicesMirror.end())
+        {
+            it->second->refresh(info);
+            continue;
+        }
+
+        auto pPulseAudioDevice = std::make_shared<PulseAudioDevice>(*this, info, info.name == m_defaultSinkName);
+        if (m_bMonitoring)
+        {
+            pPulseAudioDevice->startMonitoring(m_pContext);
+        }
+        m_audioDevicesMirror[info.index] = pPulseAudioDevice;
+        addDevice(pPulseAudioDevice->getId(), pPulseAudioDevice);
+    }
+}
+
+void
+PulseVolumeMixer::applySinkInputs()
+{
+    std::map<std::uint32_t /* sink-input index */, PulseAudioDevice*> knownSessions;
+    for (auto &device : m_audioDevicesMirror)
+    {
+        for (auto &session : device.second->m_audioSessionsMirror)
+        {
+            knownSessions[session.first] = device.second.get();
+        }
+    }
+
+    bool bSinksMissing = false;
+    for (const auto &info : m_pendingSinkInputs)
+    {
+        auto known = knownSessions.find(info.index);
+        PulseAudioDevice *pPreviousDevice = nullptr;
+        if (known != knownSessions.end())
+        {
+            pPreviousDevice = known->second;
+            knownSessions.erase(known);
+        }
+
+        auto device = m_audioDevicesMirror.find(info.sinkIndex);
+        if (device == m_audioDevicesMirror.end())
+        {
+            // Mid-move, or the sink's own event has not been processed yet
+            bSinksMissing |= (info.sinkIndex != PA_INVALID_INDEX);
+            if (pPreviousDevice)
+            {
+                pPreviousDevice->m_audioSessionsMirror[info.index]->refresh(info);
+            }
+            continue;
+        }
+        PulseAudioDevice *pDevice = device->second.get();
+
+        if (pPreviousDevice == pDevice)
+        {
+            pDevice->m_audioSessionsMirror[info.index]->refresh(info);
+            continue;
+        }
+
+        std::shared_ptr<PulseAudioSession> pPulseAudioSession;
+        if (pPreviousDevice)
+        {
+            pPulseAudioSession = pPreviousDevice->detachSession(info.index);
+            pPulseAudioSession->stopMonitoring();
+            pPulseAudioSession->refresh(info);
+        }
+        else
+        {
+            pPulseAudioSession = std::make_shared<PulseAudioSession>(*this, info);
+        }
+        if (m_bMonitoring)
+        {
+            pPulseAudioSession->startMonitoring(m_pContext, pDevice->m_monitorSourceName);
+        }
+        pDevice->attachSession(pPulseAudioSession);
+    }
+
+    for (auto &entry : knownSessions)
+    {
+        auto pPulseAudioSession = entry.second->m_audioSessionsMirror[entry.first];
+        pPulseAudioSession->stopMonitoring();
+        pPulseAudioSession->updateState(AudioSession::State::Expired);
+        entry.second->detachSession(entry.first);
+    }
+
+    if (bSinksMissing)
+    {
+        markStale(false, true, true);
+    }
+}
+
+void
+PulseVolumeMixer::applyDefaultSink()
+{
+    for (auto &entry : m_audioDevicesMirror)
+    {
+        entry.second->updateDefault(entry.second->getId() == m_defaultSinkName);
+    }
+}
+
+void
+PulseVolumeMixer::setMonitoring
+(
+    bool bMonitoring
+)
+{
+    MAINLOOP_LOCK(m_pMainloop);
+    LOCK_GUARD(m_mutex);
+    if (m_bMonitoring == bMonitoring) return;
+    m_bMonitoring = bMonitoring;
+    for (auto &entry : m_audioDevicesMirror)
+    {
+        if (bMonitoring)
+        {
+            entry.second->startMonitoring(m_pContext);
+        }
+        else
+        {
+            entry.second->stopMonitoring();
+        }
+    }
+}
+
+void
+PulseVolumeMixer::teardown()
+{
+    // Once the loop thread is stopped nothing else touches libpulse, no locking needed
+    if (m_pMainloop)
+    {
+        pa_threaded_mainloop_stop(m_pMainloop);
+    }
+
+    {
+        LOCK_GUARD(m_mutex);
+        for (auto &entry : m_audioDevicesMirror)
+        {
+            entry.second->stopMonitoring();
+        }
+    }
+
+    if (m_pRefreshEvent)
+    {
+        pa_mainloop_api *pApi = pa_threaded_mainloop_get_api(m_pMainloop);
+        pApi->defer_free(m_pRefreshEvent);
+        m_pRefreshEvent = nullptr;
+    }
+    if (m_pContext)
+    {
+        pa_context_set_state_callback(m_pContext, nullptr, nullptr);
+        pa_context_disconnect(m_pContext);
+        pa_context_unref(m_pContext);
+        m_pContext = nullptr;
+    }
+    if (m_pMainloop)
+    {
+        pa_threaded_mainloop_free(m_pMainloop);
+        m_pMainloop = nullptr;
+    }
+}
+
+void
+PulseVolumeMixer::peakSample()
+{
+    VMX_TRACE_THREAD_NAME("peak sampler");
+    VMX_TRACE_SCOPE("PulseVolumeMixer::peakSample", "peak");
+    detail::ScopedPeakTick tick{};
+    LOCK_GUARD(m_mutex);
+    for (auto &entry : m_audioDevicesMirror)
+    {
+        entry.second->peakSample();
+    }
+}
+
+bool
+PulseVolumeMixer::sendOperation
+(
+    pa_operation *pOperation
+)
+{
+    detail::countBackendCall(pOperation != nullptr);
+    if (!pOperation) return false;
+    pa_operation_unref(pOperation);
+    return true;
+}
+
+} // namespace vmx
+
+/* ==== Static Helper Functions ============================================ */
+static std::runtime_error
+pulseError
+(
+    pa_context *pContext,
+    const std::string &what
+)
+{
+    return std::runtime_error(what + ": " + pa_strerror(pa_context_errno(pContext)));
+}
+
+static std::string
+propertyOr
+(
+    pa_proplist *pProperties,
+    const char *key,
+    const char *fallback
+)
+{
+    const char *value = pProperties ? pa_proplist_gets(pProperties, key) : nullptr;
+    return value ? value : fallback;
+}
+
+static float
+toLinearVolume
+(
+    const pa_cvolume &volume
+)
+{
+    // The loudest channel is the master volume, the others keep their balance relative to it
+    if (!pa_cvolume_valid(&volume)) return 0.0f;
+    float linearVolume = static_cast<float>(pa_cvolume_max(&volume)) / static_cast<float>(PA_VOLUME_NORM);
+    return std::min(1.0f, linearVolume);
+}
+
+static pa_cvolume
+scaleVolume
+(
+    pa_cvolume volume,
+    float linearVolume
+)
+{
+    linearVolume = std::min(1.0f, linearVolume);
+    linearVolume = std::max(0.0f, linearVolume);
+    auto target = static_cast<pa_volume_t>(std::lround(linearVolume * static_cast<float>(PA_VOLUME_NORM)));
+    if (!pa_cvolume_valid(&volume))
+    {
+        pa_cvolume_set(&volume, 1, target);
+        return volume;
+    }
+    pa_cvolume_scale(&volume, target);
+    return volume;
+}
+
+static std::vector<float>
+toChannelVolumes
+(
+    const pa_cvolume &volume
+)
+{
+    std::vector<float> channelVolumes;
+    if (!pa_cvolume_valid(&volume)) return channelVolumes;
+    channelVolumes.reserve(volume.channels);
+    for (std::uint8_t channel = 0; channel < volume.channels; ++channel)
+    {
+        float linearVolume = static_cast<float>(volume.values[channel]) / static_cast<float>(PA_VOLUME_NORM);
+        channelVolumes.push_back(std::min(1.0f, linearVolume));
+    }
+    return channelVolumes;
+}
+
+// The whole array goes to the server in one pa_cvolume, so a balance change is one request
+static pa_cvolume
+fromChannelVolumes
+(
+    const std::vector<float> &channelVolumes,
+    std::uint8_t channelCount
+)
+{
+    if (channelVolumes.size() != channelCount)
+    {
+        throw std::runtime_error("Expected " + std::to_string(channelCount) + " channel volumes, got " + std::to_string(channelVolumes.size()));
+    }
+    pa_cvolume volume = {};
+    volume.channels = channelCount;
+    for (std::uint8_t channel = 0; channel < channelCount; ++channel)
+    {
+        float linearVolume = std::max(0.0f, std::min(1.0f, channelVolumes[channel]));
+        volume.values[channel] = static_cast<pa_volume_t>(std::lround(linearVolume * static_cast<float>(PA_VOLUME_NORM)));
+    }
+    return volume;
+}
+
+static vmx::AudioDevice::State
+toDeviceState
+(
+    pa_sink_state_t state
+)
+{
+    switch (state)
+    {
+        case PA_SINK_RUNNING:
+        case PA_SINK_IDLE:
+        case PA_SINK_SUSPENDED:
+            return vmx::AudioDevice::State::Active;
+        default:
+            return vmx::AudioDevice::State::Unknown;
+    }
+}
+
+#if VMX_BACKEND_PLUGIN
+/* ==== Plugin Entry Point ================================================= */
+VMX_DEFINE_BACKEND_PLUGIN("pulseaudio", vmx::PulseVolumeMixer)
+#endif
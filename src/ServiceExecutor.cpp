@@ -0,0 +1,109 @@
+/* ==== Application Includes =============================================== */
+#include <vmx/ServiceExecutor.h>
+#include "Tracing.h"
+
+/* ==== Standard Library Includes ========================================== */
+#include <utility>
+#include <vector>
+
+namespace vmx
+{
+
+/* ==== ServiceExecutor Class ============================================== */
+ServiceExecutor::ServiceExecutor()
+  : m_workThread([](std::function<void()> job){
+        VMX_TRACE_THREAD_NAME("vmx service");
+        job();
+    }, ThreadRole::Service)
+{
+}
+
+void
+ServiceExecutor::post
+(
+    std::function<void()> job
+)
+{
+    m_workThread.queue(std::move(job));
+}
+
+/* ==== Strand Class ======================================================= */
+Strand::Strand
+(
+    ServiceExecutor &executor
+)
+  : m_executor(executor),
+    m_executorThreadId(executor.threadId()),
+    m_pState(std::make_shared<State>())
+{
+}
+
+Strand::~Strand()
+{
+    close();
+}
+
+void
+Strand::post
+(
+    std::function<void()> job
+)
+{
+    std::lock_guard guard(m_pState->mutex);
+    if (m_pState->bClosed) return;
+    m_pState->jobs.push_back(std::move(job));
+    if (!m_pState->bScheduled)
+    {
+        m_pState->bScheduled = true;
+        m_executor.post([&executor = m_executor, pState = m_pState]{ run(executor, pState); });
+    }
+}
+
+void
+Strand::close()
+{
+    std::unique_lock lock(m_pState->mutex);
+    m_pState->bClosed = true;
+    m_pState->jobs.clear();
+    // On the executor's thread the running job, if any, is the caller
+    if (std::this_thread::get_id() != m_executorThreadId)
+    {
+        m_pState->idle.wait(lock, [this]{ return !m_pState->bRunning; });
+    }
+}
+
+void
+Strand::run
+(
+    ServiceExecutor &executor,
+    const std::shared_ptr<State> &pState
+)
+{
+    VMX_TRACE_SCOPE("Strand::run", "backend");
+
+    // Only the jobs queued by now; later ones wait for the next turn
+    std::unique_lock lock(pState->mutex);
+    std::size_t count = pState->jobs.size();
+    for (std::size_t i = 0; i < count && !pState->bClosed; ++i)
+    {
+        std::function<void()> job = std::move(pState->jobs.front());
+        pState->jobs.pop_front();
+        pState->bRunning = true;
+        lock.unlock();
+        job();
+        job = nullptr; // what it captured may close this strand, which takes the lock
+        lock.lock();
+        pState->bRunning = false;
+        pState->idle.notify_all();
+    }
+
+    if (pState->bClosed || pState->jobs.empty())
+    {
+        pState->bScheduled = false;
+        return;
+    }
+    // The executor is alive, since this is running on it
+    executor.post([&executor, pState]{ run(executor, pState); });
+}
+
+} // namespace vmx
@@ -0,0 +1,746 @@
+/* ==== Application Includes =============================================== */
+#include <vmx/SimulatedVolumeMixer.h>
+#include <vmx/ChannelVolumes.h>
+#include "Dispatch.h"
+#include "Instrumentation.h"
+#include "Tracing.h"
+
+/* ==== Standard Library Includes ========================================== */
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+/* ==== Macros ============================================================= */
+// The DispatchScope comes first so that synchronous observer calls wait for the lock's release
+#define LOCK_GUARD(mutex_var)                                                           \
+    const detail::DispatchScope dispatchScope;                                          \
+    const detail::LockGuard<decltype(mutex_var)> lock(mutex_var)
+
+/* ==== Forward Declarations =============================================== */
+static float clampUnit(float value);
+static std::vector<float> checkChannelVolumes(std::vector<float> channelVolumes);
+static void applyChannelVolumes(std::span<float> frames, float volume, const std::vector<float> &channelVolumes);
+static void pruneAudioTaps(std::vector<std::shared_ptr<vmx::AudioTap>> &audioTaps);
+static void closeAudioTaps(std::vector<std::shared_ptr<vmx::AudioTap>> &audioTaps);
+
+namespace vmx
+{
+
+/* ==== RenderRequest Class ================================================ */
+// How a session or device gets its mixer rendering once a tap is opened.
+// Sessions and devices can outlive their mixer, whose destructor detaches
+// this so that a tap opened afterwards asks nothing of it.
+class detail::RenderRequest
+{
+public: /* Methods */
+    explicit RenderRequest(std::function<void()> start) : m_start(std::move(start)) {};
+
+    void request()
+    {
+        std::lock_guard guard(m_mutex);
+        if (m_start) m_start();
+    };
+
+    void detach()
+    {
+        std::lock_guard guard(m_mutex);
+        m_start = nullptr;
+    };
+
+private: /* Members */
+    std::mutex m_mutex;
+    std::function<void()> m_start;
+};
+
+/* ==== SimulatedAudioSession Class ======================================== */
+SimulatedAudioSession::SimulatedAudioSession
+(
+    const std::string &id,
+    const std::string &name,
+    std::shared_ptr<detail::RenderRequest> pRenderRequest
+)
+  : m_id(id),
+    m_channelVolumes(SimulatedVolumeMixer::kChannelCount, m_volume),
+    m_noise(static_cast<std::uint32_t>(std::hash<std::string>{}(id)) | 1u),
+    m_gainRamp(SimulatedVolumeMixer::kSampleRate, m_volume),
+    m_loudnessMeter(SimulatedVolumeMixer::kSampleRate, SimulatedVolumeMixer::kChannelCount),
+    m_pRenderRequest(std::move(pRenderRequest))
+{
+    updateName(name);
+    updateState(State::Active);
+    updateVolume(m_volume);
+    updateChannelVolumes(m_channelVolumes);
+    updateMute(m_bMuted);
+}
+
+SimulatedAudioSession::~SimulatedAudioSession()
+{
+    closeAudioTaps(m_audioTaps);
+}
+
+void
+SimulatedAudioSession::simulateName
+(
+    std::string name
+)
+{
+    VMX_TRACE_SCOPE("SimulatedAudioSession::simulateName", "backend");
+    updateName(std::move(name));
+}
+
+void
+SimulatedAudioSession::simulateIconPath
+(
+    std::string iconPath
+)
+{
+    VMX_TRACE_SCOPE("SimulatedAudioSession::simulateIconPath", "backend");
+    updateIconPath(std::move(iconPath));
+}
+
+void
+SimulatedAudioSession::simulateState
+(
+    State state
+)
+{
+    VMX_TRACE_SCOPE("SimulatedAudioSession::simulateState", "backend");
+    if (state == State::Expired)
+    {
+        LOCK_GUARD(m_mutex);
+        closeAudioTaps(m_audioTaps);
+    }
+    updateState(state);
+}
+
+void
+SimulatedAudioSession::simulateVolume
+(
+    float volume
+)
+{
+    VMX_TRACE_SCOPE("SimulatedAudioSession::simulateVolume", "backend");
+    LOCK_GUARD(m_mutex);
+    m_volume = clampUnit(volume);
+    ChannelVolumes::setVolume(m_channelVolumes, m_volume);
+    m_gainRamp.setTarget(m_bMuted ? 0.0f : m_volume);
+    updateVolume(m_volume);
+    updateChannelVolumes(m_channelVolumes);
+}
+
+void
+SimulatedAudioSession::simulateChannelVolumes
+(
+    std::vector<float> channelVolumes
+)
+{
+    VMX_TRACE_SCOPE("SimulatedAudioSession::simulateChannelVolumes", "backend");
+    LOCK_GUARD(m_mutex);
+    m_channelVolumes = checkChannelVolumes(std::move(channelVolumes));
+    m_volume = ChannelVolumes::volume(m_channelVolumes);
+    m_gainRamp.setTarget(m_bMuted ? 0.0f : m_volume);
+    updateVolume(m_volume);
+    updateChannelVolumes(m_channelVolumes);
+}
+
+void
+SimulatedAudioSession::simulateMute
+(
+    bool bMuted
+)
+{
+    VMX_TRACE_SCOPE("SimulatedAudioSession::simulateMute", "backend");
+    LOCK_GUARD(m_mutex);
+    m_bMuted = bMuted;
+    m_gainRamp.setTarget(m_bMuted ? 0.0f : m_volume);
+    updateMute(m_bMuted);
+}
+
+void
+SimulatedAudioSession::simulateLevel
+(
+    float level
+)
+{
+    VMX_TRACE_SCOPE("SimulatedAudioSession::simulateLevel", "backend");
+    LOCK_GUARD(m_mutex);
+    m_level = clampUnit(level);
+}
+
+void
+SimulatedAudioSession::peakSample()
+{
+    LOCK_GUARD(m_mutex);
+
+    // xorshift32, just enough jitter that consecutive ticks produce distinct peaks
+    m_noise ^= m_noise << 13;
+    m_noise ^= m_noise >> 17;
+    m_noise ^= m_noise << 5;
+    float jitter = 0.5f + 0.5f * static_cast<float>(m_noise >> 8) / static_cast<float>(1u << 24);
+
+    m_lastPeak = m_bMuted ? 0.0f : m_level * m_volume * jitter;
+    updatePeakSample(m_lastPeak);
+}
+
+float
+SimulatedAudioSession::lastPeak()
+{
+    LOCK_GUARD(m_mutex);
+    return m_lastPeak;
+}
+
+bool
+SimulatedAudioSession::render
+(
+    std::span<float> mix,
+    std::size_t frameCount,
+    bool bMeterLoudness,
+    bool bReportLoudness
+)
+{
+    LOCK_GUARD(m_mutex);
+    pruneAudioTaps(m_audioTaps);
+    if (mix.empty() && !bMeterLoudness && m_audioTaps.empty()) return false;
+
+    m_frames.resize(frameCount * SimulatedVolumeMixer::kChannelCount);
+    for (auto &sample : m_frames)
+    {
+        m_noise ^= m_noise << 13;
+        m_noise ^= m_noise >> 17;
+        m_noise ^= m_noise << 5;
+        sample = m_level * (static_cast<float>(m_noise >> 8) / static_cast<float>(1u << 23) - 1.0f);
+    }
+
+    // Volume and mute are applied and the result summed into the device's mix in one pass
+    applyChannelVolumes(m_frames, m_volume, m_channelVolumes);
+    m_gainRamp.process(m_frames.data(), m_frames.data(), mix.empty() ? nullptr : mix.data(), SimulatedVolumeMixer::kChannelCount, frameCount);
+
+    for (auto &pAudioTap : m_audioTaps)
+    {
+        pAudioTap->write(m_frames.data(), frameCount);
+    }
+    if (bMeterLoudness)
+    {
+        m_loudnessMeter.process(SampleFormat::Float32, m_frames.data(), frameCount);
+    }
+    if (bReportLoudness)
+    {
+        updateLoudnessSample(m_loudnessMeter.loudness());
+    }
+    return !m_audioTaps.empty();
+}
+
+void
+SimulatedAudioSession::changeVolume
+(
+    float volume
+)
+{
+    VMX_TRACE_SCOPE("SimulatedAudioSession::changeVolume", "control");
+    detail::countBackendCall(true);
+    simulateVolume(volume);
+}
+
+void
+SimulatedAudioSession::changeMute
+(
+    bool bMute
+)
+{
+    VMX_TRACE_SCOPE("SimulatedAudioSession::changeMute", "control");
+    detail::countBackendCall(true);
+    simulateMute(bMute);
+}
+
+void
+SimulatedAudioSession::changeChannelVolumes
+(
+    std::vector<float> channelVolumes
+)
+{
+    VMX_TRACE_SCOPE("SimulatedAudioSession::changeChannelVolumes", "control");
+    detail::countBackendCall(true);
+    simulateChannelVolumes(std::move(channelVolumes));
+}
+
+std::shared_ptr<AudioTap>
+SimulatedAudioSession::openAudioTap
+(
+    std::chrono::milliseconds bufferLength
+)
+{
+    VMX_TRACE_SCOPE("SimulatedAudioSession::openAudioTap", "control");
+    auto pAudioTap = std::make_shared<AudioTap>(SimulatedVolumeMixer::kSampleRate, SimulatedVolumeMixer::kChannelCount, bufferLength);
+    {
+        LOCK_GUARD(m_mutex);
+        m_audioTaps.push_back(pAudioTap);
+    }
+    // Outside the lock, which render() takes after the mixer's render lock
+    if (m_pRenderRequest) m_pRenderRequest->request();
+    return pAudioTap;
+}
+
+/* ==== SimulatedAudioDevice Class ========================================= */
+SimulatedAudioDevice::SimulatedAudioDevice
+(
+    const std::string &id,
+    const std::string &name,
+    bool bDefaultDevice,
+    std::shared_ptr<detail::RenderRequest> pRenderRequest
+)
+  : m_id(id),
+    m_channelVolumes(SimulatedVolumeMixer::kChannelCount, m_volume),
+    m_gainRamp(SimulatedVolumeMixer::kSampleRate, m_volume),
+    m_loudnessMeter(SimulatedVolumeMixer::kSampleRate, SimulatedVolumeMixer::kChannelCount),
+    m_pRenderRequest(std::move(pRenderRequest))
+{
+    updateName(name);
+    updateState(State::Active);
+    updateDefault(bDefaultDevice);
+    updateVolume(m_volume);
+    updateChannelVolumes(m_channelVolumes);
+    updateMute(m_bMuted);
+}
+
+SimulatedAudioDevice::~SimulatedAudioDevice()
+{
+    closeAudioTaps(m_audioTaps);
+}
+
+std::shared_ptr<SimulatedAudioSession>
+SimulatedAudioDevice::createSession
+(
+    const std::string &audioSessionId,
+    const std::string &name
+)
+{
+    LOCK_GUARD(m_mutex);
+    auto pSimulatedAudioSession = std::make_shared<SimulatedAudioSession>(audioSessionId, name, m_pRenderRequest);
+    m_audioSessionsMirror[audioSessionId] = pSimulatedAudioSession;
+    addSession(audioSessionId, pSimulatedAudioSession);
+    return pSimulatedAudioSession;
+}
+
+void
+SimulatedAudioDevice::destroySession
+(
+    const std::string &audioSessionId
+)
+{
+    LOCK_GUARD(m_mutex);
+    auto it = m_audioSessionsMirror.find(audioSessionId);
+    if (it == m_audioSessionsMirror.end()) return;
+    it->second->simulateState(AudioSession::State::Expired);
+    m_audioSessionsMirror.erase(it);
+    removeSession(audioSessionId);
+}
+
+std::shared_ptr<SimulatedAudioSession>
+SimulatedAudioDevice::findSession
+(
+    const std::string &audioSessionId
+)
+{
+    LOCK_GUARD(m_mutex);
+    auto it = m_audioSessionsMirror.find(audioSessionId);
+    return (it == m_audioSessionsMirror.end()) ? nullptr : it->second;
+}
+
+void
+SimulatedAudioDevice::simulateName
+(
+    std::string name
+)
+{
+    VMX_TRACE_SCOPE("SimulatedAudioDevice::simulateName", "backend");
+    updateName(std::move(name));
+}
+
+void
+SimulatedAudioDevice::simulateState
+(
+    State state
+)
+{
+    VMX_TRACE_SCOPE("SimulatedAudioDevice::simulateState", "backend");
+    updateState(state);
+}
+
+void
+SimulatedAudioDevice::simulateDefault
+(
+    bool bIsDefaultDevice
+)
+{
+    VMX_TRACE_SCOPE("SimulatedAudioDevice::simulateDefault", "backend");
+    updateDefault(bIsDefaultDevice);
+}
+
+void
+SimulatedAudioDevice::simulateVolume
+(
+    float volume
+)
+{
+    VMX_TRACE_SCOPE("SimulatedAudioDevice::simulateVolume", "backend");
+    LOCK_GUARD(m_mutex);
+    m_volume = clampUnit(volume);
+    ChannelVolumes::setVolume(m_channelVolumes, m_volume);
+    m_gainRamp.setTarget(m_bMuted ? 0.0f : m_volume);
+    updateVolume(m_volume);
+    updateChannelVolumes(m_channelVolumes);
+}
+
+void
+SimulatedAudioDevice::simulateChannelVolumes
+(
+    std::vector<float> channelVolumes
+)
+{
+    VMX_TRACE_SCOPE("SimulatedAudioDevice::simulateChannelVolumes", "backend");
+    LOCK_GUARD(m_mutex);
+    m_channelVolumes = checkChannelVolumes(std::move(channelVolumes));
+    m_volume = ChannelVolumes::volume(m_channelVolumes);
+    m_gainRamp.setTarget(m_bMuted ? 0.0f : m_volume);
+    updateVolume(m_volume);
+    updateChannelVolumes(m_channelVolumes);
+}
+
+void
+SimulatedAudioDevice::simulateMute
+(
+    bool bMuted
+)
+{
+    VMX_TRACE_SCOPE("SimulatedAudioDevice::simulateMute", "backend");
+    LOCK_GUARD(m_mutex);
+    m_bMuted = bMuted;
+    m_gainRamp.setTarget(m_bMuted ? 0.0f : m_volume);
+    updateMute(m_bMuted);
+}
+
+void
+SimulatedAudioDevice::peakSample()
+{
+    LOCK_GUARD(m_mutex);
+    float loudest = 0.0f;
+    for (auto &entry : m_audioSessionsMirror)
+    {
+        entry.second->peakSample();
+        loudest = std::max(loudest, entry.second->lastPeak());
+    }
+    updatePeakSample(m_bMuted ? 0.0f : loudest * m_volume);
+}
+
+bool
+SimulatedAudioDevice::render
+(
+    std::size_t frameCount,
+    bool bMeterLoudness,
+    bool bReportLoudness
+)
+{
+    LOCK_GUARD(m_mutex);
+    pruneAudioTaps(m_audioTaps);
+
+    // Sessions still render for their own taps and meters when nobody needs the mix
+    bool bMixing = bMeterLoudness || !m_audioTaps.empty();
+    bool bTapsOpen = !m_audioTaps.empty();
+    m_mix.assign(bMixing ? frameCount * SimulatedVolumeMixer::kChannelCount : 0, 0.0f);
+    for (auto &entry : m_audioSessionsMirror)
+    {
+        bTapsOpen |= entry.second->render(m_mix, frameCount, bMeterLoudness, bReportLoudness);
+    }
+    if (!bMixing) return bTapsOpen;
+
+    m_gainRamp.process(m_mix.data(), m_mix.data(), nullptr, SimulatedVolumeMixer::kChannelCount, frameCount);
+    applyChannelVolumes(m_mix, m_volume, m_channelVolumes);
+    for (auto &pAudioTap : m_audioTaps)
+    {
+        pAudioTap->write(m_mix.data(), frameCount);
+    }
+    if (bMeterLoudness)
+    {
+        m_loudnessMeter.process(SampleFormat::Float32, m_mix.data(), frameCount);
+    }
+    if (bReportLoudness)
+    {
+        updateLoudnessSample(m_loudnessMeter.loudness());
+    }
+    return bTapsOpen;
+}
+
+void
+SimulatedAudioDevice::changeVolume
+(
+    float volume
+)
+{
+    VMX_TRACE_SCOPE("SimulatedAudioDevice::changeVolume", "control");
+    detail::countBackendCall(true);
+    simulateVolume(volume);
+}
+
+void
+SimulatedAudioDevice::changeMute
+(
+    bool bMute
+)
+{
+    VMX_TRACE_SCOPE("SimulatedAudioDevice::changeMute", "control");
+    detail::countBackendCall(true);
+    simulateMute(bMute);
+}
+
+void
+SimulatedAudioDevice::changeChannelVolumes
+(
+    std::vector<float> channelVolumes
+)
+{
+    VMX_TRACE_SCOPE("SimulatedAudioDevice::changeChannelVolumes", "control");
+    detail::countBackendCall(true);
+    simulateChannelVolumes(std::move(channelVolumes));
+}
+
+std::shared_ptr<AudioTap>
+SimulatedAudioDevice::openAudioTap
+(
+    std::chrono::milliseconds bufferLength
+)
+{
+    VMX_TRACE_SCOPE("SimulatedAudioDevice::openAudioTap", "control");
+    auto pAudioTap = std::make_shared<AudioTap>(SimulatedVolumeMixer::kSampleRate, SimulatedVolumeMixer::kChannelCount, bufferLength);
+    {
+        LOCK_GUARD(m_mutex);
+        m_audioTaps.push_back(pAudioTap);
+    }
+    // Outside the lock, which render() takes after the mixer's render lock
+    if (m_pRenderRequest) m_pRenderRequest->request();
+    return pAudioTap;
+}
+
+/* ==== SimulatedVolumeMixer Class ========================================= */
+SimulatedVolumeMixer::SimulatedVolumeMixer()
+  : m_peakSamplingTimer([this](){peakSample();}, std::chrono::milliseconds(0)),
+    m_pRenderRequest(std::make_shared<detail::RenderRequest>([this](){startRendering();})),
+    m_renderTimer([this](){render();}, std::chrono::milliseconds(0))
+{
+}
+
+SimulatedVolumeMixer::~SimulatedVolumeMixer()
+{
+    // Devices and sessions handed out may outlive this
+    m_pRenderRequest->detach();
+}
+
+std::shared_ptr<SimulatedAudioDevice>
+SimulatedVolumeMixer::createDevice
+(
+    const std::string &audioDeviceId,
+    const std::string &name,
+    bool bDefaultDevice
+)
+{
+    LOCK_GUARD(m_mutex);
+    auto pSimulatedAudioDevice = std::make_shared<SimulatedAudioDevice>(audioDeviceId, name, bDefaultDevice, m_pRenderRequest);
+    addDevice(audioDeviceId, pSimulatedAudioDevice);
+    m_audioDevicesMirror[audioDeviceId] = pSimulatedAudioDevice;
+    return pSimulatedAudioDevice;
+}
+
+void
+SimulatedVolumeMixer::destroyDevice
+(
+    const std::string &audioDeviceId
+)
+{
+    LOCK_GUARD(m_mutex);
+    if (m_audioDevicesMirror.contains(audioDeviceId))
+    {
+        m_audioDevicesMirror.erase(audioDeviceId);
+    }
+    removeDevice(audioDeviceId);
+}
+
+std::shared_ptr<SimulatedAudioDevice>
+SimulatedVolumeMixer::findDevice
+(
+    const std::string &audioDeviceId
+)
+{
+    LOCK_GUARD(m_mutex);
+    auto it = m_audioDevicesMirror.find(audioDeviceId);
+    return (it == m_audioDevicesMirror.end()) ? nullptr : it->second;
+}
+
+void
+SimulatedVolumeMixer::simulateDefaultDevice
+(
+    const std::string &audioDeviceId
+)
+{
+    VMX_TRACE_SCOPE("SimulatedVolumeMixer::simulateDefaultDevice", "backend");
+    LOCK_GUARD(m_mutex);
+    for (auto &entry : m_audioDevicesMirror)
+    {
+        entry.second->simulateDefault(audioDeviceId == entry.first);
+    }
+}
+
+void
+SimulatedVolumeMixer::setPeakSamplingPeriod
+(
+    std::chrono::milliseconds period
+)
+{
+    m_peakSamplingTimer.changePeriod(period);
+}
+
+void
+SimulatedVolumeMixer::setLoudnessSamplingPeriod
+(
+    std::chrono::milliseconds period
+)
+{
+    m_loudnessPeriodMs = period.count();
+    if (period.count() > 0)
+    {
+        startRendering();
+    }
+}
+
+void
+SimulatedVolumeMixer::peakSample()
+{
+    VMX_TRACE_THREAD_NAME("peak sampler");
+    VMX_TRACE_SCOPE("SimulatedVolumeMixer::peakSample", "peak");
+    detail::ScopedPeakTick tick{};
+    LOCK_GUARD(m_mutex);
+    for (auto &entry : m_audioDevicesMirror)
+    {
+        entry.second->peakSample();
+    }
+}
+
+void
+SimulatedVolumeMixer::render()
+{
+    VMX_TRACE_THREAD_NAME("render");
+    VMX_TRACE_SCOPE("SimulatedVolumeMixer::render", "backend");
+    LOCK_GUARD(m_renderMutex);
+
+    // Loudness is metered every period and reported every loudness period
+    auto loudnessPeriod = std::chrono::milliseconds(m_loudnessPeriodMs.load());
+    bool bMeterLoudness = loudnessPeriod.count() > 0;
+    m_sinceLoudnessReport += kRenderPeriod;
+    bool bReportLoudness = bMeterLoudness && m_sinceLoudnessReport >= loudnessPeriod;
+    if (bReportLoudness) m_sinceLoudnessReport = std::chrono::milliseconds(0);
+
+    constexpr std::size_t kFrameCount = kSampleRate * kRenderPeriod.count() / 1000;
+    bool bTapsOpen = false;
+    {
+        const detail::LockGuard<decltype(m_mutex)> mixerLock(m_mutex);
+        for (auto &entry : m_audioDevicesMirror)
+        {
+            bTapsOpen |= entry.second->render(kFrameCount, bMeterLoudness, bReportLoudness);
+        }
+    }
+
+    // Nothing left to render for: the timer sleeps until startRendering(),
+    // which waits for this to return, so a tap opened meanwhile restarts it
+    if (!bMeterLoudness && !bTapsOpen && m_bRendering)
+    {
+        m_bRendering = false;
+        m_renderTimer.changePeriod(std::chrono::milliseconds(0));
+    }
+}
+
+void
+SimulatedVolumeMixer::startRendering()
+{
+    LOCK_GUARD(m_renderMutex);
+    if (m_bRendering) return;
+    m_bRendering = true;
+    m_sinceLoudnessReport = std::chrono::milliseconds(0);
+    m_renderTimer.changePeriod(kRenderPeriod);
+}
+
+} // namespace vmx
+
+/* ==== Static Helper Functions ============================================ */
+static float
+clampUnit
+(
+    float value
+)
+{
+    value = std::min(1.0f, value);
+    value = std::max(0.0f, value);
+    return value;
+}
+
+static std::vector<float>
+checkChannelVolumes
+(
+    std::vector<float> channelVolumes
+)
+{
+    if (channelVolumes.size() != vmx::SimulatedVolumeMixer::kChannelCount)
+    {
+        throw std::runtime_error("Simulated sessions and devices have " + std::to_string(vmx::SimulatedVolumeMixer::kChannelCount) + " channels");
+    }
+    for (auto &channelVolume : channelVolumes)
+    {
+        channelVolume = clampUnit(channelVolume);
+    }
+    return channelVolumes;
+}
+
+// The gain ramp follows the loudest channel, the others are scaled down from it here
+static void
+applyChannelVolumes
+(
+    std::span<float> frames,
+    float volume,
+    const std::vector<float> &channelVolumes
+)
+{
+    float scales[vmx::SimulatedVolumeMixer::kChannelCount];
+    bool bBalanced = true;
+    for (std::size_t channel = 0; channel < vmx::SimulatedVolumeMixer::kChannelCount; ++channel)
+    {
+        scales[channel] = (volume > 0.0f) ? channelVolumes[channel] / volume : 1.0f;
+        bBalanced &= (scales[channel] == 1.0f);
+    }
+    if (bBalanced) return;
+
+    for (std::size_t i = 0; i < frames.size(); ++i)
+    {
+        frames[i] *= scales[i % vmx::SimulatedVolumeMixer::kChannelCount];
+    }
+}
+
+// Taps the consumer closed or let go of
+static void
+pruneAudioTaps
+(
+    std::vector<std::shared_ptr<vmx::AudioTap>> &audioTaps
+)
+{
+    std::erase_if(audioTaps, [](const auto &pAudioTap) { return pAudioTap->isClosed() || pAudioTap.use_count() == 1; });
+}
+
+static void
+closeAudioTaps
+(
+    std::vector<std::shared_ptr<vmx::AudioTap>> &audioTaps
+)
+{
+    for (auto &pAudioTap : audioTaps)
+    {
+        pAudioTap->close();
+    }
+    audioTaps.clear();
+}
@@ -0,0 +1,350 @@
+/* ==== Application Includes =============================================== */
+#include <vmx/SpectrumAnalyzer.h>
+#include "FftKernels.h"
+#include "Instrumentation.h"
+#include "Tracing.h"
+
+/* ==== Standard Library Includes ========================================== */
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <stdexcept>
+#include <string>
+
+/* ==== Operating System Includes ========================================== */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VMX_SPECTRUM_SSE2 1
+#include <emmintrin.h>
+#endif
+
+/* ==== Macros ============================================================= */
+#define LOCK_GUARD(mutex_var) const detail::LockGuard<decltype(mutex_var)> lock(mutex_var)
+
+namespace vmx::detail
+{
+
+namespace
+{
+
+/* ==== Baseline Operations ================================================ */
+// SSE2 is part of every x86-64 target, so this needs no runtime check. An
+// AVX2 build of the same kernels measured no faster in BM_SpectrumAnalyzer.
+#if VMX_SPECTRUM_SSE2
+struct BaselineOps
+{
+    using V = __m128;
+    static constexpr std::size_t kWidth = 4;
+
+    static V broadcast(float value) { return _mm_set1_ps(value); };
+    static V load(const float *p) { return _mm_loadu_ps(p); };
+    // p[0], p[-1], p[-2], p[-3]
+    static V loadReversed(const float *p) { V v = _mm_loadu_ps(p - 3); return _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 1, 2, 3)); };
+    static void store(float *p, V v) { _mm_storeu_ps(p, v); };
+    static V add(V a, V b) { return _mm_add_ps(a, b); };
+    static V sub(V a, V b) { return _mm_sub_ps(a, b); };
+    static V mul(V a, V b) { return _mm_mul_ps(a, b); };
+    static V mulAdd(V a, V b, V c) { return _mm_add_ps(_mm_mul_ps(a, b), c); };
+    static V mulSub(V a, V b, V c) { return _mm_sub_ps(c, _mm_mul_ps(a, b)); };
+};
+#else
+struct BaselineOps
+{
+    using V = float;
+    static constexpr std::size_t kWidth = 1;
+
+    static V broadcast(float value) { return value; };
+    static V load(const float *p) { return *p; };
+    static V loadReversed(const float *p) { return *p; };
+    static void store(float *p, V v) { *p = v; };
+    static V add(V a, V b) { return a + b; };
+    static V sub(V a, V b) { return a - b; };
+    static V mul(V a, V b) { return a * b; };
+    static V mulAdd(V a, V b, V c) { return a * b + c; };
+    static V mulSub(V a, V b, V c) { return c - a * b; };
+};
+#endif
+
+} // namespace
+
+} // namespace vmx::detail
+
+namespace vmx
+{
+
+/* ==== SpectrumAnalyzer Class ============================================= */
+SpectrumAnalyzer::SpectrumAnalyzer
+(
+    std::size_t fftSize,
+    std::size_t bandCount,
+    std::chrono::milliseconds period
+)
+  : m_fftSize(fftSize),
+    m_bandCount(bandCount),
+    m_analysisTimer([this](){analyze();}, std::chrono::milliseconds(0))
+{
+    if (fftSize < 64 || fftSize > 65536 || !std::has_single_bit(fftSize))
+    {
+        throw std::runtime_error("SpectrumAnalyzer FFT size " + std::to_string(fftSize) + " is not a power of two from 64 to 65536");
+    }
+    if (bandCount == 0)
+    {
+        throw std::runtime_error("SpectrumAnalyzer needs at least one band");
+    }
+
+    for (std::size_t band = 0; band <= bandCount; ++band)
+    {
+        double fraction = static_cast<double>(band) / static_cast<double>(bandCount);
+        m_bandEdges.push_back(static_cast<float>(kMinFrequency * std::pow(double(kMaxFrequency) / kMinFrequency, fraction)));
+    }
+
+    // A periodic Hann window. Scaling by its energy makes a full-scale sine
+    // sum to 0 dB over the bins it leaks into.
+    double windowEnergy = 0.0;
+    for (std::size_t n = 0; n < fftSize; ++n)
+    {
+        double w = 0.5 - 0.5 * std::cos(2.0 * std::numbers::pi * static_cast<double>(n) / static_cast<double>(fftSize));
+        m_window.push_back(static_cast<float>(w));
+        windowEnergy += w * w;
+    }
+    m_powerScale = static_cast<float>(4.0 / (static_cast<double>(fftSize) * windowEnergy));
+
+    // The real input is transformed as a complex one of half the size
+    const std::size_t half = fftSize / 2;
+    const int bits = std::countr_zero(half);
+    for (std::size_t n = 0; n < half; ++n)
+    {
+        std::uint32_t reversed = 0;
+        for (int bit = 0; bit < bits; ++bit)
+        {
+            reversed |= static_cast<std::uint32_t>((n >> bit) & 1) << (bits - 1 - bit);
+        }
+        m_bitReversal.push_back(reversed);
+    }
+
+    m_twiddleRe.assign(half, 0.0f);
+    m_twiddleIm.assign(half, 0.0f);
+    for (std::size_t stageHalf = 1; stageHalf < half; stageHalf *= 2)
+    {
+        for (std::size_t j = 0; j < stageHalf; ++j)
+        {
+            double angle = std::numbers::pi * static_cast<double>(j) / static_cast<double>(stageHalf);
+            m_twiddleRe[stageHalf + j] = static_cast<float>(std::cos(angle));
+            m_twiddleIm[stageHalf + j] = static_cast<float>(-std::sin(angle));
+        }
+    }
+    for (std::size_t k = 0; k <= half; ++k)
+    {
+        double angle = 2.0 * std::numbers::pi * static_cast<double>(k) / static_cast<double>(fftSize);
+        m_unpackRe.push_back(static_cast<float>(std::cos(angle)));
+        m_unpackIm.push_back(static_cast<float>(std::sin(angle)));
+    }
+
+    m_re.assign(half, 0.0f);
+    m_im.assign(half, 0.0f);
+    m_power.assign(half + 1, 0.0f);
+
+    // Only now is there a plan for the analysis timer to use
+    m_analysisTimer.changePeriod(period);
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer()
+{
+    LOCK_GUARD(m_mutex);
+    for (auto &source : m_sources)
+    {
+        source.pAudioTap->close();
+    }
+}
+
+SpectrumAnalyzer::SourceId
+SpectrumAnalyzer::addSource
+(
+    std::shared_ptr<AudioTap> pAudioTap
+)
+{
+    if (!pAudioTap)
+    {
+        throw std::runtime_error("SpectrumAnalyzer needs an audio tap, the backend may not offer one");
+    }
+
+    // Each band takes the bins whose centre falls inside it, and at least the
+    // bin nearest its lower edge where bins are wider than bands
+    const std::size_t half = m_fftSize / 2;
+    const double binWidth = static_cast<double>(pAudioTap->sampleRate()) / static_cast<double>(m_fftSize);
+    const double nyquist = static_cast<double>(pAudioTap->sampleRate()) / 2.0;
+    std::vector<std::uint32_t> bandBins;
+    for (std::size_t band = 0; band < m_bandCount; ++band)
+    {
+        auto toBin = [&](double frequency) { return std::min<std::size_t>(half + 1, static_cast<std::size_t>(std::ceil(frequency / binWidth))); };
+        std::size_t first = toBin(m_bandEdges[band]);
+        std::size_t end = toBin(m_bandEdges[band + 1]);
+        if (m_bandEdges[band] >= nyquist)
+        {
+            first = end = 0; // silent
+        }
+        else if (end <= first)
+        {
+            first = std::min(first, half);
+            end = first + 1;
+        }
+        bandBins.push_back(static_cast<std::uint32_t>(first));
+        bandBins.push_back(static_cast<std::uint32_t>(end));
+    }
+
+    LOCK_GUARD(m_mutex);
+    SourceId sourceId = m_nextSourceId++;
+    m_sources.push_back({sourceId, std::move(pAudioTap), std::vector<float>(m_fftSize, 0.0f), 0, std::move(bandBins)});
+    m_batchSources.resize(m_sources.size());
+    m_batchMagnitudes.resize(m_sources.size() * m_bandCount);
+    return sourceId;
+}
+
+void
+SpectrumAnalyzer::removeSource
+(
+    SourceId sourceId
+)
+{
+    LOCK_GUARD(m_mutex);
+    std::erase_if(m_sources, [sourceId](Source &source) {
+        if (source.id != sourceId) return false;
+        source.pAudioTap->close();
+        return true;
+    });
+}
+
+void
+SpectrumAnalyzer::addObserver
+(
+    std::shared_ptr<Observer> pObserver
+)
+{
+    LOCK_GUARD(m_mutex);
+    auto is_equal = [&](const std::weak_ptr<Observer>& wptr) { return wptr.lock() == pObserver; };
+    if (std::find_if(m_observers.begin(), m_observers.end(), is_equal) == m_observers.end())
+    {
+        m_observers.push_back(pObserver);
+    }
+}
+
+void
+SpectrumAnalyzer::removeObserver
+(
+    std::shared_ptr<Observer> pObserver
+)
+{
+    LOCK_GUARD(m_mutex);
+    std::erase_if(m_observers, [&](const std::weak_ptr<Observer>& wptr) { return wptr.expired() || wptr.lock() == pObserver; });
+}
+
+void
+SpectrumAnalyzer::setPeriod
+(
+    std::chrono::milliseconds period
+)
+{
+    m_analysisTimer.changePeriod(period);
+}
+
+void
+SpectrumAnalyzer::analyze()
+{
+    VMX_TRACE_THREAD_NAME("spectrum");
+    VMX_TRACE_SCOPE("SpectrumAnalyzer::analyze", "peak");
+    LOCK_GUARD(m_mutex);
+    std::erase_if(m_sources, [](const Source &source) { return source.pAudioTap->isClosed(); });
+
+    std::size_t rowCount = 0;
+    for (auto &source : m_sources)
+    {
+        if (!drain(source)) continue;
+        transform(source, &m_batchMagnitudes[rowCount * m_bandCount]);
+        m_batchSources[rowCount++] = source.id;
+    }
+    if (rowCount == 0) return;
+
+    // By index, since an observer may remove itself
+    Batch batch{m_bandCount, {m_batchSources.data(), rowCount}, {m_batchMagnitudes.data(), rowCount * m_bandCount}};
+    for (std::size_t index = 0; index < m_observers.size(); ++index)
+    {
+        if (auto pObserver = m_observers[index].lock())
+        {
+            pObserver->onSpectrum(batch);
+        }
+    }
+}
+
+bool
+SpectrumAnalyzer::drain
+(
+    Source &source
+)
+{
+    AudioTap &audioTap = *source.pAudioTap;
+    const std::size_t channelCount = audioTap.channelCount();
+    const float scale = 1.0f / static_cast<float>(channelCount);
+    const std::size_t mask = m_fftSize - 1;
+    bool bReceived = false;
+
+    // Twice at most, for frames that continue from the start of the ring
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        std::span<const float> samples = audioTap.read();
+        if (samples.empty()) break;
+
+        std::size_t frameCount = samples.size() / channelCount;
+        for (std::size_t frame = 0; frame < frameCount; ++frame)
+        {
+            float sum = 0.0f;
+            for (std::size_t channel = 0; channel < channelCount; ++channel)
+            {
+                sum += samples[frame * channelCount + channel];
+            }
+            source.history[source.historyIndex] = sum * scale;
+            source.historyIndex = (source.historyIndex + 1) & mask;
+        }
+        audioTap.consume(frameCount);
+        bReceived = true;
+    }
+    return bReceived;
+}
+
+void
+SpectrumAnalyzer::transform
+(
+    const Source &source,
+    float *pMagnitudes
+)
+{
+    const std::size_t half = m_fftSize / 2;
+    const std::size_t mask = m_fftSize - 1;
+
+    // Even frames become the real parts and odd frames the imaginary parts,
+    // windowed and stored in the bit-reversed order the kernel expects
+    for (std::size_t n = 0; n < half; ++n)
+    {
+        std::size_t even = (source.historyIndex + 2 * n) & mask;
+        std::size_t odd = (even + 1) & mask;
+        m_re[m_bitReversal[n]] = source.history[even] * m_window[2 * n];
+        m_im[m_bitReversal[n]] = source.history[odd] * m_window[2 * n + 1];
+    }
+    detail::fftKernel<detail::BaselineOps>(m_re.data(), m_im.data(), m_twiddleRe.data(), m_twiddleIm.data(), half);
+
+    // Separate the spectra of the even and odd frames, Z[k] = E[k] + iO[k],
+    // and join them into X[k] = E[k] + e^(-2 pi i k / N) O[k]
+    detail::powerKernel<detail::BaselineOps>(m_re.data(), m_im.data(), m_unpackRe.data(), m_unpackIm.data(), m_power.data(), half);
+
+    for (std::size_t band = 0; band < m_bandCount; ++band)
+    {
+        float power = 0.0f;
+        for (std::uint32_t bin = source.bandBins[2 * band]; bin < source.bandBins[2 * band + 1]; ++bin)
+        {
+            power += m_power[bin];
+        }
+        pMagnitudes[band] = (power > 0.0f) ? 10.0f * std::log10(power * m_powerScale) : -std::numeric_limits<float>::infinity();
+    }
+}
+
+} // namespace vmx
@@ -0,0 +1,198 @@
+/* ==== Application Includes =============================================== */
+#include <vmx/Stats.h>
+#include "Instrumentation.h"
+
+/* ==== Standard Library Includes ========================================== */
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace vmx
+{
+
+/* ==== Free Functions ===================================================== */
+const char *
+toString
+(
+    EventKind kind
+)
+{
+    switch (kind)
+    {
+        case EventKind::Name:           return "name";
+        case EventKind::IconPath:       return "icon_path";
+        case EventKind::State:          return "state";
+        case EventKind::Default:        return "default";
+        case EventKind::Volume:         return "volume";
+        case EventKind::ChannelVolumes: return "channel_volumes";
+        case EventKind::Mute:           return "mute";
+        case EventKind::PeakSample:     return "peak_sample";
+        case EventKind::LoudnessSample: return "loudness_sample";
+        case EventKind::SessionAdded:   return "session_added";
+        case EventKind::SessionRemoved: return "session_removed";
+        case EventKind::DeviceAdded:    return "device_added";
+        case EventKind::DeviceRemoved:  return "device_removed";
+        default:                        return "unknown";
+    }
+}
+
+/* ==== LatencyHistogram Class ============================================= */
+void
+LatencyHistogram::record
+(
+    std::uint64_t value
+)
+{
+    m_buckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+
+    std::uint64_t min = m_min.load(std::memory_order_relaxed);
+    while (value < min && !m_min.compare_exchange_weak(min, value, std::memory_order_relaxed)) {}
+
+    std::uint64_t max = m_max.load(std::memory_order_relaxed);
+    while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {}
+}
+
+LatencyHistogram::Snapshot
+LatencyHistogram::snapshot() const
+{
+    // count is summed from the buckets so percentiles stay consistent with
+    // count() even while other threads are recording.
+    Snapshot snapshot;
+    snapshot.m_buckets.resize(kBucketCount);
+    for (std::size_t i = 0; i < kBucketCount; i++)
+    {
+        snapshot.m_buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+        snapshot.m_count += snapshot.m_buckets[i];
+    }
+    snapshot.m_sum = m_sum.load(std::memory_order_relaxed);
+    snapshot.m_min = m_min.load(std::memory_order_relaxed);
+    snapshot.m_max = m_max.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+void
+LatencyHistogram::reset()
+{
+    for (auto &bucket : m_buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_min.store(std::numeric_limits<std::uint64_t>::max(), std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+std::size_t
+LatencyHistogram::bucketOf
+(
+    std::uint64_t value
+)
+{
+    constexpr std::uint64_t subBucketCount = 1ull << kSubBucketBits;
+    if (value < subBucketCount) return static_cast<std::size_t>(value);
+    auto shift = static_cast<std::size_t>(std::bit_width(value)) - kSubBucketBits - 1;
+    auto subBucket = static_cast<std::size_t>((value >> shift) & (subBucketCount - 1));
+    return ((shift + 1) << kSubBucketBits) + subBucket;
+}
+
+std::uint64_t
+LatencyHistogram::bucketUpperBound
+(
+    std::size_t bucket
+)
+{
+    constexpr std::uint64_t subBucketCount = 1ull << kSubBucketBits;
+    if (bucket < subBucketCount) return bucket;
+    std::size_t shift = (bucket >> kSubBucketBits) - 1;
+    std::uint64_t subBucket = bucket & (subBucketCount - 1);
+    return ((subBucketCount | subBucket) << shift) + ((1ull << shift) - 1);
+}
+
+/* ==== LatencyHistogram::Snapshot Class =================================== */
+double
+LatencyHistogram::Snapshot::mean() const
+{
+    return m_count ? static_cast<double>(m_sum) / static_cast<double>(m_count) : 0.0;
+}
+
+std::uint64_t
+LatencyHistogram::Snapshot::percentile
+(
+    double percent
+) const
+{
+    if (m_count == 0) return 0;
+    auto target = static_cast<std::uint64_t>(std::ceil(percent / 100.0 * static_cast<double>(m_count)));
+    target = std::max<std::uint64_t>(target, 1);
+
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < m_buckets.size(); i++)
+    {
+        seen += m_buckets[i];
+        if (seen >= target)
+        {
+            return std::min(bucketUpperBound(i), m_max);
+        }
+    }
+    return m_max;
+}
+
+} // namespace vmx
+
+namespace vmx::detail
+{
+
+/* ==== Process-wide Registry ============================================== */
+struct EventLatencyHistograms
+{
+    LatencyHistogram dispatch;
+    LatencyHistogram callback;
+    LatencyHistogram endToEnd;
+};
+
+static std::array<EventLatencyHistograms, kEventKindCount> g_eventLatency;
+
+void
+recordObserverCall
+(
+    EventKind kind,
+    std::uint64_t reportedNs,
+    std::uint64_t startedNs,
+    std::uint64_t finishedNs
+)
+{
+    auto &histograms = g_eventLatency[static_cast<std::size_t>(kind)];
+    histograms.dispatch.record(startedNs - reportedNs);
+    histograms.callback.record(finishedNs - startedNs);
+    histograms.endToEnd.record(finishedNs - reportedNs);
+}
+
+Stats
+snapshotStats()
+{
+    Stats stats;
+    for (std::size_t i = 0; i < kEventKindCount; i++)
+    {
+        stats.events[i].kind = static_cast<EventKind>(i);
+        stats.events[i].dispatch = g_eventLatency[i].dispatch.snapshot();
+        stats.events[i].callback = g_eventLatency[i].callback.snapshot();
+        stats.events[i].endToEnd = g_eventLatency[i].endToEnd.snapshot();
+    }
+    return stats;
+}
+
+void
+resetStats()
+{
+    for (auto &histograms : g_eventLatency)
+    {
+        histograms.dispatch.reset();
+        histograms.callback.reset();
+        histograms.endToEnd.reset();
+    }
+}
+
+} // namespace vmx::detail
@@ -0,0 +1,257 @@
+/* ==== Application Includes =============================================== */
+#include <vmx/TimerService.h>
+#include "Instrumentation.h"
+#include "Tracing.h"
+
+/* ==== Standard Library Includes ========================================== */
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+/* ==== Operating System Includes ========================================== */
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+namespace vmx
+{
+
+/* ==== TimerService Class ================================================= */
+TimerService::TimerService
+(
+    std::chrono::nanoseconds slack
+)
+  : m_slack(slack)
+{
+#ifdef __linux__
+    // steady_clock is CLOCK_MONOTONIC, so deadlines go to the timerfd as they are
+    m_timerFd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    m_wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_timerFd < 0 || m_wakeFd < 0)
+    {
+        std::string error = std::string("Unable to create the timer service's fds: ") + std::strerror(errno);
+        if (m_timerFd >= 0) ::close(m_timerFd);
+        if (m_wakeFd >= 0) ::close(m_wakeFd);
+        throw std::runtime_error(error);
+    }
+#endif
+    m_thread = std::jthread([this](std::stop_token stopToken){ run(stopToken); });
+    m_threadId = m_thread.get_id();
+}
+
+TimerService::~TimerService()
+{
+    m_thread.request_stop();
+    m_thread.join();
+#ifdef __linux__
+    ::close(m_timerFd);
+    ::close(m_wakeFd);
+#endif
+}
+
+TimerService &
+TimerService::shared()
+{
+    static TimerService *pShared = new TimerService();
+    return *pShared;
+}
+
+TimerService::TimerId
+TimerService::add
+(
+    std::function<void()> task,
+    std::chrono::nanoseconds period
+)
+{
+    std::lock_guard guard(m_mutex);
+    TimerId id = m_nextId++;
+    Timer &timer = m_timers[id];
+    timer.task = std::move(task);
+    timer.period = period;
+    timer.deadline = Clock::now() + period;
+    wakeThread();
+    return id;
+}
+
+void
+TimerService::changePeriod
+(
+    TimerId id,
+    std::chrono::nanoseconds period
+)
+{
+    std::lock_guard guard(m_mutex);
+    auto timer = m_timers.find(id);
+    if (timer == m_timers.end() || timer->second.bRemoved) return;
+    timer->second.period = period;
+    timer->second.deadline = Clock::now() + period;
+    wakeThread();
+}
+
+void
+TimerService::remove
+(
+    TimerId id
+)
+{
+    std::unique_lock lock(m_mutex);
+    auto timer = m_timers.find(id);
+    if (timer == m_timers.end()) return;
+
+    if (std::this_thread::get_id() == m_threadId)
+    {
+        // The running task may be this one, and its std::function is on the stack
+        if (m_running == id)
+        {
+            timer->second.bRemoved = true;
+            timer->second.period = std::chrono::nanoseconds(0);
+            return;
+        }
+    }
+    else
+    {
+        m_idle.wait(lock, [this, id]{ return m_running != id; });
+    }
+    m_timers.erase(id);
+}
+
+TimerService::TimerStats
+TimerService::stats
+(
+    TimerId id
+) const
+{
+    std::lock_guard guard(m_mutex);
+    auto timer = m_timers.find(id);
+    return (timer != m_timers.end()) ? timer->second.stats : TimerStats{};
+}
+
+void
+TimerService::run
+(
+    std::stop_token stopToken
+)
+{
+    VMX_TRACE_THREAD_NAME("vmx timers");
+    ScopedThreadRole threadRole(ThreadRole::Timer);
+#ifdef __linux__
+    std::stop_callback wakeOnStop(stopToken, [this]{ std::uint64_t one = 1; (void)!::write(m_wakeFd, &one, sizeof(one)); });
+#endif
+
+    std::unique_lock lock(m_mutex);
+    while (!stopToken.stop_requested())
+    {
+        // The earliest deadline overall, and the earliest task that may run now
+        Clock::time_point now = Clock::now();
+        Clock::time_point next = Clock::time_point::max();
+        TimerId dueId = 0;
+        Timer *pDue = nullptr;
+        for (auto &[id, timer] : m_timers)
+        {
+            if (timer.period == std::chrono::nanoseconds(0)) continue;
+            next = std::min(next, timer.deadline);
+            auto slack = std::min(m_slack, timer.period / 4);
+            if (timer.deadline - slack <= now && (!pDue || timer.deadline < pDue->deadline))
+            {
+                dueId = id;
+                pDue = &timer;
+            }
+        }
+        if (!pDue)
+        {
+            waitUntil(lock, next, stopToken);
+            continue;
+        }
+
+        // The next deadline follows from this one, not from now, so it does not drift
+        auto lateness = std::chrono::duration_cast<std::chrono::nanoseconds>(now - pDue->deadline);
+        std::uint64_t missed = 0;
+        if (lateness >= pDue->period)
+        {
+            missed = static_cast<std::uint64_t>(lateness / pDue->period);
+            detail::metrics().timerDeadlinesMissed.add(missed);
+        }
+        pDue->deadline += pDue->period * static_cast<std::int64_t>(missed + 1);
+        pDue->stats.runs++;
+        pDue->stats.missedDeadlines += missed;
+        pDue->stats.maxLateness = std::max(pDue->stats.maxLateness, lateness);
+
+        // remove() waits for m_running to move on, so pDue stays valid meanwhile
+        m_running = dueId;
+        lock.unlock();
+        {
+            VMX_TRACE_SCOPE("TimerService::run", "timer");
+            pDue->task();
+        }
+        lock.lock();
+        m_running = 0;
+        if (pDue->bRemoved)
+        {
+            m_timers.erase(dueId);
+        }
+        m_idle.notify_all();
+    }
+}
+
+void
+TimerService::waitUntil
+(
+    std::unique_lock<std::mutex> &lock,
+    Clock::time_point deadline,
+    std::stop_token &stopToken
+)
+{
+#ifdef __linux__
+    // Changes made after the unlock still show up, as the eventfd keeps them
+    itimerspec spec = {};
+    if (deadline != Clock::time_point::max())
+    {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+        spec.it_value.tv_sec = static_cast<time_t>(ns / 1000000000);
+        spec.it_value.tv_nsec = static_cast<long>(ns % 1000000000);
+        if (ns <= 0) spec.it_value.tv_nsec = 1; // zero would disarm it
+    }
+    ::timerfd_settime(m_timerFd, TFD_TIMER_ABSTIME, &spec, nullptr);
+    lock.unlock();
+
+    pollfd pollFds[2] = {{m_timerFd, POLLIN, 0}, {m_wakeFd, POLLIN, 0}};
+    while (::poll(pollFds, 2, -1) < 0 && errno == EINTR) {}
+    std::uint64_t count;
+    (void)!::read(m_timerFd, &count, sizeof(count));
+    (void)!::read(m_wakeFd, &count, sizeof(count));
+    (void)stopToken;
+
+    lock.lock();
+    m_bChanged = false;
+#else
+    if (deadline == Clock::time_point::max())
+    {
+        m_condition.wait(lock, stopToken, [this]{ return m_bChanged; });
+    }
+    else
+    {
+        m_condition.wait_until(lock, stopToken, deadline, [this]{ return m_bChanged; });
+    }
+    m_bChanged = false;
+#endif
+}
+
+void
+TimerService::wakeThread()
+{
+    if (m_bChanged) return; // the thread has not looked since the last one
+    m_bChanged = true;
+#ifdef __linux__
+    std::uint64_t one = 1;
+    (void)!::write(m_wakeFd, &one, sizeof(one));
+#else
+    m_condition.notify_all();
+#endif
+}
+
+} // namespace vmx
@@ -0,0 +1,267 @@
+/* ==== Application Includes =============================================== */
+#include <vmx/Trace.h>
+#include "Tracing.h"
+
+/* ==== Standard Library Includes ========================================== */
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+namespace vmx
+{
+
+#if VMX_TRACING
+namespace detail
+{
+
+/* ==== Types ============================================================== */
+struct TraceEvent
+{
+    const char *name;
+    const char *category;
+    char phase;
+    std::uint32_t tid;
+    std::uint64_t tsNs;
+    std::uint64_t durNs;
+    std::uint64_t id;
+};
+
+/* ==== TraceWriter Class ================================================== */
+// Producers only append to m_pending under a short lock; formatting and file
+// I/O happen on the writer thread so traced threads never wait on the disk.
+class TraceWriter
+{
+public: /* Methods */
+    TraceWriter(std::FILE *pFile)
+      : m_pFile(pFile),
+        m_originNs(timestampNs()),
+        m_thread(std::bind_front(&TraceWriter::writerThreadFunc, this))
+    {
+    }
+
+    ~TraceWriter()
+    {
+        m_thread.request_stop();
+        m_thread.join();
+        std::fputs("\n]}\n", m_pFile);
+        std::fclose(m_pFile);
+    }
+
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    void push(const TraceEvent &event)
+    {
+        std::lock_guard guard(m_mutex);
+        m_pending.push_back(event);
+    }
+
+private: /* Methods */
+    void writerThreadFunc(std::stop_token stopToken)
+    {
+        ScopedThreadRole threadRole(ThreadRole::TraceWriter);
+        std::vector<TraceEvent> batch;
+        std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", m_pFile);
+        while (true)
+        {
+            bool bStopping = false;
+            {
+                std::unique_lock lock(m_mutex);
+                m_condition.wait_for(lock, stopToken, std::chrono::milliseconds(50), []{ return false; });
+                bStopping = stopToken.stop_requested();
+                batch.swap(m_pending);
+            }
+            for (const auto &event : batch)
+            {
+                write(event);
+            }
+            batch.clear();
+            std::fflush(m_pFile);
+            if (bStopping) return;
+        }
+    }
+
+    void write(const TraceEvent &event)
+    {
+        const char *separator = m_bFirst ? "\n" : ",\n";
+        m_bFirst = false;
+        double tsUs = static_cast<double>(event.tsNs - m_originNs) / 1000.0;
+
+        switch (event.phase)
+        {
+            case 'X':
+                std::fprintf(m_pFile, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+                    separator, event.name, event.category, tsUs, static_cast<double>(event.durNs) / 1000.0, event.tid);
+                break;
+            case 's':
+            case 'f':
+                std::fprintf(m_pFile, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"bp\":\"e\",\"id\":%llu,\"ts\":%.3f,\"pid\":1,\"tid\":%u}",
+                    separator, event.name, event.category, event.phase, static_cast<unsigned long long>(event.id), tsUs, event.tid);
+                break;
+            case 'M':
+                std::fprintf(m_pFile, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                    separator, event.tid, event.name);
+                break;
+            default:
+                break;
+        }
+    }
+
+private: /* Members */
+    std::FILE *m_pFile;
+    std::uint64_t m_originNs;
+    bool m_bFirst = true;
+    std::vector<TraceEvent> m_pending;
+    std::mutex m_mutex;
+    std::condition_variable_any m_condition;
+    std::jthread m_thread; // last, so it starts after and joins before the members it uses
+};
+
+/* ==== Globals ============================================================ */
+std::atomic<bool> g_bTraceRecording{false};
+static std::mutex g_traceMutex;
+static std::unique_ptr<TraceWriter> g_pTraceWriter;
+static std::atomic<std::uint32_t> g_nextTraceTid{1};
+static std::atomic<std::uint64_t> g_nextTraceFlowId{1};
+static std::atomic<std::uint64_t> g_traceGeneration{0};
+
+/* ==== Static Helper Functions ============================================ */
+static std::uint32_t
+traceTid()
+{
+    thread_local std::uint32_t tid = g_nextTraceTid.fetch_add(1, std::memory_order_relaxed);
+    return tid;
+}
+
+static void
+tracePush
+(
+    const TraceEvent &event
+)
+{
+    std::lock_guard guard(g_traceMutex);
+    if (g_pTraceWriter)
+    {
+        g_pTraceWriter->push(event);
+    }
+}
+
+/* ==== Functions ========================================================== */
+void
+traceComplete
+(
+    const char *name,
+    const char *category,
+    std::uint64_t beginNs,
+    std::uint64_t endNs
+)
+{
+    tracePush({name, category, 'X', traceTid(), beginNs, endNs - beginNs, 0});
+}
+
+void
+traceFlow
+(
+    char phase,
+    const char *name,
+    std::uint64_t flowId,
+    std::uint64_t tsNs
+)
+{
+    tracePush({name, "dispatch", phase, traceTid(), tsNs, 0, flowId});
+}
+
+void
+traceThreadName
+(
+    const char *name
+)
+{
+    // Emitted once per thread per capture, each capture goes to a fresh file
+    thread_local const char *named = nullptr;
+    thread_local std::uint64_t namedGeneration = 0;
+    std::uint64_t generation = g_traceGeneration.load(std::memory_order_relaxed);
+    if ((named == name && namedGeneration == generation) || !traceRecording()) return;
+    named = name;
+    namedGeneration = generation;
+    tracePush({name, "", 'M', traceTid(), 0, 0, 0});
+}
+
+std::uint64_t
+traceNextFlowId()
+{
+    return g_nextTraceFlowId.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace detail
+#endif
+
+/* ==== Trace Class ======================================================== */
+bool
+Trace::isCompiledIn()
+{
+#if VMX_TRACING
+    return true;
+#else
+    return false;
+#endif
+}
+
+void
+Trace::start
+(
+    const std::string &path
+)
+{
+#if VMX_TRACING
+    std::FILE *pFile = std::fopen(path.c_str(), "wb");
+    if (!pFile)
+    {
+        throw std::runtime_error("Unable to open trace file " + path);
+    }
+
+    auto pWriter = std::make_unique<detail::TraceWriter>(pFile);
+    std::unique_ptr<detail::TraceWriter> pPrevious;
+    {
+        std::lock_guard guard(detail::g_traceMutex);
+        pPrevious = std::move(detail::g_pTraceWriter);
+        detail::g_pTraceWriter = std::move(pWriter);
+    }
+    ++detail::g_traceGeneration;
+    detail::g_bTraceRecording = true;
+#else
+    (void)path;
+    throw std::runtime_error("vmx was built without VMX_ENABLE_TRACING");
+#endif
+}
+
+void
+Trace::stop()
+{
+#if VMX_TRACING
+    detail::g_bTraceRecording = false;
+    std::unique_ptr<detail::TraceWriter> pWriter;
+    {
+        std::lock_guard guard(detail::g_traceMutex);
+        pWriter = std::move(detail::g_pTraceWriter);
+    }
+    // Destroying the writer drains whatever is still pending and closes the file
+#endif
+}
+
+bool
+Trace::isRecording()
+{
+#if VMX_TRACING
+    return detail::traceRecording();
+#else
+    return false;
+#endif
+}
+
+} // namespace vmx
@@ -0,0 +1,151 @@
+#pragma once
+
+/* ==== Application Includes =============================================== */
+#include <vmx/Trace.h>
+#include "Instrumentation.h"
+
+/* ==== Standard Library Includes ========================================== */
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+/* ==== Macros ============================================================= */
+#define VMX_TRACE_CONCAT_INNER(a, b) a##b
+#define VMX_TRACE_CONCAT(a, b) VMX_TRACE_CONCAT_INNER(a, b)
+
+#if VMX_TRACING
+// name and category must be string literals, they are stored by pointer
+#define VMX_TRACE_SCOPE(name, category) \
+    const vmx::detail::ScopedSpan VMX_TRACE_CONCAT(vmxTraceSpan, __LINE__)((name), (category))
+#define VMX_TRACE_THREAD_NAME(name) vmx::detail::traceThreadName((name))
+#else
+#define VMX_TRACE_SCOPE(name, category) do {} while (false)
+#define VMX_TRACE_THREAD_NAME(name) do {} while (false)
+#endif
+
+namespace vmx::detail
+{
+
+#if VMX_TRACING
+/* ==== Functions ========================================================== */
+extern std::atomic<bool> g_bTraceRecording;
+
+inline bool
+traceRecording()
+{
+    return g_bTraceRecording.load(std::memory_order_relaxed);
+}
+
+void traceComplete(const char *name, const char *category, std::uint64_t beginNs, std::uint64_t endNs);
+void traceFlow(char phase, const char *name, std::uint64_t flowId, std::uint64_t tsNs);
+void traceThreadName(const char *name);
+std::uint64_t traceNextFlowId();
+
+// The updating thread opens a flow arrow that the callback thread closes, so the
+// viewer links each update to the observer callbacks it caused.
+inline std::uint64_t
+traceDispatchQueued()
+{
+    if (!traceRecording()) return 0;
+    std::uint64_t flowId = traceNextFlowId();
+    traceFlow('s', "dispatch", flowId, timestampNs());
+    return flowId;
+}
+
+inline void
+traceDispatchStarted
+(
+    std::uint64_t flowId,
+    std::uint64_t reportedNs,
+    std::uint64_t startedNs
+)
+{
+    if (flowId == 0 || !traceRecording()) return;
+    traceThreadName("observer dispatch");
+    traceComplete("queued", "dispatch", reportedNs, startedNs);
+    traceFlow('f', "dispatch", flowId, startedNs);
+}
+
+/* ==== Classes ============================================================ */
+class ScopedSpan
+{
+public: /* Methods */
+    ScopedSpan(const char *name, const char *category)
+      : m_name(name),
+        m_category(category),
+        m_beginNs(traceRecording() ? timestampNs() : 0)
+    {
+    }
+
+    ~ScopedSpan()
+    {
+        if (m_beginNs != 0 && traceRecording())
+        {
+            traceComplete(m_name, m_category, m_beginNs, timestampNs());
+        }
+    }
+
+    ScopedSpan(const ScopedSpan&) = delete;
+    ScopedSpan& operator=(const ScopedSpan&) = delete;
+
+private: /* Members */
+    const char *m_name;
+    const char *m_category;
+    std::uint64_t m_beginNs;
+};
+
+template <class Mutex>
+class TracedLockGuard
+{
+public: /* Methods */
+    explicit TracedLockGuard(Mutex &mutex)
+      : m_mutex(mutex)
+    {
+        if (!traceRecording())
+        {
+            m_mutex.lock();
+            return;
+        }
+        std::uint64_t beginNs = timestampNs();
+        m_mutex.lock();
+        traceComplete("lock wait", "lock", beginNs, timestampNs());
+    }
+
+    ~TracedLockGuard()
+    {
+        m_mutex.unlock();
+    }
+
+    TracedLockGuard(const TracedLockGuard&) = delete;
+    TracedLockGuard& operator=(const TracedLockGuard&) = delete;
+
+private: /* Members */
+    Mutex &m_mutex;
+};
+
+template <class Mutex>
+using LockGuard = TracedLockGuard<Mutex>;
+#else
+/* ==== Functions ========================================================== */
+inline std::uint64_t
+traceDispatchQueued()
+{
+    return 0;
+}
+
+inline void
+traceDispatchStarted
+(
+    std::uint64_t,
+    std::uint64_t,
+    std::uint64_t
+)
+{
+}
+
+/* ==== Classes ============================================================ */
+template <class Mutex>
+using LockGuard = std::lock_guard<Mutex>;
+#endif
+
+} // namespace vmx::detail
@@ -1,37 +1,213 @@
 /* ==== Application Includes =============================================== */
 #include <vmx/VolumeMixer.h>
+#include "Dispatch.h"
+#include "EventQueue.h"
+#include "Instrumentation.h"
+#include "Tracing.h"
 
 /* ==== Standard Library Includes ========================================== */
 #include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <system_error>
 #include <thread>
 
 /* ==== Macros ============================================================= */
-// TODO: Investigate *not* using a detached thread here for every update...
-//       This hack was originally added to WAR a re-entrant thread from device endpoint volume notification
-#define FOR_EACH_OBSERVER_CALL_METHOD(observers, method, ...)       \
-    do                                                              \
-    {                                                               \
-        for (auto it = begin((observers)); it != end((observers));) \
-        {                                                           \
-            if (auto sptr = it->lock())                             \
-            {                                                       \
-                std::thread t([=]{sptr->method(__VA_ARGS__);});     \
-                t.detach();                                         \
-                ++it;                                               \
-            }                                                       \
-            else                                                    \
-            {                                                       \
-                it = (observers).erase(it);                         \
-            }                                                       \
-        }                                                           \
+// Threaded dispatch runs each observer call on a detached thread, originally
+// to get around re-entrant endpoint volume notifications. Synchronous dispatch
+// (the global mode, or the one the observer was added with) queues it on this
+// thread instead, and DispatchScope runs the queue once the outermost lock is
+// released, backend locks included (see Dispatch.h).
+// reportedNs is when the backend handed the change to update*(); each callback
+// records its dispatch delay and duration against that stamp.
+#define FOR_EACH_OBSERVER_CALL_METHOD(observers, kind, reportedNs, method, ...)           \
+    do                                                                                  \
+    {                                                                                   \
+        detail::metrics().eventsProduced((kind)).add();                                 \
+        for (auto it = begin((observers)); it != end((observers));)                     \
+        {                                                                               \
+            if (auto sptr = it->pWeakObserver.lock())                                   \
+            {                                                                           \
+                detail::metrics().dispatchQueueDepth.add();                             \
+                std::uint64_t flowId = detail::traceDispatchQueued();                   \
+                auto call = [=]{                                                        \
+                    std::uint64_t startedNs = detail::timestampNs();                    \
+                    detail::traceDispatchStarted(flowId, (reportedNs), startedNs);      \
+                    {                                                                   \
+                        VMX_TRACE_SCOPE(#method, "observer");                           \
+                        sptr->method(__VA_ARGS__);                                      \
+                    }                                                                   \
+                    detail::recordObserverCall((kind), (reportedNs), startedNs,         \
+                                               detail::timestampNs());                  \
+                    detail::metrics().eventsDelivered.add();                            \
+                    detail::metrics().dispatchQueueDepth.sub();                         \
+                };                                                                      \
+                if (isSynchronous(it->dispatchMode))                                    \
+                {                                                                       \
+                    t_deferredCalls.push_back(std::move(call));                         \
+                }                                                                       \
+                else                                                                    \
+                {                                                                       \
+                    try                                                                 \
+                    {                                                                   \
+                        std::thread t([call = std::move(call)]{                         \
+                            ScopedThreadRole role(ThreadRole::ObserverDispatch);        \
+                            call();                                                     \
+                        });                                                             \
+                        t.detach();                                                     \
+                    }                                                                   \
+                    catch (const std::system_error &)                                   \
+                    {                                                                   \
+                        detail::metrics().dispatchQueueDepth.sub();                     \
+                        detail::metrics().eventsDropped.add();                          \
+                    }                                                                   \
+                }                                                                       \
+                ++it;                                                                   \
+            }                                                                           \
+            else                                                                        \
+            {                                                                           \
+                it = (observers).erase(it);                                             \
+                detail::metrics().observersPruned.add();                                \
+                detail::metrics().liveObservers.sub();                                  \
+            }                                                                           \
+        }                                                                               \
     } while (false)
 
-#define LOCK_GUARD(mutex_var) const std::lock_guard<decltype(mutex_var)> lock(mutex_var)
+#define RETURN_IF_UNCHANGED(current, incoming)                                          \
+    do                                                                                  \
+    {                                                                                   \
+        if ((current) == (incoming))                                                    \
+        {                                                                               \
+            detail::metrics().eventsCoalesced.add();                                    \
+            return;                                                                     \
+        }                                                                               \
+    } while (false)
+
+// The DispatchScope comes first so that it ends after the lock is released
+#define LOCK_GUARD(mutex_var)                                                           \
+    const detail::DispatchScope dispatchScope;                                          \
+    const detail::LockGuard<decltype(mutex_var)> lock(mutex_var)
 
 namespace vmx
 {
 
+/* ==== Dispatch =========================================================== */
+namespace
+{
+
+std::atomic<DispatchMode> g_dispatchMode{DispatchMode::Threaded};
+
+// Observer calls queued by synchronous dispatch on this thread. A change made
+// from inside an observer goes to the back of the queue rather than recursing,
+// and the loop in ~DispatchScope() picks it up after the observer returns.
+thread_local std::deque<std::function<void()>> t_deferredCalls;
+thread_local int t_lockDepth = 0;
+thread_local bool t_bDraining = false;
+
+bool
+isSynchronous
+(
+    std::optional<DispatchMode> dispatchMode
+)
+{
+    return dispatchMode.value_or(g_dispatchMode.load(std::memory_order_relaxed)) == DispatchMode::Synchronous;
+}
+
+// For addObserver(), which holds the object's lock: synchronous dispatch
+// queues the initial notifications like any other call, so the observer may
+// call back into vmx; threaded dispatch makes them right away, as it always has
+template <class Notify>
+void
+notifyNow
+(
+    std::optional<DispatchMode> dispatchMode,
+    Notify notify
+)
+{
+    if (isSynchronous(dispatchMode))
+    {
+        t_deferredCalls.push_back(std::move(notify));
+    }
+    else
+    {
+        notify();
+    }
+}
+
+template <class Observer>
+void
+insertObserverEntry
+(
+    std::vector<detail::ObserverEntry<Observer>> &observers,
+    const std::shared_ptr<Observer> &pObserver,
+    std::optional<DispatchMode> dispatchMode
+)
+{
+    for (auto &entry : observers)
+    {
+        if (entry.pWeakObserver.lock() == pObserver)
+        {
+            entry.dispatchMode = dispatchMode;
+            return;
+        }
+    }
+    observers.push_back({pObserver, dispatchMode});
+    detail::metrics().liveObservers.add();
+}
+
+template <class Observer>
+void
+eraseObserverEntry
+(
+    std::vector<detail::ObserverEntry<Observer>> &observers,
+    const std::shared_ptr<Observer> &pObserver
+)
+{
+    auto removed = std::erase_if(
+        observers,
+        [&](const detail::ObserverEntry<Observer> &entry)
+        {
+            if (entry.pWeakObserver.expired())
+            {
+                detail::metrics().observersPruned.add();
+                return true;
+            }
+            return entry.pWeakObserver.lock() == pObserver;
+        }
+    );
+    detail::metrics().liveObservers.sub(static_cast<std::int64_t>(removed));
+}
+
+} // namespace
+
+/* ==== DispatchScope Class ================================================ */
+detail::DispatchScope::DispatchScope()
+{
+    ++t_lockDepth;
+}
+
+detail::DispatchScope::~DispatchScope()
+{
+    if (--t_lockDepth > 0 || t_bDraining || t_deferredCalls.empty()) return;
+
+    t_bDraining = true;
+    while (!t_deferredCalls.empty())
+    {
+        std::function<void()> call = std::move(t_deferredCalls.front());
+        t_deferredCalls.pop_front();
+        call();
+    }
+    t_bDraining = false;
+}
+
 /* ==== AudioSesssion Methods ============================================== */
+AudioSession::~AudioSession()
+{
+    detail::metrics().liveObservers.sub(static_cast<std::int64_t>(m_observers.size()));
+}
+
 void
 AudioSession::addObserver
 (
@@ -39,28 +215,44 @@ AudioSession::addObserver
     bool bNotifyNow
 )
 {
-    LOCK_GUARD(m_mutex);
-    std::weak_ptr<AudioSession::Observer> ptr = pObserver;
+    insertObserver(std::move(pObserver), bNotifyNow, std::nullopt);
+}
 
-    auto is_equal =
-        [&](const std::weak_ptr<Observer>& wptr)
-        {
-            return wptr.lock() == pObserver;
-        };
+void
+AudioSession::addObserver
+(
+    std::shared_ptr<AudioSession::Observer> pObserver,
+    bool bNotifyNow,
+    DispatchMode dispatchMode
+)
+{
+    insertObserver(std::move(pObserver), bNotifyNow, dispatchMode);
+}
 
-    if (std::find_if(m_observers.begin(), m_observers.end(), is_equal) == m_observers.end())
-    {
-        m_observers.push_back(ptr);
-    }
+void
+AudioSession::insertObserver
+(
+    std::shared_ptr<AudioSession::Observer> pObserver,
+    bool bNotifyNow,
+    std::optional<DispatchMode> dispatchMode
+)
+{
+    LOCK_GUARD(m_mutex);
+    insertObserverEntry(m_observers, pObserver, dispatchMode);
 
     if (bNotifyNow)
     {
-        pObserver->onNameChange(m_name);
-        pObserver->onIconPathChange(m_iconPath);
-        pObserver->onStateChange(m_state);
-        pObserver->onVolumeChange(m_volume);
-        pObserver->onMuteChange(m_bMuted);
-        pObserver->onPeakSample(m_peak);
+        notifyNow(dispatchMode, [pObserver, name = m_name, iconPath = m_iconPath, state = m_state, volume = m_volume,
+                                channelVolumes = m_channelVolumes, bMuted = m_bMuted, peak = m_peak, loudness = m_loudness]{
+            pObserver->onNameChange(name);
+            pObserver->onIconPathChange(iconPath);
+            pObserver->onStateChange(state);
+            pObserver->onVolumeChange(volume);
+            pObserver->onChannelVolumesChange(channelVolumes);
+            pObserver->onMuteChange(bMuted);
+            pObserver->onPeakSample(peak);
+            pObserver->onLoudnessSample(loudness);
+        });
     }
 }
 
@@ -71,17 +263,23 @@ AudioSession::removeObserver
 )
 {
     LOCK_GUARD(m_mutex);
-    m_observers.erase(
-        std::remove_if(
-            m_observers.begin(),
-            m_observers.end(),
-            [&](const std::weak_ptr<AudioSession::Observer>& wptr)
-            {
-                return wptr.expired() || wptr.lock() == pObserver;
-            }
-        ),
-        m_observers.end()
-    );
+    eraseObserverEntry(m_observers, pObserver);
+}
+
+std::vector<float>
+AudioSession::getChannelVolumes()
+{
+    LOCK_GUARD(m_mutex);
+    return m_channelVolumes;
+}
+
+std::shared_ptr<AudioTap>
+AudioSession::openAudioTap
+(
+    std::chrono::milliseconds /*bufferLength*/
+)
+{
+    return nullptr;
 }
 
 void
@@ -90,10 +288,12 @@ AudioSession::updateName
     std::string name
 )
 {
+    std::uint64_t reportedNs = detail::timestampNs();
+    VMX_TRACE_SCOPE("AudioSession::updateName", "update");
     LOCK_GUARD(m_mutex);
-    if (m_name == name) return;
+    RETURN_IF_UNCHANGED(m_name, name);
     m_name = name;
-    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, onNameChange, name);
+    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, EventKind::Name, reportedNs, onNameChange, name);
 }
 
 void
@@ -102,10 +302,12 @@ AudioSession::updateIconPath
     std::string iconPath
 )
 {
+    std::uint64_t reportedNs = detail::timestampNs();
+    VMX_TRACE_SCOPE("AudioSession::updateIconPath", "update");
     LOCK_GUARD(m_mutex);
-    if (m_iconPath == iconPath) return;
+    RETURN_IF_UNCHANGED(m_iconPath, iconPath);
     m_iconPath = iconPath;
-    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, onIconPathChange, iconPath);
+    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, EventKind::IconPath, reportedNs, onIconPathChange, iconPath);
 }
 
 void
@@ -114,10 +316,12 @@ AudioSession::updateState
     AudioSession::State state
 )
 {
+    std::uint64_t reportedNs = detail::timestampNs();
+    VMX_TRACE_SCOPE("AudioSession::updateState", "update");
     LOCK_GUARD(m_mutex);
-    if (m_state == state) return;
+    RETURN_IF_UNCHANGED(m_state, state);
     m_state = state;
-    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, onStateChange, state);
+    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, EventKind::State, reportedNs, onStateChange, state);
 }
 
 void
@@ -126,10 +330,27 @@ AudioSession::updateVolume
     float volume
 )
 {
+    std::uint64_t reportedNs = detail::timestampNs();
+    VMX_TRACE_SCOPE("AudioSession::updateVolume", "update");
     LOCK_GUARD(m_mutex);
-    if (m_volume == volume) return;
+    RETURN_IF_UNCHANGED(m_volume, volume);
     m_volume = volume;
-    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, onVolumeChange, volume);
+    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, EventKind::Volume, reportedNs, onVolumeChange, volume);
+}
+
+// All channels travel as one array, so observers see one event per change however many channels there are
+void
+AudioSession::updateChannelVolumes
+(
+    std::vector<float> channelVolumes
+)
+{
+    std::uint64_t reportedNs = detail::timestampNs();
+    VMX_TRACE_SCOPE("AudioSession::updateChannelVolumes", "update");
+    LOCK_GUARD(m_mutex);
+    RETURN_IF_UNCHANGED(m_channelVolumes, channelVolumes);
+    m_channelVolumes = channelVolumes;
+    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, EventKind::ChannelVolumes, reportedNs, onChannelVolumesChange, channelVolumes);
 }
 
 void
@@ -138,10 +359,12 @@ AudioSession::updateMute
     bool bMuted
 )
 {
+    std::uint64_t reportedNs = detail::timestampNs();
+    VMX_TRACE_SCOPE("AudioSession::updateMute", "update");
     LOCK_GUARD(m_mutex);
-    if (m_bMuted == bMuted) return;
+    RETURN_IF_UNCHANGED(m_bMuted, bMuted);
     m_bMuted = bMuted;
-    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, onMuteChange, bMuted);
+    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, EventKind::Mute, reportedNs, onMuteChange, bMuted);
 }
 
 void
@@ -150,13 +373,34 @@ AudioSession::updatePeakSample
     float peak
 )
 {
+    std::uint64_t reportedNs = detail::timestampNs();
+    VMX_TRACE_SCOPE("AudioSession::updatePeakSample", "update");
     LOCK_GUARD(m_mutex);
-    if (m_peak == peak) return;
+    RETURN_IF_UNCHANGED(m_peak, peak);
     m_peak = peak;
-    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, onPeakSample, peak);
+    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, EventKind::PeakSample, reportedNs, onPeakSample, peak);
+}
+
+void
+AudioSession::updateLoudnessSample
+(
+    Loudness loudness
+)
+{
+    std::uint64_t reportedNs = detail::timestampNs();
+    VMX_TRACE_SCOPE("AudioSession::updateLoudnessSample", "update");
+    LOCK_GUARD(m_mutex);
+    RETURN_IF_UNCHANGED(m_loudness, loudness);
+    m_loudness = loudness;
+    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, EventKind::LoudnessSample, reportedNs, onLoudnessSample, loudness);
 }
 
 /* ==== AudioDevice Methods ================================================ */
+AudioDevice::~AudioDevice()
+{
+    detail::metrics().liveObservers.sub(static_cast<std::int64_t>(m_observers.size()));
+}
+
 void
 AudioDevice::addObserver
 (
@@ -164,34 +408,51 @@ AudioDevice::addObserver
     bool bNotifyNow
 )
 {
-    LOCK_GUARD(m_mutex);
-    std::weak_ptr<AudioDevice::Observer> ptr = pObserver;
+    insertObserver(std::move(pObserver), bNotifyNow, std::nullopt);
+}
 
-    auto is_equal =
-        [&](const std::weak_ptr<AudioDevice::Observer>& wptr)
-        {
-            return wptr.lock() == pObserver;
-        };
+void
+AudioDevice::addObserver
+(
+    std::shared_ptr<AudioDevice::Observer> pObserver,
+    bool bNotifyNow,
+    DispatchMode dispatchMode
+)
+{
+    insertObserver(std::move(pObserver), bNotifyNow, dispatchMode);
+}
 
-    if (std::find_if(m_observers.begin(), m_observers.end(), is_equal) == m_observers.end())
-    {
-        m_observers.push_back(ptr);
-    }
+void
+AudioDevice::insertObserver
+(
+    std::shared_ptr<AudioDevice::Observer> pObserver,
+    bool bNotifyNow,
+    std::optional<DispatchMode> dispatchMode
+)
+{
+    LOCK_GUARD(m_mutex);
+    insertObserverEntry(m_observers, pObserver, dispatchMode);
 
     if (bNotifyNow)
     {
-        pObserver->onNameChange(m_name);
-        pObserver->onIconPathChange(m_iconPath);
-        pObserver->onStateChange(m_state);
-        pObserver->onDefaultChange(m_bIsDefaultDevice);
-        pObserver->onVolumeChange(m_volume);
-        pObserver->onMuteChange(m_bMuted);
-        pObserver->onPeakSample(m_peak);
-
-        for (const auto &entry : m_audioSessions)
-        {
-            pObserver->onAudioSessionAdded(entry.first, entry.second);
-        }
+        notifyNow(dispatchMode, [pObserver, name = m_name, iconPath = m_iconPath, state = m_state, bIsDefaultDevice = m_bIsDefaultDevice,
+                                volume = m_volume, channelVolumes = m_channelVolumes, bMuted = m_bMuted, peak = m_peak,
+                                loudness = m_loudness, audioSessions = m_audioSessions]{
+            pObserver->onNameChange(name);
+            pObserver->onIconPathChange(iconPath);
+            pObserver->onStateChange(state);
+            pObserver->onDefaultChange(bIsDefaultDevice);
+            pObserver->onVolumeChange(volume);
+            pObserver->onChannelVolumesChange(channelVolumes);
+            pObserver->onMuteChange(bMuted);
+            pObserver->onPeakSample(peak);
+            pObserver->onLoudnessSample(loudness);
+
+            for (const auto &entry : audioSessions)
+            {
+                pObserver->onAudioSessionAdded(entry.first, entry.second);
+            }
+        });
     }
 }
 
@@ -202,17 +463,23 @@ AudioDevice::removeObserver
 )
 {
     LOCK_GUARD(m_mutex);
-    m_observers.erase(
-        std::remove_if(
-            m_observers.begin(),
-            m_observers.end(),
-            [&](const std::weak_ptr<AudioDevice::Observer>& wptr)
-            {
-                return wptr.expired() || wptr.lock() == pObserver;
-            }
-        ),
-        m_observers.end()
-    );
+    eraseObserverEntry(m_observers, pObserver);
+}
+
+std::vector<float>
+AudioDevice::getChannelVolumes()
+{
+    LOCK_GUARD(m_mutex);
+    return m_channelVolumes;
+}
+
+std::shared_ptr<AudioTap>
+AudioDevice::openAudioTap
+(
+    std::chrono::milliseconds /*bufferLength*/
+)
+{
+    return nullptr;
 }
 
 void
@@ -221,10 +488,12 @@ AudioDevice::updateName
     std::string name
 )
 {
+    std::uint64_t reportedNs = detail::timestampNs();
+    VMX_TRACE_SCOPE("AudioDevice::updateName", "update");
     LOCK_GUARD(m_mutex);
-    if (m_name == name) return;
+    RETURN_IF_UNCHANGED(m_name, name);
     m_name = name;
-    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, onNameChange, name);
+    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, EventKind::Name, reportedNs, onNameChange, name);
 }
 
 void
@@ -233,10 +502,12 @@ AudioDevice::updateIconPath
     std::string iconPath
 )
 {
+    std::uint64_t reportedNs = detail::timestampNs();
+    VMX_TRACE_SCOPE("AudioDevice::updateIconPath", "update");
     LOCK_GUARD(m_mutex);
-    if (m_iconPath == iconPath) return;
+    RETURN_IF_UNCHANGED(m_iconPath, iconPath);
     m_iconPath = iconPath;
-    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, onIconPathChange, iconPath);
+    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, EventKind::IconPath, reportedNs, onIconPathChange, iconPath);
 
 }
 
@@ -246,10 +517,12 @@ AudioDevice::updateState
     State state
 )
 {
+    std::uint64_t reportedNs = detail::timestampNs();
+    VMX_TRACE_SCOPE("AudioDevice::updateState", "update");
     LOCK_GUARD(m_mutex);
-    if (m_state == state) return;
+    RETURN_IF_UNCHANGED(m_state, state);
     m_state = state;
-    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, onStateChange, state);
+    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, EventKind::State, reportedNs, onStateChange, state);
 }
 
 void
@@ -258,10 +531,12 @@ AudioDevice::updateDefault
     bool bIsDefaultDevice
 )
 {
+    std::uint64_t reportedNs = detail::timestampNs();
+    VMX_TRACE_SCOPE("AudioDevice::updateDefault", "update");
     LOCK_GUARD(m_mutex);
-    if (m_bIsDefaultDevice == bIsDefaultDevice) return;
+    RETURN_IF_UNCHANGED(m_bIsDefaultDevice, bIsDefaultDevice);
     m_bIsDefaultDevice = bIsDefaultDevice;
-    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, onDefaultChange, bIsDefaultDevice);
+    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, EventKind::Default, reportedNs, onDefaultChange, bIsDefaultDevice);
 }
 
 void
@@ -270,10 +545,26 @@ AudioDevice::updateVolume
     float volume
 )
 {
+    std::uint64_t reportedNs = detail::timestampNs();
+    VMX_TRACE_SCOPE("AudioDevice::updateVolume", "update");
     LOCK_GUARD(m_mutex);
-    if (m_volume == volume) return;
+    RETURN_IF_UNCHANGED(m_volume, volume);
     m_volume = volume;
-    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, onVolumeChange, volume);
+    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, EventKind::Volume, reportedNs, onVolumeChange, volume);
+}
+
+void
+AudioDevice::updateChannelVolumes
+(
+    std::vector<float> channelVolumes
+)
+{
+    std::uint64_t reportedNs = detail::timestampNs();
+    VMX_TRACE_SCOPE("AudioDevice::updateChannelVolumes", "update");
+    LOCK_GUARD(m_mutex);
+    RETURN_IF_UNCHANGED(m_channelVolumes, channelVolumes);
+    m_channelVolumes = channelVolumes;
+    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, EventKind::ChannelVolumes, reportedNs, onChannelVolumesChange, channelVolumes);
 }
 
 void
@@ -282,10 +573,12 @@ AudioDevice::updateMute
     bool bMuted
 )
 {
+    std::uint64_t reportedNs = detail::timestampNs();
+    VMX_TRACE_SCOPE("AudioDevice::updateMute", "update");
     LOCK_GUARD(m_mutex);
-    if (m_bMuted == bMuted) return;
+    RETURN_IF_UNCHANGED(m_bMuted, bMuted);
     m_bMuted = bMuted;
-    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, onMuteChange, bMuted);
+    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, EventKind::Mute, reportedNs, onMuteChange, bMuted);
 }
 
 void
@@ -294,10 +587,26 @@ AudioDevice::updatePeakSample
     float peak
 )
 {
+    std::uint64_t reportedNs = detail::timestampNs();
+    VMX_TRACE_SCOPE("AudioDevice::updatePeakSample", "update");
     LOCK_GUARD(m_mutex);
-    if (m_peak == peak) return;
+    RETURN_IF_UNCHANGED(m_peak, peak);
     m_peak = peak;
-    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, onPeakSample, peak);
+    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, EventKind::PeakSample, reportedNs, onPeakSample, peak);
+}
+
+void
+AudioDevice::updateLoudnessSample
+(
+    Loudness loudness
+)
+{
+    std::uint64_t reportedNs = detail::timestampNs();
+    VMX_TRACE_SCOPE("AudioDevice::updateLoudnessSample", "update");
+    LOCK_GUARD(m_mutex);
+    RETURN_IF_UNCHANGED(m_loudness, loudness);
+    m_loudness = loudness;
+    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, EventKind::LoudnessSample, reportedNs, onLoudnessSample, loudness);
 }
 
 void
@@ -307,9 +616,11 @@ AudioDevice::addSession
     std::shared_ptr<AudioSession> pAudioSession
 )
 {
+    std::uint64_t reportedNs = detail::timestampNs();
+    VMX_TRACE_SCOPE("AudioDevice::addSession", "update");
     LOCK_GUARD(m_mutex);
     m_audioSessions[audioSessionId] = pAudioSession;
-    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, onAudioSessionAdded, audioSessionId, pAudioSession);
+    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, EventKind::SessionAdded, reportedNs, onAudioSessionAdded, audioSessionId, pAudioSession);
 }
 
 void
@@ -318,12 +629,102 @@ AudioDevice::removeSession
     const std::string &audioSessionId
 )
 {
+    std::uint64_t reportedNs = detail::timestampNs();
+    VMX_TRACE_SCOPE("AudioDevice::removeSession", "update");
     LOCK_GUARD(m_mutex);
-    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, onAudioSessionRemoved, audioSessionId);
+    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, EventKind::SessionRemoved, reportedNs, onAudioSessionRemoved, audioSessionId);
     m_audioSessions.erase(audioSessionId);
 }
 
 /* ==== VolumeMixer Methods ================================================ */
+VolumeMixer::~VolumeMixer()
+{
+    // Before the count below, the queue's observer goes away with it
+    m_pEventQueue.reset();
+    detail::metrics().liveObservers.sub(static_cast<std::int64_t>(m_observers.size()));
+}
+
+void
+VolumeMixer::setLoudnessSamplingPeriod
+(
+    std::chrono::milliseconds /*period*/
+)
+{
+    // Only backends that see the audio itself can meter loudness
+}
+
+Stats
+VolumeMixer::stats()
+{
+    return detail::snapshotStats();
+}
+
+void
+VolumeMixer::resetStats()
+{
+    detail::resetStats();
+}
+
+Metrics &
+VolumeMixer::metrics()
+{
+    return detail::metrics();
+}
+
+ThreadInventory
+VolumeMixer::threadInventory()
+{
+    return detail::metrics().threadInventory();
+}
+
+void
+VolumeMixer::setDispatchMode
+(
+    DispatchMode dispatchMode
+)
+{
+    g_dispatchMode.store(dispatchMode, std::memory_order_relaxed);
+}
+
+VolumeMixer::DispatchMode
+VolumeMixer::dispatchMode()
+{
+    return g_dispatchMode.load(std::memory_order_relaxed);
+}
+
+int
+VolumeMixer::eventFd()
+{
+    return eventQueue().fd();
+}
+
+std::size_t
+VolumeMixer::drainEvents
+(
+    std::vector<MixerChange> &buffer
+)
+{
+    return eventQueue().drain(buffer);
+}
+
+std::shared_ptr<AudioDevice>
+VolumeMixer::eventDevice
+(
+    std::uint32_t handle
+)
+{
+    return eventQueue().table().findDevice(handle);
+}
+
+std::shared_ptr<AudioSession>
+VolumeMixer::eventSession
+(
+    std::uint32_t handle
+)
+{
+    return eventQueue().table().findSession(handle);
+}
+
 void
 VolumeMixer::addObserver
 (
@@ -331,26 +732,39 @@ VolumeMixer::addObserver
     bool bNotifyNow
 )
 {
-    LOCK_GUARD(m_mutex);
-    std::weak_ptr<VolumeMixer::Observer> ptr = pObserver;
+    insertObserver(std::move(pObserver), bNotifyNow, std::nullopt);
+}
 
-    auto is_equal =
-        [&](const std::weak_ptr<VolumeMixer::Observer>& wptr)
-        {
-            return wptr.lock() == pObserver;
-        };
+void
+VolumeMixer::addObserver
+(
+    std::shared_ptr<VolumeMixer::Observer> pObserver,
+    bool bNotifyNow,
+    DispatchMode dispatchMode
+)
+{
+    insertObserver(std::move(pObserver), bNotifyNow, dispatchMode);
+}
 
-    if (std::find_if(m_observers.begin(), m_observers.end(), is_equal) == m_observers.end())
-    {
-        m_observers.push_back(ptr);
-    }
+void
+VolumeMixer::insertObserver
+(
+    std::shared_ptr<VolumeMixer::Observer> pObserver,
+    bool bNotifyNow,
+    std::optional<DispatchMode> dispatchMode
+)
+{
+    LOCK_GUARD(m_mutex);
+    insertObserverEntry(m_observers, pObserver, dispatchMode);
 
     if (bNotifyNow)
     {
-        for (const auto &entry : m_audioDevices)
-        {
-            pObserver->onAudioDeviceAdded(entry.first, entry.second);
-        }
+        notifyNow(dispatchMode, [pObserver, audioDevices = m_audioDevices]{
+            for (const auto &entry : audioDevices)
+            {
+                pObserver->onAudioDeviceAdded(entry.first, entry.second);
+            }
+        });
     }
 }
 
@@ -361,17 +775,7 @@ VolumeMixer::removeObserver
 )
 {
     LOCK_GUARD(m_mutex);
-    m_observers.erase(
-        std::remove_if(
-            m_observers.begin(),
-            m_observers.end(),
-            [&](const std::weak_ptr<VolumeMixer::Observer>& wptr)
-            {
-                return wptr.expired() || wptr.lock() == pObserver;
-            }
-        ),
-        m_observers.end()
-    );
+    eraseObserverEntry(m_observers, pObserver);
 }
 
 void
@@ -381,9 +785,11 @@ VolumeMixer::addDevice
     std::shared_ptr<AudioDevice> pAudioDevice
 )
 {
+    std::uint64_t reportedNs = detail::timestampNs();
+    VMX_TRACE_SCOPE("VolumeMixer::addDevice", "update");
     LOCK_GUARD(m_mutex);
     m_audioDevices[audioDeviceId] = pAudioDevice;
-    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, onAudioDeviceAdded, audioDeviceId, pAudioDevice);
+    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, EventKind::DeviceAdded, reportedNs, onAudioDeviceAdded, audioDeviceId, pAudioDevice);
 }
 
 void
@@ -392,9 +798,22 @@ VolumeMixer::removeDevice
     const std::string &audioDeviceId
 )
 {
+    std::uint64_t reportedNs = detail::timestampNs();
+    VMX_TRACE_SCOPE("VolumeMixer::removeDevice", "update");
     LOCK_GUARD(m_mutex);
-    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, onAudioDeviceRemoved, audioDeviceId);
+    FOR_EACH_OBSERVER_CALL_METHOD(m_observers, EventKind::DeviceRemoved, reportedNs, onAudioDeviceRemoved, audioDeviceId);
     m_audioDevices.erase(audioDeviceId);
 }
 
+detail::EventQueue &
+VolumeMixer::eventQueue()
+{
+    std::lock_guard guard(m_eventQueueMutex);
+    if (!m_pEventQueue)
+    {
+        m_pEventQueue = std::make_shared<detail::EventQueue>(*this);
+    }
+    return *m_pEventQueue;
+}
+
 } // namespace vmx
@@ -1,10 +1,15 @@
 /* ==== Application Includes =============================================== */
 #include <vmx/WindowsVolumeMixer.h>
+#include "BackendPlugin.h"
+#include "Dispatch.h"
+#include "Instrumentation.h"
+#include "Tracing.h"
 
 /* ==== Standard Library Includes ========================================== */
 #include <stdexcept>
 #include <algorithm>
 #include <format>
+#include <vector>
 
 /* ==== Operating System Includes ========================================== */
 // todo do this in cmake instead
@@ -15,6 +20,7 @@
 #define CHECK_HRESULT(hr)                                                                                   \
     do                                                                                                      \
     {                                                                                                       \
+        vmx::detail::countBackendCall(SUCCEEDED((hr)));                                                     \
         if (FAILED((hr)))                                                                                   \
         {                                                                                                   \
             auto s = std::format("Error encountered at {}:{} hr:{:x}", __FILE__, __LINE__, (unsigned)hr);   \
@@ -23,10 +29,20 @@
     }                                                                                                       \
     while (false)
 
-#define LOCK_GUARD(mutex_var) const std::lock_guard<decltype(mutex_var)> lock(mutex_var)
+// The DispatchScope comes first so that synchronous observer calls wait for the lock's release
+#define LOCK_GUARD(mutex_var)                                                           \
+    const detail::DispatchScope dispatchScope;                                          \
+    const detail::LockGuard<decltype(mutex_var)> lock(mutex_var)
+
+/* ==== Constants ========================================================== */
+// Tags channel volume changes vmx makes in several calls (one per endpoint
+// channel, or a session's multipliers and master volume), so their
+// notifications can be skipped in favour of the one update made after them
+static const GUID kChannelVolumesContext = { 0x6f1c2d3e, 0x8a4b, 0x4c5d, { 0x9e, 0x7f, 0x10, 0x21, 0x32, 0x43, 0x54, 0x65 } };
 
 /* ==== Forward Declarations =============================================== */
 static std::string utf8_encode(const std::wstring &wstr);
+static std::vector<float> clampChannelVolumes(std::vector<float> channelVolumes, UINT channelCount);
 static std::string windowName(unsigned int processId, bool bSystemsSoundSession);
 static vmx::AudioSession::State from(AudioSessionState state);
 static vmx::AudioDevice::State from(DWORD state);
@@ -68,6 +84,12 @@ WindowsAudioSession::WindowsAudioSession
     m_pSimpleAudioVolume = { (ISimpleAudioVolume*)ptr, false };
     CHECK_HRESULT(hr);
 
+    hr = m_pAudioSessionControl->QueryInterface(
+        __uuidof(IChannelAudioVolume),
+        &ptr);
+    m_pChannelAudioVolume = { (IChannelAudioVolume*)ptr, false };
+    CHECK_HRESULT(hr);
+
     hr = m_pAudioSessionControl->QueryInterface(
         __uuidof(IAudioMeterInformation),
         &ptr);
@@ -120,6 +142,7 @@ WindowsAudioSession::WindowsAudioSession
     hr = m_pSimpleAudioVolume->GetMasterVolume(&sessionVolume);
     CHECK_HRESULT(hr);
     updateVolume(sessionVolume);
+    refreshChannelVolumes();
 
     hr = m_pSimpleAudioVolume->GetMute(&bSessionMuted);
     CHECK_HRESULT(hr);
@@ -144,6 +167,7 @@ WindowsAudioSession::changeVolume
     float volume
 )
 {
+    VMX_TRACE_SCOPE("WindowsAudioSession::changeVolume", "control");
     LOCK_GUARD(m_mutex);
     CoInitializer com{};
     volume = std::min(1.0f, volume);
@@ -151,6 +175,7 @@ WindowsAudioSession::changeVolume
     HRESULT hr = m_pSimpleAudioVolume->SetMasterVolume(volume, nullptr);
     CHECK_HRESULT(hr);
     updateVolume(volume);
+    refreshChannelVolumes();
 }
 
 void
@@ -159,6 +184,7 @@ WindowsAudioSession::changeMute
     bool bMute
 )
 {
+    VMX_TRACE_SCOPE("WindowsAudioSession::changeMute", "control");
     LOCK_GUARD(m_mutex);
     CoInitializer com{};
     HRESULT hr = m_pSimpleAudioVolume->SetMute(bMute, nullptr);
@@ -166,6 +192,65 @@ WindowsAudioSession::changeMute
     updateMute(bMute);
 }
 
+// Windows keeps a session's channel volumes as multipliers under its master
+// volume. Here the loudest channel becomes the master volume and the
+// multipliers are what is left. Both calls are tagged, so observers get the
+// array once, from here, rather than from each notification.
+void
+WindowsAudioSession::changeChannelVolumes
+(
+    std::vector<float> channelVolumes
+)
+{
+    VMX_TRACE_SCOPE("WindowsAudioSession::changeChannelVolumes", "control");
+    LOCK_GUARD(m_mutex);
+    CoInitializer com{};
+    UINT32 channelCount;
+    HRESULT hr = m_pChannelAudioVolume->GetChannelCount(&channelCount);
+    CHECK_HRESULT(hr);
+    channelVolumes = clampChannelVolumes(std::move(channelVolumes), channelCount);
+
+    float volume = ChannelVolumes::volume(channelVolumes);
+    std::vector<float> multipliers(channelCount, 1.0f);
+    for (UINT32 channel = 0; channel < channelCount && volume > 0.0f; ++channel)
+    {
+        multipliers[channel] = channelVolumes[channel] / volume;
+    }
+    hr = m_pChannelAudioVolume->SetAllVolumes(channelCount, multipliers.data(), &kChannelVolumesContext);
+    CHECK_HRESULT(hr);
+    hr = m_pSimpleAudioVolume->SetMasterVolume(volume, &kChannelVolumesContext);
+    CHECK_HRESULT(hr);
+    updateVolume(volume);
+    updateChannelVolumes(std::move(channelVolumes));
+}
+
+// Also runs on notification threads, so failures are counted rather than thrown
+void
+WindowsAudioSession::refreshChannelVolumes()
+{
+    CoInitializer com{};
+    float volume = 0.0f;
+    UINT32 channelCount = 0;
+    HRESULT hr = m_pSimpleAudioVolume->GetMasterVolume(&volume);
+    if (SUCCEEDED(hr))
+    {
+        hr = m_pChannelAudioVolume->GetChannelCount(&channelCount);
+    }
+    std::vector<float> channelVolumes(SUCCEEDED(hr) ? channelCount : 0);
+    if (SUCCEEDED(hr))
+    {
+        hr = m_pChannelAudioVolume->GetAllVolumes(channelCount, channelVolumes.data());
+    }
+    detail::countBackendCall(SUCCEEDED(hr));
+    if (FAILED(hr)) return;
+
+    for (auto &channelVolume : channelVolumes)
+    {
+        channelVolume *= volume;
+    }
+    updateChannelVolumes(std::move(channelVolumes));
+}
+
 void
 WindowsAudioSession::peakSample()
 {
@@ -174,6 +259,7 @@ WindowsAudioSession::peakSample()
     float peak;
     HRESULT hr = m_pAudioMeterInformation->GetPeakValue(&peak);
     // CHECK_HRESULT(hr);
+    detail::countBackendCall(SUCCEEDED(hr));
     if (FAILED(hr))
     {
         peak = 0.0f;
@@ -238,6 +324,7 @@ CAudioSessionEvents::OnDisplayNameChanged
     LPCGUID EventContext
 )
 {
+    VMX_TRACE_SCOPE("CAudioSessionEvents::OnDisplayNameChanged", "backend");
     (void)EventContext;
     std::string name = utf8_encode(NewDisplayName);
     if (name.empty() || m_parent.m_bSystemsSoundSession)
@@ -255,6 +342,7 @@ CAudioSessionEvents::OnIconPathChanged
     LPCGUID EventContext
 )
 {
+    VMX_TRACE_SCOPE("CAudioSessionEvents::OnIconPathChanged", "backend");
     (void)EventContext;
     // todo: re-lookup actual icon path
     m_parent.updateIconPath(utf8_encode(NewIconPath));
@@ -269,9 +357,11 @@ CAudioSessionEvents::OnSimpleVolumeChanged
     LPCGUID EventContext
 )
 {
-    (void)EventContext;
+    VMX_TRACE_SCOPE("CAudioSessionEvents::OnSimpleVolumeChanged", "backend");
+    if (EventContext && *EventContext == kChannelVolumesContext) return S_OK;
     m_parent.updateVolume(NewVolume);
     m_parent.updateMute(NewMute);
+    m_parent.refreshChannelVolumes();
     return S_OK;
 
 }
@@ -285,11 +375,13 @@ CAudioSessionEvents::OnChannelVolumeChanged
     LPCGUID EventContext
 )
 {
-    // Ignoring for now. per-channel support not enabled yet.
+    // One notification carries every channel; they are multipliers, so the master volume is read back too
+    VMX_TRACE_SCOPE("CAudioSessionEvents::OnChannelVolumeChanged", "backend");
     (void)ChannelCount;
     (void)NewChannelVolumeArray;
     (void)ChangedChannel;
-    (void)EventContext;
+    if (EventContext && *EventContext == kChannelVolumesContext) return S_OK;
+    m_parent.refreshChannelVolumes();
     return S_OK;
 }
 
@@ -316,6 +408,7 @@ CAudioSessionEvents::OnStateChanged
     AudioSessionState NewState
 )
 {
+    VMX_TRACE_SCOPE("CAudioSessionEvents::OnStateChanged", "backend");
     m_parent.updateState(from(NewState));
     return S_OK;
 }
@@ -336,16 +429,18 @@ CAudioSessionEvents::OnSessionDisconnected
 WindowsAudioDevice::WindowsAudioDevice
 (
     IMMDevice *pMMDevice,
-    bool bDefaultDevice
+    bool bDefaultDevice,
+    ServiceExecutor &serviceExecutor
 )
   : m_pMMDevice(pMMDevice, true),
     m_pAudioEndpointVolumeCallback(new CAudioEndpointVolumeCallback(*this), false),
     m_pAudioSessionNotification(new CAudioSessionNotification(*this), false),
-    m_queuedWorkThread([this](const std::string &str){ killSession(str); })
+    m_strand(serviceExecutor)
 {
     HRESULT     hr;
     PROPVARIANT varString;
     float       volume;
+    UINT        channelCount;
     BOOL        bMuted;
     float       peak;
     int         sessionCount;
@@ -406,6 +501,16 @@ WindowsAudioDevice::WindowsAudioDevice
     CHECK_HRESULT(hr);
     updateVolume(volume);
 
+    hr = m_pAudioEndpointVolume->GetChannelCount(&channelCount);
+    CHECK_HRESULT(hr);
+    std::vector<float> channelVolumes(channelCount);
+    for (UINT channel = 0; channel < channelCount; ++channel)
+    {
+        hr = m_pAudioEndpointVolume->GetChannelVolumeLevelScalar(channel, &channelVolumes[channel]);
+        CHECK_HRESULT(hr);
+    }
+    updateChannelVolumes(std::move(channelVolumes));
+
     hr = m_pAudioEndpointVolume->GetMute(&bMuted);
     CHECK_HRESULT(hr);
     updateMute(bMuted);
@@ -448,6 +553,9 @@ WindowsAudioDevice::WindowsAudioDevice
 
 WindowsAudioDevice::~WindowsAudioDevice()
 {
+    // No killSession() runs once this returns, and none starts
+    m_strand.close();
+
     if (m_bAudioEndpointVolumeCallbackRegistered)
     {
         (void)m_pAudioEndpointVolume->UnregisterControlChangeNotify(m_pAudioEndpointVolumeCallback.get());
@@ -467,6 +575,7 @@ WindowsAudioDevice::changeVolume
     float volume
 )
 {
+    VMX_TRACE_SCOPE("WindowsAudioDevice::changeVolume", "control");
     LOCK_GUARD(m_mutex);
     CoInitializer com{};
     volume = std::min(1.0f, volume);
@@ -482,6 +591,7 @@ WindowsAudioDevice::changeMute
     bool bMute
 )
 {
+    VMX_TRACE_SCOPE("WindowsAudioDevice::changeMute", "control");
     LOCK_GUARD(m_mutex);
     CoInitializer com{};
     HRESULT hr = m_pAudioEndpointVolume->SetMute(bMute, nullptr);
@@ -489,14 +599,37 @@ WindowsAudioDevice::changeMute
     updateMute(bMute);
 }
 
+// Endpoints have no call that sets every channel, so the per-channel
+// notifications are tagged and skipped and one update goes out at the end
+void
+WindowsAudioDevice::changeChannelVolumes
+(
+    std::vector<float> channelVolumes
+)
+{
+    VMX_TRACE_SCOPE("WindowsAudioDevice::changeChannelVolumes", "control");
+    LOCK_GUARD(m_mutex);
+    CoInitializer com{};
+    UINT channelCount;
+    HRESULT hr = m_pAudioEndpointVolume->GetChannelCount(&channelCount);
+    CHECK_HRESULT(hr);
+    channelVolumes = clampChannelVolumes(std::move(channelVolumes), channelCount);
+    for (UINT channel = 0; channel < channelCount; ++channel)
+    {
+        hr = m_pAudioEndpointVolume->SetChannelVolumeLevelScalar(channel, channelVolumes[channel], &kChannelVolumesContext);
+        CHECK_HRESULT(hr);
+    }
+    updateVolume(ChannelVolumes::volume(channelVolumes));
+    updateChannelVolumes(std::move(channelVolumes));
+}
+
 void
 WindowsAudioDevice::markSessionForDeletion
 (
     const std::string &audioSessionId
 )
 {
-    std::string session = audioSessionId;
-    m_queuedWorkThread.queue(std::move(session));
+    m_strand.post([this, session = audioSessionId]{ killSession(session); });
 }
 
 void
@@ -505,6 +638,7 @@ WindowsAudioDevice::killSession
     const std::string &sessionId
 )
 {
+    VMX_TRACE_SCOPE("WindowsAudioDevice::killSession", "backend");
     LOCK_GUARD(m_mutex);
 
     try
@@ -699,6 +833,7 @@ CAudioSessionLifetimeObserver::OnStateChanged
     AudioSessionState NewState
 )
 {
+    VMX_TRACE_SCOPE("CAudioSessionLifetimeObserver::OnStateChanged", "backend");
     if (from(NewState) == AudioSession::State::Expired)
     {
         m_parent.markSessionForDeletion(m_id);
@@ -786,6 +921,7 @@ CAudioSessionNotification::OnSessionCreated
     IAudioSessionControl *NewSession
 )
 {
+    VMX_TRACE_SCOPE("CAudioSessionNotification::OnSessionCreated", "backend");
     LOCK_GUARD(m_parent.m_mutex);
     CoInitializer com{};
 
@@ -858,9 +994,11 @@ CAudioEndpointVolumeCallback::OnNotify
     PAUDIO_VOLUME_NOTIFICATION_DATA pNotify
 )
 {
-    if (pNotify)
+    VMX_TRACE_SCOPE("CAudioEndpointVolumeCallback::OnNotify", "backend");
+    if (pNotify && pNotify->guidEventContext != kChannelVolumesContext)
     {
         m_parent.updateVolume(pNotify->fMasterVolume);
+        m_parent.updateChannelVolumes(std::vector<float>(pNotify->afChannelVolumes, pNotify->afChannelVolumes + pNotify->nChannels));
         m_parent.updateMute(pNotify->bMuted);
     }
 
@@ -870,7 +1008,7 @@ CAudioEndpointVolumeCallback::OnNotify
 /* ==== WindowsVolumeMixer Class =========================================== */
 WindowsVolumeMixer::WindowsVolumeMixer()
   : m_pMMNotificationClient{new CMMNotificationClient(*this), false },
-    m_peakSamplingThread([this](){peakSample();}, std::chrono::milliseconds(0))
+    m_peakSamplingTimer([this](){peakSample();}, std::chrono::milliseconds(0))
 {
     HRESULT hr;
     UINT    deviceCount;
@@ -923,7 +1061,7 @@ WindowsVolumeMixer::WindowsVolumeMixer()
         CoTaskMemFree(wstring);
         wstring = nullptr;
 
-        auto pWindowsAudioDevice = std::make_shared<WindowsAudioDevice>(pMMDevice, bDefaultDevice);
+        auto pWindowsAudioDevice = std::make_shared<WindowsAudioDevice>(pMMDevice, bDefaultDevice, m_serviceExecutor);
         addDevice(pWindowsAudioDevice->getId(), pWindowsAudioDevice);
         m_audioDevicesMirror[pWindowsAudioDevice->getId()] = pWindowsAudioDevice;
     }
@@ -940,6 +1078,13 @@ WindowsVolumeMixer::~WindowsVolumeMixer()
         (void)m_pMMDeviceEnumerator->UnregisterEndpointNotificationCallback(m_pMMNotificationClient.get());
         m_bNotificationClientRegistered = false;
     }
+
+    // Observers may keep devices past the mixer, so their strands are closed
+    // while the executor they post to is still here
+    for (auto &entry : m_audioDevicesMirror)
+    {
+        entry.second->m_strand.close();
+    }
 }
 
 void
@@ -948,7 +1093,7 @@ WindowsVolumeMixer::setPeakSamplingPeriod
     std::chrono::milliseconds period
 )
 {
-    m_peakSamplingThread.changePeriod(period);
+    m_peakSamplingTimer.changePeriod(period);
 }
 
 void
@@ -956,6 +1101,9 @@ WindowsVolumeMixer::peakSample()
 {
     try
     {
+        VMX_TRACE_THREAD_NAME("peak sampler");
+        VMX_TRACE_SCOPE("WindowsVolumeMixer::peakSample", "peak");
+        detail::ScopedPeakTick tick{};
         LOCK_GUARD(m_mutex);
         for (auto &entry : m_audioDevicesMirror)
         {
@@ -1033,6 +1181,7 @@ CMMNotificationClient::OnDefaultDeviceChanged
     LPCWSTR pwstrDeviceId
 )
 {
+    VMX_TRACE_SCOPE("CMMNotificationClient::OnDefaultDeviceChanged", "backend");
     if ((flow == eRender) &&
         (role == eConsole))
     {
@@ -1102,6 +1251,7 @@ CMMNotificationClient::OnDeviceRemoved
     LPCWSTR pwstrDeviceId
 )
 {
+    VMX_TRACE_SCOPE("CMMNotificationClient::OnDeviceRemoved", "backend");
     LOCK_GUARD(m_parent.m_mutex);
     std::string deviceId = utf8_encode(pwstrDeviceId);
 
@@ -1121,6 +1271,7 @@ CMMNotificationClient::OnDeviceStateChanged
     DWORD dwNewState
 )
 {
+    VMX_TRACE_SCOPE("CMMNotificationClient::OnDeviceStateChanged", "backend");
     LOCK_GUARD(m_parent.m_mutex);
     std::string deviceId = utf8_encode(pwstrDeviceId);
 
@@ -1139,6 +1290,7 @@ CMMNotificationClient::OnPropertyValueChanged
     const PROPERTYKEY key
 )
 {
+    VMX_TRACE_SCOPE("CMMNotificationClient::OnPropertyValueChanged", "backend");
     LOCK_GUARD(m_parent.m_mutex);
     std::string deviceId = utf8_encode(pwstrDeviceId);
 
@@ -1173,6 +1325,24 @@ utf8_encode
     return strTo;
 }
 
+static std::vector<float>
+clampChannelVolumes
+(
+    std::vector<float> channelVolumes,
+    UINT channelCount
+)
+{
+    if (channelVolumes.size() != channelCount)
+    {
+        throw std::runtime_error(std::format("Expected {} channel volumes, got {}", channelCount, channelVolumes.size()));
+    }
+    for (auto &channelVolume : channelVolumes)
+    {
+        channelVolume = std::max(0.0f, std::min(1.0f, channelVolume));
+    }
+    return channelVolumes;
+}
+
 static std::string
 windowName
 (
@@ -1268,3 +1438,8 @@ from
         default:                        return vmx::AudioDevice::State::Unknown;
     }
 }
+
+#if VMX_BACKEND_PLUGIN
+/* ==== Plugin Entry Point ================================================= */
+VMX_DEFINE_BACKEND_PLUGIN("windows", vmx::WindowsVolumeMixer)
+#endif
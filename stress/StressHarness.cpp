@@ -0,0 +1,751 @@
+/* ==== VMX Includes ======================================================= */
+#include <vmx/SimulatedVolumeMixer.h>
+#include <vmx/Trace.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* ==== Types ============================================================== */
+using Clock = std::chrono::steady_clock;
+
+struct Options
+{
+    std::chrono::seconds duration{10};
+    unsigned int updaterThreads = 4;
+    unsigned int maxDevices = 4;
+    unsigned int maxSessionsPerDevice = 16;
+    unsigned int maxObservers = 64;
+    std::chrono::milliseconds peakPeriod{5};
+    std::chrono::milliseconds loudnessPeriod{50};
+    std::chrono::seconds stallTimeout{10};
+    std::uint64_t sloP99Us = 0; // 0 disables the SLO check
+    std::uint32_t seed = 1;
+    bool bSynchronous = false;
+    std::string metricsPath = "";
+    std::string tracePath = "";
+};
+
+/* ==== Globals ============================================================ */
+// Volume updates carry a sequence number in their value (seq / 2^20 is exact in a
+// float), which lets an observer look up when the event was produced.
+static constexpr std::uint32_t kSeqBits = 20;
+static constexpr std::uint32_t kSeqMask = (1u << kSeqBits) - 1;
+static std::array<std::atomic<std::int64_t>, (1u << kSeqBits)> g_stamps{};
+static std::atomic<std::uint32_t> g_seq{1};
+
+static std::atomic<std::uint64_t> g_produced{0};
+static std::atomic<std::uint64_t> g_delivered{0};
+static std::atomic<std::uint64_t> g_progress{0};
+static std::atomic<std::uint64_t> g_violations{0};
+static std::atomic<bool> g_bStop{false};
+
+// notifyNow replays happen synchronously inside addObserver() on the calling
+// thread; they replay old values and must not be counted as event latency.
+static thread_local bool t_bReplaying = false;
+
+static vmx::LatencyHistogram g_latency;
+
+/* ==== Static Helper Functions ============================================ */
+static std::int64_t
+nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+static void
+violation
+(
+    const char *what
+)
+{
+    ++g_violations;
+    std::fprintf(stderr, "invariant violated: %s\n", what);
+}
+
+static float
+stampedVolume()
+{
+    std::uint32_t seq = g_seq.fetch_add(1, std::memory_order_relaxed) & kSeqMask;
+    if (seq == 0) seq = g_seq.fetch_add(1, std::memory_order_relaxed) & kSeqMask;
+    g_stamps[seq].store(nowNs(), std::memory_order_release);
+    return static_cast<float>(seq) / static_cast<float>(1u << kSeqBits);
+}
+
+static void
+recordVolumeDelivery
+(
+    float volume
+)
+{
+    ++g_delivered;
+    if (!(volume >= 0.0f && volume <= 1.0f))
+    {
+        violation("volume outside [0, 1]");
+        return;
+    }
+    if (t_bReplaying) return;
+
+    auto seq = static_cast<std::uint32_t>(std::lround(volume * static_cast<float>(1u << kSeqBits)));
+    if (seq == 0 || seq > kSeqMask) return; // initial/default volumes aren't stamped
+    std::int64_t stamp = g_stamps[seq].load(std::memory_order_acquire);
+    if (stamp == 0)
+    {
+        violation("delivered a volume that was never produced");
+        return;
+    }
+    g_latency.record(static_cast<std::uint64_t>(std::max<std::int64_t>(nowNs() - stamp, 0)));
+}
+
+static void
+checkChannelVolumes
+(
+    const std::vector<float> &channelVolumes
+)
+{
+    ++g_delivered;
+    if (channelVolumes.size() != vmx::SimulatedVolumeMixer::kChannelCount) violation("channel volumes with the wrong channel count");
+    for (float channelVolume : channelVolumes)
+    {
+        if (!(channelVolume >= 0.0f && channelVolume <= 1.0f)) violation("channel volume outside [0, 1]");
+    }
+}
+
+static std::mt19937 &
+threadRng()
+{
+    static std::atomic<std::uint32_t> s_streams{0};
+    thread_local std::mt19937 rng(0x9e3779b9u * ++s_streams);
+    return rng;
+}
+
+static bool
+chance
+(
+    std::mt19937 &rng,
+    unsigned int percent
+)
+{
+    return std::uniform_int_distribution<unsigned int>(0, 99)(rng) < percent;
+}
+
+/* ==== Observers ========================================================== */
+class StressSessionObserver : public vmx::AudioSession::Observer
+{
+public: /* Methods */
+    StressSessionObserver(std::weak_ptr<vmx::AudioSession> pSession) : m_pSession(std::move(pSession)) {};
+
+public: /* Virtual Methods */
+    virtual void onNameChange(std::string) override { ++g_delivered; };
+    virtual void onIconPathChange(std::string) override { ++g_delivered; };
+    virtual void onStateChange(vmx::AudioSession::State) override { ++g_delivered; };
+    virtual void onVolumeChange(float volume) override { recordVolumeDelivery(volume); };
+    virtual void onChannelVolumesChange(std::vector<float> channelVolumes) override { checkChannelVolumes(channelVolumes); };
+    virtual void onPeakSample(float peak) override
+    {
+        ++g_delivered;
+        if (!(peak >= 0.0f && peak <= 1.0f)) violation("session peak outside [0, 1]");
+    };
+    virtual void onLoudnessSample(vmx::Loudness loudness) override
+    {
+        ++g_delivered;
+        if (loudness.momentary > 10.0f) violation("session loudness above +10 LUFS");
+    };
+    virtual void onMuteChange(bool) override
+    {
+        ++g_delivered;
+        // Controllers commonly react to one change by issuing another; keep the
+        // re-entrant path (observer -> changeVolume -> observers) under load.
+        if (t_bReplaying || !chance(threadRng(), 10)) return;
+        if (auto pSession = m_pSession.lock())
+        {
+            pSession->changeVolume(stampedVolume());
+            ++g_produced;
+        }
+    };
+
+private: /* Members */
+    std::weak_ptr<vmx::AudioSession> m_pSession;
+};
+
+class StressDeviceObserver : public vmx::AudioDevice::Observer
+{
+public: /* Virtual Methods */
+    virtual void onNameChange(std::string) override { ++g_delivered; };
+    virtual void onIconPathChange(std::string) override { ++g_delivered; };
+    virtual void onStateChange(vmx::AudioDevice::State) override { ++g_delivered; };
+    virtual void onDefaultChange(bool) override { ++g_delivered; };
+    virtual void onVolumeChange(float volume) override { recordVolumeDelivery(volume); };
+    virtual void onChannelVolumesChange(std::vector<float> channelVolumes) override { checkChannelVolumes(channelVolumes); };
+    virtual void onMuteChange(bool) override { ++g_delivered; };
+    virtual void onPeakSample(float peak) override
+    {
+        ++g_delivered;
+        if (!(peak >= 0.0f && peak <= 1.0f)) violation("device peak outside [0, 1]");
+    };
+    virtual void onLoudnessSample(vmx::Loudness loudness) override
+    {
+        ++g_delivered;
+        if (loudness.momentary > 10.0f) violation("device loudness above +10 LUFS");
+    };
+    virtual void onAudioSessionAdded(const std::string &, std::weak_ptr<vmx::AudioSession> pAudioSession) override
+    {
+        ++g_delivered;
+        if (pAudioSession.expired()) violation("onAudioSessionAdded delivered an expired session");
+    };
+    virtual void onAudioSessionRemoved(const std::string &) override { ++g_delivered; };
+};
+
+class StressMixerObserver : public vmx::VolumeMixer::Observer
+{
+public: /* Virtual Methods */
+    virtual void onAudioDeviceAdded(const std::string &, std::weak_ptr<vmx::AudioDevice> pAudioDevice) override
+    {
+        ++g_delivered;
+        if (pAudioDevice.expired()) violation("onAudioDeviceAdded delivered an expired device");
+    };
+    virtual void onAudioDeviceRemoved(const std::string &) override { ++g_delivered; };
+};
+
+// Snapshot observers used to check the tree once the run has quiesced.
+class CollectingMixerObserver : public vmx::VolumeMixer::Observer
+{
+public: /* Virtual Methods */
+    virtual void onAudioDeviceAdded(const std::string &audioDeviceId, std::weak_ptr<vmx::AudioDevice>) override { ids.insert(audioDeviceId); };
+    virtual void onAudioDeviceRemoved(const std::string &) override {};
+
+public: /* Members */
+    std::set<std::string> ids;
+};
+
+class CollectingDeviceObserver : public StressDeviceObserver
+{
+public: /* Virtual Methods */
+    virtual void onAudioSessionAdded(const std::string &audioSessionId, std::weak_ptr<vmx::AudioSession>) override { ids.insert(audioSessionId); };
+
+public: /* Members */
+    std::set<std::string> ids;
+};
+
+/* ==== Harness Model ====================================================== */
+// What the harness believes the tree looks like. Its lock is never held while
+// calling into vmx, so it can't take part in a lock-order inversion itself.
+struct LiveSession
+{
+    std::shared_ptr<vmx::SimulatedAudioDevice> pDevice;
+    std::shared_ptr<vmx::SimulatedAudioSession> pSession;
+};
+
+class Model
+{
+public: /* Methods */
+    std::shared_ptr<vmx::SimulatedAudioDevice> randomDevice(std::mt19937 &rng)
+    {
+        std::lock_guard guard(m_mutex);
+        if (m_devices.empty()) return nullptr;
+        return m_devices[std::uniform_int_distribution<std::size_t>(0, m_devices.size() - 1)(rng)];
+    }
+
+    LiveSession randomSession(std::mt19937 &rng)
+    {
+        std::lock_guard guard(m_mutex);
+        if (m_sessions.empty()) return {};
+        return m_sessions[std::uniform_int_distribution<std::size_t>(0, m_sessions.size() - 1)(rng)];
+    }
+
+    std::string nextId(const char *prefix)
+    {
+        return prefix + std::to_string(m_nextId.fetch_add(1));
+    }
+
+    std::size_t deviceCount()
+    {
+        std::lock_guard guard(m_mutex);
+        return m_devices.size();
+    }
+
+    std::size_t sessionCount(const std::shared_ptr<vmx::SimulatedAudioDevice> &pDevice)
+    {
+        std::lock_guard guard(m_mutex);
+        return static_cast<std::size_t>(std::count_if(m_sessions.begin(), m_sessions.end(),
+            [&](const LiveSession &s){ return s.pDevice == pDevice; }));
+    }
+
+    void addDevice(std::shared_ptr<vmx::SimulatedAudioDevice> pDevice)
+    {
+        std::lock_guard guard(m_mutex);
+        m_devices.push_back(std::move(pDevice));
+    }
+
+    void addSession(LiveSession session)
+    {
+        std::lock_guard guard(m_mutex);
+        m_sessions.push_back(std::move(session));
+    }
+
+    bool retireDevice(const std::shared_ptr<vmx::SimulatedAudioDevice> &pDevice)
+    {
+        std::lock_guard guard(m_mutex);
+        auto it = std::find(m_devices.begin(), m_devices.end(), pDevice);
+        if (it == m_devices.end()) return false;
+        m_retiredDevices.push_back(pDevice);
+        m_devices.erase(it);
+        std::erase_if(m_sessions, [&](const LiveSession &s)
+        {
+            if (s.pDevice != pDevice) return false;
+            m_retiredSessions.push_back(s.pSession);
+            return true;
+        });
+        return true;
+    }
+
+    bool retireSession(const LiveSession &session)
+    {
+        std::lock_guard guard(m_mutex);
+        auto it = std::find_if(m_sessions.begin(), m_sessions.end(),
+            [&](const LiveSession &s){ return s.pSession == session.pSession; });
+        if (it == m_sessions.end()) return false;
+        m_retiredSessions.push_back(session.pSession);
+        m_sessions.erase(it);
+        return true;
+    }
+
+    std::vector<std::shared_ptr<vmx::SimulatedAudioDevice>> devices()
+    {
+        std::lock_guard guard(m_mutex);
+        return m_devices;
+    }
+
+    std::vector<LiveSession> sessions()
+    {
+        std::lock_guard guard(m_mutex);
+        return m_sessions;
+    }
+
+    std::size_t leakedObjects()
+    {
+        std::lock_guard guard(m_mutex);
+        auto leaked = std::count_if(m_retiredDevices.begin(), m_retiredDevices.end(), [](auto &w){ return !w.expired(); });
+        leaked += std::count_if(m_retiredSessions.begin(), m_retiredSessions.end(), [](auto &w){ return !w.expired(); });
+        return static_cast<std::size_t>(leaked);
+    }
+
+private: /* Members */
+    std::mutex m_mutex;
+    std::atomic<std::uint64_t> m_nextId{0};
+    std::vector<std::shared_ptr<vmx::SimulatedAudioDevice>> m_devices;
+    std::vector<LiveSession> m_sessions;
+    std::vector<std::weak_ptr<vmx::SimulatedAudioDevice>> m_retiredDevices;
+    std::vector<std::weak_ptr<vmx::SimulatedAudioSession>> m_retiredSessions;
+};
+
+/* ==== Workers ============================================================ */
+static void
+updaterThread
+(
+    Model &model,
+    std::uint32_t seed
+)
+{
+    std::mt19937 rng(seed);
+    while (!g_bStop.load(std::memory_order_relaxed))
+    {
+        unsigned int op = std::uniform_int_distribution<unsigned int>(0, 99)(rng);
+        if (op < 80)
+        {
+            LiveSession s = model.randomSession(rng);
+            if (!s.pSession) { std::this_thread::yield(); continue; }
+            if      (op < 40) s.pSession->simulateVolume(stampedVolume());
+            else if (op < 60) s.pSession->changeVolume(stampedVolume());
+            else if (op < 70) s.pSession->changeMute(chance(rng, 50));
+            else if (op < 73) s.pSession->simulateName(model.nextId("name"));
+            else if (op < 75)
+            {
+                // Balance moves keep the loudest channel, so the volume stays a stamped one
+                auto channelVolumes = s.pSession->getChannelVolumes();
+                vmx::ChannelVolumes::setBalance(channelVolumes, std::uniform_real_distribution<float>(-1.0f, 1.0f)(rng));
+                s.pSession->changeChannelVolumes(std::move(channelVolumes));
+            }
+            else              s.pSession->simulateLevel(std::uniform_real_distribution<float>(0.0f, 1.0f)(rng));
+        }
+        else
+        {
+            auto pDevice = model.randomDevice(rng);
+            if (!pDevice) { std::this_thread::yield(); continue; }
+            if      (op < 90) pDevice->changeVolume(stampedVolume());
+            else if (op < 95) pDevice->changeMute(chance(rng, 50));
+            else              pDevice->simulateName(model.nextId("name"));
+        }
+        ++g_produced;
+        ++g_progress;
+    }
+}
+
+static void
+observerChurnThread
+(
+    vmx::SimulatedVolumeMixer &mixer,
+    Model &model,
+    const Options &options,
+    std::uint32_t seed
+)
+{
+    std::mt19937 rng(seed);
+    std::vector<std::shared_ptr<void>> observers;
+    auto pMixerObserver = std::make_shared<StressMixerObserver>();
+    mixer.addObserver(pMixerObserver, false);
+
+    while (!g_bStop.load(std::memory_order_relaxed))
+    {
+        bool bNotifyNow = chance(rng, 50);
+        unsigned int op = std::uniform_int_distribution<unsigned int>(0, 99)(rng);
+
+        if (op < 50 && observers.size() < options.maxObservers)
+        {
+            t_bReplaying = bNotifyNow;
+            if (op < 35)
+            {
+                LiveSession s = model.randomSession(rng);
+                if (s.pSession)
+                {
+                    auto pObserver = std::make_shared<StressSessionObserver>(s.pSession);
+                    s.pSession->addObserver(pObserver, bNotifyNow);
+                    observers.push_back(pObserver);
+                }
+            }
+            else if (auto pDevice = model.randomDevice(rng))
+            {
+                auto pObserver = std::make_shared<StressDeviceObserver>();
+                pDevice->addObserver(pObserver, bNotifyNow);
+                observers.push_back(pObserver);
+            }
+            t_bReplaying = false;
+        }
+        else if (op < 75 && !observers.empty())
+        {
+            // Dropping the last reference without removeObserver() leaves an expired
+            // weak_ptr behind for the notification path to prune.
+            std::size_t i = std::uniform_int_distribution<std::size_t>(0, observers.size() - 1)(rng);
+            observers.erase(observers.begin() + static_cast<std::ptrdiff_t>(i));
+        }
+        else if (op < 90)
+        {
+            auto pObserver = std::make_shared<StressMixerObserver>();
+            t_bReplaying = true;
+            mixer.addObserver(pObserver, true);
+            t_bReplaying = false;
+            mixer.removeObserver(pObserver);
+        }
+        else if (auto pDevice = model.randomDevice(rng))
+        {
+            auto pObserver = std::make_shared<StressDeviceObserver>();
+            t_bReplaying = true;
+            pDevice->addObserver(pObserver, true);
+            t_bReplaying = false;
+            pDevice->removeObserver(pObserver);
+        }
+        ++g_progress;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+
+    mixer.removeObserver(pMixerObserver);
+}
+
+static void
+lifecycleThread
+(
+    vmx::SimulatedVolumeMixer &mixer,
+    Model &model,
+    const Options &options,
+    std::uint32_t seed
+)
+{
+    std::mt19937 rng(seed);
+    while (!g_bStop.load(std::memory_order_relaxed))
+    {
+        unsigned int op = std::uniform_int_distribution<unsigned int>(0, 99)(rng);
+        if (op < 5 || model.deviceCount() == 0)
+        {
+            if (model.deviceCount() < options.maxDevices)
+            {
+                std::string id = model.nextId("device");
+                model.addDevice(mixer.createDevice(id, id, model.deviceCount() == 0));
+            }
+        }
+        else if (op < 8)
+        {
+            if (auto pDevice = model.randomDevice(rng); pDevice && model.retireDevice(pDevice))
+            {
+                mixer.destroyDevice(pDevice->getId());
+            }
+        }
+        else if (op < 10)
+        {
+            if (auto pDevice = model.randomDevice(rng))
+            {
+                mixer.simulateDefaultDevice(pDevice->getId());
+            }
+        }
+        else if (op < 60)
+        {
+            auto pDevice = model.randomDevice(rng);
+            if (pDevice && model.sessionCount(pDevice) < options.maxSessionsPerDevice)
+            {
+                std::string id = model.nextId("session");
+                model.addSession({pDevice, pDevice->createSession(id, id)});
+            }
+        }
+        else
+        {
+            LiveSession s = model.randomSession(rng);
+            if (s.pSession && model.retireSession(s))
+            {
+                s.pDevice->destroySession(s.pSession->getId());
+            }
+        }
+        ++g_produced;
+        ++g_progress;
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+}
+
+/* ==== Reporting ========================================================== */
+static void
+waitForQuiescence()
+{
+    // Observer callbacks run asynchronously; wait until deliveries stop trickling in.
+    std::uint64_t last = g_delivered.load();
+    for (int stableTicks = 0; stableTicks < 5;)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        std::uint64_t now = g_delivered.load();
+        stableTicks = (now == last) ? stableTicks + 1 : 0;
+        last = now;
+    }
+}
+
+static void
+checkTree
+(
+    vmx::SimulatedVolumeMixer &mixer,
+    Model &model
+)
+{
+    auto pMixerSnapshot = std::make_shared<CollectingMixerObserver>();
+    mixer.addObserver(pMixerSnapshot, true);
+    mixer.removeObserver(pMixerSnapshot);
+
+    std::set<std::string> expectedDevices;
+    for (auto &pDevice : model.devices())
+    {
+        expectedDevices.insert(pDevice->getId());
+
+        std::set<std::string> expectedSessions;
+        for (auto &s : model.sessions())
+        {
+            if (s.pDevice == pDevice) expectedSessions.insert(s.pSession->getId());
+        }
+
+        auto pDeviceSnapshot = std::make_shared<CollectingDeviceObserver>();
+        t_bReplaying = true;
+        pDevice->addObserver(pDeviceSnapshot, true);
+        t_bReplaying = false;
+        pDevice->removeObserver(pDeviceSnapshot);
+        if (pDeviceSnapshot->ids != expectedSessions) violation("device session list disagrees with the harness model");
+    }
+
+    if (pMixerSnapshot->ids != expectedDevices) violation("mixer device list disagrees with the harness model");
+}
+
+static void
+printUsage()
+{
+    std::printf(
+        "usage: vmx_stress [options]\n"
+        "  --duration <s>        run time in seconds (default 10)\n"
+        "  --threads <n>         concurrent updater threads (default 4)\n"
+        "  --max-devices <n>     upper bound on simulated devices (default 4)\n"
+        "  --max-sessions <n>    upper bound on sessions per device (default 16)\n"
+        "  --max-observers <n>   upper bound on churned observers (default 64)\n"
+        "  --peak-period <ms>    peak sampling period, 0 disables (default 5)\n"
+        "  --loudness-period <ms> loudness sampling period, 0 disables (default 50)\n"
+        "  --stall-timeout <s>   declare a deadlock after this long without progress (default 10)\n"
+        "  --slo-p99-us <us>     fail if p99 event-to-callback latency exceeds this (default off)\n"
+        "  --seed <n>            random seed (default 1)\n"
+        "  --sync                synchronous observer dispatch instead of a thread per call\n"
+        "  --metrics <path>      write vmx metrics in Prometheus text format at the end\n"
+        "  --trace <path>        capture a Chrome trace (needs VMX_ENABLE_TRACING)\n");
+}
+
+static bool
+parseOptions
+(
+    int argc,
+    char **argv,
+    Options &options
+)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--sync")
+        {
+            options.bSynchronous = true;
+            continue;
+        }
+        if (arg == "--help" || arg == "-h" || i + 1 >= argc) return false;
+        if (arg == "--metrics")
+        {
+            options.metricsPath = argv[++i];
+            continue;
+        }
+        if (arg == "--trace")
+        {
+            options.tracePath = argv[++i];
+            continue;
+        }
+        unsigned long long value = std::strtoull(argv[++i], nullptr, 10);
+        if      (arg == "--duration")      options.duration = std::chrono::seconds(value);
+        else if (arg == "--threads")       options.updaterThreads = static_cast<unsigned int>(value);
+        else if (arg == "--max-devices")   options.maxDevices = static_cast<unsigned int>(value);
+        else if (arg == "--max-sessions")  options.maxSessionsPerDevice = static_cast<unsigned int>(value);
+        else if (arg == "--max-observers") options.maxObservers = static_cast<unsigned int>(value);
+        else if (arg == "--peak-period")   options.peakPeriod = std::chrono::milliseconds(value);
+        else if (arg == "--loudness-period") options.loudnessPeriod = std::chrono::milliseconds(value);
+        else if (arg == "--stall-timeout") options.stallTimeout = std::chrono::seconds(value);
+        else if (arg == "--slo-p99-us")    options.sloP99Us = value;
+        else if (arg == "--seed")          options.seed = static_cast<std::uint32_t>(value);
+        else return false;
+    }
+    return true;
+}
+
+/* ==== Main =============================================================== */
+int
+main
+(
+    int argc,
+    char **argv
+)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (!options.tracePath.empty())
+    {
+        if (!vmx::Trace::isCompiledIn())
+        {
+            std::fprintf(stderr, "--trace needs vmx configured with -DVMX_ENABLE_TRACING=ON\n");
+            return 1;
+        }
+        vmx::Trace::start(options.tracePath);
+    }
+
+    if (options.bSynchronous)
+    {
+        vmx::VolumeMixer::setDispatchMode(vmx::VolumeMixer::DispatchMode::Synchronous);
+    }
+
+    Model model;
+    auto pMixer = std::make_unique<vmx::SimulatedVolumeMixer>();
+    pMixer->setPeakSamplingPeriod(options.peakPeriod);
+    pMixer->setLoudnessSamplingPeriod(options.loudnessPeriod);
+
+    auto start = Clock::now();
+    std::vector<std::thread> workers;
+    workers.emplace_back(lifecycleThread, std::ref(*pMixer), std::ref(model), std::cref(options), options.seed);
+    workers.emplace_back(observerChurnThread, std::ref(*pMixer), std::ref(model), std::cref(options), options.seed + 1);
+    for (unsigned int i = 0; i < options.updaterThreads; i++)
+    {
+        workers.emplace_back(updaterThread, std::ref(model), options.seed + 2 + i);
+    }
+
+    // Watchdog: a deadlock shows up as every worker stopping at once.
+    std::uint64_t lastProgress = 0;
+    auto lastProgressTime = Clock::now();
+    while (Clock::now() - start < options.duration)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        std::uint64_t progress = g_progress.load();
+        if (progress != lastProgress)
+        {
+            lastProgress = progress;
+            lastProgressTime = Clock::now();
+        }
+        else if (Clock::now() - lastProgressTime > options.stallTimeout)
+        {
+            std::fprintf(stderr, "STALL: no progress for %llds after %llu operations, assuming deadlock\n",
+                static_cast<long long>(options.stallTimeout.count()), static_cast<unsigned long long>(progress));
+            std::fflush(stderr);
+            std::abort();
+        }
+    }
+
+    g_bStop = true;
+    for (auto &worker : workers) worker.join();
+    auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    pMixer->setPeakSamplingPeriod(std::chrono::milliseconds(0));
+    pMixer->setLoudnessSamplingPeriod(std::chrono::milliseconds(0));
+    waitForQuiescence();
+    vmx::Trace::stop();
+    checkTree(*pMixer, model);
+
+    // With the harness model gone, removed objects must not be kept alive by anything.
+    std::size_t leaked = model.leakedObjects();
+    if (leaked != 0) violation("removed devices/sessions are still referenced");
+    if (vmx::VolumeMixer::metrics().dispatchQueueDepth.value() != 0) violation("observer callbacks still in flight after quiescence");
+
+    if (!options.metricsPath.empty())
+    {
+        vmx::VolumeMixer::metrics().writePrometheus(options.metricsPath);
+    }
+
+    std::printf("duration            %.2f s\n", elapsed);
+    std::printf("events produced     %llu (%.0f/s)\n", static_cast<unsigned long long>(g_produced.load()), static_cast<double>(g_produced.load()) / elapsed);
+    std::printf("callbacks delivered %llu (%.0f/s)\n", static_cast<unsigned long long>(g_delivered.load()), static_cast<double>(g_delivered.load()) / elapsed);
+    auto latency = g_latency.snapshot();
+    std::printf("latency samples     %llu\n", static_cast<unsigned long long>(latency.count()));
+    std::printf("latency p50         %.1f us\n", static_cast<double>(latency.percentile(50.0)) / 1000.0);
+    std::printf("latency p99         %.1f us\n", static_cast<double>(latency.percentile(99.0)) / 1000.0);
+    std::printf("latency p999        %.1f us\n", static_cast<double>(latency.percentile(99.9)) / 1000.0);
+    std::printf("latency max         %.1f us\n", static_cast<double>(latency.max()) / 1000.0);
+
+    std::printf("\n%-16s %10s %12s %12s %12s\n", "library events", "callbacks", "p50 us", "p99 us", "p999 us");
+    for (const auto &event : vmx::VolumeMixer::stats().events)
+    {
+        if (event.endToEnd.count() == 0) continue;
+        std::printf("%-16s %10llu %12.1f %12.1f %12.1f\n", vmx::toString(event.kind),
+            static_cast<unsigned long long>(event.endToEnd.count()),
+            static_cast<double>(event.endToEnd.percentile(50.0)) / 1000.0,
+            static_cast<double>(event.endToEnd.percentile(99.0)) / 1000.0,
+            static_cast<double>(event.endToEnd.percentile(99.9)) / 1000.0);
+    }
+    std::printf("invariant failures  %llu\n", static_cast<unsigned long long>(g_violations.load()));
+
+    bool bSloMet = (options.sloP99Us == 0) || (latency.percentile(99.0) <= options.sloP99Us * 1000);
+    if (!bSloMet)
+    {
+        std::printf("SLO FAILED: p99 above %llu us\n", static_cast<unsigned long long>(options.sloP99Us));
+    }
+
+    return (g_violations.load() == 0 && bSloMet) ? 0 : 1;
+}
@@ -0,0 +1,199 @@
+/* ==== VMX Includes ======================================================= */
+#include <vmx/VolumeMixer.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Drives one device of a real audio server through a backend and checks the
+// changes come back as callbacks. Run by with-audio-server.sh against a private
+// server with a null sink, see tests/CMakeLists.txt.
+
+/* ==== Globals ============================================================ */
+static constexpr std::chrono::seconds kTimeout{10};
+static constexpr float kVolumeTolerance = 0.02f; // servers store volumes in their own integer steps
+
+/* ==== Observers ========================================================== */
+// Everything a device reported last, for the test to wait on
+class RecordingDeviceObserver : public vmx::AudioDevice::Observer
+{
+public: /* Methods */
+    bool waitFor(const char *what, const std::function<bool()> &predicate)
+    {
+        std::unique_lock lock(m_mutex);
+        if (m_cv.wait_for(lock, kTimeout, predicate)) return true;
+        std::fprintf(stderr, "FAIL no callback for %s within %llds\n", what, static_cast<long long>(kTimeout.count()));
+        return false;
+    };
+
+public: /* Virtual Methods */
+    virtual void onNameChange(std::string) override {};
+    virtual void onIconPathChange(std::string) override {};
+    virtual void onStateChange(vmx::AudioDevice::State) override {};
+    virtual void onDefaultChange(bool) override {};
+    virtual void onPeakSample(float) override {};
+    virtual void onLoudnessSample(vmx::Loudness) override {};
+    virtual void onAudioSessionAdded(const std::string &, std::weak_ptr<vmx::AudioSession>) override {};
+    virtual void onAudioSessionRemoved(const std::string &) override {};
+    virtual void onVolumeChange(float volume) override { record([&]{ reportedVolumes.push_back(volume); }); };
+    virtual void onChannelVolumesChange(std::vector<float> channelVolumes) override { record([&]{ reportedChannelVolumes.push_back(std::move(channelVolumes)); }); };
+    virtual void onMuteChange(bool bMuted) override { record([&]{ reportedMutes.push_back(bMuted); }); };
+
+public: /* Members, under m_mutex */
+    std::vector<float> reportedVolumes;
+    std::vector<std::vector<float>> reportedChannelVolumes;
+    std::vector<bool> reportedMutes;
+
+private: /* Methods */
+    void record(const std::function<void()> &update)
+    {
+        std::lock_guard guard(m_mutex);
+        update();
+        m_cv.notify_all();
+    };
+
+private: /* Members */
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+};
+
+class DeviceWaiter : public vmx::VolumeMixer::Observer
+{
+public: /* Methods */
+    explicit DeviceWaiter(std::string audioDeviceId) : m_audioDeviceId(std::move(audioDeviceId)) {};
+
+    std::shared_ptr<vmx::AudioDevice> wait()
+    {
+        std::unique_lock lock(m_mutex);
+        m_cv.wait_for(lock, kTimeout, [this]{ return m_pAudioDevice.lock() != nullptr; });
+        return m_pAudioDevice.lock();
+    };
+
+public: /* Virtual Methods */
+    virtual void onAudioDeviceAdded(const std::string &audioDeviceId, std::weak_ptr<vmx::AudioDevice> pAudioDevice) override
+    {
+        if (!m_audioDeviceId.empty() && audioDeviceId != m_audioDeviceId) return;
+        std::lock_guard guard(m_mutex);
+        if (m_pAudioDevice.lock()) return;
+        m_pAudioDevice = pAudioDevice;
+        m_cv.notify_all();
+    };
+    virtual void onAudioDeviceRemoved(const std::string &) override {};
+
+private: /* Members */
+    std::string m_audioDeviceId = "";
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::weak_ptr<vmx::AudioDevice> m_pAudioDevice;
+};
+
+/* ==== Static Helper Functions ============================================ */
+static std::shared_ptr<vmx::AudioDevice>
+findDevice
+(
+    vmx::VolumeMixer &volumeMixer,
+    const std::string &audioDeviceId
+)
+{
+    auto pWaiter = std::make_shared<DeviceWaiter>(audioDeviceId);
+    volumeMixer.addObserver(pWaiter, true);
+    auto pAudioDevice = pWaiter->wait();
+    volumeMixer.removeObserver(pWaiter);
+    if (!pAudioDevice)
+    {
+        std::fprintf(stderr, "FAIL device \"%s\" never showed up\n", audioDeviceId.c_str());
+    }
+    return pAudioDevice;
+}
+
+static bool
+near
+(
+    float a,
+    float b
+)
+{
+    return std::fabs(a - b) <= kVolumeTolerance;
+}
+
+/* ==== Main =============================================================== */
+int
+main
+(
+    int argc,
+    char **argv
+)
+{
+    if (argc < 2 || argc > 3)
+    {
+        std::fprintf(stderr, "usage: vmx_backend_smoke_test <backend> [device id]\n");
+        return EXIT_FAILURE;
+    }
+    std::string backendName = argv[1];
+    std::string audioDeviceId = (argc == 3) ? argv[2] : "";
+
+    try
+    {
+        // Changes are made through one mixer and watched through another, so
+        // a callback means the change went through the server and came back.
+        // A JACK device only exists inside vmx's own client, so it watches itself.
+        auto pControlMixer = vmx::VolumeMixer::create(backendName);
+        std::unique_ptr<vmx::VolumeMixer> pWatchMixer;
+        if (backendName != "jack")
+        {
+            pWatchMixer = vmx::VolumeMixer::create(backendName);
+        }
+        auto pControlDevice = findDevice(*pControlMixer, audioDeviceId);
+        auto pWatchDevice = findDevice(pWatchMixer ? *pWatchMixer : *pControlMixer, audioDeviceId);
+        if (!pControlDevice || !pWatchDevice) return EXIT_FAILURE;
+
+        auto pObserver = std::make_shared<RecordingDeviceObserver>();
+        pWatchDevice->addObserver(pObserver, false);
+        bool bPassed = true;
+
+        pControlDevice->changeVolume(0.25f);
+        bPassed &= pObserver->waitFor("changeVolume(0.25)", [&]{ return !pObserver->reportedVolumes.empty() && near(pObserver->reportedVolumes.back(), 0.25f); });
+
+        pControlDevice->changeMute(true);
+        bPassed &= pObserver->waitFor("changeMute(true)", [&]{ return !pObserver->reportedMutes.empty() && pObserver->reportedMutes.back(); });
+        pControlDevice->changeMute(false);
+        bPassed &= pObserver->waitFor("changeMute(false)", [&]{ return !pObserver->reportedMutes.empty() && !pObserver->reportedMutes.back(); });
+
+        // Every channel but the first at half of it, which moves the balance
+        std::vector<float> channelVolumes = pControlDevice->getChannelVolumes();
+        for (std::size_t channel = 0; channel < channelVolumes.size(); ++channel)
+        {
+            channelVolumes[channel] = (channel == 0) ? 0.8f : 0.4f;
+        }
+        pControlDevice->changeChannelVolumes(channelVolumes);
+        bPassed &= pObserver->waitFor("changeChannelVolumes()", [&]{
+            if (pObserver->reportedChannelVolumes.empty()) return false;
+            const auto &reported = pObserver->reportedChannelVolumes.back();
+            if (reported.size() != channelVolumes.size()) return false;
+            for (std::size_t channel = 0; channel < reported.size(); ++channel)
+            {
+                if (!near(reported[channel], channelVolumes[channel])) return false;
+            }
+            return true;
+        });
+
+        pWatchDevice->removeObserver(pObserver);
+        std::printf("%s %s: volume, mute and channel volume callbacks\n", bPassed ? "ok  " : "FAIL", backendName.c_str());
+        return bPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (const std::exception &e)
+    {
+        std::fprintf(stderr, "FAIL %s: %s\n", backendName.c_str(), e.what());
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,103 @@
+/* ==== VMX Includes ======================================================= */
+#include <vmx/ChannelVolumes.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+/* ==== Globals ============================================================ */
+static constexpr float kTolerance = 1e-6f;
+
+/* ==== Helpers ============================================================ */
+static bool
+expectVolumes
+(
+    const char *testName,
+    const std::vector<float> &channelVolumes,
+    const std::vector<float> &expected
+)
+{
+    for (std::size_t channel = 0; channel < expected.size(); ++channel)
+    {
+        if (std::fabs(channelVolumes[channel] - expected[channel]) > kTolerance)
+        {
+            std::fprintf(stderr, "FAIL %s: channel %zu is %.6f, expected %.6f\n",
+                         testName, channel, channelVolumes[channel], expected[channel]);
+            return false;
+        }
+    }
+    std::printf("ok   %s\n", testName);
+    return true;
+}
+
+/* ==== Tests ============================================================== */
+// A 5.1 array trimmed per speaker (FL FR FC LFE BL BR): balance only scales
+// the left and right sides, the centre, the LFE and the ratio between front
+// and back speakers stay where the user put them.
+static bool
+testBalanceKeepsTrim()
+{
+    const std::vector<float> trimmed = {0.8f, 0.8f, 0.5f, 0.2f, 0.6f, 0.6f};
+    bool bPassed = true;
+
+    std::vector<float> channelVolumes = trimmed;
+    vmx::ChannelVolumes::setBalance(channelVolumes, 0.0f);
+    bPassed &= expectVolumes("5.1 centred stays as trimmed", channelVolumes, trimmed);
+
+    vmx::ChannelVolumes::setBalance(channelVolumes, 0.5f);
+    bPassed &= expectVolumes("5.1 balance right", channelVolumes, {0.4f, 0.8f, 0.5f, 0.2f, 0.3f, 0.6f});
+    if (std::fabs(vmx::ChannelVolumes::balance(channelVolumes) - 0.5f) > kTolerance)
+    {
+        std::fprintf(stderr, "FAIL 5.1 balance right: balance() is %.6f\n", vmx::ChannelVolumes::balance(channelVolumes));
+        bPassed = false;
+    }
+
+    vmx::ChannelVolumes::setBalance(channelVolumes, -0.25f);
+    bPassed &= expectVolumes("5.1 balance right to left", channelVolumes, {0.8f, 0.6f, 0.5f, 0.2f, 0.6f, 0.45f});
+
+    vmx::ChannelVolumes::setBalance(channelVolumes, 0.0f);
+    bPassed &= expectVolumes("5.1 back to centre", channelVolumes, trimmed);
+    return bPassed;
+}
+
+// Fully to one side leaves nothing of the other side's trim to restore
+static bool
+testBalanceFromSilencedSide()
+{
+    std::vector<float> channelVolumes = {0.8f, 0.8f, 0.5f, 0.2f, 0.6f, 0.6f};
+    bool bPassed = true;
+
+    vmx::ChannelVolumes::setBalance(channelVolumes, -1.0f);
+    bPassed &= expectVolumes("5.1 balance fully left", channelVolumes, {0.8f, 0.0f, 0.5f, 0.2f, 0.6f, 0.0f});
+
+    vmx::ChannelVolumes::setBalance(channelVolumes, 0.0f);
+    bPassed &= expectVolumes("5.1 back from fully left", channelVolumes, {0.8f, 0.8f, 0.5f, 0.2f, 0.6f, 0.8f});
+    return bPassed;
+}
+
+static bool
+testBalanceKeepsVolume()
+{
+    std::vector<float> channelVolumes = {0.3f, 0.9f};
+    vmx::ChannelVolumes::setBalance(channelVolumes, -0.5f);
+    bool bPassed = expectVolumes("stereo balance keeps the volume", channelVolumes, {0.9f, 0.45f});
+    if (vmx::ChannelVolumes::volume(channelVolumes) != 0.9f)
+    {
+        std::fprintf(stderr, "FAIL stereo balance keeps the volume: volume() is %.6f\n", vmx::ChannelVolumes::volume(channelVolumes));
+        bPassed = false;
+    }
+    return bPassed;
+}
+
+/* ==== Main =============================================================== */
+int
+main()
+{
+    bool bPassed = true;
+    bPassed &= testBalanceKeepsTrim();
+    bPassed &= testBalanceFromSilencedSide();
+    bPassed &= testBalanceKeepsVolume();
+    return bPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,291 @@
+/* ==== VMX Includes ======================================================= */
+#include <vmx/Coroutines.h>
+#include <vmx/EventStream.h>
+#include <vmx/SimulatedVolumeMixer.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* ==== Globals ============================================================ */
+static constexpr int kWantedSamples = 20;
+static constexpr std::chrono::seconds kTimeout{5};
+
+static std::mutex g_mutex;
+static std::condition_variable g_cv;
+static int g_sessionSamples = 0;
+static int g_deviceSamples = 0;
+static int g_failures = 0;
+
+/* ==== Observers ========================================================== */
+// Each peak sample looks the tree up again through the mixer, which takes the
+// locks the backend held while it sampled. Synchronous dispatch has to wait
+// for those to be released or this deadlocks the timer thread.
+class ReentrantSessionObserver : public vmx::AudioSession::Observer
+{
+public: /* Methods */
+    explicit ReentrantSessionObserver(vmx::SimulatedVolumeMixer &volumeMixer) : m_volumeMixer(volumeMixer) {};
+
+public: /* Virtual Methods */
+    virtual void onNameChange(std::string) override {};
+    virtual void onIconPathChange(std::string) override {};
+    virtual void onStateChange(vmx::AudioSession::State) override {};
+    virtual void onVolumeChange(float) override {};
+    virtual void onChannelVolumesChange(std::vector<float>) override {};
+    virtual void onMuteChange(bool) override {};
+    virtual void onLoudnessSample(vmx::Loudness) override {};
+    virtual void onPeakSample(float) override
+    {
+        auto pDevice = m_volumeMixer.findDevice("device");
+        bool bFound = pDevice && pDevice->findSession("session");
+        std::lock_guard guard(g_mutex);
+        g_failures += bFound ? 0 : 1;
+        ++g_sessionSamples;
+        g_cv.notify_all();
+    };
+
+private: /* Members */
+    vmx::SimulatedVolumeMixer &m_volumeMixer;
+};
+
+class ReentrantDeviceObserver : public vmx::AudioDevice::Observer
+{
+public: /* Methods */
+    explicit ReentrantDeviceObserver(vmx::SimulatedVolumeMixer &volumeMixer) : m_volumeMixer(volumeMixer) {};
+
+public: /* Virtual Methods */
+    virtual void onNameChange(std::string) override {};
+    virtual void onIconPathChange(std::string) override {};
+    virtual void onStateChange(vmx::AudioDevice::State) override {};
+    virtual void onDefaultChange(bool) override {};
+    virtual void onVolumeChange(float) override {};
+    virtual void onChannelVolumesChange(std::vector<float>) override {};
+    virtual void onMuteChange(bool) override {};
+    virtual void onLoudnessSample(vmx::Loudness) override {};
+    virtual void onAudioSessionAdded(const std::string &, std::weak_ptr<vmx::AudioSession>) override {};
+    virtual void onAudioSessionRemoved(const std::string &) override {};
+    virtual void onPeakSample(float) override
+    {
+        // A change from inside the callback is queued behind it, not recursed into
+        if (auto pDevice = m_volumeMixer.findDevice("device"))
+        {
+            pDevice->changeVolume(0.5f);
+        }
+        std::lock_guard guard(g_mutex);
+        ++g_deviceSamples;
+        g_cv.notify_all();
+    };
+
+private: /* Members */
+    vmx::SimulatedVolumeMixer &m_volumeMixer;
+};
+
+// Registers a second observer and drops itself from the initial
+// notification, which addObserver() makes with the mixer's std::mutex held
+class ReentrantMixerObserver : public vmx::VolumeMixer::Observer, public std::enable_shared_from_this<ReentrantMixerObserver>
+{
+public: /* Methods */
+    explicit ReentrantMixerObserver(vmx::SimulatedVolumeMixer &volumeMixer) : m_volumeMixer(volumeMixer) {};
+
+public: /* Virtual Methods */
+    virtual void onAudioDeviceAdded(const std::string &, std::weak_ptr<vmx::AudioDevice>) override
+    {
+        m_volumeMixer.addObserver(std::make_shared<ReentrantMixerObserver>(m_volumeMixer), false);
+        m_volumeMixer.removeObserver(shared_from_this());
+        ++m_devicesAdded;
+    };
+    virtual void onAudioDeviceRemoved(const std::string &) override {};
+
+public: /* Members */
+    int m_devicesAdded = 0;
+
+private: /* Members */
+    vmx::SimulatedVolumeMixer &m_volumeMixer;
+};
+
+/* ==== Tests ============================================================== */
+static bool
+testReentryFromPeakSample
+(
+    vmx::VolumeMixer::DispatchMode dispatchMode,
+    const char *modeName
+)
+{
+    vmx::VolumeMixer::setDispatchMode(dispatchMode);
+    g_sessionSamples = g_deviceSamples = g_failures = 0;
+
+    auto pVolumeMixer = std::make_unique<vmx::SimulatedVolumeMixer>();
+    auto pDevice = pVolumeMixer->createDevice("device", "Device", true);
+    auto pSession = pDevice->createSession("session", "Session");
+    auto pSessionObserver = std::make_shared<ReentrantSessionObserver>(*pVolumeMixer);
+    auto pDeviceObserver = std::make_shared<ReentrantDeviceObserver>(*pVolumeMixer);
+    pSession->addObserver(pSessionObserver, false);
+    pDevice->addObserver(pDeviceObserver, false);
+    pVolumeMixer->setPeakSamplingPeriod(std::chrono::milliseconds(2));
+
+    bool bDone;
+    {
+        std::unique_lock lock(g_mutex);
+        bDone = g_cv.wait_for(lock, kTimeout, []{ return g_sessionSamples >= kWantedSamples && g_deviceSamples >= kWantedSamples; });
+    }
+    if (!bDone)
+    {
+        // The timer thread is stuck inside the mixer, which cannot be torn down
+        std::fprintf(stderr, "FAIL reentry from onPeakSample (%s): %d session and %d device samples after %llds, deadlocked\n",
+                     modeName, g_sessionSamples, g_deviceSamples, static_cast<long long>(kTimeout.count()));
+        std::fflush(stderr);
+        std::_Exit(EXIT_FAILURE);
+    }
+
+    pVolumeMixer->setPeakSamplingPeriod(std::chrono::milliseconds(0));
+    pSession->removeObserver(pSessionObserver);
+    pDevice->removeObserver(pDeviceObserver);
+    pVolumeMixer.reset();
+
+    std::lock_guard guard(g_mutex);
+    if (g_failures != 0)
+    {
+        std::fprintf(stderr, "FAIL reentry from onPeakSample (%s): findDevice() missed the tree %d times\n", modeName, g_failures);
+        return false;
+    }
+    std::printf("ok   reentry from onPeakSample (%s)\n", modeName);
+    return true;
+}
+
+static bool
+testReentryFromNotifyNow()
+{
+    vmx::VolumeMixer::setDispatchMode(vmx::VolumeMixer::DispatchMode::Synchronous);
+
+    auto pVolumeMixer = std::make_unique<vmx::SimulatedVolumeMixer>();
+    pVolumeMixer->createDevice("device", "Device", true);
+    auto pObserver = std::make_shared<ReentrantMixerObserver>(*pVolumeMixer);
+
+    // On a thread of its own, so a deadlock is reported rather than hung on
+    bool bDone = false;
+    std::thread adder([&]{
+        pVolumeMixer->addObserver(pObserver, true);
+        std::lock_guard guard(g_mutex);
+        bDone = true;
+        g_cv.notify_all();
+    });
+    {
+        std::unique_lock lock(g_mutex);
+        if (!g_cv.wait_for(lock, kTimeout, [&]{ return bDone; }))
+        {
+            std::fprintf(stderr, "FAIL reentry from addObserver(bNotifyNow) (synchronous): deadlocked after %llds\n",
+                         static_cast<long long>(kTimeout.count()));
+            std::fflush(stderr);
+            std::_Exit(EXIT_FAILURE);
+        }
+    }
+    adder.join();
+
+    // The queued notification runs before addObserver() returns
+    if (pObserver->m_devicesAdded != 1)
+    {
+        std::fprintf(stderr, "FAIL reentry from addObserver(bNotifyNow) (synchronous): %d devices reported, expected 1\n",
+                     pObserver->m_devicesAdded);
+        return false;
+    }
+    std::printf("ok   reentry from addObserver(bNotifyNow) (synchronous)\n");
+    return true;
+}
+
+// The event queue observes the tree synchronously, so under threaded dispatch
+// a change is in the batch by the time change*() returns, with no thread
+// started to deliver it
+static bool
+testEventFdWithoutThreads()
+{
+    vmx::VolumeMixer::setDispatchMode(vmx::VolumeMixer::DispatchMode::Threaded);
+
+    auto pVolumeMixer = std::make_unique<vmx::SimulatedVolumeMixer>();
+    auto pDevice = pVolumeMixer->createDevice("device", "Device", true);
+    auto pSession = pDevice->createSession("session", "Session");
+
+    std::vector<vmx::MixerChange> changes;
+    pVolumeMixer->eventFd();
+    if (pVolumeMixer->drainEvents(changes) == 0)
+    {
+        std::fprintf(stderr, "FAIL eventFd() without threads: no DeviceAdded batch after eventFd()\n");
+        return false;
+    }
+
+    pSession->changeVolume(0.25f);
+    pVolumeMixer->drainEvents(changes);
+    bool bFound = false;
+    for (const vmx::MixerChange &change : changes)
+    {
+        bFound |= (change.event.kind == vmx::EventKind::Volume && change.value.volume == 0.25f);
+    }
+    if (!bFound)
+    {
+        std::fprintf(stderr, "FAIL eventFd() without threads: the volume change was not in the batch when changeVolume() returned\n");
+        return false;
+    }
+    std::printf("ok   eventFd() without threads (threaded)\n");
+    return true;
+}
+
+// Waits for one batch after the initial one and records the volume in it
+static vmx::DetachedTask
+awaitVolume
+(
+    vmx::EventStream &stream,
+    float &volume
+)
+{
+    co_await stream.nextEvents();
+    for (const vmx::MixerChange &change : co_await stream.nextEvents())
+    {
+        if (change.event.kind == vmx::EventKind::Volume) volume = change.value.volume;
+    }
+}
+
+// Likewise for a stream: with the default executor the waiting coroutine has
+// run by the time change*() returns, without a thread per observer call
+static bool
+testEventStreamWithoutThreads()
+{
+    vmx::VolumeMixer::setDispatchMode(vmx::VolumeMixer::DispatchMode::Threaded);
+
+    auto pVolumeMixer = std::make_unique<vmx::SimulatedVolumeMixer>();
+    auto pDevice = pVolumeMixer->createDevice("device", "Device", true);
+    auto pSession = pDevice->createSession("session", "Session");
+
+    float volume = -1.0f;
+    {
+        vmx::EventStream stream(*pVolumeMixer);
+        awaitVolume(stream, volume);
+        pSession->changeVolume(0.25f);
+    }
+    if (volume != 0.25f)
+    {
+        std::fprintf(stderr, "FAIL EventStream without threads: the coroutine saw volume %.2f when changeVolume() returned\n", volume);
+        return false;
+    }
+    std::printf("ok   EventStream without threads (threaded)\n");
+    return true;
+}
+
+/* ==== Main =============================================================== */
+int
+main()
+{
+    bool bPassed = true;
+    bPassed &= testReentryFromPeakSample(vmx::VolumeMixer::DispatchMode::Threaded, "threaded");
+    bPassed &= testReentryFromPeakSample(vmx::VolumeMixer::DispatchMode::Synchronous, "synchronous");
+    bPassed &= testReentryFromNotifyNow();
+    bPassed &= testEventFdWithoutThreads();
+    bPassed &= testEventStreamWithoutThreads();
+    return bPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
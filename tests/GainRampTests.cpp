@@ -0,0 +1,143 @@
+/* ==== VMX Includes ======================================================= */
+#include <vmx/GainRamp.h>
+#include <vmx/PcmMeter.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+/* ==== Globals ============================================================ */
+static constexpr unsigned int kSampleRate = 48000; // 240 frame ramps
+static constexpr double kTolerance = 2e-5;
+
+// Periods from 1 to 1000 frames, shorter and longer than a ramp
+static constexpr std::size_t kPeriods[] = {1, 7, 240, 3, 1000, 239, 64, 1, 241, 500, 13, 999, 2, 120, 333};
+
+// New targets land on some periods, usually while the last ramp is running
+static constexpr float kTargets[] = {0.25f, 1.5f, 0.0f, 1.0f, 0.7f, 0.7f, 0.0f, 1.25f};
+
+/* ==== Types ============================================================== */
+// The same fader in double precision, one frame at a time: a new target
+// starts a ramp of rampFrames frames from wherever the gain is
+class ReferenceRamp
+{
+public:
+    explicit ReferenceRamp(std::size_t rampFrames) : m_rampFrames(rampFrames) {};
+
+    void setTarget(float target) { m_target = target; };
+
+    double next()
+    {
+        if (m_target != m_rampTarget)
+        {
+            m_rampTarget = m_target;
+            m_step = (static_cast<double>(m_target) - m_gain) / static_cast<double>(m_rampFrames);
+            m_framesLeft = m_rampFrames;
+        }
+        if (m_framesLeft > 0)
+        {
+            m_gain = (--m_framesLeft == 0) ? m_rampTarget : m_gain + m_step;
+        }
+        return m_gain;
+    };
+
+private:
+    std::size_t m_rampFrames;
+    float m_target = 1.0f;
+    float m_rampTarget = 1.0f;
+    double m_gain = 1.0;
+    double m_step = 0.0;
+    std::size_t m_framesLeft = 0;
+};
+
+/* ==== Tests ============================================================== */
+// Every output path of process() against the reference, with retargets mid-ramp
+static bool
+testAgainstReference
+(
+    vmx::PcmMeter::Isa isa
+)
+{
+    // The kernel is picked from PcmMeter::isa() when a ramp is made
+    vmx::PcmMeter::setIsa(isa);
+    const char *kernelName = (isa >= vmx::PcmMeter::Isa::Avx2) ? "avx2" : "baseline";
+
+    std::uint32_t noise = 1;
+    auto nextSample = [&noise]()
+    {
+        noise = noise * 1664525u + 1013904223u;
+        return static_cast<float>(static_cast<std::int32_t>(noise)) / 2147483648.0f;
+    };
+
+    for (std::size_t channelCount = 1; channelCount <= vmx::GainRamp::kMaxChannels; ++channelCount)
+    {
+        vmx::GainRamp ramp(kSampleRate);
+        ReferenceRamp reference(ramp.rampFrames());
+        std::size_t target = 0;
+        for (std::size_t call = 0; call < std::size(kPeriods); ++call)
+        {
+            if ((call + channelCount) % 3 != 0)
+            {
+                float gain = kTargets[target++ % std::size(kTargets)];
+                ramp.setTarget(gain);
+                reference.setTarget(gain);
+            }
+
+            const std::size_t frameCount = kPeriods[call];
+            const std::size_t sampleCount = frameCount * channelCount;
+            std::vector<float> in(sampleCount), out(sampleCount, 0.0f), bus(sampleCount), busBefore;
+            for (float &sample : in) sample = nextSample();
+            for (float &sample : bus) sample = nextSample();
+            busBefore = bus;
+
+            // Out and bus, out only, bus only, and in place
+            const int mode = static_cast<int>(call % 4);
+            float *pOut = (mode == 0 || mode == 1) ? out.data() : (mode == 3) ? in.data() : nullptr;
+            float *pBus = (mode == 0 || mode == 2) ? bus.data() : nullptr;
+            const std::vector<float> input = in;
+            ramp.process(in.data(), pOut, pBus, channelCount, frameCount);
+
+            for (std::size_t frame = 0; frame < frameCount; ++frame)
+            {
+                const double gain = reference.next();
+                for (std::size_t channel = 0; channel < channelCount; ++channel)
+                {
+                    const std::size_t index = frame * channelCount + channel;
+                    const double expected = input[index] * gain;
+                    double error = 0.0;
+                    if (pOut) error = std::fabs(pOut[index] - expected);
+                    if (pBus) error = std::fmax(error, std::fabs(bus[index] - (busBefore[index] + expected)));
+                    if (error > kTolerance)
+                    {
+                        std::fprintf(stderr, "FAIL %s kernel matches the reference: %zu channels, call %zu (%zu frames, mode %d), "
+                                     "frame %zu channel %zu is off by %g at gain %.6f\n",
+                                     kernelName, channelCount, call, frameCount, mode, frame, channel, error, gain);
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    std::printf("ok   %s kernel matches the reference\n", kernelName);
+    return true;
+}
+
+/* ==== Main =============================================================== */
+int
+main()
+{
+    bool bPassed = true;
+    for (auto isa : {vmx::PcmMeter::Isa::Scalar, vmx::PcmMeter::Isa::Avx2})
+    {
+        if (!vmx::PcmMeter::isSupported(isa))
+        {
+            std::printf("skip %s is not supported here\n", vmx::toString(isa));
+            continue;
+        }
+        bPassed &= testAgainstReference(isa);
+    }
+    return bPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
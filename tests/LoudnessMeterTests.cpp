@@ -0,0 +1,138 @@
+/* ==== VMX Includes ======================================================= */
+#include <vmx/LoudnessMeter.h>
+#include <vmx/PcmMeter.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <numbers>
+#include <vector>
+
+/* ==== Globals ============================================================ */
+static constexpr float kTolerance = 0.1f; // LU, as EBU Tech 3341 allows
+
+/* ==== Types ============================================================== */
+struct Segment
+{
+    double level;   // dBFS of the sine on each channel
+    double seconds;
+};
+
+struct Case
+{
+    const char *name;
+    std::vector<Segment> segments;
+    float integrated;
+    bool bSteady;   // momentary and short-term have to read integrated too
+};
+
+/* ==== Helpers ============================================================ */
+// Feeds a stereo 1 kHz sine through the meter in uneven chunks, so blocks
+// close in the middle of process() calls
+static vmx::Loudness
+measure
+(
+    const Case &testCase,
+    unsigned int sampleRate
+)
+{
+    constexpr std::size_t kChunkFrames = 1031;
+    vmx::LoudnessMeter meter(sampleRate, 2);
+    std::vector<float> frames(kChunkFrames * 2);
+    double phase = 0.0;
+    const double step = 2.0 * std::numbers::pi * 1000.0 / sampleRate;
+    for (const Segment &segment : testCase.segments)
+    {
+        const double amplitude = std::pow(10.0, segment.level / 20.0);
+        std::size_t remaining = static_cast<std::size_t>(std::llround(segment.seconds * sampleRate));
+        while (remaining > 0)
+        {
+            std::size_t frameCount = (remaining < kChunkFrames) ? remaining : kChunkFrames;
+            for (std::size_t frame = 0; frame < frameCount; ++frame)
+            {
+                float sample = static_cast<float>(amplitude * std::sin(phase));
+                frames[2 * frame] = sample;
+                frames[2 * frame + 1] = sample;
+                phase = std::fmod(phase + step, 2.0 * std::numbers::pi);
+            }
+            meter.process(vmx::SampleFormat::Float32, frames.data(), frameCount);
+            remaining -= frameCount;
+        }
+    }
+    return meter.loudness();
+}
+
+static bool
+expectLoudness
+(
+    const char *what,
+    float value,
+    float expected,
+    const Case &testCase,
+    unsigned int sampleRate,
+    vmx::PcmMeter::Isa isa
+)
+{
+    if (std::fabs(value - expected) <= kTolerance) return true;
+    std::fprintf(stderr, "FAIL %s at %u Hz (%s): %s is %.3f LUFS, expected %.1f\n",
+                 testCase.name, sampleRate, vmx::toString(isa), what, value, expected);
+    return false;
+}
+
+/* ==== Tests ============================================================== */
+// EBU Tech 3341 minimum requirements, cases 1 to 5
+static bool
+testTech3341
+(
+    vmx::PcmMeter::Isa isa
+)
+{
+    const Case cases[] = {
+        {"3341 case 1", {{-23.0, 20.0}}, -23.0f, true},
+        {"3341 case 2", {{-33.0, 20.0}}, -33.0f, true},
+        {"3341 case 3", {{-36.0, 10.0}, {-23.0, 60.0}, {-36.0, 10.0}}, -23.0f, false},
+        {"3341 case 4", {{-72.0, 10.0}, {-36.0, 10.0}, {-23.0, 60.0}, {-36.0, 10.0}, {-72.0, 10.0}}, -23.0f, false},
+        {"3341 case 5", {{-26.0, 20.0}, {-20.0, 20.1}, {-26.0, 20.0}}, -23.0f, false},
+    };
+
+    // The K-weighting kernel is picked from PcmMeter::isa() when a meter is made
+    vmx::PcmMeter::setIsa(isa);
+    bool bPassed = true;
+    for (unsigned int sampleRate : {44100u, 48000u})
+    {
+        for (const Case &testCase : cases)
+        {
+            vmx::Loudness loudness = measure(testCase, sampleRate);
+            bool bCasePassed = expectLoudness("integrated", loudness.integrated, testCase.integrated, testCase, sampleRate, isa);
+            if (testCase.bSteady)
+            {
+                bCasePassed &= expectLoudness("momentary", loudness.momentary, testCase.integrated, testCase, sampleRate, isa);
+                bCasePassed &= expectLoudness("short-term", loudness.shortTerm, testCase.integrated, testCase, sampleRate, isa);
+            }
+            if (bCasePassed)
+            {
+                std::printf("ok   %s at %u Hz (%s)\n", testCase.name, sampleRate, vmx::toString(isa));
+            }
+            bPassed &= bCasePassed;
+        }
+    }
+    return bPassed;
+}
+
+/* ==== Main =============================================================== */
+int
+main()
+{
+    bool bPassed = true;
+    for (auto isa : {vmx::PcmMeter::Isa::Scalar, vmx::PcmMeter::Isa::Avx2})
+    {
+        if (!vmx::PcmMeter::isSupported(isa))
+        {
+            std::printf("skip %s is not supported here\n", vmx::toString(isa));
+            continue;
+        }
+        bPassed &= testTech3341(isa);
+    }
+    return bPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,99 @@
+/* ==== VMX Includes ======================================================= */
+#include <vmx/MeterSegment.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+/* ==== Operating System Includes ========================================== */
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* ==== Globals ============================================================ */
+static const std::string g_name = "/vmx-meters-test-" + std::to_string(::getpid());
+
+/* ==== Tests ============================================================== */
+// A second writer must not take the name over from one that is still running
+static bool
+testLiveSegmentIsKept()
+{
+    vmx::MeterSegmentWriter writer(g_name);
+    writer.add(1, 0, false, "live");
+    writer.setPeak(1, 0.5f);
+    writer.publish();
+
+    try
+    {
+        vmx::MeterSegmentWriter other(g_name);
+        std::fprintf(stderr, "FAIL live segment is kept: a second writer replaced it\n");
+        return false;
+    }
+    catch (const std::runtime_error&)
+    {
+    }
+
+    vmx::MeterSegmentReader reader(g_name);
+    const auto &meters = reader.read();
+    if (meters.size() != 1 || meters[0].id != "live")
+    {
+        std::fprintf(stderr, "FAIL live segment is kept: the reader sees %zu meters\n", meters.size());
+        return false;
+    }
+    std::printf("ok   live segment is kept\n");
+    return true;
+}
+
+// A writer whose process died without unlinking leaves a segment behind
+static bool
+testStaleSegmentIsReplaced()
+{
+    pid_t child = ::fork();
+    if (child == 0)
+    {
+        vmx::MeterSegmentWriter writer(g_name);
+        writer.publish();
+        ::_exit(EXIT_SUCCESS); // no destructor, the segment stays
+    }
+    int status = 0;
+    if (child < 0 || ::waitpid(child, &status, 0) != child || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+    {
+        std::fprintf(stderr, "FAIL stale segment is replaced: the writer process failed\n");
+        ::shm_unlink(g_name.c_str());
+        return false;
+    }
+
+    try
+    {
+        vmx::MeterSegmentWriter writer(g_name);
+        writer.add(2, 0, true, "fresh");
+        writer.publish();
+        vmx::MeterSegmentReader reader(g_name);
+        const auto &meters = reader.read();
+        if (meters.size() != 1 || meters[0].id != "fresh")
+        {
+            std::fprintf(stderr, "FAIL stale segment is replaced: the reader sees %zu meters\n", meters.size());
+            return false;
+        }
+    }
+    catch (const std::runtime_error &error)
+    {
+        std::fprintf(stderr, "FAIL stale segment is replaced: %s\n", error.what());
+        ::shm_unlink(g_name.c_str());
+        return false;
+    }
+    std::printf("ok   stale segment is replaced\n");
+    return true;
+}
+
+/* ==== Main =============================================================== */
+int
+main()
+{
+    bool bPassed = true;
+    bPassed &= testLiveSegmentIsKept();
+    bPassed &= testStaleSegmentIsReplaced();
+    return bPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,152 @@
+/* ==== VMX Includes ======================================================= */
+#include <vmx/PcmMeter.h>
+
+/* ==== Standard Library Includes ========================================== */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <span>
+#include <vector>
+
+/* ==== Globals ============================================================ */
+static constexpr vmx::SampleFormat kFormats[] = {
+    vmx::SampleFormat::Float32,
+    vmx::SampleFormat::Int16,
+    vmx::SampleFormat::Int24,
+    vmx::SampleFormat::Int32,
+};
+static constexpr const char *kFormatNames[] = {"f32", "s16", "s24", "s32"};
+static constexpr std::size_t kSampleSizes[] = {4, 2, 3, 4};
+
+// Odd, below and above the true-peak history, and with many channels past
+// the point where lane sums are folded into the totals. True-peak is costly
+// in unoptimized builds and does no folding, so it stops short of that.
+static constexpr std::size_t kFrameCounts[] = {0, 1, 3, 11, 12, 13, 63, 257, 1001, 2053};
+static constexpr std::size_t kTruePeakFrameCounts[] = {0, 1, 3, 11, 12, 13, 63, 257};
+
+/* ==== Helpers ============================================================ */
+// Noise with occasional full-scale samples, so peaks land on every lane
+static std::vector<std::uint8_t>
+makeFrames
+(
+    vmx::SampleFormat format,
+    std::size_t sampleCount,
+    std::uint32_t seed
+)
+{
+    std::size_t sampleSize = kSampleSizes[static_cast<std::size_t>(format)];
+    std::vector<std::uint8_t> frames(sampleCount * sampleSize);
+    std::uint32_t noise = seed;
+    for (std::size_t index = 0; index < sampleCount; ++index)
+    {
+        noise = noise * 1664525u + 1013904223u;
+        std::int32_t value = static_cast<std::int32_t>(noise);
+        if ((noise >> 8) % 97 == 0) value = (noise & 1) ? INT32_MIN : INT32_MAX;
+        std::uint8_t *pSample = frames.data() + index * sampleSize;
+        switch (format)
+        {
+            case vmx::SampleFormat::Float32:
+            {
+                float sample = static_cast<float>(value) / 2147483648.0f;
+                std::memcpy(pSample, &sample, sizeof(sample));
+                break;
+            }
+            case vmx::SampleFormat::Int16:
+            {
+                std::int16_t sample = static_cast<std::int16_t>(value >> 16);
+                std::memcpy(pSample, &sample, sizeof(sample));
+                break;
+            }
+            case vmx::SampleFormat::Int24:
+            {
+                std::uint32_t bits = static_cast<std::uint32_t>(value) >> 8;
+                pSample[0] = static_cast<std::uint8_t>(bits);
+                pSample[1] = static_cast<std::uint8_t>(bits >> 8);
+                pSample[2] = static_cast<std::uint8_t>(bits >> 16);
+                break;
+            }
+            case vmx::SampleFormat::Int32:
+                std::memcpy(pSample, &value, sizeof(value));
+                break;
+        }
+    }
+    return frames;
+}
+
+using Kernel = void (*)(vmx::SampleFormat, const void*, std::size_t, std::span<float>);
+
+// Every channel has to match the scalar kernel bit for bit on each ISA
+static bool
+compareKernel
+(
+    const char *kernelName,
+    Kernel kernel,
+    std::span<const std::size_t> frameCounts,
+    std::span<const vmx::PcmMeter::Isa> isas
+)
+{
+    std::vector<float> expected(vmx::PcmMeter::kMaxChannels);
+    std::vector<float> levels(vmx::PcmMeter::kMaxChannels);
+    std::vector<bool> passed(isas.size(), true);
+    for (std::size_t f = 0; f < std::size(kFormats); ++f)
+    {
+        for (std::size_t channelCount = 1; channelCount <= vmx::PcmMeter::kMaxChannels; ++channelCount)
+        {
+            for (std::size_t frameCount : frameCounts)
+            {
+                auto frames = makeFrames(kFormats[f], frameCount * channelCount, static_cast<std::uint32_t>(channelCount * 7919 + frameCount));
+                vmx::PcmMeter::setIsa(vmx::PcmMeter::Isa::Scalar);
+                kernel(kFormats[f], frames.data(), frameCount, std::span<float>(expected.data(), channelCount));
+
+                for (std::size_t i = 0; i < isas.size(); ++i)
+                {
+                    if (!passed[i]) continue;
+                    vmx::PcmMeter::setIsa(isas[i]);
+                    kernel(kFormats[f], frames.data(), frameCount, std::span<float>(levels.data(), channelCount));
+                    for (std::size_t channel = 0; channel < channelCount; ++channel)
+                    {
+                        if (std::memcmp(&expected[channel], &levels[channel], sizeof(float)) == 0) continue;
+                        std::fprintf(stderr, "FAIL %s %s %s: %zu channels, %zu frames, channel %zu is %.9g, scalar %.9g\n",
+                                     vmx::toString(isas[i]), kernelName, kFormatNames[f], channelCount, frameCount,
+                                     channel, levels[channel], expected[channel]);
+                        passed[i] = false;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    bool bPassed = true;
+    for (std::size_t i = 0; i < isas.size(); ++i)
+    {
+        if (passed[i]) std::printf("ok   %s %s matches scalar\n", vmx::toString(isas[i]), kernelName);
+        bPassed &= passed[i];
+    }
+    return bPassed;
+}
+
+/* ==== Main =============================================================== */
+int
+main()
+{
+    std::vector<vmx::PcmMeter::Isa> isas;
+    for (auto isa : {vmx::PcmMeter::Isa::Sse2, vmx::PcmMeter::Isa::Avx2, vmx::PcmMeter::Isa::Avx512})
+    {
+        if (vmx::PcmMeter::isSupported(isa))
+        {
+            isas.push_back(isa);
+        }
+        else
+        {
+            std::printf("skip %s is not supported here\n", vmx::toString(isa));
+        }
+    }
+
+    bool bPassed = true;
+    bPassed &= compareKernel("peak", vmx::PcmMeter::peak, kFrameCounts, isas);
+    bPassed &= compareKernel("rms", vmx::PcmMeter::rms, kFrameCounts, isas);
+    bPassed &= compareKernel("true peak", vmx::PcmMeter::truePeak, kTruePeakFrameCounts, isas);
+    return bPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,73 @@
+#!/bin/sh
+# Runs a command against a private audio server with a null sink named
+# vmx_null (for jackd, the dummy driver's playback ports), which is torn
+# down afterwards. Nothing else on the host is used.
+#
+#   with-audio-server.sh <pulseaudio|pipewire|jackd> <command> [args...]
+set -eu
+
+server=$1
+shift
+
+runtime=$(mktemp -d)
+pid=
+cleanup() {
+    if [ -n "$pid" ]; then
+        kill "$pid" 2>/dev/null || true
+        wait "$pid" 2>/dev/null || true
+    fi
+    rm -rf "$runtime"
+}
+trap cleanup EXIT
+trap "exit 1" INT TERM
+
+# Polls until the server answers, for up to 10 seconds
+wait_until() {
+    tries=0
+    until "$@" >/dev/null 2>&1; do
+        tries=$((tries + 1))
+        if [ "$tries" -ge 100 ]; then
+            echo "with-audio-server.sh: $server did not come up" >&2
+            exit 1
+        fi
+        sleep 0.1
+    done
+}
+
+export XDG_RUNTIME_DIR="$runtime"
+case "$server" in
+    pulseaudio)
+        export PULSE_RUNTIME_PATH="$runtime/pulse"
+        export PULSE_SERVER="unix:$runtime/pulse/native"
+        pulseaudio -n --daemonize=no --exit-idle-time=-1 --disallow-exit \
+            --load=module-native-protocol-unix \
+            --load="module-null-sink sink_name=vmx_null channels=2" &
+        pid=$!
+        wait_until pactl info
+        ;;
+    pipewire)
+        export PIPEWIRE_RUNTIME_DIR="$runtime"
+        export PIPEWIRE_REMOTE=pipewire-0
+        pipewire &
+        pid=$!
+        wait_until pw-cli info 0
+        # No session manager runs, so nothing else touches the sink's Props
+        pw-cli create-node adapter '{ factory.name=support.null-audio-sink node.name=vmx_null media.class=Audio/Sink object.linger=true audio.position=[FL FR] }' >/dev/null
+        wait_until sh -c 'pw-cli ls Node | grep -q "node.name = \"vmx_null\""'
+        ;;
+    jackd)
+        export JACK_DEFAULT_SERVER="vmx-smoke-$$"
+        export JACK_NO_AUDIO_RESERVATION=1
+        jackd --no-realtime -d dummy -r 48000 -p 256 -P 2 &
+        pid=$!
+        wait_until jack_lsp system:playback_1
+        ;;
+    *)
+        echo "with-audio-server.sh: unknown server $server" >&2
+        exit 1
+        ;;
+esac
+
+status=0
+"$@" || status=$?
+exit "$status"